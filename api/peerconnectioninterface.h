@@ -98,6 +98,7 @@
 #include "media/base/mediaconfig.h"
 #include "media/base/videocapturer.h"
 #include "p2p/base/portallocator.h"
+#include "rtc_base/memory_accountant.h"
 #include "rtc_base/network.h"
 #include "rtc_base/rtccertificate.h"
 #include "rtc_base/rtccertificategenerator.h"
@@ -485,6 +486,11 @@ class PeerConnectionInterface : public rtc::RefCountInterface {
     // interval specified in milliseconds by the uniform distribution [a, b].
     rtc::Optional<rtc::IntervalRange> ice_regather_interval_range;
 
+    // Soft budget for the memory of the packet histories and packet buffers
+    // of this PeerConnection, in bytes. While it's exceeded, they stop growing
+    // and shrink where they can. See GetMemoryUsage().
+    rtc::Optional<int> soft_memory_budget_bytes;
+
     // Optional TurnCustomizer.
     // With this class one can modify outgoing TURN messages.
     // The object passed in must remain valid until PeerConnection::Close() is
@@ -747,6 +753,9 @@ class PeerConnectionInterface : public rtc::RefCountInterface {
   // Exposed for testing while waiting for automatic cache clear to work.
   // https://bugs.webrtc.org/8693
   virtual void ClearStatsCache() {}
+  // Returns the memory accounted per subsystem of this PeerConnection, see
+  // MemoryTag. For debugging; this isn't part of the standard stats.
+  virtual MemoryUsage GetMemoryUsage() { return MemoryUsage(); }
 
   // Create a data channel with the provided config, or default config if none
   // is provided. Note that an offer/answer negotiation is still necessary
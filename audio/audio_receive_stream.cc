@@ -63,7 +63,8 @@ namespace {
 std::unique_ptr<voe::ChannelProxy> CreateChannelAndProxy(
     webrtc::AudioState* audio_state,
     ProcessThread* module_process_thread,
-    const webrtc::AudioReceiveStream::Config& config) {
+    const webrtc::AudioReceiveStream::Config& config,
+    MemoryAccountant* memory_accountant) {
   RTC_DCHECK(audio_state);
   internal::AudioState* internal_audio_state =
       static_cast<internal::AudioState*>(audio_state);
@@ -73,7 +74,8 @@ std::unique_ptr<voe::ChannelProxy> CreateChannelAndProxy(
               internal_audio_state->audio_device_module(),
               config.jitter_buffer_max_packets,
               config.jitter_buffer_fast_accelerate,
-              config.decoder_factory))));
+              config.decoder_factory,
+              memory_accountant))));
 }
 }  // namespace
 
@@ -83,7 +85,8 @@ AudioReceiveStream::AudioReceiveStream(
     ProcessThread* module_process_thread,
     const webrtc::AudioReceiveStream::Config& config,
     const rtc::scoped_refptr<webrtc::AudioState>& audio_state,
-    webrtc::RtcEventLog* event_log)
+    webrtc::RtcEventLog* event_log,
+    MemoryAccountant* memory_accountant)
     : AudioReceiveStream(receiver_controller,
                          packet_router,
                          config,
@@ -91,7 +94,8 @@ AudioReceiveStream::AudioReceiveStream(
                          event_log,
                          CreateChannelAndProxy(audio_state.get(),
                                                module_process_thread,
-                                               config)) {}
+                                               config,
+                                               memory_accountant)) {}
 
 AudioReceiveStream::AudioReceiveStream(
     RtpStreamReceiverControllerInterface* receiver_controller,
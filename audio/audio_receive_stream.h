@@ -23,6 +23,7 @@
 #include "rtc_base/thread_checker.h"
 
 namespace webrtc {
+class MemoryAccountant;
 class PacketRouter;
 class ProcessThread;
 class RtcEventLog;
@@ -46,7 +47,8 @@ class AudioReceiveStream final : public webrtc::AudioReceiveStream,
                      ProcessThread* module_process_thread,
                      const webrtc::AudioReceiveStream::Config& config,
                      const rtc::scoped_refptr<webrtc::AudioState>& audio_state,
-                     webrtc::RtcEventLog* event_log);
+                     webrtc::RtcEventLog* event_log,
+                     MemoryAccountant* memory_accountant);
   // For unit tests, which need to supply a mock channel proxy.
   AudioReceiveStream(RtpStreamReceiverControllerInterface* receiver_controller,
                      PacketRouter* packet_router,
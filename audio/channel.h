@@ -41,6 +41,7 @@ class TimestampWrapAroundHandler;
 namespace webrtc {
 
 class AudioDeviceModule;
+class MemoryAccountant;
 class PacketRouter;
 class ProcessThread;
 class RateLimiter;
@@ -153,7 +154,8 @@ class Channel
           AudioDeviceModule* audio_device_module,
           size_t jitter_buffer_max_packets,
           bool jitter_buffer_fast_playout,
-          rtc::scoped_refptr<AudioDecoderFactory> decoder_factory);
+          rtc::scoped_refptr<AudioDecoderFactory> decoder_factory,
+          MemoryAccountant* memory_accountant);
   virtual ~Channel();
 
   void SetSink(AudioSinkInterface* sink);
@@ -20,6 +20,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "system_wrappers/include/clock.h"
+#include "system_wrappers/include/field_trial.h"
 #include "system_wrappers/include/metrics.h"
 
 namespace webrtc {
@@ -38,6 +39,9 @@ const uint32_t kMinToggleBitrateBps = 20000;
 
 const int64_t kBweLogIntervalMs = 5000;
 
+const char kSkipUnchangedUpdatesFieldTrial[] =
+    "WebRTC-BitrateAllocator-SkipUnchangedUpdates";
+
 namespace {
 
 double MediaRatio(uint32_t allocated_bitrate, uint32_t protection_bitrate) {
@@ -56,12 +60,15 @@ BitrateAllocator::BitrateAllocator(LimitObserver* limit_observer)
       last_non_zero_bitrate_bps_(kDefaultBitrateBps),
       last_fraction_loss_(0),
       last_rtt_(0),
+      last_bwe_period_ms_(0),
       num_pause_events_(0),
       clock_(Clock::GetRealTimeClock()),
       last_bwe_log_time_(0),
       total_requested_padding_bitrate_(0),
       total_requested_min_bitrate_(0),
-      bitrate_allocation_strategy_(nullptr) {
+      bitrate_allocation_strategy_(nullptr),
+      skip_unchanged_updates_(
+          field_trial::IsEnabled(kSkipUnchangedUpdatesFieldTrial)) {
   sequenced_checker_.Detach();
 }
 
@@ -75,6 +82,9 @@ void BitrateAllocator::OnNetworkChanged(uint32_t target_bitrate_bps,
                                         int64_t rtt,
                                         int64_t bwe_period_ms) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
+  const bool network_parameters_changed =
+      fraction_loss != last_fraction_loss_ || rtt != last_rtt_ ||
+      bwe_period_ms != last_bwe_period_ms_;
   last_bitrate_bps_ = target_bitrate_bps;
   last_non_zero_bitrate_bps_ =
       target_bitrate_bps > 0 ? target_bitrate_bps : last_non_zero_bitrate_bps_;
@@ -91,8 +101,17 @@ void BitrateAllocator::OnNetworkChanged(uint32_t target_bitrate_bps,
 
   ObserverAllocation allocation = AllocateBitrates(target_bitrate_bps);
 
-  for (auto& config : bitrate_observer_configs_) {
-    uint32_t allocated_bitrate = allocation[config.observer];
+  for (size_t i = 0; i < bitrate_observer_configs_.size(); ++i) {
+    ObserverConfig& config = bitrate_observer_configs_[i];
+    uint32_t allocated_bitrate = allocation[i];
+    // With many streams, most bandwidth updates only move a few allocations.
+    // Optionally don't notify observers that would get the same update again.
+    // Note that this also means that their protection bitrate, and thereby
+    // their media ratio, is only refreshed when something changes.
+    if (skip_unchanged_updates_ && !network_parameters_changed &&
+        config.allocated_bitrate_bps == allocated_bitrate) {
+      continue;
+    }
     uint32_t protection_bitrate = config.observer->OnBitrateUpdated(
         allocated_bitrate, last_fraction_loss_, last_rtt_,
         last_bwe_period_ms_);
@@ -150,13 +169,15 @@ void BitrateAllocator::AddObserver(BitrateAllocatorObserver* observer,
         observer, min_bitrate_bps, max_bitrate_bps, pad_up_bitrate_bps,
         enforce_min_bitrate, track_id, bitrate_priority));
   }
+  UpdateSortedOrders();
 
   ObserverAllocation allocation;
   if (last_bitrate_bps_ > 0) {
     // Calculate a new allocation and update all observers.
     allocation = AllocateBitrates(last_bitrate_bps_);
-    for (auto& config : bitrate_observer_configs_) {
-      uint32_t allocated_bitrate = allocation[config.observer];
+    for (size_t i = 0; i < bitrate_observer_configs_.size(); ++i) {
+      ObserverConfig& config = bitrate_observer_configs_[i];
+      uint32_t allocated_bitrate = allocation[i];
       uint32_t protection_bitrate = config.observer->OnBitrateUpdated(
           allocated_bitrate, last_fraction_loss_, last_rtt_,
           last_bwe_period_ms_);
@@ -213,6 +234,7 @@ void BitrateAllocator::RemoveObserver(BitrateAllocatorObserver* observer) {
   auto it = FindObserverConfig(observer);
   if (it != bitrate_observer_configs_.end()) {
     bitrate_observer_configs_.erase(it);
+    UpdateSortedOrders();
   }
 
   UpdateAllocationLimits();
@@ -242,6 +264,38 @@ void BitrateAllocator::SetBitrateAllocationStrategy(
   bitrate_allocation_strategy_ = std::move(bitrate_allocation_strategy);
 }
 
+void BitrateAllocator::UpdateSortedOrders() {
+  RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
+  const ObserverConfigs& configs = bitrate_observer_configs_;
+  max_bitrate_order_.resize(configs.size());
+  for (size_t i = 0; i < configs.size(); ++i)
+    max_bitrate_order_[i] = i;
+  relative_order_ = max_bitrate_order_;
+
+  // Observers with the same max bitrate are kept in insertion order.
+  std::stable_sort(max_bitrate_order_.begin(), max_bitrate_order_.end(),
+                   [&configs](size_t a, size_t b) {
+                     return configs[a].max_bitrate_bps <
+                            configs[b].max_bitrate_bps;
+                   });
+
+  // We want to sort by which observers will be allocated their full capacity
+  // first. By dividing each observer's capacity by its bitrate priority we
+  // are "normalizing" the capacity of an observer by the rate it will be
+  // filled. This is because the amount allocated is based upon bitrate
+  // priority. We allocate twice as much bitrate to an observer with twice the
+  // bitrate priority of another.
+  auto normalized_capacity = [&configs](size_t i) {
+    uint32_t capacity_bps =
+        configs[i].max_bitrate_bps - configs[i].min_bitrate_bps;
+    return capacity_bps / configs[i].bitrate_priority;
+  };
+  std::stable_sort(relative_order_.begin(), relative_order_.end(),
+                   [&normalized_capacity](size_t a, size_t b) {
+                     return normalized_capacity(a) < normalized_capacity(b);
+                   });
+}
+
 BitrateAllocator::ObserverConfigs::iterator
 BitrateAllocator::FindObserverConfig(const BitrateAllocatorObserver* observer) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
@@ -270,12 +324,8 @@ BitrateAllocator::ObserverAllocation BitrateAllocator::AllocateBitrates(
         bitrate_allocation_strategy_->AllocateBitrates(bitrate, track_configs);
     // The strategy should return allocation for all tracks.
     RTC_CHECK(track_allocations.size() == bitrate_observer_configs_.size());
-    ObserverAllocation allocation;
-    auto track_allocations_it = track_allocations.begin();
-    for (const auto& observer_config : bitrate_observer_configs_) {
-      allocation[observer_config.observer] = *track_allocations_it++;
-    }
-    return allocation;
+    return ObserverAllocation(track_allocations.begin(),
+                              track_allocations.end());
   }
 
   if (bitrate == 0)
@@ -305,38 +355,38 @@ BitrateAllocator::ObserverAllocation BitrateAllocator::AllocateBitrates(
 
 BitrateAllocator::ObserverAllocation BitrateAllocator::ZeroRateAllocation() {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
-  ObserverAllocation allocation;
-  for (const auto& observer_config : bitrate_observer_configs_)
-    allocation[observer_config.observer] = 0;
-  return allocation;
+  return ObserverAllocation(bitrate_observer_configs_.size(), 0);
 }
 
 BitrateAllocator::ObserverAllocation BitrateAllocator::LowRateAllocation(
     uint32_t bitrate) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
-  ObserverAllocation allocation;
+  const size_t num_observers = bitrate_observer_configs_.size();
+  ObserverAllocation allocation(num_observers, 0);
   // Start by allocating bitrate to observers enforcing a min bitrate, hence
   // remaining_bitrate might turn negative.
   int64_t remaining_bitrate = bitrate;
-  for (const auto& observer_config : bitrate_observer_configs_) {
+  for (size_t i = 0; i < num_observers; ++i) {
+    const ObserverConfig& observer_config = bitrate_observer_configs_[i];
     int32_t allocated_bitrate = 0;
     if (observer_config.enforce_min_bitrate)
       allocated_bitrate = observer_config.min_bitrate_bps;
 
-    allocation[observer_config.observer] = allocated_bitrate;
+    allocation[i] = allocated_bitrate;
     remaining_bitrate -= allocated_bitrate;
   }
 
   // Allocate bitrate to all previously active streams.
   if (remaining_bitrate > 0) {
-    for (const auto& observer_config : bitrate_observer_configs_) {
+    for (size_t i = 0; i < num_observers; ++i) {
+      const ObserverConfig& observer_config = bitrate_observer_configs_[i];
       if (observer_config.enforce_min_bitrate ||
           observer_config.LastAllocatedBitrate() == 0)
         continue;
 
       uint32_t required_bitrate = observer_config.MinBitrateWithHysteresis();
       if (remaining_bitrate >= required_bitrate) {
-        allocation[observer_config.observer] = required_bitrate;
+        allocation[i] = required_bitrate;
         remaining_bitrate -= required_bitrate;
       }
     }
@@ -344,14 +394,15 @@ BitrateAllocator::ObserverAllocation BitrateAllocator::LowRateAllocation(
 
   // Allocate bitrate to previously paused streams.
   if (remaining_bitrate > 0) {
-    for (const auto& observer_config : bitrate_observer_configs_) {
+    for (size_t i = 0; i < num_observers; ++i) {
+      const ObserverConfig& observer_config = bitrate_observer_configs_[i];
       if (observer_config.LastAllocatedBitrate() != 0)
         continue;
 
       // Add a hysteresis to avoid toggling.
       uint32_t required_bitrate = observer_config.MinBitrateWithHysteresis();
       if (remaining_bitrate >= required_bitrate) {
-        allocation[observer_config.observer] = required_bitrate;
+        allocation[i] = required_bitrate;
         remaining_bitrate -= required_bitrate;
       }
     }
@@ -377,18 +428,15 @@ BitrateAllocator::ObserverAllocation BitrateAllocator::NormalRateAllocation(
     uint32_t sum_min_bitrates) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
   ObserverAllocation allocation;
-  ObserverAllocation observers_capacities;
-  for (const auto& observer_config : bitrate_observer_configs_) {
-    allocation[observer_config.observer] = observer_config.min_bitrate_bps;
-    observers_capacities[observer_config.observer] =
-        observer_config.max_bitrate_bps - observer_config.min_bitrate_bps;
-  }
+  allocation.reserve(bitrate_observer_configs_.size());
+  for (const auto& observer_config : bitrate_observer_configs_)
+    allocation.push_back(observer_config.min_bitrate_bps);
 
   bitrate -= sum_min_bitrates;
   // From the remaining bitrate, allocate a proportional amount to each observer
   // above the min bitrate already allocated.
   if (bitrate > 0)
-    DistributeBitrateRelatively(bitrate, observers_capacities, &allocation);
+    DistributeBitrateRelatively(bitrate, &allocation);
 
   return allocation;
 }
@@ -398,9 +446,10 @@ BitrateAllocator::ObserverAllocation BitrateAllocator::MaxRateAllocation(
     uint32_t sum_max_bitrates) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
   ObserverAllocation allocation;
+  allocation.reserve(bitrate_observer_configs_.size());
 
   for (const auto& observer_config : bitrate_observer_configs_) {
-    allocation[observer_config.observer] = observer_config.max_bitrate_bps;
+    allocation.push_back(observer_config.max_bitrate_bps);
     bitrate -= observer_config.max_bitrate_bps;
   }
   DistributeBitrateEvenly(bitrate, true, kTransmissionMaxBitrateMultiplier,
@@ -439,32 +488,34 @@ void BitrateAllocator::DistributeBitrateEvenly(uint32_t bitrate,
                                                ObserverAllocation* allocation) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
   RTC_DCHECK_EQ(allocation->size(), bitrate_observer_configs_.size());
+  RTC_DCHECK_EQ(max_bitrate_order_.size(), bitrate_observer_configs_.size());
 
-  ObserverSortingMap list_max_bitrates;
-  for (const auto& observer_config : bitrate_observer_configs_) {
-    if (include_zero_allocations ||
-        allocation->at(observer_config.observer) != 0) {
-      list_max_bitrates.insert(std::pair<uint32_t, const ObserverConfig*>(
-          observer_config.max_bitrate_bps, &observer_config));
-    }
+  size_t num_remaining = 0;
+  for (int allocated_bitrate : *allocation) {
+    if (include_zero_allocations || allocated_bitrate != 0)
+      ++num_remaining;
   }
-  auto it = list_max_bitrates.begin();
-  while (it != list_max_bitrates.end()) {
+  // Visit the observers with the lowest max bitrate first, so that what they
+  // can't fit is carried over to the observers that have more room.
+  for (size_t i : max_bitrate_order_) {
+    if (!include_zero_allocations && (*allocation)[i] == 0)
+      continue;
     RTC_DCHECK_GT(bitrate, 0);
+    const uint32_t max_bitrate_bps =
+        bitrate_observer_configs_[i].max_bitrate_bps;
     uint32_t extra_allocation =
-        bitrate / static_cast<uint32_t>(list_max_bitrates.size());
-    uint32_t total_allocation =
-        extra_allocation + allocation->at(it->second->observer);
+        bitrate / static_cast<uint32_t>(num_remaining);
+    uint32_t total_allocation = extra_allocation + (*allocation)[i];
     bitrate -= extra_allocation;
-    if (total_allocation > max_multiplier * it->first) {
+    if (total_allocation > max_multiplier * max_bitrate_bps) {
       // There is more than we can fit for this observer, carry over to the
       // remaining observers.
-      bitrate += total_allocation - max_multiplier * it->first;
-      total_allocation = max_multiplier * it->first;
+      bitrate += total_allocation - max_multiplier * max_bitrate_bps;
+      total_allocation = max_multiplier * max_bitrate_bps;
     }
     // Finally, update the allocation for this observer.
-    allocation->at(it->second->observer) = total_allocation;
-    it = list_max_bitrates.erase(it);
+    (*allocation)[i] = total_allocation;
+    --num_remaining;
   }
 }
 
@@ -488,76 +539,46 @@ bool BitrateAllocator::EnoughBitrateForAllObservers(uint32_t bitrate,
 
 void BitrateAllocator::DistributeBitrateRelatively(
     uint32_t remaining_bitrate,
-    const ObserverAllocation& observers_capacities,
     ObserverAllocation* allocation) {
   RTC_DCHECK_CALLED_SEQUENTIALLY(&sequenced_checker_);
   RTC_DCHECK_EQ(allocation->size(), bitrate_observer_configs_.size());
-  RTC_DCHECK_EQ(observers_capacities.size(), bitrate_observer_configs_.size());
-
-  struct PriorityRateObserverConfig {
-    PriorityRateObserverConfig(BitrateAllocatorObserver* allocation_key,
-                               uint32_t capacity_bps,
-                               double bitrate_priority)
-        : allocation_key(allocation_key),
-          capacity_bps(capacity_bps),
-          bitrate_priority(bitrate_priority) {}
-
-    BitrateAllocatorObserver* allocation_key;
-    // The amount of bitrate bps that can be allocated to this observer.
-    uint32_t capacity_bps;
-    double bitrate_priority;
-
-    // We want to sort by which observers will be allocated their full capacity
-    // first. By dividing each observer's capacity by its bitrate priority we
-    // are "normalizing" the capacity of an observer by the rate it will be
-    // filled. This is because the amount allocated is based upon bitrate
-    // priority. We allocate twice as much bitrate to an observer with twice the
-    // bitrate priority of another.
-    bool operator<(const PriorityRateObserverConfig& other) const {
-      return capacity_bps / bitrate_priority <
-             other.capacity_bps / other.bitrate_priority;
-    }
-  };
+  RTC_DCHECK_EQ(relative_order_.size(), bitrate_observer_configs_.size());
 
   double bitrate_priority_sum = 0;
-  std::vector<PriorityRateObserverConfig> priority_rate_observers;
-  for (const auto& observer_config : bitrate_observer_configs_) {
-    uint32_t capacity_bps = observers_capacities.at(observer_config.observer);
-    priority_rate_observers.emplace_back(observer_config.observer, capacity_bps,
-                                         observer_config.bitrate_priority);
+  for (const auto& observer_config : bitrate_observer_configs_)
     bitrate_priority_sum += observer_config.bitrate_priority;
-  }
 
   // Iterate in the order observers can be allocated their full capacity.
-  std::sort(priority_rate_observers.begin(), priority_rate_observers.end());
   size_t i;
-  for (i = 0; i < priority_rate_observers.size(); ++i) {
-    const auto& priority_rate_observer = priority_rate_observers[i];
+  for (i = 0; i < relative_order_.size(); ++i) {
+    const ObserverConfig& observer_config =
+        bitrate_observer_configs_[relative_order_[i]];
+    const uint32_t capacity_bps =
+        observer_config.max_bitrate_bps - observer_config.min_bitrate_bps;
     // We allocate the full capacity to an observer only if its relative
     // portion from the remaining bitrate is sufficient to allocate its full
     // capacity. This means we aren't greedily allocating the full capacity, but
     // that it is only done when there is also enough bitrate to allocate the
     // proportional amounts to all other observers.
     double observer_share =
-        priority_rate_observer.bitrate_priority / bitrate_priority_sum;
+        observer_config.bitrate_priority / bitrate_priority_sum;
     double allocation_bps = observer_share * remaining_bitrate;
-    bool enough_bitrate = allocation_bps >= priority_rate_observer.capacity_bps;
+    bool enough_bitrate = allocation_bps >= capacity_bps;
     if (!enough_bitrate)
       break;
-    allocation->at(priority_rate_observer.allocation_key) +=
-        priority_rate_observer.capacity_bps;
-    remaining_bitrate -= priority_rate_observer.capacity_bps;
-    bitrate_priority_sum -= priority_rate_observer.bitrate_priority;
+    (*allocation)[relative_order_[i]] += capacity_bps;
+    remaining_bitrate -= capacity_bps;
+    bitrate_priority_sum -= observer_config.bitrate_priority;
   }
 
   // From the remaining bitrate, allocate the proportional amounts to the
   // observers that aren't allocated their max capacity.
-  for (; i < priority_rate_observers.size(); ++i) {
-    const auto& priority_rate_observer = priority_rate_observers[i];
+  for (; i < relative_order_.size(); ++i) {
+    const ObserverConfig& observer_config =
+        bitrate_observer_configs_[relative_order_[i]];
     double fraction_allocated =
-        priority_rate_observer.bitrate_priority / bitrate_priority_sum;
-    allocation->at(priority_rate_observer.allocation_key) +=
-        fraction_allocated * remaining_bitrate;
+        observer_config.bitrate_priority / bitrate_priority_sum;
+    (*allocation)[relative_order_[i]] += fraction_allocated * remaining_bitrate;
   }
 }
 
@@ -13,7 +13,6 @@
 
 #include <stdint.h>
 
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -64,6 +63,10 @@ class BitrateAllocator {
   ~BitrateAllocator();
 
   // Allocate target_bitrate across the registered BitrateAllocatorObservers.
+  // If the WebRTC-BitrateAllocator-SkipUnchangedUpdates field trial is
+  // enabled, observers are only notified if their allocated bitrate changed or
+  // if any of |fraction_loss|, |rtt| and |bwe_period_ms| changed since the
+  // last call.
   void OnNetworkChanged(uint32_t target_bitrate_bps,
                         uint8_t fraction_loss,
                         int64_t rtt,
@@ -116,21 +119,17 @@ class BitrateAllocator {
         : TrackConfig(min_bitrate_bps,
                       max_bitrate_bps,
                       enforce_min_bitrate,
-                      track_id),
+                      track_id,
+                      bitrate_priority),
           observer(observer),
           pad_up_bitrate_bps(pad_up_bitrate_bps),
           allocated_bitrate_bps(-1),
-          media_ratio(1.0),
-          bitrate_priority(bitrate_priority) {}
+          media_ratio(1.0) {}
 
     BitrateAllocatorObserver* observer;
     uint32_t pad_up_bitrate_bps;
     int64_t allocated_bitrate_bps;
     double media_ratio;  // Part of the total bitrate used for media [0.0, 1.0].
-    // The amount of bitrate allocated to this observer relative to all other
-    // observers. If an observer has twice the bitrate_priority of other
-    // observers, it should be allocated twice the bitrate above its min.
-    double bitrate_priority;
 
     uint32_t LastAllocatedBitrate() const;
     // The minimum bitrate required by this observer, including
@@ -146,8 +145,13 @@ class BitrateAllocator {
   ObserverConfigs::iterator FindObserverConfig(
       const BitrateAllocatorObserver* observer);
 
-  typedef std::multimap<uint32_t, const ObserverConfig*> ObserverSortingMap;
-  typedef std::map<BitrateAllocatorObserver*, int> ObserverAllocation;
+  // Allocated bitrate per observer, with the same indexing as
+  // |bitrate_observer_configs_|.
+  typedef std::vector<int> ObserverAllocation;
+
+  // Rebuilds |max_bitrate_order_| and |relative_order_|. Must be called
+  // whenever an observer config is added, changed or removed.
+  void UpdateSortedOrders();
 
   ObserverAllocation AllocateBitrates(uint32_t bitrate);
 
@@ -169,7 +173,7 @@ class BitrateAllocator {
   // Splits |bitrate| evenly to observers already in |allocation|.
   // |include_zero_allocations| decides if zero allocations should be part of
   // the distribution or not. The allowed max bitrate is |max_multiplier| x
-  // observer max bitrate.
+  // observer max bitrate. Observers are visited in |max_bitrate_order_|.
   void DistributeBitrateEvenly(uint32_t bitrate,
                                bool include_zero_allocations,
                                int max_multiplier,
@@ -182,16 +186,21 @@ class BitrateAllocator {
   // more than the observer's capacity, it will be allocated its capacity, and
   // the excess bitrate is still allocated proportionally to other observers.
   // Allocating the proportional amount means an observer with twice the
-  // bitrate_priority of another will be allocated twice the bitrate.
-  void DistributeBitrateRelatively(
-      uint32_t bitrate,
-      const ObserverAllocation& observers_capacities,
-      ObserverAllocation* allocation);
+  // bitrate_priority of another will be allocated twice the bitrate. The
+  // capacity of an observer is its max bitrate minus its min bitrate.
+  void DistributeBitrateRelatively(uint32_t bitrate,
+                                   ObserverAllocation* allocation);
 
   rtc::SequencedTaskChecker sequenced_checker_;
   LimitObserver* const limit_observer_ RTC_GUARDED_BY(&sequenced_checker_);
   // Stored in a list to keep track of the insertion order.
   ObserverConfigs bitrate_observer_configs_ RTC_GUARDED_BY(&sequenced_checker_);
+  // Indices into |bitrate_observer_configs_|, sorted by max bitrate and by
+  // capacity relative to bitrate priority respectively. They only depend on
+  // the observer configs, so they are kept between allocations instead of
+  // being sorted for every bandwidth update.
+  std::vector<size_t> max_bitrate_order_ RTC_GUARDED_BY(&sequenced_checker_);
+  std::vector<size_t> relative_order_ RTC_GUARDED_BY(&sequenced_checker_);
   uint32_t last_bitrate_bps_ RTC_GUARDED_BY(&sequenced_checker_);
   uint32_t last_non_zero_bitrate_bps_ RTC_GUARDED_BY(&sequenced_checker_);
   uint8_t last_fraction_loss_ RTC_GUARDED_BY(&sequenced_checker_);
@@ -205,6 +214,7 @@ class BitrateAllocator {
   uint32_t total_requested_min_bitrate_ RTC_GUARDED_BY(&sequenced_checker_);
   std::unique_ptr<rtc::BitrateAllocationStrategy> bitrate_allocation_strategy_
       RTC_GUARDED_BY(&sequenced_checker_);
+  const bool skip_unchanged_updates_;
 };
 
 }  // namespace webrtc
@@ -10,12 +10,16 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "call/bitrate_allocator.h"
 #include "modules/bitrate_controller/include/bitrate_controller.h"
+#include "rtc_base/timeutils.h"
+#include "test/field_trial.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 using ::testing::NiceMock;
 using ::testing::_;
@@ -36,7 +40,8 @@ class TestBitrateObserver : public BitrateAllocatorObserver {
         last_fraction_loss_(0),
         last_rtt_ms_(0),
         last_probing_interval_ms_(0),
-        protection_ratio_(0.0) {}
+        protection_ratio_(0.0),
+        num_updates_(0) {}
 
   void SetBitrateProtectionRatio(double protection_ratio) {
     protection_ratio_ = protection_ratio;
@@ -50,6 +55,7 @@ class TestBitrateObserver : public BitrateAllocatorObserver {
     last_fraction_loss_ = fraction_loss;
     last_rtt_ms_ = rtt;
     last_probing_interval_ms_ = probing_interval_ms;
+    ++num_updates_;
     return bitrate_bps * protection_ratio_;
   }
   uint32_t last_bitrate_bps_;
@@ -57,6 +63,7 @@ class TestBitrateObserver : public BitrateAllocatorObserver {
   int64_t last_rtt_ms_;
   int last_probing_interval_ms_;
   double protection_ratio_;
+  int num_updates_;
 };
 
 namespace {
@@ -796,4 +803,74 @@ TEST_F(BitrateAllocatorTest, PriorityRateThreeObserversTwoAllocatedToMax) {
   allocator_->RemoveObserver(&observer_high);
 }
 
+TEST(BitrateAllocatorSkipUnchangedUpdatesTest, OnlyNotifiesChangedObservers) {
+  test::ScopedFieldTrials field_trials(
+      "WebRTC-BitrateAllocator-SkipUnchangedUpdates/Enabled/");
+  NiceMock<MockLimitObserver> limit_observer;
+  BitrateAllocator allocator(&limit_observer);
+  allocator.OnNetworkChanged(300000u, 0, 0, kDefaultProbingIntervalMs);
+  TestBitrateObserver observer_capped;
+  TestBitrateObserver observer_uncapped;
+  allocator.AddObserver(&observer_capped, 30000, 100000, 0, true, "",
+                        kDefaultBitratePriority);
+  allocator.AddObserver(&observer_uncapped, 30000, 1000000, 0, true, "",
+                        kDefaultBitratePriority);
+  EXPECT_EQ(100000u, observer_capped.last_bitrate_bps_);
+  EXPECT_EQ(200000u, observer_uncapped.last_bitrate_bps_);
+  int capped_updates = observer_capped.num_updates_;
+  int uncapped_updates = observer_uncapped.num_updates_;
+
+  // Only the uncapped observer gets more bitrate.
+  allocator.OnNetworkChanged(310000u, 0, 0, kDefaultProbingIntervalMs);
+  EXPECT_EQ(capped_updates, observer_capped.num_updates_);
+  EXPECT_EQ(uncapped_updates + 1, observer_uncapped.num_updates_);
+  EXPECT_EQ(210000u, observer_uncapped.last_bitrate_bps_);
+
+  // A changed rtt is passed on to all observers.
+  allocator.OnNetworkChanged(310000u, 0, 50, kDefaultProbingIntervalMs);
+  EXPECT_EQ(capped_updates + 1, observer_capped.num_updates_);
+  EXPECT_EQ(uncapped_updates + 2, observer_uncapped.num_updates_);
+  EXPECT_EQ(50, observer_capped.last_rtt_ms_);
+
+  allocator.RemoveObserver(&observer_capped);
+  allocator.RemoveObserver(&observer_uncapped);
+}
+
+TEST(BitrateAllocatorPerfTest, DISABLED_OnNetworkChangedThousandObservers) {
+  const size_t kNumObservers = 1000;
+  const int kNumUpdates = 1000;
+  NiceMock<MockLimitObserver> limit_observer;
+  BitrateAllocator allocator(&limit_observer);
+  allocator.OnNetworkChanged(300000000u, 0, 0, kDefaultProbingIntervalMs);
+  std::vector<TestBitrateObserver> observers(kNumObservers);
+  for (size_t i = 0; i < kNumObservers; ++i) {
+    // Mix of observers with different limits and priorities, similar to a
+    // call with both thumbnails and high resolution streams.
+    uint32_t min_bitrate_bps = 30000 + (i % 5) * 20000;
+    uint32_t max_bitrate_bps = 150000 + (i % 7) * 300000;
+    double bitrate_priority = 1.0 + (i % 3);
+    allocator.AddObserver(&observers[i], min_bitrate_bps, max_bitrate_bps, 0,
+                          false, std::to_string(i), bitrate_priority);
+  }
+
+  const uint32_t kBitratesBps[] = {100000000, 300000000, 1000000000};
+  for (uint32_t bitrate_bps : kBitratesBps) {
+    const int64_t start_ns = rtc::TimeNanos();
+    for (int i = 0; i < kNumUpdates; ++i) {
+      // Small changes around the target, as typical for BWE updates.
+      allocator.OnNetworkChanged(bitrate_bps + (i % 10) * 10000, 0, 0,
+                                 kDefaultProbingIntervalMs);
+    }
+    const int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+    test::PrintResult("bitrate_allocator_on_network_changed",
+                      "_" + std::to_string(kNumObservers) + "_observers",
+                      std::to_string(bitrate_bps / 1000000) + "_mbps",
+                      static_cast<double>(elapsed_ns) / kNumUpdates / 1000,
+                      "us", false);
+  }
+
+  for (auto& observer : observers)
+    allocator.RemoveObserver(&observer);
+}
+
 }  // namespace webrtc
@@ -49,6 +49,7 @@
 #include "rtc_base/location.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/ptr_util.h"
+#include "rtc_base/rcu_snapshot.h"
 #include "rtc_base/sequenced_task_checker.h"
 #include "rtc_base/task_queue.h"
 #include "rtc_base/thread_annotations.h"
@@ -251,8 +252,8 @@ class Call : public webrtc::Call,
       RTC_EXCLUSIVE_LOCKS_REQUIRED(receive_crit_);
 
   void NotifyBweOfReceivedPacket(const RtpPacketReceived& packet,
-                                 MediaType media_type)
-      RTC_SHARED_LOCKS_REQUIRED(receive_crit_);
+                                 MediaType media_type,
+                                 bool use_send_side_bwe);
 
   void UpdateSendHistograms(int64_t first_sent_packet_ms)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(&bitrate_crit_);
@@ -264,6 +265,11 @@ class Call : public webrtc::Call,
   // bandwidth estimation from |new_start| if set.
   void UpdateCurrentBitrateConfig(const rtc::Optional<int>& new_start);
 
+  // Copies the stream maps into a new |routing_table_|. Returns once no packet
+  // delivery can see the previous table, so that streams no longer in the maps
+  // can be deleted.
+  void PublishRoutingTable();
+
   Clock* const clock_;
 
   const int num_cpu_cores_;
@@ -325,6 +331,18 @@ class Call : public webrtc::Call,
       RTC_GUARDED_BY(send_crit_);
   std::set<VideoSendStream*> video_send_streams_ RTC_GUARDED_BY(send_crit_);
 
+  // The streams and configs needed to route received packets, so that packet
+  // delivery takes neither |receive_crit_| nor |send_crit_|. Republished
+  // whenever a stream is created or destroyed.
+  struct RoutingTable {
+    std::map<uint32_t, ReceiveRtpConfig> receive_rtp_config;
+    std::vector<AudioReceiveStream*> audio_receive_streams;
+    std::vector<VideoReceiveStream*> video_receive_streams;
+    std::vector<AudioSendStream*> audio_send_streams;
+    std::vector<VideoSendStream*> video_send_streams;
+  };
+  rtc::RcuSnapshot<RoutingTable> routing_table_;
+
   using RtpStateMap = std::map<uint32_t, RtpState>;
   RtpStateMap suspended_audio_send_ssrcs_
       RTC_GUARDED_BY(configuration_sequence_checker_);
@@ -625,6 +643,7 @@ webrtc::AudioSendStream* Call::CreateAudioSendStream(
                audio_send_ssrcs_.end());
     audio_send_ssrcs_[config.rtp.ssrc] = send_stream;
   }
+  PublishRoutingTable();
   {
     ReadLockScoped read_lock(*receive_crit_);
     for (AudioReceiveStream* stream : audio_receive_streams_) {
@@ -654,6 +673,7 @@ void Call::DestroyAudioSendStream(webrtc::AudioSendStream* send_stream) {
     size_t num_deleted = audio_send_ssrcs_.erase(ssrc);
     RTC_DCHECK_EQ(1, num_deleted);
   }
+  PublishRoutingTable();
   {
     ReadLockScoped read_lock(*receive_crit_);
     for (AudioReceiveStream* stream : audio_receive_streams_) {
@@ -675,7 +695,8 @@ webrtc::AudioReceiveStream* Call::CreateAudioReceiveStream(
       CreateRtcLogStreamConfig(config)));
   AudioReceiveStream* receive_stream = new AudioReceiveStream(
       &audio_receiver_controller_, transport_send_->packet_router(),
-      module_process_thread_.get(), config, config_.audio_state, event_log_);
+      module_process_thread_.get(), config, config_.audio_state, event_log_,
+      config_.memory_accountant.get());
   {
     WriteLockScoped write_lock(*receive_crit_);
     receive_rtp_config_[config.rtp.remote_ssrc] =
@@ -684,6 +705,7 @@ webrtc::AudioReceiveStream* Call::CreateAudioReceiveStream(
 
     ConfigureSync(config.sync_group);
   }
+  PublishRoutingTable();
   {
     ReadLockScoped read_lock(*send_crit_);
     auto it = audio_send_ssrcs_.find(config.rtp.local_ssrc);
@@ -719,6 +741,7 @@ void Call::DestroyAudioReceiveStream(
     }
     receive_rtp_config_.erase(ssrc);
   }
+  PublishRoutingTable();
   UpdateAggregateNetworkState();
   delete audio_receive_stream;
 }
@@ -752,7 +775,8 @@ webrtc::VideoSendStream* Call::CreateVideoSendStream(
   VideoSendStream* send_stream = new VideoSendStream(
       num_cpu_cores_, module_process_thread_.get(), &worker_queue_,
       call_stats_.get(), transport_send_.get(), bitrate_allocator_.get(),
-      video_send_delay_stats_.get(), event_log_, std::move(config),
+      video_send_delay_stats_.get(), event_log_,
+      config_.memory_accountant.get(), std::move(config),
       std::move(encoder_config), suspended_video_send_ssrcs_,
       suspended_video_payload_states_, std::move(fec_controller));
 
@@ -764,6 +788,7 @@ webrtc::VideoSendStream* Call::CreateVideoSendStream(
     }
     video_send_streams_.insert(send_stream);
   }
+  PublishRoutingTable();
   send_stream->SignalNetworkState(video_network_state_);
   UpdateAggregateNetworkState();
 
@@ -792,6 +817,7 @@ void Call::DestroyVideoSendStream(webrtc::VideoSendStream* send_stream) {
     video_send_streams_.erase(send_stream_impl);
   }
   RTC_CHECK(send_stream_impl != nullptr);
+  PublishRoutingTable();
 
   VideoSendStream::RtpStateMap rtp_states;
   VideoSendStream::RtpPayloadStateMap rtp_payload_states;
@@ -816,7 +842,8 @@ webrtc::VideoReceiveStream* Call::CreateVideoReceiveStream(
   VideoReceiveStream* receive_stream = new VideoReceiveStream(
       &video_receiver_controller_, num_cpu_cores_,
       transport_send_->packet_router(), std::move(configuration),
-      module_process_thread_.get(), call_stats_.get());
+      module_process_thread_.get(), call_stats_.get(),
+      config_.memory_accountant.get());
 
   const webrtc::VideoReceiveStream::Config& config = receive_stream->config();
   ReceiveRtpConfig receive_config(config.rtp.extensions,
@@ -834,6 +861,7 @@ webrtc::VideoReceiveStream* Call::CreateVideoReceiveStream(
     video_receive_streams_.insert(receive_stream);
     ConfigureSync(config.sync_group);
   }
+  PublishRoutingTable();
   receive_stream->SignalNetworkState(video_network_state_);
   UpdateAggregateNetworkState();
   event_log_->Log(rtc::MakeUnique<RtcEventVideoReceiveStreamConfig>(
@@ -860,6 +888,7 @@ void Call::DestroyVideoReceiveStream(
     video_receive_streams_.erase(receive_stream_impl);
     ConfigureSync(config.sync_group);
   }
+  PublishRoutingTable();
 
   receive_side_cc_.GetRemoteBitrateEstimator(UseSendSideBwe(config))
       ->RemoveStream(config.rtp.remote_ssrc);
@@ -881,12 +910,9 @@ FlexfecReceiveStream* Call::CreateFlexfecReceiveStream(
     // Unlike the video and audio receive streams,
     // FlexfecReceiveStream implements RtpPacketSinkInterface itself,
     // and hence its constructor passes its |this| pointer to
-    // video_receiver_controller_->CreateStream(). Calling the
-    // constructor while holding |receive_crit_| ensures that we don't
-    // call OnRtpPacket until the constructor is finished and the
-    // object is in a valid state.
-    // TODO(nisse): Fix constructor so that it can be moved outside of
-    // this locked scope.
+    // video_receiver_controller_->CreateStream(). Its ssrc is only added to
+    // |routing_table_| below, which ensures that we don't call OnRtpPacket
+    // until the constructor is finished and the object is in a valid state.
     receive_stream = new FlexfecReceiveStreamImpl(
         &video_receiver_controller_, config, recovered_packet_receiver,
         call_stats_->rtcp_rtt_stats(), module_process_thread_.get());
@@ -896,6 +922,7 @@ FlexfecReceiveStream* Call::CreateFlexfecReceiveStream(
     receive_rtp_config_[config.remote_ssrc] =
         ReceiveRtpConfig(config.rtp_header_extensions, UseSendSideBwe(config));
   }
+  PublishRoutingTable();
 
   // TODO(brandtr): Store config in RtcEventLog here.
 
@@ -919,6 +946,7 @@ void Call::DestroyFlexfecReceiveStream(FlexfecReceiveStream* receive_stream) {
     receive_side_cc_.GetRemoteBitrateEstimator(UseSendSideBwe(config))
         ->RemoveStream(ssrc);
   }
+  PublishRoutingTable();
 
   delete receive_stream;
 }
@@ -1303,31 +1331,28 @@ PacketReceiver::DeliveryStatus Call::DeliverRtcp(MediaType media_type,
     received_rtcp_bytes_per_second_counter_.Add(static_cast<int>(length));
   }
   bool rtcp_delivered = false;
+  rtc::RcuSnapshot<RoutingTable>::ReadScope table(&routing_table_);
   if (media_type == MediaType::ANY || media_type == MediaType::VIDEO) {
-    ReadLockScoped read_lock(*receive_crit_);
-    for (VideoReceiveStream* stream : video_receive_streams_) {
+    for (VideoReceiveStream* stream : table->video_receive_streams) {
       if (stream->DeliverRtcp(packet, length))
         rtcp_delivered = true;
     }
   }
   if (media_type == MediaType::ANY || media_type == MediaType::AUDIO) {
-    ReadLockScoped read_lock(*receive_crit_);
-    for (AudioReceiveStream* stream : audio_receive_streams_) {
+    for (AudioReceiveStream* stream : table->audio_receive_streams) {
       if (stream->DeliverRtcp(packet, length))
         rtcp_delivered = true;
     }
   }
   if (media_type == MediaType::ANY || media_type == MediaType::VIDEO) {
-    ReadLockScoped read_lock(*send_crit_);
-    for (VideoSendStream* stream : video_send_streams_) {
+    for (VideoSendStream* stream : table->video_send_streams) {
       if (stream->DeliverRtcp(packet, length))
         rtcp_delivered = true;
     }
   }
   if (media_type == MediaType::ANY || media_type == MediaType::AUDIO) {
-    ReadLockScoped read_lock(*send_crit_);
-    for (auto& kv : audio_send_ssrcs_) {
-      if (kv.second->DeliverRtcp(packet, length))
+    for (AudioSendStream* stream : table->audio_send_streams) {
+      if (stream->DeliverRtcp(packet, length))
         rtcp_delivered = true;
     }
   }
@@ -1363,22 +1388,24 @@ PacketReceiver::DeliveryStatus Call::DeliverRtp(MediaType media_type,
   RTC_DCHECK(media_type == MediaType::AUDIO || media_type == MediaType::VIDEO ||
              is_keep_alive_packet);
 
-  ReadLockScoped read_lock(*receive_crit_);
-  auto it = receive_rtp_config_.find(parsed_packet.Ssrc());
-  if (it == receive_rtp_config_.end()) {
+  rtc::RcuSnapshot<RoutingTable>::ReadScope table(&routing_table_);
+  auto it = table->receive_rtp_config.find(parsed_packet.Ssrc());
+  if (it == table->receive_rtp_config.end()) {
     RTC_LOG(LS_ERROR) << "receive_rtp_config_ lookup failed for ssrc "
                       << parsed_packet.Ssrc();
-    // Destruction of the receive stream, including deregistering from the
-    // RtpDemuxer, is not protected by the |receive_crit_| lock. But
-    // deregistering in the |receive_rtp_config_| map is protected by that lock.
-    // So by not passing the packet on to demuxing in this case, we prevent
-    // incoming packets to be passed on via the demuxer to a receive stream
-    // which is being torned down.
+    // Receive streams are deleted only after a routing table without their
+    // ssrcs has been published, and every delivery that could still see the
+    // previous table has returned. So by not passing the packet on to
+    // demuxing in this case, we prevent incoming packets to be passed on via
+    // the demuxer to a receive stream which is being torn down.
     return DELIVERY_UNKNOWN_SSRC;
   }
   parsed_packet.IdentifyExtensions(it->second.extensions);
+  // Parse the extensions once for all the receivers below.
+  parsed_packet.ResolveHeader();
 
-  NotifyBweOfReceivedPacket(parsed_packet, media_type);
+  NotifyBweOfReceivedPacket(parsed_packet, media_type,
+                            it->second.use_send_side_bwe);
 
   // RateCounters expect input parameter as int, save it as int,
   // instead of converting each time it is passed to RateCounter::Add below.
@@ -1431,31 +1458,49 @@ void Call::OnRecoveredPacket(const uint8_t* packet, size_t length) {
 
   parsed_packet.set_recovered(true);
 
-  ReadLockScoped read_lock(*receive_crit_);
-  auto it = receive_rtp_config_.find(parsed_packet.Ssrc());
-  if (it == receive_rtp_config_.end()) {
+  rtc::RcuSnapshot<RoutingTable>::ReadScope table(&routing_table_);
+  auto it = table->receive_rtp_config.find(parsed_packet.Ssrc());
+  if (it == table->receive_rtp_config.end()) {
     RTC_LOG(LS_ERROR) << "receive_rtp_config_ lookup failed for ssrc "
                       << parsed_packet.Ssrc();
-    // Destruction of the receive stream, including deregistering from the
-    // RtpDemuxer, is not protected by the |receive_crit_| lock. But
-    // deregistering in the |receive_rtp_config_| map is protected by that lock.
-    // So by not passing the packet on to demuxing in this case, we prevent
-    // incoming packets to be passed on via the demuxer to a receive stream
-    // which is being torned down.
+    // Receive streams are deleted only after a routing table without their
+    // ssrcs has been published, and every delivery that could still see the
+    // previous table has returned. So by not passing the packet on to
+    // demuxing in this case, we prevent incoming packets to be passed on via
+    // the demuxer to a receive stream which is being torn down.
     return;
   }
   parsed_packet.IdentifyExtensions(it->second.extensions);
+  parsed_packet.ResolveHeader();
 
   // TODO(brandtr): Update here when we support protecting audio packets too.
   video_receiver_controller_.OnRtpPacket(parsed_packet);
 }
 
-void Call::NotifyBweOfReceivedPacket(const RtpPacketReceived& packet,
-                                     MediaType media_type) {
-  auto it = receive_rtp_config_.find(packet.Ssrc());
-  bool use_send_side_bwe =
-      (it != receive_rtp_config_.end()) && it->second.use_send_side_bwe;
+void Call::PublishRoutingTable() {
+  RTC_DCHECK_CALLED_SEQUENTIALLY(&configuration_sequence_checker_);
+  std::unique_ptr<RoutingTable> table(new RoutingTable());
+  {
+    ReadLockScoped read_lock(*receive_crit_);
+    table->receive_rtp_config = receive_rtp_config_;
+    table->audio_receive_streams.assign(audio_receive_streams_.begin(),
+                                        audio_receive_streams_.end());
+    table->video_receive_streams.assign(video_receive_streams_.begin(),
+                                        video_receive_streams_.end());
+  }
+  {
+    ReadLockScoped read_lock(*send_crit_);
+    for (const auto& kv : audio_send_ssrcs_)
+      table->audio_send_streams.push_back(kv.second);
+    table->video_send_streams.assign(video_send_streams_.begin(),
+                                     video_send_streams_.end());
+  }
+  routing_table_.Publish(std::move(table));
+}
 
+void Call::NotifyBweOfReceivedPacket(const RtpPacketReceived& packet,
+                                     MediaType media_type,
+                                     bool use_send_side_bwe) {
   RTPHeader header;
   packet.GetHeader(&header);
 
@@ -27,6 +27,7 @@
 #include "common_types.h"  // NOLINT(build/include)
 #include "rtc_base/bitrateallocationstrategy.h"
 #include "rtc_base/copyonwritebuffer.h"
+#include "rtc_base/memory_accountant.h"
 #include "rtc_base/networkroute.h"
 #include "rtc_base/platform_file.h"
 #include "rtc_base/socket.h"
@@ -114,6 +115,10 @@ class Call {
     // RtcEventLog to use for this call. Required.
     // Use webrtc::RtcEventLog::CreateNull() for a null implementation.
     RtcEventLog* event_log = nullptr;
+
+    // Accounts the memory of the packet buffers of the streams of this call.
+    // Optional.
+    rtc::scoped_refptr<MemoryAccountant> memory_accountant;
   };
 
   struct Stats {
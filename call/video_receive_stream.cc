@@ -46,6 +46,7 @@ std::string VideoReceiveStream::Stats::ToString(int64_t time_ms) const {
   ss << "render_fps: " << render_frame_rate << ", ";
   ss << "decode_ms: " << decode_ms << ", ";
   ss << "max_decode_ms: " << max_decode_ms << ", ";
+  ss << "decoder_frame_buffer_bytes: " << decoder_frame_buffer_bytes << ", ";
   ss << "cur_delay_ms: " << current_delay_ms << ", ";
   ss << "targ_delay_ms: " << target_delay_ms << ", ";
   ss << "jb_delay_ms: " << jitter_buffer_ms << ", ";
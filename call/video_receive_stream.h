@@ -83,6 +83,10 @@ class VideoReceiveStream {
     int64_t interframe_delay_max_ms = -1;
     uint32_t frames_decoded = 0;
     rtc::Optional<uint64_t> qp_sum;
+    // Memory held by the frame buffer pools of all decoders in the process,
+    // which share one limit, and the allocations refused because of it.
+    size_t decoder_frame_buffer_bytes = 0;
+    uint32_t decoder_frame_buffer_failed_allocations = 0;
 
     int current_payload_type = -1;
 
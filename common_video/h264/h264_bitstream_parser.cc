@@ -9,10 +9,10 @@
  */
 #include "common_video/h264/h264_bitstream_parser.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
-#include "rtc_base/bitbuffer.h"
 #include "rtc_base/checks.h"
 
 #include "common_video/h264/h264_common.h"
@@ -45,13 +45,13 @@ H264BitstreamParser::Result H264BitstreamParser::ParseNonParameterSetNalu(
     return kInvalidStream;
 
   last_slice_qp_delta_ = rtc::nullopt;
-  const std::vector<uint8_t> slice_rbsp =
-      H264::ParseRbsp(source, source_length);
-  if (slice_rbsp.size() < H264::kNaluTypeSize)
+  if (source_length < H264::kNaluTypeSize)
     return kInvalidStream;
 
-  rtc::BitBuffer slice_reader(slice_rbsp.data() + H264::kNaluTypeSize,
-                              slice_rbsp.size() - H264::kNaluTypeSize);
+  // Only the slice header is read, so skip the emulation bytes while reading
+  // rather than unescaping the whole, possibly very large, slice.
+  H264::RbspBitReader slice_reader(source + H264::kNaluTypeSize,
+                                   source_length - H264::kNaluTypeSize);
   // Check to see if this is an IDR slice, which has an extra field to parse
   // out.
   bool is_idr = (source[0] & 0x0F) == H264::NaluType::kIdr;
@@ -266,23 +266,45 @@ H264BitstreamParser::Result H264BitstreamParser::ParseNonParameterSetNalu(
   return kOk;
 }
 
+void H264BitstreamParser::ParseSps(const uint8_t* sps, size_t length) {
+  if (sps_ && length == sps_nalu_.size() &&
+      std::equal(sps, sps + length, sps_nalu_.begin())) {
+    return;
+  }
+  sps_ = SpsParser::ParseSps(sps + H264::kNaluTypeSize,
+                             length - H264::kNaluTypeSize);
+  if (!sps_) {
+    RTC_LOG(LS_WARNING) << "Unable to parse SPS from H264 bitstream.";
+    sps_nalu_.clear();
+    return;
+  }
+  sps_nalu_.assign(sps, sps + length);
+}
+
+void H264BitstreamParser::ParsePps(const uint8_t* pps, size_t length) {
+  if (pps_ && length == pps_nalu_.size() &&
+      std::equal(pps, pps + length, pps_nalu_.begin())) {
+    return;
+  }
+  pps_ = PpsParser::ParsePps(pps + H264::kNaluTypeSize,
+                             length - H264::kNaluTypeSize);
+  if (!pps_) {
+    RTC_LOG(LS_WARNING) << "Unable to parse PPS from H264 bitstream.";
+    pps_nalu_.clear();
+    return;
+  }
+  pps_nalu_.assign(pps, pps + length);
+}
+
 void H264BitstreamParser::ParseSlice(const uint8_t* slice, size_t length) {
   H264::NaluType nalu_type = H264::ParseNaluType(slice[0]);
   switch (nalu_type) {
-    case H264::NaluType::kSps: {
-      sps_ = SpsParser::ParseSps(slice + H264::kNaluTypeSize,
-                                 length - H264::kNaluTypeSize);
-      if (!sps_)
-        RTC_LOG(LS_WARNING) << "Unable to parse SPS from H264 bitstream.";
+    case H264::NaluType::kSps:
+      ParseSps(slice, length);
       break;
-    }
-    case H264::NaluType::kPps: {
-      pps_ = PpsParser::ParsePps(slice + H264::kNaluTypeSize,
-                                 length - H264::kNaluTypeSize);
-      if (!pps_)
-        RTC_LOG(LS_WARNING) << "Unable to parse PPS from H264 bitstream.";
+    case H264::NaluType::kPps:
+      ParsePps(slice, length);
       break;
-    }
     case H264::NaluType::kAud:
     case H264::NaluType::kSei:
       break;  // Ignore these nalus, as we don't care about their contents.
@@ -296,12 +318,42 @@ void H264BitstreamParser::ParseSlice(const uint8_t* slice, size_t length) {
 
 void H264BitstreamParser::ParseBitstream(const uint8_t* bitstream,
                                          size_t length) {
-  std::vector<H264::NaluIndex> nalu_indices =
-      H264::FindNaluIndices(bitstream, length);
-  for (const H264::NaluIndex& index : nalu_indices)
+  H264::FindNaluIndices(bitstream, length, &nalu_indices_);
+  for (const H264::NaluIndex& index : nalu_indices_)
     ParseSlice(&bitstream[index.payload_start_offset], index.payload_size);
 }
 
+void H264BitstreamParser::ParseFirstSlice(const uint8_t* bitstream,
+                                          size_t length) {
+  H264::NaluIndex index;
+  if (!H264::FindNextNaluIndex(bitstream, length, 0, &index))
+    return;
+  while (true) {
+    const uint8_t* nalu = &bitstream[index.payload_start_offset];
+    switch (H264::ParseNaluType(nalu[0])) {
+      case H264::NaluType::kSlice:
+      case H264::NaluType::kIdr:
+        // The slice runs to the end of the buffer as far as we know, which
+        // is fine since only its header is read.
+        ParseSlice(nalu, index.payload_size);
+        return;
+      default:
+        break;
+    }
+    // Parameter sets and the like are small, so finding where they end is
+    // cheap.
+    H264::NaluIndex next;
+    const bool has_next = H264::FindNextNaluIndex(
+        bitstream, length, index.payload_start_offset, &next);
+    if (has_next)
+      index.payload_size = next.start_offset - index.payload_start_offset;
+    ParseSlice(nalu, index.payload_size);
+    if (!has_next)
+      return;
+    index = next;
+  }
+}
+
 bool H264BitstreamParser::GetLastSliceQp(int* qp) const {
   if (!last_slice_qp_delta_ || !pps_)
     return false;
@@ -13,7 +13,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <vector>
+
 #include "api/optional.h"
+#include "common_video/h264/h264_common.h"
 #include "common_video/h264/pps_parser.h"
 #include "common_video/h264/sps_parser.h"
 
@@ -43,11 +46,21 @@ class H264BitstreamParser {
   // Parse an additional chunk of H264 bitstream.
   void ParseBitstream(const uint8_t* bitstream, size_t length);
 
+  // Like ParseBitstream(), but stops at the first slice of |bitstream|: the
+  // parameter sets in front of it and its header are parsed, and the rest of
+  // the frame is never looked at. Enough to get the QP for quality scaling,
+  // as encoders use the same QP, or close to it, for all slices of a frame.
+  void ParseFirstSlice(const uint8_t* bitstream, size_t length);
+
   // Get the last extracted QP value from the parsed bitstream.
   bool GetLastSliceQp(int* qp) const;
 
  protected:
   void ParseSlice(const uint8_t* slice, size_t length);
+  // Parses an SPS or PPS, unless it is identical to the last one parsed, as
+  // encoders repeat them in front of every key frame.
+  void ParseSps(const uint8_t* sps, size_t length);
+  void ParsePps(const uint8_t* pps, size_t length);
   Result ParseNonParameterSetNalu(const uint8_t* source,
                                   size_t source_length,
                                   uint8_t nalu_type);
@@ -55,9 +68,15 @@ class H264BitstreamParser {
   // SPS/PPS state, updated when parsing new SPS/PPS, used to parse slices.
   rtc::Optional<SpsParser::SpsState> sps_;
   rtc::Optional<PpsParser::PpsState> pps_;
+  // The NALUs |sps_| and |pps_| were parsed from.
+  std::vector<uint8_t> sps_nalu_;
+  std::vector<uint8_t> pps_nalu_;
 
   // Last parsed slice QP.
   rtc::Optional<int32_t> last_slice_qp_delta_;
+
+  // Reused between calls to ParseBitstream to not allocate for every frame.
+  std::vector<H264::NaluIndex> nalu_indices_;
 };
 
 }  // namespace webrtc
@@ -10,7 +10,14 @@
 
 #include "common_video/h264/h264_bitstream_parser.h"
 
+#include <vector>
+
+#include "common_video/h264/h264_common.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -85,4 +92,104 @@ TEST(H264BitstreamParserTest, ReportsLastSliceQpForCABACImageSlices) {
   EXPECT_EQ(24, qp);
 }
 
+TEST(H264BitstreamParserTest, ParseFirstSliceReportsSameQpAsParseBitstream) {
+  H264BitstreamParser h264_parser;
+  h264_parser.ParseFirstSlice(kH264SpsPps, sizeof(kH264SpsPps));
+  int qp;
+  EXPECT_FALSE(h264_parser.GetLastSliceQp(&qp));
+
+  h264_parser.ParseFirstSlice(kH264BitstreamChunk,
+                              sizeof(kH264BitstreamChunk));
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(35, qp);
+
+  // SPS and PPS are kept from the previous frame.
+  h264_parser.ParseFirstSlice(kH264BitstreamNextImageSliceChunk,
+                              sizeof(kH264BitstreamNextImageSliceChunk));
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(37, qp);
+
+  H264BitstreamParser cabac_parser;
+  cabac_parser.ParseFirstSlice(kH264BitstreamChunkCabac,
+                               sizeof(kH264BitstreamChunkCabac));
+  cabac_parser.ParseFirstSlice(kH264BitstreamNextImageSliceChunkCabac,
+                               sizeof(kH264BitstreamNextImageSliceChunkCabac));
+  ASSERT_TRUE(cabac_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(24, qp);
+}
+
+TEST(H264BitstreamParserTest, ParseFirstSliceStopsAtFirstSlice) {
+  rtc::Buffer frame(kH264BitstreamChunk, sizeof(kH264BitstreamChunk));
+  frame.AppendData(kH264BitstreamNextImageSliceChunk,
+                   sizeof(kH264BitstreamNextImageSliceChunk));
+  H264BitstreamParser h264_parser;
+  int qp;
+  h264_parser.ParseFirstSlice(frame.data(), frame.size());
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(35, qp);
+  h264_parser.ParseBitstream(frame.data(), frame.size());
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(37, qp);
+}
+
+TEST(H264BitstreamParserTest, DISABLED_ParseBitstream4kKeyFrame) {
+  // A 4K key frame of about 1.5 MB in 8 IDR slices: the SPS/PPS and slice
+  // header of kH264BitstreamChunk followed by random, escaped, slice data.
+  constexpr size_t kNumSlices = 8;
+  constexpr size_t kSliceDataSize = 190000;
+  constexpr size_t kSliceHeaderOffset = sizeof(kH264SpsPps);
+  constexpr int kNumIterations = 50;
+  Random random(0x4b);
+  rtc::Buffer key_frame(kH264SpsPps, sizeof(kH264SpsPps));
+  std::vector<uint8_t> slice_data(kSliceDataSize);
+  for (size_t i = 0; i < kNumSlices; ++i) {
+    key_frame.AppendData(kH264BitstreamChunk + kSliceHeaderOffset,
+                         sizeof(kH264BitstreamChunk) - kSliceHeaderOffset);
+    for (uint8_t& byte : slice_data)
+      byte = random.Rand<uint8_t>();
+    H264::WriteRbsp(slice_data.data(), slice_data.size(), &key_frame);
+  }
+
+  std::vector<H264::NaluIndex> indices;
+  int64_t start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i)
+    H264::FindNaluIndices(key_frame.data(), key_frame.size(), &indices);
+  int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+  ASSERT_EQ(kNumSlices + 2, indices.size());
+  test::PrintResult("h264_4k_key_frame", "", "find_nalu_indices",
+                    elapsed_ns / 1000.0 / kNumIterations, "us", false);
+
+  std::vector<uint8_t> rbsp(key_frame.size());
+  start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (const H264::NaluIndex& index : indices) {
+      H264::ParseRbsp(key_frame.data() + index.payload_start_offset,
+                      index.payload_size, rbsp.data());
+    }
+  }
+  elapsed_ns = rtc::TimeNanos() - start_ns;
+  test::PrintResult("h264_4k_key_frame", "", "parse_rbsp",
+                    elapsed_ns / 1000.0 / kNumIterations, "us", false);
+
+  H264BitstreamParser h264_parser;
+  start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i)
+    h264_parser.ParseBitstream(key_frame.data(), key_frame.size());
+  elapsed_ns = rtc::TimeNanos() - start_ns;
+  int qp;
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(35, qp);
+  test::PrintResult("h264_4k_key_frame", "", "parse_bitstream_qp",
+                    elapsed_ns / 1000.0 / kNumIterations, "us", false);
+
+  start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i)
+    h264_parser.ParseFirstSlice(key_frame.data(), key_frame.size());
+  elapsed_ns = rtc::TimeNanos() - start_ns;
+  ASSERT_TRUE(h264_parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(35, qp);
+  test::PrintResult("h264_4k_key_frame", "", "parse_first_slice_qp",
+                    elapsed_ns / 1000.0 / kNumIterations, "us", false);
+}
+
 }  // namespace webrtc
@@ -10,6 +10,10 @@
 
 #include "common_video/h264/h264_common.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 namespace webrtc {
 namespace H264 {
 
@@ -17,43 +21,62 @@ const uint8_t kNaluTypeMask = 0x1F;
 
 std::vector<NaluIndex> FindNaluIndices(const uint8_t* buffer,
                                        size_t buffer_size) {
-  // This is sorta like Boyer-Moore, but with only the first optimization step:
-  // given a 3-byte sequence we're looking at, if the 3rd byte isn't 1 or 0,
-  // skip ahead to the next 3-byte sequence. 0s and 1s are relatively rare, so
-  // this will skip the majority of reads/checks.
   std::vector<NaluIndex> sequences;
-  if (buffer_size < kNaluShortStartSequenceSize)
-    return sequences;
-
-  const size_t end = buffer_size - kNaluShortStartSequenceSize;
-  for (size_t i = 0; i < end;) {
-    if (buffer[i + 2] > 1) {
-      i += 3;
-    } else if (buffer[i + 2] == 1 && buffer[i + 1] == 0 && buffer[i] == 0) {
-      // We found a start sequence, now check if it was a 3 of 4 byte one.
-      NaluIndex index = {i, i + 3, 0};
-      if (index.start_offset > 0 && buffer[index.start_offset - 1] == 0)
-        --index.start_offset;
-
-      // Update length of previous entry.
-      auto it = sequences.rbegin();
-      if (it != sequences.rend())
-        it->payload_size = index.start_offset - it->payload_start_offset;
-
-      sequences.push_back(index);
-
-      i += 3;
-    } else {
-      ++i;
+  FindNaluIndices(buffer, buffer_size, &sequences);
+  return sequences;
+}
+
+void FindNaluIndices(const uint8_t* buffer,
+                     size_t buffer_size,
+                     std::vector<NaluIndex>* indices) {
+  indices->clear();
+  NaluIndex index;
+  size_t offset = 0;
+  while (FindNextNaluIndex(buffer, buffer_size, offset, &index)) {
+    // Update length of previous entry.
+    if (!indices->empty()) {
+      indices->back().payload_size =
+          index.start_offset - indices->back().payload_start_offset;
     }
+    indices->push_back(index);
+    offset = index.payload_start_offset;
   }
+}
 
-  // Update length of last entry, if any.
-  auto it = sequences.rbegin();
-  if (it != sequences.rend())
-    it->payload_size = buffer_size - it->payload_start_offset;
+bool FindNextNaluIndex(const uint8_t* buffer,
+                       size_t buffer_size,
+                       size_t offset,
+                       NaluIndex* index) {
+  if (buffer_size < kNaluShortStartSequenceSize ||
+      offset > buffer_size - kNaluShortStartSequenceSize) {
+    return false;
+  }
 
-  return sequences;
+  // Look for the 1 that ends each start sequence with memchr, which is
+  // vectorized in any libc worth its salt, and check the two bytes before it.
+  // A 1 is rare in compressed data, so most of the buffer is never looked at
+  // byte by byte. A start sequence ending in the last byte would be followed
+  // by an empty NALU and isn't reported.
+  const uint8_t* const end = buffer + buffer_size - 1;
+  const uint8_t* p = buffer + offset + 2;
+  while (p < end) {
+    p = static_cast<const uint8_t*>(memchr(p, 1, end - p));
+    if (!p)
+      return false;
+    if (p[-1] != 0 || p[-2] != 0) {
+      ++p;
+      continue;
+    }
+    // We found a start sequence, now check if it was a 3 of 4 byte one.
+    const size_t start_offset = p - 2 - buffer;
+    index->start_offset = start_offset;
+    index->payload_start_offset = start_offset + 3;
+    index->payload_size = buffer_size - index->payload_start_offset;
+    if (start_offset > offset && buffer[start_offset - 1] == 0)
+      --index->start_offset;
+    return true;
+  }
+  return false;
 }
 
 NaluType ParseNaluType(uint8_t data) {
@@ -61,26 +84,40 @@ NaluType ParseNaluType(uint8_t data) {
 }
 
 std::vector<uint8_t> ParseRbsp(const uint8_t* data, size_t length) {
-  std::vector<uint8_t> out;
-  out.reserve(length);
-
-  for (size_t i = 0; i < length;) {
-    // Be careful about over/underflow here. byte_length_ - 3 can underflow, and
-    // i + 3 can overflow, but byte_length_ - i can't, because i < byte_length_
-    // above, and that expression will produce the number of bytes left in
-    // the stream including the byte at i.
-    if (length - i >= 3 && !data[i] && !data[i + 1] && data[i + 2] == 3) {
-      // Two rbsp bytes.
-      out.push_back(data[i++]);
-      out.push_back(data[i++]);
-      // Skip the emulation byte.
-      i++;
-    } else {
-      // Single rbsp byte.
-      out.push_back(data[i++]);
+  std::vector<uint8_t> out(length);
+  out.resize(ParseRbsp(data, length, out.data()));
+  return out;
+}
+
+size_t ParseRbsp(const uint8_t* data, size_t length, uint8_t* destination) {
+  // Every 00 00 03 sequence is an emulation: the 03 can't be part of an
+  // earlier one. Find the 03s with memchr and copy the runs between the
+  // emulation bytes in one go. Each run is written before or at where it is
+  // read from, so this works in place as long as nothing is read from before
+  // the start of the current run.
+  if (length == 0)
+    return 0;
+  size_t written = 0;
+  size_t run_start = 0;
+  size_t i = 2;
+  while (i < length) {
+    const uint8_t* emulation =
+        static_cast<const uint8_t*>(memchr(data + i, 3, length - i));
+    if (!emulation)
+      break;
+    i = emulation - data;
+    if (data[i - 1] != 0 || data[i - 2] != 0) {
+      ++i;
+      continue;
     }
+    memmove(destination + written, data + run_start, i - run_start);
+    written += i - run_start;
+    run_start = i + 1;
+    // The next emulation byte needs two new zeros first.
+    i += 3;
   }
-  return out;
+  memmove(destination + written, data + run_start, length - run_start);
+  return written + length - run_start;
 }
 
 void WriteRbsp(const uint8_t* bytes, size_t length, rtc::Buffer* destination) {
@@ -106,5 +143,104 @@ void WriteRbsp(const uint8_t* bytes, size_t length, rtc::Buffer* destination) {
   }
 }
 
+RbspBitReader::RbspBitReader(const uint8_t* data, size_t length)
+    : data_(data),
+      length_(length),
+      byte_offset_(0),
+      bit_offset_(0),
+      zero_count_(0) {}
+
+bool RbspBitReader::ReadBits(uint32_t* val, size_t bit_count) {
+  if (bit_count > 32)
+    return false;
+  const size_t original_byte_offset = byte_offset_;
+  const size_t original_bit_offset = bit_offset_;
+  const int original_zero_count = zero_count_;
+  uint32_t bits = 0;
+  while (bit_count > 0) {
+    if (byte_offset_ >= length_) {
+      byte_offset_ = original_byte_offset;
+      bit_offset_ = original_bit_offset;
+      zero_count_ = original_zero_count;
+      return false;
+    }
+    const size_t bits_in_byte = std::min<size_t>(8 - bit_offset_, bit_count);
+    const uint32_t mask = (1u << bits_in_byte) - 1;
+    bits = (bits << bits_in_byte) |
+           ((data_[byte_offset_] >> (8 - bit_offset_ - bits_in_byte)) & mask);
+    bit_offset_ += bits_in_byte;
+    bit_count -= bits_in_byte;
+    if (bit_offset_ == 8) {
+      bit_offset_ = 0;
+      NextByte();
+    }
+  }
+  *val = bits;
+  return true;
+}
+
+bool RbspBitReader::ConsumeBits(size_t bit_count) {
+  const size_t original_byte_offset = byte_offset_;
+  const size_t original_bit_offset = bit_offset_;
+  const int original_zero_count = zero_count_;
+  uint32_t unused;
+  while (bit_count > 32) {
+    if (!ReadBits(&unused, 32))
+      break;
+    bit_count -= 32;
+  }
+  if (bit_count > 32 || !ReadBits(&unused, bit_count)) {
+    byte_offset_ = original_byte_offset;
+    bit_offset_ = original_bit_offset;
+    zero_count_ = original_zero_count;
+    return false;
+  }
+  return true;
+}
+
+bool RbspBitReader::ReadExponentialGolomb(uint32_t* val) {
+  const size_t original_byte_offset = byte_offset_;
+  const size_t original_bit_offset = bit_offset_;
+  const int original_zero_count = zero_count_;
+  // Count the leading 0 bits. The value bit count is that plus one, which
+  // must fit in a uint32_t.
+  size_t zero_bit_count = 0;
+  uint32_t bit = 0;
+  while (ReadBits(&bit, 1) && bit == 0)
+    ++zero_bit_count;
+  uint32_t value_bits = 0;
+  if (bit != 1 || zero_bit_count > 31 ||
+      !ReadBits(&value_bits, zero_bit_count)) {
+    byte_offset_ = original_byte_offset;
+    bit_offset_ = original_bit_offset;
+    zero_count_ = original_zero_count;
+    return false;
+  }
+  *val = ((uint64_t{1} << zero_bit_count) | value_bits) - 1;
+  return true;
+}
+
+bool RbspBitReader::ReadSignedExponentialGolomb(int32_t* val) {
+  uint32_t unsigned_val;
+  if (!ReadExponentialGolomb(&unsigned_val))
+    return false;
+  if ((unsigned_val & 1) == 0) {
+    *val = -static_cast<int32_t>(unsigned_val / 2);
+  } else {
+    *val = (unsigned_val + 1) / 2;
+  }
+  return true;
+}
+
+void RbspBitReader::NextByte() {
+  zero_count_ = data_[byte_offset_] == 0 ? zero_count_ + 1 : 0;
+  ++byte_offset_;
+  if (zero_count_ >= 2 && byte_offset_ < length_ &&
+      data_[byte_offset_] == 3) {
+    ++byte_offset_;
+    zero_count_ = 0;
+  }
+}
+
 }  // namespace H264
 }  // namespace webrtc
@@ -59,6 +59,21 @@ struct NaluIndex {
 std::vector<NaluIndex> FindNaluIndices(const uint8_t* buffer,
                                        size_t buffer_size);
 
+// Same as above, but writes the indices to |indices|, which is cleared first.
+// Lets callers that parse every frame reuse the vector's memory.
+void FindNaluIndices(const uint8_t* buffer,
+                     size_t buffer_size,
+                     std::vector<NaluIndex>* indices);
+
+// Finds the first NALU whose start sequence begins at or after |offset|, for
+// callers that stop at a given NALU and don't want the rest of the buffer
+// scanned. The payload size of |index| runs to the end of the buffer. Returns
+// false if there is no further NALU.
+bool FindNextNaluIndex(const uint8_t* buffer,
+                       size_t buffer_size,
+                       size_t offset,
+                       NaluIndex* index);
+
 // Get the NAL type from the header byte immediately following start sequence.
 NaluType ParseNaluType(uint8_t data);
 
@@ -78,10 +93,44 @@ NaluType ParseNaluType(uint8_t data);
 // Parse the given data and remove any emulation byte escaping.
 std::vector<uint8_t> ParseRbsp(const uint8_t* data, size_t length);
 
+// Same as above, but writes to |destination|, which must have room for
+// |length| bytes, and returns the number of bytes written. |destination| may
+// be |data|, to unescape in place.
+size_t ParseRbsp(const uint8_t* data, size_t length, uint8_t* destination);
+
 // Write the given data to the destination buffer, inserting and emulation
 // bytes in order to escape any data the could be interpreted as a start
 // sequence.
 void WriteRbsp(const uint8_t* bytes, size_t length, rtc::Buffer* destination);
+
+// Bit reader over escaped NALU data, which skips the emulation bytes as it
+// reads instead of requiring the whole NALU to be unescaped first. Useful when
+// only a header at the start of a large NALU is parsed. The methods have the
+// same semantics as those of rtc::BitBuffer: if a read fails, the position is
+// left unchanged.
+class RbspBitReader {
+ public:
+  RbspBitReader(const uint8_t* data, size_t length);
+
+  // Reads |bit_count| bits, at most 32, into the low bits of |val|.
+  bool ReadBits(uint32_t* val, size_t bit_count);
+  // Moves the position |bit_count| bits forward.
+  bool ConsumeBits(size_t bit_count);
+  // Reads an unsigned or signed exponential golomb encoded value.
+  bool ReadExponentialGolomb(uint32_t* val);
+  bool ReadSignedExponentialGolomb(int32_t* val);
+
+ private:
+  // Moves to the next byte, skipping it if it is an emulation byte.
+  void NextByte();
+
+  const uint8_t* const data_;
+  const size_t length_;
+  size_t byte_offset_;
+  size_t bit_offset_;
+  // Number of consecutive zero bytes before |byte_offset_|.
+  int zero_count_;
+};
 }  // namespace H264
 }  // namespace webrtc
 
@@ -0,0 +1,205 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "common_video/h264/h264_common.h"
+#include "rtc_base/bitbuffer.h"
+#include "rtc_base/random.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace H264 {
+namespace {
+
+// Straightforward byte by byte versions to compare against.
+std::vector<NaluIndex> ReferenceFindNaluIndices(const uint8_t* buffer,
+                                                size_t buffer_size) {
+  std::vector<NaluIndex> sequences;
+  for (size_t i = 0; i + kNaluShortStartSequenceSize < buffer_size; ++i) {
+    if (buffer[i] != 0 || buffer[i + 1] != 0 || buffer[i + 2] != 1)
+      continue;
+    NaluIndex index = {i, i + 3, 0};
+    if (i > 0 && buffer[i - 1] == 0)
+      --index.start_offset;
+    if (!sequences.empty()) {
+      sequences.back().payload_size =
+          index.start_offset - sequences.back().payload_start_offset;
+    }
+    sequences.push_back(index);
+    i += 2;
+  }
+  if (!sequences.empty()) {
+    sequences.back().payload_size =
+        buffer_size - sequences.back().payload_start_offset;
+  }
+  return sequences;
+}
+
+std::vector<uint8_t> ReferenceParseRbsp(const uint8_t* data, size_t length) {
+  std::vector<uint8_t> out;
+  for (size_t i = 0; i < length;) {
+    if (length - i >= 3 && !data[i] && !data[i + 1] && data[i + 2] == 3) {
+      out.push_back(data[i++]);
+      out.push_back(data[i++]);
+      i++;
+    } else {
+      out.push_back(data[i++]);
+    }
+  }
+  return out;
+}
+
+// Random data with plenty of zeros, ones and threes, so that there are many
+// start sequences and emulation bytes.
+std::vector<uint8_t> RandomBytes(Random* random, size_t size) {
+  std::vector<uint8_t> data(size);
+  for (uint8_t& byte : data) {
+    byte = random->Rand(0, 3) == 0 ? random->Rand(0, 3)
+                                   : random->Rand<uint8_t>();
+  }
+  return data;
+}
+
+void ExpectEqual(const std::vector<NaluIndex>& expected,
+                 const std::vector<NaluIndex>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].start_offset, actual[i].start_offset);
+    EXPECT_EQ(expected[i].payload_start_offset,
+              actual[i].payload_start_offset);
+    EXPECT_EQ(expected[i].payload_size, actual[i].payload_size);
+  }
+}
+
+}  // namespace
+
+TEST(H264CommonTest, FindNaluIndices) {
+  const uint8_t kBuffer[] = {0, 0, 0, 1, 0x67, 0xaa, 0, 0, 1, 0x68, 0xbb,
+                             0xcc, 0, 0, 0, 1, 0x65, 0, 1, 0, 0, 1};
+  std::vector<NaluIndex> indices = FindNaluIndices(kBuffer, sizeof(kBuffer));
+  ASSERT_EQ(3u, indices.size());
+  EXPECT_EQ(0u, indices[0].start_offset);
+  EXPECT_EQ(4u, indices[0].payload_start_offset);
+  EXPECT_EQ(2u, indices[0].payload_size);
+  EXPECT_EQ(6u, indices[1].start_offset);
+  EXPECT_EQ(9u, indices[1].payload_start_offset);
+  EXPECT_EQ(3u, indices[1].payload_size);
+  EXPECT_EQ(12u, indices[2].start_offset);
+  EXPECT_EQ(16u, indices[2].payload_start_offset);
+  // A start sequence at the very end isn't reported.
+  EXPECT_EQ(6u, indices[2].payload_size);
+
+  EXPECT_TRUE(FindNaluIndices(kBuffer, 2).empty());
+}
+
+TEST(H264CommonTest, FindNaluIndicesReusesOutput) {
+  const uint8_t kBuffer[] = {0, 0, 1, 0x67, 0, 0, 1, 0x68};
+  std::vector<NaluIndex> indices(10);
+  FindNaluIndices(kBuffer, sizeof(kBuffer), &indices);
+  EXPECT_EQ(2u, indices.size());
+  FindNaluIndices(kBuffer, 3, &indices);
+  EXPECT_TRUE(indices.empty());
+}
+
+TEST(H264CommonTest, FindNaluIndicesMatchesReference) {
+  Random random(0x264);
+  std::vector<NaluIndex> indices;
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<uint8_t> data = RandomBytes(&random, random.Rand(0, 200));
+    FindNaluIndices(data.data(), data.size(), &indices);
+    ExpectEqual(ReferenceFindNaluIndices(data.data(), data.size()), indices);
+  }
+}
+
+TEST(H264CommonTest, FindNextNaluIndex) {
+  const uint8_t kBuffer[] = {0, 0, 0, 1, 0x67, 0xaa, 0, 0, 1, 0x68, 0xbb,
+                             0xcc, 0, 0, 0, 1, 0x65, 0, 1, 0, 0, 1};
+  NaluIndex index;
+  ASSERT_TRUE(FindNextNaluIndex(kBuffer, sizeof(kBuffer), 0, &index));
+  EXPECT_EQ(0u, index.start_offset);
+  EXPECT_EQ(4u, index.payload_start_offset);
+  EXPECT_EQ(sizeof(kBuffer) - 4, index.payload_size);
+  ASSERT_TRUE(FindNextNaluIndex(kBuffer, sizeof(kBuffer), 4, &index));
+  EXPECT_EQ(6u, index.start_offset);
+  EXPECT_EQ(9u, index.payload_start_offset);
+  ASSERT_TRUE(FindNextNaluIndex(kBuffer, sizeof(kBuffer), 9, &index));
+  EXPECT_EQ(12u, index.start_offset);
+  EXPECT_EQ(16u, index.payload_start_offset);
+  EXPECT_FALSE(FindNextNaluIndex(kBuffer, sizeof(kBuffer), 16, &index));
+  EXPECT_FALSE(FindNextNaluIndex(kBuffer, sizeof(kBuffer), 100, &index));
+}
+
+TEST(H264CommonTest, ParseRbsp) {
+  const uint8_t kEscaped[] = {0x01, 0, 0, 3, 0, 0, 0, 3, 3, 0, 0, 3};
+  const uint8_t kUnescaped[] = {0x01, 0, 0, 0, 0, 0, 3, 0, 0};
+  std::vector<uint8_t> rbsp = ParseRbsp(kEscaped, sizeof(kEscaped));
+  EXPECT_EQ(std::vector<uint8_t>(kUnescaped, kUnescaped + sizeof(kUnescaped)),
+            rbsp);
+  EXPECT_TRUE(ParseRbsp(kEscaped, 0).empty());
+}
+
+TEST(H264CommonTest, ParseRbspMatchesReferenceAndWorksInPlace) {
+  Random random(0x3);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<uint8_t> data = RandomBytes(&random, random.Rand(0, 200));
+    std::vector<uint8_t> expected =
+        ReferenceParseRbsp(data.data(), data.size());
+    EXPECT_EQ(expected, ParseRbsp(data.data(), data.size()));
+    data.resize(ParseRbsp(data.data(), data.size(), data.data()));
+    EXPECT_EQ(expected, data);
+  }
+}
+
+TEST(H264CommonTest, RbspBitReaderMatchesBitBufferOnUnescapedData) {
+  Random random(0x4);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<uint8_t> data = RandomBytes(&random, random.Rand(0, 64));
+    std::vector<uint8_t> rbsp = ParseRbsp(data.data(), data.size());
+    rtc::BitBuffer expected_reader(rbsp.data(), rbsp.size());
+    RbspBitReader reader(data.data(), data.size());
+    for (int op = 0; op < 100; ++op) {
+      uint32_t expected_value = 0;
+      uint32_t value = 0;
+      switch (random.Rand(0, 3)) {
+        case 0: {
+          // rtc::BitBuffer peeks at the current byte even for 0 bits.
+          const size_t bit_count = random.Rand(1, 32);
+          ASSERT_EQ(expected_reader.ReadBits(&expected_value, bit_count),
+                    reader.ReadBits(&value, bit_count));
+          break;
+        }
+        case 1: {
+          const size_t bit_count = random.Rand(0, 40);
+          ASSERT_EQ(expected_reader.ConsumeBits(bit_count),
+                    reader.ConsumeBits(bit_count));
+          break;
+        }
+        case 2:
+          ASSERT_EQ(expected_reader.ReadExponentialGolomb(&expected_value),
+                    reader.ReadExponentialGolomb(&value));
+          break;
+        case 3: {
+          int32_t expected_signed = 0;
+          int32_t signed_value = 0;
+          ASSERT_EQ(
+              expected_reader.ReadSignedExponentialGolomb(&expected_signed),
+              reader.ReadSignedExponentialGolomb(&signed_value));
+          ASSERT_EQ(expected_signed, signed_value);
+          break;
+        }
+      }
+      ASSERT_EQ(expected_value, value);
+    }
+  }
+}
+
+}  // namespace H264
+}  // namespace webrtc
@@ -0,0 +1,279 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "media/engine/videodecoderpool.h"
+
+#include <utility>
+
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "system_wrappers/include/metrics.h"
+
+namespace webrtc {
+
+namespace {
+
+// Upper pixel count of each resolution class but the last.
+const int kResolutionClassMaxPixels[] = {320 * 240, 640 * 480, 1280 * 720,
+                                         1920 * 1080};
+
+}  // namespace
+
+// Forwards to a decoder of its own until InitDecode finds a warm decoder in
+// the pool, then forwards to that one.
+class VideoDecoderPool::PooledDecoder : public VideoDecoder {
+ public:
+  PooledDecoder(VideoDecoderPool* pool,
+                const SdpVideoFormat& format,
+                std::unique_ptr<VideoDecoder> decoder)
+      : pool_(pool),
+        format_(format),
+        decoder_(std::move(decoder)),
+        initialized_(false),
+        number_of_cores_(0),
+        callback_(nullptr) {}
+
+  ~PooledDecoder() override {
+    if (initialized_) {
+      pool_->ReturnDecoder(std::move(decoder_), format_, codec_settings_,
+                           number_of_cores_);
+    }
+  }
+
+  int32_t InitDecode(const VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    std::unique_ptr<VideoDecoder> warm_decoder =
+        pool_->TakeWarmDecoder(
+            MakeKey(format_, *codec_settings, number_of_cores));
+    const bool hit = warm_decoder != nullptr;
+    pool_->OnInitDecode(hit);
+    if (hit) {
+      decoder_ = std::move(warm_decoder);
+    } else {
+      int32_t ret = decoder_->InitDecode(codec_settings, number_of_cores);
+      if (ret != WEBRTC_VIDEO_CODEC_OK) {
+        initialized_ = false;
+        return ret;
+      }
+    }
+    initialized_ = true;
+    codec_settings_ = *codec_settings;
+    number_of_cores_ = number_of_cores;
+    if (callback_)
+      decoder_->RegisterDecodeCompleteCallback(callback_);
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Decode(const EncodedImage& input_image,
+                 bool missing_frames,
+                 const RTPFragmentationHeader* fragmentation,
+                 const CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    return decoder_->Decode(input_image, missing_frames, fragmentation,
+                            codec_specific_info, render_time_ms);
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      DecodedImageCallback* callback) override {
+    callback_ = callback;
+    return decoder_->RegisterDecodeCompleteCallback(callback);
+  }
+
+  int32_t Release() override { return decoder_->Release(); }
+
+  bool PrefersLateDecoding() const override {
+    return decoder_->PrefersLateDecoding();
+  }
+
+  const char* ImplementationName() const override {
+    return decoder_->ImplementationName();
+  }
+
+ private:
+  VideoDecoderPool* const pool_;
+  const SdpVideoFormat format_;
+  std::unique_ptr<VideoDecoder> decoder_;
+  // Whether |decoder_| was initialized with |codec_settings_|, and can be
+  // reset to that state when it's given back to the pool.
+  bool initialized_;
+  VideoCodec codec_settings_;
+  int32_t number_of_cores_;
+  DecodedImageCallback* callback_;
+};
+
+// Releases and initializes a given back decoder on |reset_queue_|, and adds
+// it to the pool.
+class VideoDecoderPool::ResetDecoderTask : public rtc::QueuedTask {
+ public:
+  ResetDecoderTask(VideoDecoderPool* pool,
+                   std::unique_ptr<VideoDecoder> decoder,
+                   const SdpVideoFormat& format,
+                   const VideoCodec& codec_settings,
+                   int32_t number_of_cores)
+      : pool_(pool),
+        decoder_(std::move(decoder)),
+        format_(format),
+        codec_settings_(codec_settings),
+        number_of_cores_(number_of_cores) {}
+
+ private:
+  bool Run() override {
+    RTC_DCHECK(pool_->reset_queue_.IsCurrent());
+    decoder_->Release();
+    if (decoder_->InitDecode(&codec_settings_, number_of_cores_) ==
+        WEBRTC_VIDEO_CODEC_OK) {
+      pool_->AddWarmDecoder(
+          {MakeKey(format_, codec_settings_, number_of_cores_),
+           std::move(decoder_)});
+    }
+    return true;
+  }
+
+  VideoDecoderPool* const pool_;
+  std::unique_ptr<VideoDecoder> decoder_;
+  const SdpVideoFormat format_;
+  const VideoCodec codec_settings_;
+  const int32_t number_of_cores_;
+};
+
+bool VideoDecoderPool::Key::operator==(const Key& other) const {
+  return format == other.format &&
+         resolution_class == other.resolution_class &&
+         number_of_cores == other.number_of_cores;
+}
+
+VideoDecoderPool::VideoDecoderPool(VideoDecoderFactory* factory,
+                                   size_t max_warm_decoders)
+    : factory_(factory),
+      max_warm_decoders_(max_warm_decoders),
+      reset_queue_("VideoDecoderPool") {
+  RTC_DCHECK(factory_);
+}
+
+VideoDecoderPool::~VideoDecoderPool() {
+  rtc::CritScope lock(&crit_);
+  RTC_LOG(LS_INFO) << "Video decoder pool: " << stats_.num_hits
+                   << " hits, " << stats_.num_misses << " misses.";
+}
+
+std::unique_ptr<VideoDecoder> VideoDecoderPool::CreateVideoDecoder(
+    const SdpVideoFormat& format) {
+  std::unique_ptr<VideoDecoder> decoder = factory_->CreateVideoDecoder(format);
+  if (!decoder)
+    return nullptr;
+  return std::unique_ptr<VideoDecoder>(
+      new PooledDecoder(this, format, std::move(decoder)));
+}
+
+void VideoDecoderPool::Prewarm(const SdpVideoFormat& format,
+                               const VideoCodec& codec_settings,
+                               int32_t number_of_cores,
+                               size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    std::unique_ptr<VideoDecoder> decoder =
+        factory_->CreateVideoDecoder(format);
+    if (!decoder ||
+        decoder->InitDecode(&codec_settings, number_of_cores) !=
+            WEBRTC_VIDEO_CODEC_OK) {
+      RTC_LOG(LS_WARNING) << "Failed to prewarm a " << format.name
+                          << " decoder.";
+      return;
+    }
+    AddWarmDecoder({MakeKey(format, codec_settings, number_of_cores),
+                    std::move(decoder)});
+  }
+}
+
+VideoDecoderPool::Stats VideoDecoderPool::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  return stats_;
+}
+
+void VideoDecoderPool::WaitForReturnedDecoders() {
+  rtc::Event done(false, false);
+  reset_queue_.PostTask([&done] { done.Set(); });
+  done.Wait(rtc::Event::kForever);
+}
+
+int VideoDecoderPool::ResolutionClass(int width, int height) {
+  const int pixels = width * height;
+  int resolution_class = 0;
+  for (int max_pixels : kResolutionClassMaxPixels) {
+    if (pixels <= max_pixels)
+      break;
+    ++resolution_class;
+  }
+  return resolution_class;
+}
+
+VideoDecoderPool::Key VideoDecoderPool::MakeKey(
+    const SdpVideoFormat& format,
+    const VideoCodec& codec_settings,
+    int32_t number_of_cores) {
+  return {format,
+          ResolutionClass(codec_settings.width, codec_settings.height),
+          number_of_cores};
+}
+
+std::unique_ptr<VideoDecoder> VideoDecoderPool::TakeWarmDecoder(
+    const Key& key) {
+  rtc::CritScope lock(&crit_);
+  // Take the most recently returned one.
+  for (auto it = warm_decoders_.rbegin(); it != warm_decoders_.rend(); ++it) {
+    if (it->key == key) {
+      std::unique_ptr<VideoDecoder> decoder = std::move(it->decoder);
+      warm_decoders_.erase(std::next(it).base());
+      stats_.num_warm_decoders = warm_decoders_.size();
+      return decoder;
+    }
+  }
+  return nullptr;
+}
+
+void VideoDecoderPool::ReturnDecoder(std::unique_ptr<VideoDecoder> decoder,
+                                     const SdpVideoFormat& format,
+                                     const VideoCodec& codec_settings,
+                                     int32_t number_of_cores) {
+  if (max_warm_decoders_ == 0)
+    return;
+  // The stream is done with the decoder, so it can't be called back any more.
+  decoder->RegisterDecodeCompleteCallback(nullptr);
+  // Reinitializing is the cost the next stream saves; don't make the thread
+  // that destroys the stream pay it instead.
+  reset_queue_.PostTask(std::unique_ptr<rtc::QueuedTask>(
+      new ResetDecoderTask(this, std::move(decoder), format, codec_settings,
+                           number_of_cores)));
+}
+
+void VideoDecoderPool::AddWarmDecoder(WarmDecoder warm_decoder) {
+  // Destroyed outside the lock.
+  std::unique_ptr<VideoDecoder> evicted_decoder;
+  rtc::CritScope lock(&crit_);
+  warm_decoders_.push_back(std::move(warm_decoder));
+  if (warm_decoders_.size() > max_warm_decoders_) {
+    evicted_decoder = std::move(warm_decoders_.front().decoder);
+    warm_decoders_.pop_front();
+  }
+  stats_.num_warm_decoders = warm_decoders_.size();
+}
+
+void VideoDecoderPool::OnInitDecode(bool hit) {
+  RTC_HISTOGRAM_BOOLEAN("WebRTC.Video.DecoderPoolHit", hit);
+  rtc::CritScope lock(&crit_);
+  if (hit) {
+    ++stats_.num_hits;
+  } else {
+    ++stats_.num_misses;
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MEDIA_ENGINE_VIDEODECODERPOOL_H_
+#define MEDIA_ENGINE_VIDEODECODERPOOL_H_
+
+#include <deque>
+#include <memory>
+
+#include "api/video_codecs/sdp_video_format.h"
+#include "api/video_codecs/video_decoder.h"
+#include "api/video_codecs/video_decoder_factory.h"
+#include "common_types.h"  // NOLINT(build/include)
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/task_queue.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Keeps initialized decoders of receive streams that have gone away, so that
+// the next stream with the same format, resolution class and number of cores
+// can decode its first frame without waiting for InitDecode.
+//
+// The decoders returned by CreateVideoDecoder() are proxies. On InitDecode
+// they take a matching warm decoder from the pool if there is one, and when
+// they are destroyed they give their decoder back. A decoder is released and
+// initialized again on the pool's own task queue before it goes back into the
+// pool, so a warm decoder has no state from its previous stream and waits for
+// a key frame like a new one, and destroying a stream doesn't wait for it.
+class VideoDecoderPool {
+ public:
+  struct Stats {
+    // InitDecode calls that were served by a warm decoder, and calls that had
+    // to initialize a decoder.
+    uint32_t num_hits = 0;
+    uint32_t num_misses = 0;
+    size_t num_warm_decoders = 0;
+  };
+
+  // |factory| must outlive the pool, and the pool must outlive the decoders
+  // it creates. At most |max_warm_decoders| are kept, the ones returned last.
+  VideoDecoderPool(VideoDecoderFactory* factory, size_t max_warm_decoders);
+  ~VideoDecoderPool();
+
+  // Returns nullptr if the factory can't create a decoder for |format|.
+  std::unique_ptr<VideoDecoder> CreateVideoDecoder(
+      const SdpVideoFormat& format);
+
+  // Initializes |count| decoders for |codec_settings| ahead of the first
+  // stream that needs them.
+  void Prewarm(const SdpVideoFormat& format,
+               const VideoCodec& codec_settings,
+               int32_t number_of_cores,
+               size_t count);
+
+  Stats GetStats() const;
+
+  // Waits until the decoders given back so far are in the pool (or have
+  // failed to initialize).
+  void WaitForReturnedDecoders();
+
+  // Decoders are shared between resolutions of the same class, since the
+  // decoder configuration (e.g. number of threads) depends on it.
+  static int ResolutionClass(int width, int height);
+
+ private:
+  class PooledDecoder;
+  class ResetDecoderTask;
+
+  struct Key {
+    SdpVideoFormat format;
+    int resolution_class;
+    int32_t number_of_cores;
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct WarmDecoder {
+    Key key;
+    std::unique_ptr<VideoDecoder> decoder;
+  };
+
+  static Key MakeKey(const SdpVideoFormat& format,
+                     const VideoCodec& codec_settings,
+                     int32_t number_of_cores);
+
+  // Returns nullptr if there's no warm decoder for |key|.
+  std::unique_ptr<VideoDecoder> TakeWarmDecoder(const Key& key);
+  // Resets |decoder| to the initial state for |codec_settings| on
+  // |reset_queue_| and keeps it.
+  void ReturnDecoder(std::unique_ptr<VideoDecoder> decoder,
+                     const SdpVideoFormat& format,
+                     const VideoCodec& codec_settings,
+                     int32_t number_of_cores);
+  void AddWarmDecoder(WarmDecoder warm_decoder);
+  void OnInitDecode(bool hit);
+
+  VideoDecoderFactory* const factory_;
+  const size_t max_warm_decoders_;
+
+  rtc::CriticalSection crit_;
+  // Oldest first.
+  std::deque<WarmDecoder> warm_decoders_ RTC_GUARDED_BY(crit_);
+  Stats stats_ RTC_GUARDED_BY(crit_);
+
+  // Last, so that it's stopped before the members its tasks use are destroyed.
+  rtc::TaskQueue reset_queue_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(VideoDecoderPool);
+};
+
+}  // namespace webrtc
+
+#endif  // MEDIA_ENGINE_VIDEODECODERPOOL_H_
@@ -0,0 +1,290 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "media/engine/videodecoderpool.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "media/engine/internaldecoderfactory.h"
+#include "modules/video_coding/codecs/vp8/include/vp8.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/timeutils.h"
+#include "test/frame_generator.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+#include "test/video_codec_settings.h"
+
+namespace webrtc {
+
+namespace {
+
+class FakeDecoder : public VideoDecoder {
+ public:
+  int32_t InitDecode(const VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    ++init_decode_count_;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Decode(const EncodedImage& input_image,
+                 bool missing_frames,
+                 const RTPFragmentationHeader* fragmentation,
+                 const CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      DecodedImageCallback* callback) override {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Release() override {
+    ++release_count_;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  const char* ImplementationName() const override { return "fake-decoder"; }
+
+  int init_decode_count_ = 0;
+  int release_count_ = 0;
+  DecodedImageCallback* callback_ = nullptr;
+};
+
+class FakeDecoderFactory : public VideoDecoderFactory {
+ public:
+  std::vector<SdpVideoFormat> GetSupportedFormats() const override {
+    return {SdpVideoFormat("VP8"), SdpVideoFormat("VP9")};
+  }
+
+  std::unique_ptr<VideoDecoder> CreateVideoDecoder(
+      const SdpVideoFormat& format) override {
+    FakeDecoder* decoder = new FakeDecoder();
+    decoders_.push_back(decoder);
+    return std::unique_ptr<VideoDecoder>(decoder);
+  }
+
+  // Not owned, may have been destroyed.
+  std::vector<FakeDecoder*> decoders_;
+};
+
+class DecodedImageCallbackStub : public DecodedImageCallback {
+ public:
+  int32_t Decoded(VideoFrame& decoded_image) override {
+    ++num_decoded_frames_;
+    return 0;
+  }
+
+  int num_decoded_frames_ = 0;
+};
+
+class KeyFrameCallback : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    buffer_.assign(encoded_image._buffer,
+                   encoded_image._buffer + encoded_image._length);
+    key_frame_ = encoded_image;
+    key_frame_._buffer = buffer_.data();
+    key_frame_._size = buffer_.size();
+    return Result(Result::OK);
+  }
+
+  std::vector<uint8_t> buffer_;
+  EncodedImage key_frame_;
+};
+
+VideoCodec MakeCodecSettings(VideoCodecType codec_type,
+                             int width,
+                             int height) {
+  VideoCodec codec_settings;
+  memset(&codec_settings, 0, sizeof(codec_settings));
+  codec_settings.codecType = codec_type;
+  codec_settings.width = width;
+  codec_settings.height = height;
+  return codec_settings;
+}
+
+}  // namespace
+
+class VideoDecoderPoolTest : public ::testing::Test {
+ protected:
+  VideoDecoderPoolTest()
+      : vp8_format_("VP8"),
+        vp8_settings_(MakeCodecSettings(kVideoCodecVP8, 640, 360)),
+        pool_(&factory_, 2) {}
+
+  const SdpVideoFormat vp8_format_;
+  const VideoCodec vp8_settings_;
+  FakeDecoderFactory factory_;
+  VideoDecoderPool pool_;
+};
+
+TEST_F(VideoDecoderPoolTest, ReusesResetDecoder) {
+  std::unique_ptr<VideoDecoder> decoder = pool_.CreateVideoDecoder(vp8_format_);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder->InitDecode(&vp8_settings_, 2));
+  decoder->Release();
+  decoder.reset();
+  pool_.WaitForReturnedDecoders();
+  ASSERT_EQ(1u, factory_.decoders_.size());
+  FakeDecoder* const warm_decoder = factory_.decoders_[0];
+  EXPECT_EQ(2, warm_decoder->init_decode_count_);
+  EXPECT_EQ(2, warm_decoder->release_count_);
+  EXPECT_EQ(1u, pool_.GetStats().num_warm_decoders);
+
+  // A new stream with a slightly different resolution gets the warm decoder
+  // without initializing it again.
+  const VideoCodec settings = MakeCodecSettings(kVideoCodecVP8, 640, 480);
+  DecodedImageCallbackStub callback;
+  decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->RegisterDecodeCompleteCallback(&callback);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder->InitDecode(&settings, 2));
+  EXPECT_EQ(2, warm_decoder->init_decode_count_);
+  EXPECT_EQ(&callback, warm_decoder->callback_);
+
+  const VideoDecoderPool::Stats stats = pool_.GetStats();
+  EXPECT_EQ(1u, stats.num_hits);
+  EXPECT_EQ(1u, stats.num_misses);
+  EXPECT_EQ(0u, stats.num_warm_decoders);
+}
+
+TEST_F(VideoDecoderPoolTest, DoesNotKeepUninitializedDecoder) {
+  pool_.CreateVideoDecoder(vp8_format_);
+  pool_.WaitForReturnedDecoders();
+  EXPECT_EQ(0u, pool_.GetStats().num_warm_decoders);
+}
+
+TEST_F(VideoDecoderPoolTest, MatchesCodecResolutionClassAndCores) {
+  pool_.CreateVideoDecoder(vp8_format_)->InitDecode(&vp8_settings_, 2);
+  pool_.WaitForReturnedDecoders();
+  EXPECT_EQ(1u, pool_.GetStats().num_warm_decoders);
+
+  const VideoCodec vp9_settings = MakeCodecSettings(kVideoCodecVP9, 640, 360);
+  const VideoCodec hd_settings = MakeCodecSettings(kVideoCodecVP8, 1280, 720);
+  std::unique_ptr<VideoDecoder> decoder =
+      pool_.CreateVideoDecoder(SdpVideoFormat("VP9"));
+  decoder->InitDecode(&vp9_settings, 2);
+  decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->InitDecode(&hd_settings, 2);
+  decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->InitDecode(&vp8_settings_, 4);
+  EXPECT_EQ(0u, pool_.GetStats().num_hits);
+  EXPECT_EQ(4u, pool_.GetStats().num_misses);
+}
+
+TEST_F(VideoDecoderPoolTest, MatchesFormatParameters) {
+  const SdpVideoFormat baseline_format(
+      "H264", {{"profile-level-id", "42e01f"}, {"packetization-mode", "1"}});
+  const SdpVideoFormat high_format(
+      "H264", {{"profile-level-id", "640c1f"}, {"packetization-mode", "1"}});
+  const VideoCodec h264_settings =
+      MakeCodecSettings(kVideoCodecH264, 640, 360);
+  pool_.CreateVideoDecoder(baseline_format)->InitDecode(&h264_settings, 2);
+  pool_.WaitForReturnedDecoders();
+  EXPECT_EQ(1u, pool_.GetStats().num_warm_decoders);
+
+  std::unique_ptr<VideoDecoder> decoder =
+      pool_.CreateVideoDecoder(high_format);
+  decoder->InitDecode(&h264_settings, 2);
+  EXPECT_EQ(0u, pool_.GetStats().num_hits);
+  decoder = pool_.CreateVideoDecoder(baseline_format);
+  decoder->InitDecode(&h264_settings, 2);
+  EXPECT_EQ(1u, pool_.GetStats().num_hits);
+}
+
+TEST_F(VideoDecoderPoolTest, KeepsMostRecentlyReturnedDecoders) {
+  const VideoCodec vp9_settings = MakeCodecSettings(kVideoCodecVP9, 640, 360);
+  const VideoCodec hd_settings = MakeCodecSettings(kVideoCodecVP8, 1280, 720);
+  pool_.CreateVideoDecoder(vp8_format_)->InitDecode(&vp8_settings_, 2);
+  pool_.CreateVideoDecoder(SdpVideoFormat("VP9"))->InitDecode(&vp9_settings, 2);
+  pool_.CreateVideoDecoder(vp8_format_)->InitDecode(&hd_settings, 2);
+  pool_.WaitForReturnedDecoders();
+  EXPECT_EQ(2u, pool_.GetStats().num_warm_decoders);
+
+  std::unique_ptr<VideoDecoder> decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->InitDecode(&vp8_settings_, 2);
+  EXPECT_EQ(0u, pool_.GetStats().num_hits);
+  decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->InitDecode(&hd_settings, 2);
+  EXPECT_EQ(1u, pool_.GetStats().num_hits);
+}
+
+TEST_F(VideoDecoderPoolTest, PrewarmedDecoderIsUsedByFirstStream) {
+  pool_.Prewarm(vp8_format_, vp8_settings_, 2, 1);
+  ASSERT_EQ(1u, factory_.decoders_.size());
+  EXPECT_EQ(1, factory_.decoders_[0]->init_decode_count_);
+
+  std::unique_ptr<VideoDecoder> decoder = pool_.CreateVideoDecoder(vp8_format_);
+  decoder->InitDecode(&vp8_settings_, 2);
+  EXPECT_EQ(1, factory_.decoders_[0]->init_decode_count_);
+  EXPECT_EQ(1u, pool_.GetStats().num_hits);
+}
+
+TEST(VideoDecoderPoolPerfTest, DISABLED_TimeToFirstVp8Frame) {
+  const int kNumStreams = 10;
+  VideoCodec codec_settings;
+  test::CodecSettings(kVideoCodecVP8, &codec_settings);
+  codec_settings.width = 1280;
+  codec_settings.height = 720;
+
+  // Encode a key frame for the streams to start with.
+  KeyFrameCallback encoded_callback;
+  std::unique_ptr<VideoEncoder> encoder(VP8Encoder::Create());
+  ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            encoder->InitEncode(&codec_settings, 1, 1200));
+  encoder->RegisterEncodeCompleteCallback(&encoded_callback);
+  std::unique_ptr<test::FrameGenerator> frame_generator =
+      test::FrameGenerator::CreateSquareGenerator(codec_settings.width,
+                                                  codec_settings.height);
+  const std::vector<FrameType> frame_types = {kVideoFrameKey};
+  ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            encoder->Encode(*frame_generator->NextFrame(), nullptr,
+                            &frame_types));
+  encoder->Release();
+  const EncodedImage& key_frame = encoded_callback.key_frame_;
+  ASSERT_EQ(kVideoFrameKey, key_frame._frameType);
+
+  const SdpVideoFormat vp8_format("VP8");
+  InternalDecoderFactory factory;
+  VideoDecoderPool cold_pool(&factory, 0);
+  VideoDecoderPool warm_pool(&factory, 1);
+  warm_pool.Prewarm(vp8_format, codec_settings, 1, 1);
+  for (VideoDecoderPool* pool : {&cold_pool, &warm_pool}) {
+    int64_t total_time_us = 0;
+    for (int i = 0; i < kNumStreams; ++i) {
+      pool->WaitForReturnedDecoders();
+      // The decoder goes back to |pool| at the end of the iteration.
+      std::unique_ptr<VideoDecoder> decoder =
+          pool->CreateVideoDecoder(vp8_format);
+      DecodedImageCallbackStub decoded_callback;
+      decoder->RegisterDecodeCompleteCallback(&decoded_callback);
+      const int64_t start_time_us = rtc::TimeMicros();
+      ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder->InitDecode(&codec_settings, 1));
+      ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK,
+                decoder->Decode(key_frame, false, nullptr, nullptr, -1));
+      ASSERT_EQ(1, decoded_callback.num_decoded_frames_);
+      total_time_us += rtc::TimeMicros() - start_time_us;
+      decoder->Release();
+    }
+    test::PrintResult("time_to_first_frame", "",
+                      pool == &warm_pool ? "warm" : "cold",
+                      total_time_us / 1000.0 / kNumStreams, "ms", false);
+  }
+  EXPECT_EQ(0u, cold_pool.GetStats().num_hits);
+  EXPECT_EQ(static_cast<uint32_t>(kNumStreams),
+            warm_pool.GetStats().num_hits);
+}
+
+}  // namespace webrtc
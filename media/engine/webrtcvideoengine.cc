@@ -27,6 +27,7 @@
 #include "media/engine/constants.h"
 #include "media/engine/convert_legacy_video_factory.h"
 #include "media/engine/simulcast.h"
+#include "media/engine/videodecoderpool.h"
 #include "media/engine/webrtcmediaengine.h"
 #include "media/engine/webrtcvoiceengine.h"
 #include "modules/video_coding/include/video_error_codes.h"
@@ -40,6 +41,11 @@
 using DegradationPreference = webrtc::VideoSendStream::DegradationPreference;
 
 namespace cricket {
+namespace {
+// Enables pooling of decoders from injected factories. Off by default, since
+// warm decoders hold on to their resources (e.g. hardware decoder instances).
+const char kDecoderPoolFieldTrial[] = "WebRTC-VideoDecoderPool";
+}  // namespace
 
 // Hack in order to pass in |receive_stream_id| to legacy clients.
 // TODO(magjed): Remove once WebRtcVideoDecoderFactory is deprecated and
@@ -57,7 +63,12 @@ class DecoderFactoryAdapter {
   explicit DecoderFactoryAdapter(
       std::unique_ptr<webrtc::VideoDecoderFactory> video_decoder_factory)
       : cricket_decoder_with_params_(nullptr),
-        decoder_factory_(std::move(video_decoder_factory)) {}
+        decoder_factory_(std::move(video_decoder_factory)),
+        decoder_pool_(
+            webrtc::field_trial::IsEnabled(kDecoderPoolFieldTrial)
+                ? new webrtc::VideoDecoderPool(decoder_factory_.get(),
+                                               kMaxWarmDecoders)
+                : nullptr) {}
 
   void SetReceiveStreamId(const std::string& receive_stream_id) {
     if (cricket_decoder_with_params_)
@@ -70,10 +81,16 @@ class DecoderFactoryAdapter {
 
   std::unique_ptr<webrtc::VideoDecoder> CreateVideoDecoder(
       const webrtc::SdpVideoFormat& format) {
+    if (decoder_pool_)
+      return decoder_pool_->CreateVideoDecoder(format);
     return decoder_factory_->CreateVideoDecoder(format);
   }
 
  private:
+  // Number of initialized decoders kept after their receive streams are
+  // destroyed, so that new streams can start decoding right away.
+  static const size_t kMaxWarmDecoders = 4;
+
   // WebRtcVideoDecoderFactory implementation that allows to override
   // |receive_stream_id|.
   class CricketDecoderWithParams : public WebRtcVideoDecoderFactory {
@@ -120,6 +137,10 @@ class DecoderFactoryAdapter {
   // |decoder_factory_|.
   CricketDecoderWithParams* const cricket_decoder_with_params_;
   std::unique_ptr<webrtc::VideoDecoderFactory> decoder_factory_;
+  // Only set if |kDecoderPoolFieldTrial| is enabled. Not used with legacy
+  // factories, since their decoders are created for a particular
+  // |receive_stream_id|.
+  const std::unique_ptr<webrtc::VideoDecoderPool> decoder_pool_;
 };
 
 namespace {
@@ -30,6 +30,7 @@ namespace webrtc {
 // Forward declarations.
 class AudioFrame;
 class AudioDecoderFactory;
+class MemoryAccountant;
 
 struct NetEqNetworkStatistics {
   uint16_t current_buffer_size_ms;  // Current jitter buffer size in ms.
@@ -69,6 +70,10 @@ struct NetEqLifetimeStatistics {
   uint64_t concealed_samples = 0;
   uint64_t concealment_events = 0;
   uint64_t jitter_buffer_delay_ms = 0;
+  // Samples decoded from redundant data (codec-internal FEC or RED) in place
+  // of lost packets. Together with |concealed_samples|, this tells how much of
+  // the loss was recovered rather than concealed.
+  uint64_t secondary_decoded_samples = 0;
 };
 
 enum NetEqPlayoutMode {
@@ -108,6 +113,8 @@ class NetEq {
     NetEqPlayoutMode playout_mode;
     bool enable_fast_accelerate;
     bool enable_muted_state = false;
+    // Accounts the memory of the packet buffer, if not null.
+    MemoryAccountant* memory_accountant = nullptr;
   };
 
   enum ReturnCodes {
@@ -54,6 +54,7 @@ class MockPacketBuffer : public PacketBuffer {
                void(uint32_t timestamp_limit,
                     uint32_t horizon_samples,
                     StatisticsCalculator* stats));
+  MOCK_METHOD1(SalvageLateRedundantPacket, bool(uint32_t timestamp_limit));
   MOCK_METHOD2(DiscardAllOldPackets,
                void(uint32_t timestamp_limit, StatisticsCalculator* stats));
   MOCK_CONST_METHOD0(NumPacketsInBuffer,
@@ -69,7 +69,9 @@ NetEqImpl::Dependencies::Dependencies(
       timestamp_scaler(new TimestampScaler(*decoder_database)),
       accelerate_factory(new AccelerateFactory),
       expand_factory(new ExpandFactory),
-      preemptive_expand_factory(new PreemptiveExpandFactory) {}
+      preemptive_expand_factory(new PreemptiveExpandFactory) {
+  packet_buffer->SetMemoryAccountant(config.memory_accountant);
+}
 
 NetEqImpl::Dependencies::~Dependencies() = default;
 
@@ -1081,6 +1083,11 @@ int NetEqImpl::GetDecision(Operations* operation,
   assert(sync_buffer_.get());
   uint32_t end_timestamp = sync_buffer_->end_timestamp();
   if (!new_codec_) {
+    // Redundant data that overlaps the end of what was played out is used for
+    // the rest of its audio, rather than discarded and concealed. Not while
+    // comfort noise is played, since |end_timestamp| then lags behind.
+    if (decision_logic_->CngOff())
+      packet_buffer_->SalvageLateRedundantPacket(end_timestamp);
     const uint32_t five_seconds_samples = 5 * fs_hz_;
     packet_buffer_->DiscardOldPackets(end_timestamp, five_seconds_samples,
                                       &stats_);
@@ -1488,15 +1495,24 @@ int NetEqImpl::DecodeLoop(PacketList* packet_list, const Operations& operation,
         rtc::ArrayView<int16_t>(&decoded_buffer_[*decoded_length],
                                 decoded_buffer_length_ - *decoded_length));
     last_decoded_timestamps_.push_back(packet_list->front().timestamp);
+    const size_t late_samples =
+        packet_list->front().late_samples * decoder->Channels();
     packet_list->pop_front();
     if (opt_result) {
       const auto& result = *opt_result;
       *speech_type = result.speech_type;
       if (result.num_decoded_samples > 0) {
-        *decoded_length += rtc::dchecked_cast<int>(result.num_decoded_samples);
         // Update |decoder_frame_length_| with number of samples per channel.
         decoder_frame_length_ =
             result.num_decoded_samples / decoder->Channels();
+        // Drop the part of a partially late packet that was already played.
+        const size_t num_samples =
+            result.num_decoded_samples -
+            std::min(late_samples, result.num_decoded_samples);
+        int16_t* const decoded = &decoded_buffer_[*decoded_length];
+        std::copy(decoded + result.num_decoded_samples - num_samples,
+                  decoded + result.num_decoded_samples, decoded);
+        *decoded_length += rtc::dchecked_cast<int>(num_samples);
       }
     } else {
       // Error.
@@ -1982,8 +1998,13 @@ int NetEqImpl::ExtractPackets(size_t required_samples,
     size_t packet_duration = 0;
     if (packet->frame) {
       packet_duration = packet->frame->Duration();
-      // TODO(ossu): Is this the correct way to track Opus FEC packets?
-      if (packet->priority.codec_level > 0) {
+      if (packet_duration > 0) {
+        RTC_DCHECK_LT(packet->late_samples, packet_duration);
+        packet_duration -= packet->late_samples;
+      }
+      // Redundant packets, from codec-internal FEC or RED, are only kept in
+      // the buffer when the primary packet for their timestamp is missing.
+      if (packet->priority != Packet::Priority(0, 0)) {
         stats_.SecondaryDecodedSamples(
             rtc::dchecked_cast<int>(packet_duration));
       }
@@ -1999,6 +2020,8 @@ int NetEqImpl::ExtractPackets(size_t required_samples,
       packet_duration = decoder_frame_length_;
     }
     extracted_samples = packet->timestamp - first_timestamp + packet_duration;
+    const uint32_t packet_end_timestamp =
+        packet->timestamp + static_cast<uint32_t>(packet_duration);
 
     stats_.JitterBufferDelay(extracted_samples, waiting_time_ms);
 
@@ -2017,6 +2040,13 @@ int NetEqImpl::ExtractPackets(size_t required_samples,
         // The next sequence number is available, or the next part of a packet
         // that was split into pieces upon insertion.
         next_packet_available = true;
+      } else if (next_packet->priority != Packet::Priority(0, 0) &&
+                 next_packet->timestamp == packet_end_timestamp) {
+        // The packet with the next sequence number is lost, but redundant data
+        // for the audio that directly follows is available from a later
+        // packet. Use it rather than stopping here, which would leave the gap
+        // to be concealed.
+        next_packet_available = true;
       }
       prev_sequence_number = next_packet->sequence_number;
     }
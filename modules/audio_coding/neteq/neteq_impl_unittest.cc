@@ -626,6 +626,130 @@ TEST_F(NetEqImplTest, ReorderedPacket) {
   EXPECT_CALL(mock_decoder, Die());
 }
 
+// Decoder for payloads that hold their duration in ms in the first byte, and
+// the duration of the preceding audio that they carry as FEC in the second.
+// Primary frames decode to ones, and FEC frames to twos.
+class FecDurationDecoder : public AudioDecoder {
+ public:
+  explicit FecDurationDecoder(int sample_rate_hz)
+      : sample_rate_hz_(sample_rate_hz) {}
+
+  std::vector<ParseResult> ParsePayload(rtc::Buffer&& payload,
+                                        uint32_t timestamp) override {
+    const size_t samples_per_ms = rtc::CheckedDivExact(sample_rate_hz_, 1000);
+    std::vector<ParseResult> results;
+    if (payload[1] > 0) {
+      const size_t fec_duration = payload[1] * samples_per_ms;
+      results.emplace_back(
+          timestamp - fec_duration, 1,
+          std::unique_ptr<EncodedAudioFrame>(
+              new Frame(this, fec_duration, /*is_fec=*/true)));
+    }
+    results.emplace_back(timestamp, 0,
+                         std::unique_ptr<EncodedAudioFrame>(new Frame(
+                             this, payload[0] * samples_per_ms, false)));
+    return results;
+  }
+
+  int DecodeInternal(const uint8_t* encoded,
+                     size_t encoded_len,
+                     int sample_rate_hz,
+                     int16_t* decoded,
+                     SpeechType* speech_type) override {
+    ADD_FAILURE() << "Frames are decoded through ParsePayload";
+    return -1;
+  }
+
+  void Reset() override {}
+  int SampleRateHz() const override { return sample_rate_hz_; }
+  size_t Channels() const override { return 1; }
+
+  int num_fec_decodes() const { return num_fec_decodes_; }
+
+ private:
+  class Frame : public EncodedAudioFrame {
+   public:
+    Frame(FecDurationDecoder* decoder, size_t duration, bool is_fec)
+        : decoder_(decoder), duration_(duration), is_fec_(is_fec) {}
+
+    size_t Duration() const override { return duration_; }
+
+    rtc::Optional<DecodeResult> Decode(
+        rtc::ArrayView<int16_t> decoded) const override {
+      RTC_CHECK_GE(decoded.size(), duration_);
+      std::fill(decoded.begin(), decoded.begin() + duration_,
+                is_fec_ ? 2 : 1);
+      decoder_->num_fec_decodes_ += is_fec_;
+      return DecodeResult{duration_, kSpeech};
+    }
+
+   private:
+    FecDurationDecoder* const decoder_;
+    const size_t duration_;
+    const bool is_fec_;
+  };
+
+  const int sample_rate_hz_;
+  int num_fec_decodes_ = 0;
+};
+
+// This test verifies that FEC data that arrives partially late is used for the
+// part of its audio that was not played out yet, rather than concealing it.
+// This happens when the frame length grows, since the FEC in a packet covers
+// one of its own frames.
+TEST_F(NetEqImplTest, DecodesPartiallyLateFec) {
+  UseNoMocks();
+  CreateInstance();
+
+  const uint8_t kPayloadType = 17;
+  const int kSampleRateHz = 16000;
+  const size_t k10MsSamples = 10 * kSampleRateHz / 1000;
+  FecDurationDecoder decoder(kSampleRateHz);
+  EXPECT_EQ(NetEq::kOK, neteq_->RegisterExternalDecoder(
+                            &decoder, NetEqDecoder::kDecoderPCM16Bwb,
+                            "fec decoder", kPayloadType));
+
+  RTPHeader rtp_header;
+  rtp_header.payloadType = kPayloadType;
+  rtp_header.sequenceNumber = 0x1234;
+  rtp_header.timestamp = 0x12345678;
+  rtp_header.ssrc = 0x87654321;
+  const uint32_t first_timestamp = rtp_header.timestamp;
+
+  // A 10 ms packet.
+  uint8_t payload[] = {10, 0};
+  EXPECT_EQ(NetEq::kOK, neteq_->InsertPacket(rtp_header, payload, 0));
+  AudioFrame output;
+  bool muted;
+  EXPECT_EQ(NetEq::kOK, neteq_->GetAudio(&output, &muted));
+  EXPECT_EQ(AudioFrame::kNormalSpeech, output.speech_type_);
+  EXPECT_EQ(first_timestamp + k10MsSamples,
+            neteq_->sync_buffer_for_test()->end_timestamp());
+
+  // The next 10 ms packet is lost. The one after is 20 ms long, and its FEC
+  // covers the first packet as well as the lost one.
+  rtp_header.sequenceNumber += 2;
+  rtp_header.timestamp += 2 * k10MsSamples;
+  payload[0] = 20;
+  payload[1] = 20;
+  EXPECT_EQ(NetEq::kOK, neteq_->InsertPacket(rtp_header, payload, 0));
+  EXPECT_EQ(NetEq::kOK, neteq_->GetAudio(&output, &muted));
+  EXPECT_NE(kExpand, neteq_->last_operation_for_test());
+  EXPECT_EQ(AudioFrame::kNormalSpeech, output.speech_type_);
+  EXPECT_EQ(1, decoder.num_fec_decodes());
+  // Only the second half of the FEC frame is used.
+  EXPECT_EQ(first_timestamp + 2 * k10MsSamples,
+            neteq_->sync_buffer_for_test()->end_timestamp());
+
+  EXPECT_EQ(NetEq::kOK, neteq_->GetAudio(&output, &muted));
+  EXPECT_EQ(first_timestamp + 4 * k10MsSamples,
+            neteq_->sync_buffer_for_test()->end_timestamp());
+
+  const NetEqLifetimeStatistics stats = neteq_->GetLifetimeStatistics();
+  EXPECT_EQ(k10MsSamples, stats.secondary_decoded_samples);
+  EXPECT_EQ(0u, stats.concealed_samples);
+}
+
 // This test verifies that NetEq can handle the situation where the first
 // incoming packet is rejected.
 TEST_F(NetEqImplTest, FirstPacketUnknown) {
@@ -73,6 +73,11 @@ struct Packet {
   Priority priority;
   std::unique_ptr<TickTimer::Stopwatch> waiting_time;
   std::unique_ptr<AudioDecoder::EncodedAudioFrame> frame;
+  // Number of samples at the start of |frame| that were already played out
+  // when the packet was extracted, and that are dropped after decoding. Only
+  // set for redundant payloads that arrived partially late; see
+  // PacketBuffer::SalvageLateRedundantPacket.
+  size_t late_samples = 0;
 
   Packet();
   Packet(Packet&& b);
@@ -49,6 +49,10 @@ bool EqualSampleRates(uint8_t pt1,
   return di1 && di2 && di1->SampleRateHz() == di2->SampleRateHz();
 }
 
+size_t PacketBytes(const Packet& packet) {
+  return sizeof(packet) + packet.payload.size();
+}
+
 void LogPacketDiscarded(int codec_level, StatisticsCalculator* stats) {
   RTC_CHECK(stats);
   if (codec_level > 0) {
@@ -60,9 +64,13 @@ void LogPacketDiscarded(int codec_level, StatisticsCalculator* stats) {
 
 }  // namespace
 
+constexpr size_t PacketBuffer::kMaxPacketsUnderMemoryPressure;
+
 PacketBuffer::PacketBuffer(size_t max_number_of_packets,
                            const TickTimer* tick_timer)
-    : max_number_of_packets_(max_number_of_packets), tick_timer_(tick_timer) {}
+    : max_number_of_packets_(max_number_of_packets),
+      tick_timer_(tick_timer),
+      memory_account_(MemoryTag::kAudioPacketBuffer) {}
 
 // Destructor. All packets in the buffer will be destroyed.
 PacketBuffer::~PacketBuffer() {
@@ -72,6 +80,11 @@ PacketBuffer::~PacketBuffer() {
 // Flush the buffer. All packets in the buffer will be destroyed.
 void PacketBuffer::Flush() {
   buffer_.clear();
+  memory_account_.Clear();
+}
+
+void PacketBuffer::SetMemoryAccountant(MemoryAccountant* accountant) {
+  memory_account_.SetAccountant(accountant);
 }
 
 bool PacketBuffer::Empty() const {
@@ -91,7 +104,11 @@ int PacketBuffer::InsertPacket(Packet&& packet, StatisticsCalculator* stats) {
 
   packet.waiting_time = tick_timer_->GetNewStopwatch();
 
-  if (buffer_.size() >= max_number_of_packets_) {
+  const size_t max_number_of_packets =
+      memory_account_.OverBudget()
+          ? std::min(max_number_of_packets_, kMaxPacketsUnderMemoryPressure)
+          : max_number_of_packets_;
+  if (buffer_.size() >= max_number_of_packets) {
     // Buffer is full. Flush it.
     Flush();
     RTC_LOG(LS_WARNING) << "Packet buffer flushed";
@@ -119,8 +136,10 @@ int PacketBuffer::InsertPacket(Packet&& packet, StatisticsCalculator* stats) {
   PacketList::iterator it = rit.base();
   if (it != buffer_.end() && packet.timestamp == it->timestamp) {
     LogPacketDiscarded(packet.priority.codec_level, stats);
+    memory_account_.Subtract(PacketBytes(*it));
     it = buffer_.erase(it);
   }
+  memory_account_.Add(PacketBytes(packet));
   buffer_.insert(it, std::move(packet));  // Insert the packet at that position.
 
   return return_val;
@@ -212,6 +231,7 @@ rtc::Optional<Packet> PacketBuffer::GetNextPacket() {
     return rtc::nullopt;
   }
 
+  memory_account_.Subtract(PacketBytes(buffer_.front()));
   rtc::Optional<Packet> packet(std::move(buffer_.front()));
   // Assert that the packet sanity checks in InsertPacket method works.
   RTC_DCHECK(!packet->empty());
@@ -228,6 +248,7 @@ int PacketBuffer::DiscardNextPacket(StatisticsCalculator* stats) {
   const Packet& packet = buffer_.front();
   RTC_DCHECK(!packet.empty());
   LogPacketDiscarded(packet.priority.codec_level, stats);
+  memory_account_.Subtract(PacketBytes(packet));
   buffer_.pop_front();
   return kOK;
 }
@@ -235,14 +256,63 @@ int PacketBuffer::DiscardNextPacket(StatisticsCalculator* stats) {
 void PacketBuffer::DiscardOldPackets(uint32_t timestamp_limit,
                                      uint32_t horizon_samples,
                                      StatisticsCalculator* stats) {
-  buffer_.remove_if([timestamp_limit, horizon_samples, stats](const Packet& p) {
-    if (timestamp_limit == p.timestamp ||
-        !IsObsoleteTimestamp(p.timestamp, timestamp_limit, horizon_samples)) {
-      return false;
+  buffer_.remove_if(
+      [this, timestamp_limit, horizon_samples, stats](const Packet& p) {
+        if (timestamp_limit == p.timestamp ||
+            !IsObsoleteTimestamp(p.timestamp, timestamp_limit,
+                                 horizon_samples)) {
+          return false;
+        }
+        LogPacketDiscarded(p.priority.codec_level, stats);
+        memory_account_.Subtract(PacketBytes(p));
+        return true;
+      });
+}
+
+bool PacketBuffer::SalvageLateRedundantPacket(uint32_t timestamp_limit) {
+  PacketList::iterator salvaged = buffer_.end();
+  uint32_t salvaged_end_timestamp = 0;
+  for (auto it = buffer_.begin(); it != buffer_.end(); ++it) {
+    if (!IsObsoleteTimestamp(it->timestamp, timestamp_limit, 0)) {
+      if (it->timestamp == timestamp_limit) {
+        // The audio at |timestamp_limit| is available as it is.
+        return false;
+      }
+      break;
     }
-    LogPacketDiscarded(p.priority.codec_level, stats);
-    return true;
-  });
+    if (it->priority == Packet::Priority(0, 0) || !it->frame) {
+      continue;
+    }
+    // A packet that was salvaged before, but not decoded, already starts
+    // |late_samples| into its frame.
+    RTC_DCHECK_LT(it->late_samples, it->frame->Duration());
+    const size_t duration = it->frame->Duration() - it->late_samples;
+    const uint32_t late_samples = timestamp_limit - it->timestamp;
+    if (duration <= late_samples) {
+      continue;
+    }
+    // Prefer the packet with the most audio left to play.
+    const uint32_t end_timestamp =
+        static_cast<uint32_t>(it->timestamp + duration);
+    if (salvaged == buffer_.end() ||
+        IsNewerTimestamp(end_timestamp, salvaged_end_timestamp)) {
+      salvaged = it;
+      salvaged_end_timestamp = end_timestamp;
+    }
+  }
+  if (salvaged == buffer_.end()) {
+    return false;
+  }
+  // Keep the buffer sorted by moving the salvaged packet after the old ones,
+  // which are about to be discarded.
+  auto first_current = std::find_if(
+      salvaged, buffer_.end(), [timestamp_limit](const Packet& p) {
+        return !IsObsoleteTimestamp(p.timestamp, timestamp_limit, 0);
+      });
+  buffer_.splice(first_current, buffer_, salvaged);
+  salvaged->late_samples += timestamp_limit - salvaged->timestamp;
+  salvaged->timestamp = timestamp_limit;
+  return true;
 }
 
 void PacketBuffer::DiscardAllOldPackets(uint32_t timestamp_limit,
@@ -252,11 +322,12 @@ void PacketBuffer::DiscardAllOldPackets(uint32_t timestamp_limit,
 
 void PacketBuffer::DiscardPacketsWithPayloadType(uint8_t payload_type,
                                                  StatisticsCalculator* stats) {
-  buffer_.remove_if([payload_type, stats](const Packet& p) {
+  buffer_.remove_if([this, payload_type, stats](const Packet& p) {
     if (p.payload_type != payload_type) {
       return false;
     }
     LogPacketDiscarded(p.priority.codec_level, stats);
+    memory_account_.Subtract(PacketBytes(p));
     return true;
   });
 }
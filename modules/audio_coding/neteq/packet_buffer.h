@@ -15,6 +15,7 @@
 #include "modules/audio_coding/neteq/packet.h"
 #include "modules/include/module_common_types.h"
 #include "rtc_base/constructormagic.h"
+#include "rtc_base/memory_accountant.h"
 #include "typedefs.h"  // NOLINT(build/include)
 
 namespace webrtc {
@@ -42,6 +43,11 @@ class PacketBuffer {
   // Deletes all packets in the buffer before destroying the buffer.
   virtual ~PacketBuffer();
 
+  // Accounts the buffered packets with |accountant|, which may be null. While
+  // it is over budget, the buffer is flushed at a lower number of packets,
+  // see kMaxPacketsUnderMemoryPressure.
+  void SetMemoryAccountant(MemoryAccountant* accountant);
+
   // Flushes the buffer and deletes all packets in it.
   virtual void Flush();
 
@@ -105,6 +111,16 @@ class PacketBuffer {
                                  uint32_t horizon_samples,
                                  StatisticsCalculator* stats);
 
+  // Looks for redundant (FEC or RED) data for the audio at |timestamp_limit|,
+  // in case no packet starts there. A redundant packet that starts before
+  // |timestamp_limit| but ends after it arrived partially late, and would be
+  // discarded as old although it still holds audio that has not been played
+  // out. Such a packet is moved to start at |timestamp_limit|, and the part
+  // already played is added to its |late_samples|. A packet that is salvaged
+  // again, because it wasn't decoded in time, keeps adding to them. Returns
+  // true if a packet was moved.
+  virtual bool SalvageLateRedundantPacket(uint32_t timestamp_limit);
+
   // Discards all packets that are (strictly) older than timestamp_limit.
   virtual void DiscardAllOldPackets(uint32_t timestamp_limit,
                                     StatisticsCalculator* stats);
@@ -137,10 +153,18 @@ class PacketBuffer {
             IsNewerTimestamp(timestamp, timestamp_limit - horizon_samples));
   }
 
+  // The number of packets the buffer is flushed at while the memory budget is
+  // exceeded, if lower than |max_number_of_packets|. About one second of 20 ms
+  // packets.
+  static constexpr size_t kMaxPacketsUnderMemoryPressure = 50;
+
  private:
   size_t max_number_of_packets_;
   PacketList buffer_;
   const TickTimer* tick_timer_;
+  // Counts the packets and their payloads. Parsed payloads are held by
+  // |Packet::frame| and not counted.
+  MemoryAccount memory_account_;
   RTC_DISALLOW_COPY_AND_ASSIGN(PacketBuffer);
 };
 
@@ -16,6 +16,8 @@
 #include "modules/audio_coding/neteq/mock/mock_statistics_calculator.h"
 #include "modules/audio_coding/neteq/packet.h"
 #include "modules/audio_coding/neteq/tick_timer.h"
+#include "rtc_base/memory_accountant.h"
+#include "rtc_base/refcountedobject.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
 
@@ -65,6 +67,34 @@ Packet PacketGenerator::NextPacket(int payload_size_bytes) {
   return packet;
 }
 
+// Frame of a given duration, for packets that are never decoded.
+class FakeFrame : public AudioDecoder::EncodedAudioFrame {
+ public:
+  explicit FakeFrame(size_t duration) : duration_(duration) {}
+  size_t Duration() const override { return duration_; }
+  rtc::Optional<DecodeResult> Decode(
+      rtc::ArrayView<int16_t> decoded) const override {
+    ADD_FAILURE() << "Not expected to be decoded";
+    return rtc::nullopt;
+  }
+
+ private:
+  const size_t duration_;
+};
+
+Packet MakePacketWithFrame(uint16_t sequence_number,
+                           uint32_t timestamp,
+                           Packet::Priority priority,
+                           size_t duration) {
+  Packet packet;
+  packet.sequence_number = sequence_number;
+  packet.timestamp = timestamp;
+  packet.payload_type = 0;
+  packet.priority = priority;
+  packet.frame.reset(new FakeFrame(duration));
+  return packet;
+}
+
 struct PacketsToInsert {
   uint16_t sequence_number;
   uint32_t timestamp;
@@ -160,6 +190,60 @@ TEST(PacketBuffer, OverfillBuffer) {
   buffer.Flush();
 }
 
+TEST(PacketBuffer, AccountsBufferedPackets) {
+  TickTimer tick_timer;
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  PacketBuffer buffer(10, &tick_timer);  // 10 packets.
+  buffer.SetMemoryAccountant(accountant);
+  PacketGenerator gen(0, 0, 0, 10);
+  StrictMock<MockStatisticsCalculator> mock_stats;
+
+  const int payload_len = 100;
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(PacketBuffer::kOK,
+              buffer.InsertPacket(gen.NextPacket(payload_len), &mock_stats));
+  }
+  const int64_t packet_bytes = sizeof(Packet) + payload_len;
+  EXPECT_EQ(5 * packet_bytes, accountant->GetUsage().total_bytes);
+
+  EXPECT_TRUE(buffer.GetNextPacket());
+  EXPECT_EQ(4 * packet_bytes, accountant->GetUsage().total_bytes);
+
+  buffer.Flush();
+  EXPECT_EQ(0, accountant->GetUsage().total_bytes);
+}
+
+// Over the memory budget, the buffer is flushed at
+// kMaxPacketsUnderMemoryPressure packets instead of its own limit.
+TEST(PacketBuffer, FlushesEarlierOverMemoryBudget) {
+  TickTimer tick_timer;
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  accountant->SetSoftBudget(1);
+  PacketBuffer buffer(200, &tick_timer);  // 200 packets.
+  buffer.SetMemoryAccountant(accountant);
+  PacketGenerator gen(0, 0, 0, 10);
+  StrictMock<MockStatisticsCalculator> mock_stats;
+
+  const int payload_len = 10;
+  for (size_t i = 0; i < PacketBuffer::kMaxPacketsUnderMemoryPressure; ++i) {
+    EXPECT_EQ(PacketBuffer::kOK,
+              buffer.InsertPacket(gen.NextPacket(payload_len), &mock_stats));
+  }
+  EXPECT_EQ(PacketBuffer::kFlushed,
+            buffer.InsertPacket(gen.NextPacket(payload_len), &mock_stats));
+  EXPECT_EQ(1u, buffer.NumPacketsInBuffer());
+
+  // Without a budget, the buffer grows to its own limit.
+  accountant->SetSoftBudget(0);
+  for (size_t i = 1; i < 200; ++i) {
+    EXPECT_EQ(PacketBuffer::kOK,
+              buffer.InsertPacket(gen.NextPacket(payload_len), &mock_stats));
+  }
+  EXPECT_EQ(200u, buffer.NumPacketsInBuffer());
+}
+
 // Test inserting a list of packets.
 TEST(PacketBuffer, InsertPacketList) {
   TickTimer tick_timer;
@@ -380,6 +464,79 @@ TEST(PacketBuffer, DiscardPackets) {
   EXPECT_TRUE(buffer.Empty());
 }
 
+TEST(PacketBuffer, SalvagesPartiallyLateRedundantPacket) {
+  TickTimer tick_timer;
+  PacketBuffer buffer(10, &tick_timer);
+  MockStatisticsCalculator mock_stats;
+  const Packet::Priority kPrimary(0, 0);
+  const Packet::Priority kFec(1, 0);
+  // Audio up to timestamp 200 was played out. The FEC packet carried by
+  // packet 3 covers 160 to 240; the primary packet 2 for that time was lost.
+  buffer.InsertPacket(MakePacketWithFrame(1, 100, kPrimary, 80), &mock_stats);
+  buffer.InsertPacket(MakePacketWithFrame(3, 160, kFec, 80), &mock_stats);
+  buffer.InsertPacket(MakePacketWithFrame(3, 240, kPrimary, 80), &mock_stats);
+
+  EXPECT_TRUE(buffer.SalvageLateRedundantPacket(200));
+  EXPECT_CALL(mock_stats, PacketsDiscarded(1));
+  buffer.DiscardAllOldPackets(200, &mock_stats);
+
+  ASSERT_EQ(2u, buffer.NumPacketsInBuffer());
+  rtc::Optional<Packet> packet = buffer.GetNextPacket();
+  EXPECT_EQ(200u, packet->timestamp);
+  EXPECT_EQ(40u, packet->late_samples);
+  EXPECT_EQ(kFec, packet->priority);
+  packet = buffer.GetNextPacket();
+  EXPECT_EQ(240u, packet->timestamp);
+  EXPECT_EQ(0u, packet->late_samples);
+}
+
+TEST(PacketBuffer, SalvagesRedundantPacketAgainIfNotDecoded) {
+  TickTimer tick_timer;
+  PacketBuffer buffer(10, &tick_timer);
+  MockStatisticsCalculator mock_stats;
+  const Packet::Priority kFec(1, 0);
+  // The FEC packet covers 160 to 240. It is salvaged at 200, but the audio
+  // up to 220 is concealed before it is decoded.
+  buffer.InsertPacket(MakePacketWithFrame(3, 160, kFec, 80), &mock_stats);
+  EXPECT_TRUE(buffer.SalvageLateRedundantPacket(200));
+  EXPECT_TRUE(buffer.SalvageLateRedundantPacket(220));
+
+  rtc::Optional<Packet> packet = buffer.GetNextPacket();
+  ASSERT_TRUE(packet);
+  EXPECT_EQ(220u, packet->timestamp);
+  EXPECT_EQ(60u, packet->late_samples);
+  EXPECT_TRUE(buffer.Empty());
+
+  // Once the rest of its audio has been played out, it is not salvaged.
+  buffer.InsertPacket(std::move(*packet), &mock_stats);
+  EXPECT_FALSE(buffer.SalvageLateRedundantPacket(240));
+}
+
+TEST(PacketBuffer, OnlySalvagesRedundantPacketsWithAudioLeft) {
+  TickTimer tick_timer;
+  PacketBuffer buffer(10, &tick_timer);
+  MockStatisticsCalculator mock_stats;
+  const Packet::Priority kPrimary(0, 0);
+  const Packet::Priority kRed(0, 1);
+  // A late primary packet, and a redundant packet that ends where the
+  // played out audio does.
+  buffer.InsertPacket(MakePacketWithFrame(1, 160, kPrimary, 80), &mock_stats);
+  buffer.InsertPacket(MakePacketWithFrame(2, 120, kRed, 80), &mock_stats);
+  EXPECT_FALSE(buffer.SalvageLateRedundantPacket(200));
+
+  // Nothing is salvaged when the audio at the limit is available anyway.
+  buffer.InsertPacket(MakePacketWithFrame(3, 170, kRed, 80), &mock_stats);
+  buffer.InsertPacket(MakePacketWithFrame(4, 200, kPrimary, 80), &mock_stats);
+  EXPECT_FALSE(buffer.SalvageLateRedundantPacket(200));
+
+  for (uint32_t timestamp : {120u, 160u, 170u, 200u}) {
+    rtc::Optional<Packet> packet = buffer.GetNextPacket();
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(timestamp, packet->timestamp);
+    EXPECT_EQ(0u, packet->late_samples);
+  }
+}
+
 TEST(PacketBuffer, Reordering) {
   TickTimer tick_timer;
   PacketBuffer buffer(100, &tick_timer);  // 100 packets.
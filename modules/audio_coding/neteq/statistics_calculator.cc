@@ -236,6 +236,7 @@ void StatisticsCalculator::JitterBufferDelay(size_t num_samples,
 
 void StatisticsCalculator::SecondaryDecodedSamples(int num_samples) {
   secondary_decoded_samples_ += num_samples;
+  lifetime_stats_.secondary_decoded_samples += num_samples;
 }
 
 void StatisticsCalculator::LogDelayedPacketOutageEvent(int outage_duration_ms) {
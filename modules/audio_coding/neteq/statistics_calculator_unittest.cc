@@ -63,6 +63,24 @@ TEST(LifetimeStatistics, NoUpdateOnTimeStretch) {
   EXPECT_EQ(200u, stats.GetLifetimeStatistics().concealed_samples);
 }
 
+TEST(LifetimeStatistics, SecondaryDecodedSamples) {
+  StatisticsCalculator stats;
+  stats.SecondaryDecodedSamples(480);
+  stats.ExpandedVoiceSamples(100, true);
+  stats.SecondaryDecodedSamples(960);
+  NetEqLifetimeStatistics lifetime_stats = stats.GetLifetimeStatistics();
+  EXPECT_EQ(480u + 960u, lifetime_stats.secondary_decoded_samples);
+  EXPECT_EQ(100u, lifetime_stats.concealed_samples);
+
+  // Unlike the network statistics, the lifetime statistics are not reset when
+  // read.
+  NetEqNetworkStatistics stats_output;
+  stats.IncreaseCounter(480, 48000);
+  stats.GetNetworkStatistics(48000, 0, 960, &stats_output);
+  EXPECT_EQ(480u + 960u,
+            stats.GetLifetimeStatistics().secondary_decoded_samples);
+}
+
 TEST(StatisticsCalculator, ExpandedSamplesCorrection) {
   StatisticsCalculator stats;
   NetEqNetworkStatistics stats_output;
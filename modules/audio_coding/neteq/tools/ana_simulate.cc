@@ -0,0 +1,236 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "api/audio_codecs/audio_decoder_factory_template.h"
+#include "api/audio_codecs/opus/audio_decoder_opus.h"
+#include "api/audio_codecs/opus/audio_encoder_opus.h"
+#include "modules/audio_coding/neteq/tools/ana_simulator.h"
+#include "modules/audio_coding/neteq/tools/resample_input_audio_file.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/flags.h"
+#include "rtc_base/stringencode.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// Define command line flags.
+DEFINE_string(input, "", "Mono 16-bit PCM file with the audio to send");
+DEFINE_int(input_sample_rate, 16000, "Sample rate of the input file");
+DEFINE_string(traces, "", "Comma-separated network trace files");
+DEFINE_string(ana_configs,
+              "none",
+              "Comma-separated files with serialized ANA configs "
+              "(audio_network_adaptor::config::ControllerManager); \"none\" "
+              "runs Opus without ANA");
+DEFINE_int(bitrate, 32000, "Initial Opus bitrate in bps");
+DEFINE_int(frame_len, 20, "Initial Opus frame length in ms");
+DEFINE_bool(fec, false, "Start with Opus in-band FEC enabled");
+DEFINE_bool(dtx, false, "Start with Opus DTX enabled");
+DEFINE_int(min_frame_len, 20, "Shortest frame length the receiver accepts");
+DEFINE_int(max_frame_len, 120, "Longest frame length the receiver accepts");
+DEFINE_int(duration, 0, "Simulated time in ms; 0 runs to the end of a trace");
+DEFINE_int(max_queue_delay, 500, "Bottleneck queue size in ms");
+DEFINE_float(loss_burst_length, 1.0f, "Mean length of loss bursts");
+DEFINE_int(feedback_interval, 1000, "Time between network updates in ms");
+DEFINE_int(runs, 1, "Runs per trace and config, with different random seeds");
+DEFINE_int(seed, 1, "Random seed of the first run");
+DEFINE_int(num_shards,
+           1,
+           "Split the runs into this many shards, to run them in parallel in "
+           "separate processes");
+DEFINE_int(shard_index, 0, "The shard of the runs to run");
+DEFINE_bool(help, false, "Print this message");
+
+constexpr int kPayloadType = 111;
+
+class AudioFileGenerator : public EncodeNetEqInput::Generator {
+ public:
+  AudioFileGenerator(const std::string& file_name,
+                     int file_rate_hz,
+                     int output_rate_hz)
+      : input_file_(file_name, file_rate_hz, output_rate_hz) {}
+
+  rtc::ArrayView<const int16_t> Generate(size_t num_samples) override {
+    samples_.resize(num_samples);
+    RTC_CHECK(input_file_.Read(num_samples, samples_.data()));
+    return samples_;
+  }
+
+ private:
+  ResampleInputAudioFile input_file_;  // Loops at the end of the file.
+  std::vector<int16_t> samples_;
+};
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  RTC_CHECK(file) << "Could not open " << file_name;
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+std::unique_ptr<AudioEncoder> CreateEncoder(const std::string& ana_config) {
+  AudioEncoderOpusConfig config;
+  config.bitrate_bps = FLAG_bitrate;
+  config.frame_size_ms = FLAG_frame_len;
+  config.fec_enabled = FLAG_fec;
+  config.dtx_enabled = FLAG_dtx;
+  RTC_CHECK(config.IsOk());
+  std::unique_ptr<AudioEncoder> encoder =
+      AudioEncoderOpus::MakeAudioEncoder(config, kPayloadType);
+  if (!ana_config.empty()) {
+    RTC_CHECK(encoder->EnableAudioNetworkAdaptor(ana_config, nullptr))
+        << "Invalid ANA config";
+  }
+  encoder->SetReceiverFrameLengthRange(FLAG_min_frame_len,
+                                       FLAG_max_frame_len);
+  return encoder;
+}
+
+void PrintOptional(const rtc::Optional<uint32_t>& value) {
+  if (value)
+    printf(",%u", *value);
+  else
+    printf(",");
+}
+
+int RunAnaSimulate(int argc, char* argv[]) {
+  const std::string program_name = argv[0];
+  const std::string usage =
+      "Tool for evaluating audio network adaptor (ANA) configs offline, by\n"
+      "running Opus with each config over recorded uplink traces, and\n"
+      "decoding the result with NetEq. Prints one CSV line per run.\n"
+      "Network traces are text files with one sample per line,\n"
+      "  <time_ms> <uplink_bandwidth_bps> <packet_loss_fraction> [<rtt_ms>]\n"
+      "Run " +
+      program_name +
+      " --help for usage.\n"
+      "Example usage:\n" +
+      program_name +
+      " --input=speech.pcm --traces=lte.txt,wifi.txt "
+      "--ana_configs=none,ana_a.pb,ana_b.pb --runs=4\n"
+      "Each process runs one simulation at a time. To use several cores, run\n"
+      "one process per shard with --num_shards and --shard_index; only\n"
+      "shard 0 prints the CSV header.\n\n";
+  if (rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true) || FLAG_help ||
+      argc != 1 || strlen(FLAG_input) == 0 || strlen(FLAG_traces) == 0 ||
+      FLAG_num_shards < 1 || FLAG_shard_index < 0 ||
+      FLAG_shard_index >= FLAG_num_shards) {
+    printf("%s", usage.c_str());
+    if (FLAG_help) {
+      rtc::FlagList::Print(nullptr, false);
+      return 0;
+    }
+    return 1;
+  }
+
+  std::vector<std::string> trace_files;
+  rtc::split(FLAG_traces, ',', &trace_files);
+  std::vector<std::vector<NetworkTraceSample>> traces(trace_files.size());
+  for (size_t i = 0; i < trace_files.size(); ++i) {
+    if (!ParseNetworkTrace(ReadFile(trace_files[i]), &traces[i]) ||
+        traces[i].empty()) {
+      fprintf(stderr, "Malformed network trace %s\n", trace_files[i].c_str());
+      return 1;
+    }
+  }
+  std::vector<std::string> config_files;
+  rtc::split(FLAG_ana_configs, ',', &config_files);
+  std::vector<std::string> ana_configs;
+  for (const std::string& config_file : config_files)
+    ana_configs.push_back(config_file == "none" ? "" : ReadFile(config_file));
+
+  AnaSimulator::Config config;
+  config.duration_ms = FLAG_duration;
+  config.payload_type = kPayloadType;
+  config.max_queue_delay_ms = FLAG_max_queue_delay;
+  config.mean_loss_burst_length = FLAG_loss_burst_length;
+  config.feedback_interval_ms = FLAG_feedback_interval;
+
+  struct Run {
+    size_t trace_index;
+    size_t config_index;
+    uint64_t seed;
+  };
+  std::vector<Run> runs;
+  for (size_t trace_index = 0; trace_index < traces.size(); ++trace_index) {
+    for (size_t config_index = 0; config_index < ana_configs.size();
+         ++config_index) {
+      for (int run = 0; run < FLAG_runs; ++run) {
+        runs.push_back({trace_index, config_index,
+                        static_cast<uint64_t>(FLAG_seed + run)});
+      }
+    }
+  }
+
+  if (FLAG_shard_index == 0) {
+    printf(
+        "trace,ana_config,seed,available_bandwidth_bps,send_bitrate_bps,"
+        "encoder_target_bitrate_bps,bandwidth_utilization,packet_rate,"
+        "frame_length_ms,random_loss_fraction,congestion_loss_fraction,"
+        "mean_queue_delay_ms,max_queue_delay_ms,concealed_fraction,"
+        "secondary_decoded_fraction,concealment_events,"
+        "jitter_buffer_delay_ms,bitrate_actions,fec_actions,dtx_actions,"
+        "frame_length_increases,frame_length_decreases\n");
+  }
+  for (size_t i = FLAG_shard_index; i < runs.size(); i += FLAG_num_shards) {
+    const Run& run = runs[i];
+    const std::string& ana_config = ana_configs[run.config_index];
+    config.random_seed = run.seed;
+    AnaSimulator simulator(
+        config, traces[run.trace_index],
+        [&ana_config] { return CreateEncoder(ana_config); },
+        std::unique_ptr<EncodeNetEqInput::Generator>(new AudioFileGenerator(
+            FLAG_input, FLAG_input_sample_rate, 48000)),
+        SdpAudioFormat("opus", 48000, 2),
+        CreateAudioDecoderFactory<AudioDecoderOpus>());
+    const AnaSimulationResult result = simulator.Run();
+    printf("%s,%s,%llu,%d,%d,%d,%.3f,%.1f,%.1f,%.4f,%.4f,%.1f,%d,%.4f,%.4f,"
+           "%llu,%.1f",
+           trace_files[run.trace_index].c_str(),
+           config_files[run.config_index].c_str(),
+           static_cast<unsigned long long>(run.seed),  // NOLINT
+           result.available_bandwidth_bps, result.send_bitrate_bps,
+           result.encoder_target_bitrate_bps, result.bandwidth_utilization,
+           result.packet_rate, result.frame_length_ms,
+           result.random_loss_fraction, result.congestion_loss_fraction,
+           result.mean_queue_delay_ms, result.max_queue_delay_ms,
+           result.concealed_fraction, result.secondary_decoded_fraction,
+           static_cast<unsigned long long>(  // NOLINT
+               result.concealment_events),
+           result.jitter_buffer_delay_ms);
+    PrintOptional(result.ana_stats.bitrate_action_counter);
+    PrintOptional(result.ana_stats.fec_action_counter);
+    PrintOptional(result.ana_stats.dtx_action_counter);
+    PrintOptional(result.ana_stats.frame_length_increase_counter);
+    PrintOptional(result.ana_stats.frame_length_decrease_counter);
+    printf("\n");
+    fflush(stdout);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace webrtc
+
+int main(int argc, char* argv[]) {
+  return webrtc::test::RunAnaSimulate(argc, argv);
+}
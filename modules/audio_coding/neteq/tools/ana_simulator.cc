@@ -0,0 +1,321 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/tools/ana_simulator.h"
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+#include <utility>
+
+#include "common_types.h"  // NOLINT(build/include)
+#include "modules/audio_coding/neteq/include/neteq.h"
+#include "modules/include/module_common_types.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/fakeclock.h"
+#include "rtc_base/numerics/safe_conversions.h"
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+constexpr int64_t kBlockMs = 10;
+constexpr uint32_t kSsrc = 0x1234;
+
+struct InFlightPacket {
+  int64_t arrival_ms;
+  RTPHeader header;
+  rtc::Buffer payload;
+};
+
+// Bursty packet loss, using a Gilbert-Elliott model where every packet is lost
+// in the bad state and none in the good state.
+class BurstyLossModel {
+ public:
+  BurstyLossModel(float mean_burst_length, uint64_t seed)
+      : leave_bad_probability_(1.0f / std::max(mean_burst_length, 1.0f)),
+        random_(seed) {}
+
+  bool Lost(float loss_fraction) {
+    if (in_bad_state_) {
+      in_bad_state_ = random_.Rand<float>() >= leave_bad_probability_;
+    } else if (loss_fraction > 0.0f) {
+      // The fraction of time spent in the bad state is the loss fraction.
+      const float enter_bad_probability =
+          loss_fraction >= 1.0f ? 1.0f
+                                : loss_fraction * leave_bad_probability_ /
+                                      (1.0f - loss_fraction);
+      in_bad_state_ = random_.Rand<float>() < enter_bad_probability;
+    }
+    return in_bad_state_;
+  }
+
+ private:
+  const float leave_bad_probability_;
+  Random random_;
+  bool in_bad_state_ = false;
+};
+
+}  // namespace
+
+bool ParseNetworkTrace(const std::string& text,
+                       std::vector<NetworkTraceSample>* trace) {
+  RTC_DCHECK(trace);
+  std::vector<NetworkTraceSample> samples;
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream fields(line);
+    std::string first;
+    if (!(fields >> first) || first[0] == '#')
+      continue;  // Empty line or comment.
+    fields.seekg(0);
+    NetworkTraceSample sample;
+    if (!(fields >> sample.time_ms >> sample.uplink_bandwidth_bps >>
+          sample.packet_loss_fraction)) {
+      return false;
+    }
+    // The RTT is optional, but nothing else may follow.
+    std::string rest;
+    if (fields >> rest) {
+      std::istringstream rtt(rest);
+      if (!(rtt >> sample.rtt_ms) || !rtt.eof() || fields >> rest)
+        return false;
+    }
+    if (sample.uplink_bandwidth_bps < 0 || sample.packet_loss_fraction < 0 ||
+        sample.packet_loss_fraction > 1 || sample.rtt_ms < 0) {
+      return false;
+    }
+    if (!samples.empty() && sample.time_ms <= samples.back().time_ms)
+      return false;
+    samples.push_back(sample);
+  }
+  *trace = std::move(samples);
+  return true;
+}
+
+AnaSimulator::AnaSimulator(
+    const Config& config,
+    std::vector<NetworkTraceSample> trace,
+    EncoderFactory encoder_factory,
+    std::unique_ptr<EncodeNetEqInput::Generator> generator,
+    const SdpAudioFormat& format,
+    rtc::scoped_refptr<AudioDecoderFactory> decoder_factory)
+    : config_(config),
+      trace_(std::move(trace)),
+      encoder_factory_(std::move(encoder_factory)),
+      generator_(std::move(generator)),
+      format_(format),
+      decoder_factory_(std::move(decoder_factory)) {
+  RTC_DCHECK(!trace_.empty());
+  RTC_DCHECK(encoder_factory_);
+  RTC_DCHECK(generator_);
+  RTC_DCHECK_GT(config_.feedback_interval_ms, 0);
+}
+
+AnaSimulator::~AnaSimulator() = default;
+
+AnaSimulationResult AnaSimulator::Run() {
+  const int64_t duration_ms =
+      config_.duration_ms > 0 ? config_.duration_ms : trace_.back().time_ms;
+  RTC_CHECK_GT(duration_ms, 0);
+
+  // Set to |now_ms| in each block.
+  rtc::ScopedFakeClock clock;
+  const std::unique_ptr<AudioEncoder> encoder = encoder_factory_();
+  RTC_CHECK(encoder);
+
+  NetEq::Config neteq_config;
+  neteq_config.sample_rate_hz = config_.output_sample_rate_hz;
+  std::unique_ptr<NetEq> neteq(NetEq::Create(neteq_config, decoder_factory_));
+  RTC_CHECK(neteq->RegisterPayloadType(config_.payload_type, format_));
+
+  BurstyLossModel loss_model(config_.mean_loss_burst_length,
+                             config_.random_seed);
+  encoder->OnReceivedOverhead(config_.overhead_bytes_per_packet);
+
+  const size_t samples_per_block = rtc::CheckedDivExact(
+      static_cast<int>(encoder->SampleRateHz() * kBlockMs), 1000);
+  const uint32_t timestamps_per_block = rtc::dchecked_cast<uint32_t>(
+      samples_per_block * encoder->RtpTimestampRateHz() /
+      encoder->SampleRateHz());
+
+  size_t trace_index = 0;
+  int64_t next_feedback_ms = 0;
+  // Packets sent and lost since the last feedback. Losses right after a
+  // received packet could be recovered with 1st order FEC.
+  int feedback_sent_packets = 0;
+  int feedback_lost_packets = 0;
+  int feedback_recoverable_lost_packets = 0;
+  bool previous_packet_lost = false;
+
+  // The bottleneck link is busy sending queued packets until |link_free_ms|.
+  double link_free_ms = 0;
+  std::deque<InFlightPacket> in_flight_packets;
+  uint32_t rtp_timestamp = 0;
+  uint16_t sequence_number = 0;
+  rtc::Buffer encoded;
+  AudioFrame audio_frame;
+
+  int64_t available_bits_ms = 0;
+  int64_t target_bits_ms = 0;
+  int64_t sent_bytes = 0;
+  int sent_packets = 0;
+  int random_lost_packets = 0;
+  int congestion_lost_packets = 0;
+  double queue_delay_sum_ms = 0;
+  double max_queue_delay_ms = 0;
+
+  for (int64_t now_ms = 0; now_ms < duration_ms; now_ms += kBlockMs) {
+    clock.SetTimeMicros(now_ms * rtc::kNumMicrosecsPerMillisec);
+    while (trace_index + 1 < trace_.size() &&
+           trace_[trace_index + 1].time_ms <= now_ms) {
+      ++trace_index;
+    }
+    const NetworkTraceSample& network = trace_[trace_index];
+    available_bits_ms += network.uplink_bandwidth_bps * kBlockMs;
+
+    if (now_ms >= next_feedback_ms) {
+      encoder->OnReceivedUplinkBandwidth(network.uplink_bandwidth_bps,
+                                          rtc::nullopt);
+      if (network.rtt_ms > 0)
+        encoder->OnReceivedRtt(network.rtt_ms);
+      if (feedback_sent_packets > 0) {
+        encoder->OnReceivedUplinkPacketLossFraction(
+            static_cast<float>(feedback_lost_packets) / feedback_sent_packets);
+        encoder->OnReceivedUplinkRecoverablePacketLossFraction(
+            static_cast<float>(feedback_recoverable_lost_packets) /
+            feedback_sent_packets);
+      }
+      feedback_sent_packets = 0;
+      feedback_lost_packets = 0;
+      feedback_recoverable_lost_packets = 0;
+      next_feedback_ms += config_.feedback_interval_ms;
+    }
+
+    // Receive side.
+    while (!in_flight_packets.empty() &&
+           in_flight_packets.front().arrival_ms <= now_ms) {
+      const InFlightPacket& packet = in_flight_packets.front();
+      const int error = neteq->InsertPacket(
+          packet.header, packet.payload,
+          static_cast<uint32_t>(packet.arrival_ms *
+                                config_.output_sample_rate_hz / 1000));
+      RTC_CHECK_EQ(error, NetEq::kOK);
+      in_flight_packets.pop_front();
+    }
+    bool muted;
+    RTC_CHECK_EQ(neteq->GetAudio(&audio_frame, &muted), NetEq::kOK);
+
+    // Send side. A packet is sent when the audio it holds has been captured.
+    target_bits_ms += encoder->GetTargetBitrate() * kBlockMs;
+    encoded.Clear();
+    const AudioEncoder::EncodedInfo info = encoder->Encode(
+        rtp_timestamp, generator_->Generate(samples_per_block), &encoded);
+    rtp_timestamp += timestamps_per_block;
+    if (encoded.size() == 0)
+      continue;
+
+    const double send_ms = now_ms + kBlockMs;
+    const size_t packet_bytes =
+        encoded.size() + config_.overhead_bytes_per_packet;
+    ++sent_packets;
+    ++feedback_sent_packets;
+    sent_bytes += packet_bytes;
+
+    bool lost = false;
+    const double start_ms = std::max(link_free_ms, send_ms);
+    if (network.uplink_bandwidth_bps <= 0 ||
+        start_ms - send_ms > config_.max_queue_delay_ms) {
+      ++congestion_lost_packets;
+      lost = true;
+    } else {
+      link_free_ms =
+          start_ms + packet_bytes * 8 * 1000.0 / network.uplink_bandwidth_bps;
+      const double queue_delay_ms = link_free_ms - send_ms;
+      queue_delay_sum_ms += queue_delay_ms;
+      max_queue_delay_ms = std::max(max_queue_delay_ms, queue_delay_ms);
+      if (loss_model.Lost(network.packet_loss_fraction)) {
+        ++random_lost_packets;
+        lost = true;
+      }
+    }
+
+    if (lost) {
+      ++feedback_lost_packets;
+      if (!previous_packet_lost)
+        ++feedback_recoverable_lost_packets;
+    } else {
+      InFlightPacket packet;
+      packet.arrival_ms = static_cast<int64_t>(link_free_ms) +
+                          network.rtt_ms / 2;
+      // Keep the link in order, even if the RTT drops.
+      if (!in_flight_packets.empty()) {
+        packet.arrival_ms =
+            std::max(packet.arrival_ms, in_flight_packets.back().arrival_ms);
+      }
+      packet.header.payloadType = info.payload_type;
+      packet.header.sequenceNumber = sequence_number;
+      packet.header.timestamp = info.encoded_timestamp;
+      packet.header.ssrc = kSsrc;
+      packet.payload.SetData(encoded.data(), encoded.size());
+      in_flight_packets.push_back(std::move(packet));
+    }
+    previous_packet_lost = lost;
+    ++sequence_number;
+  }
+
+  AnaSimulationResult result;
+  result.available_bandwidth_bps =
+      rtc::dchecked_cast<int>(available_bits_ms / duration_ms);
+  result.send_bitrate_bps =
+      rtc::dchecked_cast<int>(sent_bytes * 8 * 1000 / duration_ms);
+  result.encoder_target_bitrate_bps =
+      rtc::dchecked_cast<int>(target_bits_ms / duration_ms);
+  if (result.available_bandwidth_bps > 0) {
+    result.bandwidth_utilization =
+        static_cast<float>(result.send_bitrate_bps) /
+        result.available_bandwidth_bps;
+  }
+  result.packet_rate = sent_packets * 1000.0f / duration_ms;
+  if (sent_packets > 0) {
+    result.frame_length_ms = static_cast<float>(duration_ms) / sent_packets;
+    result.random_loss_fraction =
+        static_cast<float>(random_lost_packets) / sent_packets;
+    result.congestion_loss_fraction =
+        static_cast<float>(congestion_lost_packets) / sent_packets;
+  }
+  const int queued_packets = sent_packets - congestion_lost_packets;
+  if (queued_packets > 0)
+    result.mean_queue_delay_ms = queue_delay_sum_ms / queued_packets;
+  result.max_queue_delay_ms = static_cast<int>(max_queue_delay_ms);
+
+  const NetEqLifetimeStatistics lifetime_stats =
+      neteq->GetLifetimeStatistics();
+  if (lifetime_stats.total_samples_received > 0) {
+    const double total_samples = lifetime_stats.total_samples_received;
+    result.concealed_fraction =
+        lifetime_stats.concealed_samples / total_samples;
+    result.secondary_decoded_fraction =
+        lifetime_stats.secondary_decoded_samples / total_samples;
+    result.jitter_buffer_delay_ms =
+        lifetime_stats.jitter_buffer_delay_ms / total_samples;
+  }
+  result.concealment_events = lifetime_stats.concealment_events;
+  result.ana_stats = encoder->GetANAStats();
+  return result;
+}
+
+}  // namespace test
+}  // namespace webrtc
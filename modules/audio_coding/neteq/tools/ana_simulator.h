@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_CODING_NETEQ_TOOLS_ANA_SIMULATOR_H_
+#define MODULES_AUDIO_CODING_NETEQ_TOOLS_ANA_SIMULATOR_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/audio_codecs/audio_decoder_factory.h"
+#include "api/audio_codecs/audio_encoder.h"
+#include "api/audio_codecs/audio_format.h"
+#include "modules/audio_coding/neteq/tools/encode_neteq_input.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+namespace test {
+
+// One sample of a recorded uplink, valid until the next sample.
+struct NetworkTraceSample {
+  int64_t time_ms = 0;
+  int uplink_bandwidth_bps = 0;
+  float packet_loss_fraction = 0.0f;
+  int rtt_ms = 0;
+};
+
+// Parses a network trace in text form. Every line that is not empty and does
+// not start with '#' holds one sample,
+//   <time_ms> <uplink_bandwidth_bps> <packet_loss_fraction> [<rtt_ms>]
+// with strictly increasing times. Returns false if |text| is malformed.
+bool ParseNetworkTrace(const std::string& text,
+                       std::vector<NetworkTraceSample>* trace);
+
+struct AnaSimulationResult {
+  // Averages over the simulated duration. The send bitrate includes the
+  // per-packet overhead.
+  int available_bandwidth_bps = 0;
+  int send_bitrate_bps = 0;
+  int encoder_target_bitrate_bps = 0;
+  // |send_bitrate_bps| over |available_bandwidth_bps|.
+  float bandwidth_utilization = 0.0f;
+  // Packets sent per second, and the average audio duration per packet.
+  float packet_rate = 0.0f;
+  float frame_length_ms = 0.0f;
+
+  // Fractions of the sent packets that were dropped by the random loss model,
+  // and because the bottleneck queue was full.
+  float random_loss_fraction = 0.0f;
+  float congestion_loss_fraction = 0.0f;
+  // Average and maximum delay in the bottleneck queue.
+  float mean_queue_delay_ms = 0.0f;
+  int max_queue_delay_ms = 0;
+
+  // Audio quality proxies, from NetEq. Fractions of the played out samples
+  // that were concealed, and that were decoded from FEC/RED data.
+  float concealed_fraction = 0.0f;
+  float secondary_decoded_fraction = 0.0f;
+  uint64_t concealment_events = 0;
+  // Average jitter buffer delay of the played out samples.
+  float jitter_buffer_delay_ms = 0.0f;
+
+  ANAStats ana_stats;
+};
+
+// Runs an audio encoder, typically Opus with an audio network adaptor (ANA),
+// over a recorded uplink and decodes the result with NetEq. Every 10 ms, the
+// encoder is fed audio from the generator, and the packets it produces are
+// sent through a bottleneck link with the bandwidth of the trace, and then
+// subjected to random bursty loss at the trace's loss rate. At a fixed
+// interval, the encoder is told the bandwidth and RTT of the trace and the
+// loss measured on the simulated link, as a sender would learn from feedback.
+//
+// The encoder and ANA read rtc::TimeMillis(), so Run() replaces the clock with
+// a simulated one that advances 10 ms per block. That makes the simulation
+// deterministic for a given random seed, however fast it runs. The clock is
+// global, so only one simulator may run at a time in a process; run several
+// processes to simulate in parallel.
+class AnaSimulator {
+ public:
+  // Called by Run(), so that the encoder is created under the simulated
+  // clock.
+  using EncoderFactory = std::function<std::unique_ptr<AudioEncoder>()>;
+
+  struct Config {
+    // Defaults to the end of the trace.
+    int64_t duration_ms = 0;
+    int payload_type = 111;
+    // RTP, UDP and IPv4 headers. Also passed on to the encoder.
+    size_t overhead_bytes_per_packet = 40;
+    // Packets that would wait longer than this in the bottleneck queue are
+    // dropped.
+    int64_t max_queue_delay_ms = 500;
+    // Mean number of consecutive packets lost in the random loss model; 1
+    // gives independent losses.
+    float mean_loss_burst_length = 1.0f;
+    // How often the encoder gets network updates.
+    int64_t feedback_interval_ms = 1000;
+    int output_sample_rate_hz = 48000;
+    uint64_t random_seed = 1;
+  };
+
+  // |format| and |decoder_factory| must decode what the encoders of
+  // |encoder_factory| produce, with |config.payload_type|.
+  AnaSimulator(const Config& config,
+               std::vector<NetworkTraceSample> trace,
+               EncoderFactory encoder_factory,
+               std::unique_ptr<EncodeNetEqInput::Generator> generator,
+               const SdpAudioFormat& format,
+               rtc::scoped_refptr<AudioDecoderFactory> decoder_factory);
+  ~AnaSimulator();
+
+  // Not safe to call while another simulator runs, or anything else that
+  // uses rtc::TimeMillis(), see above.
+  AnaSimulationResult Run();
+
+ private:
+  const Config config_;
+  const std::vector<NetworkTraceSample> trace_;
+  const EncoderFactory encoder_factory_;
+  std::unique_ptr<EncodeNetEqInput::Generator> generator_;
+  const SdpAudioFormat format_;
+  const rtc::scoped_refptr<AudioDecoderFactory> decoder_factory_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(AnaSimulator);
+};
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_CODING_NETEQ_TOOLS_ANA_SIMULATOR_H_
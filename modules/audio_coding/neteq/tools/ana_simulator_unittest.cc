@@ -0,0 +1,357 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/tools/ana_simulator.h"
+
+#include <math.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "api/audio_codecs/L16/audio_decoder_L16.h"
+#include "api/audio_codecs/L16/audio_encoder_L16.h"
+#include "api/audio_codecs/audio_decoder_factory_template.h"
+#include "api/audio_codecs/opus/audio_decoder_opus.h"
+#include "common_audio/smoothing_filter.h"
+#include "modules/audio_coding/audio_network_adaptor/audio_network_adaptor_impl.h"
+#include "modules/audio_coding/audio_network_adaptor/controller.h"
+#include "modules/audio_coding/audio_network_adaptor/controller_manager.h"
+#include "modules/audio_coding/codecs/opus/audio_encoder_opus.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+constexpr int kPayloadType = 96;
+constexpr int kSampleRateHz = 16000;
+// 16 kHz L16 in 20 ms packets, with 40 bytes of overhead per packet.
+constexpr int kSendBitrateBps = (640 + 40) * 8 * 50;
+
+class SineGenerator : public EncodeNetEqInput::Generator {
+ public:
+  rtc::ArrayView<const int16_t> Generate(size_t num_samples) override {
+    samples_.resize(num_samples);
+    for (int16_t& sample : samples_) {
+      sample = static_cast<int16_t>(2000 * sin(phase_));
+      phase_ += 2 * M_PI * 300 / kSampleRateHz;
+    }
+    return samples_;
+  }
+
+ private:
+  std::vector<int16_t> samples_;
+  double phase_ = 0;
+};
+
+struct NetworkUpdates {
+  std::vector<float> loss_fractions;
+  std::vector<int> bandwidths_bps;
+  int rtt_ms = 0;
+  size_t overhead_bytes_per_packet = 0;
+};
+
+// Forwards to an L16 encoder, and records the network updates in |updates|,
+// which outlive the encoder.
+class RecordingEncoder : public AudioEncoder {
+ public:
+  explicit RecordingEncoder(NetworkUpdates* updates) : updates_(updates) {
+    AudioEncoderL16::Config config;
+    config.sample_rate_hz = kSampleRateHz;
+    config.frame_size_ms = 20;
+    encoder_ = AudioEncoderL16::MakeAudioEncoder(config, kPayloadType);
+  }
+
+  int SampleRateHz() const override { return encoder_->SampleRateHz(); }
+  size_t NumChannels() const override { return encoder_->NumChannels(); }
+  size_t Num10MsFramesInNextPacket() const override {
+    return encoder_->Num10MsFramesInNextPacket();
+  }
+  size_t Max10MsFramesInAPacket() const override {
+    return encoder_->Max10MsFramesInAPacket();
+  }
+  int GetTargetBitrate() const override { return encoder_->GetTargetBitrate(); }
+  void Reset() override { encoder_->Reset(); }
+
+  void OnReceivedUplinkPacketLossFraction(float fraction) override {
+    if (updates_)
+      updates_->loss_fractions.push_back(fraction);
+  }
+  void OnReceivedUplinkBandwidth(int bandwidth_bps,
+                                 rtc::Optional<int64_t>) override {
+    if (updates_)
+      updates_->bandwidths_bps.push_back(bandwidth_bps);
+  }
+  void OnReceivedRtt(int rtt_ms) override {
+    if (updates_)
+      updates_->rtt_ms = rtt_ms;
+  }
+  void OnReceivedOverhead(size_t overhead_bytes) override {
+    if (updates_)
+      updates_->overhead_bytes_per_packet = overhead_bytes;
+  }
+
+ protected:
+  EncodedInfo EncodeImpl(uint32_t rtp_timestamp,
+                         rtc::ArrayView<const int16_t> audio,
+                         rtc::Buffer* encoded) override {
+    return encoder_->Encode(rtp_timestamp, audio, encoded);
+  }
+
+ private:
+  NetworkUpdates* const updates_;
+  std::unique_ptr<AudioEncoder> encoder_;
+};
+
+// Records the uplink bandwidths an audio network adaptor passes on to its
+// controllers, and when they came.
+class BandwidthRecordingController : public Controller {
+ public:
+  struct Update {
+    int64_t time_ms;
+    int bandwidth_bps;
+  };
+
+  explicit BandwidthRecordingController(std::vector<Update>* updates)
+      : updates_(updates) {}
+
+  void UpdateNetworkMetrics(const NetworkMetrics& network_metrics) override {
+    if (network_metrics.uplink_bandwidth_bps) {
+      updates_->push_back(
+          {rtc::TimeMillis(), *network_metrics.uplink_bandwidth_bps});
+    }
+  }
+
+  void MakeDecision(AudioEncoderRuntimeConfig* config) override {}
+
+ private:
+  std::vector<Update>* const updates_;
+};
+
+// Opus with a real audio network adaptor and bitrate smoother, whose only
+// controller records the bandwidth updates.
+std::unique_ptr<AudioEncoder> CreateOpusWithAna(
+    int payload_type,
+    std::vector<BandwidthRecordingController::Update>* updates) {
+  AudioEncoderOpusConfig config;
+  auto ana_creator = [updates](const std::string& config_string,
+                               RtcEventLog* event_log) {
+    std::vector<std::unique_ptr<Controller>> controllers;
+    controllers.emplace_back(new BandwidthRecordingController(updates));
+    return std::unique_ptr<AudioNetworkAdaptor>(new AudioNetworkAdaptorImpl(
+        AudioNetworkAdaptorImpl::Config(),
+        rtc::MakeUnique<ControllerManagerImpl>(
+            ControllerManagerImpl::Config(5000, 0.0f), std::move(controllers),
+            std::map<const Controller*, std::pair<int, float>>())));
+  };
+  std::unique_ptr<AudioEncoder> encoder(new AudioEncoderOpusImpl(
+      config, payload_type, ana_creator,
+      rtc::MakeUnique<SmoothingFilterImpl>(5000)));
+  EXPECT_TRUE(encoder->EnableAudioNetworkAdaptor("", nullptr));
+  return encoder;
+}
+
+std::unique_ptr<AnaSimulator> CreateSimulator(
+    const AnaSimulator::Config& config,
+    std::vector<NetworkTraceSample> trace,
+    NetworkUpdates* updates = nullptr) {
+  AnaSimulator::Config simulator_config = config;
+  simulator_config.payload_type = kPayloadType;
+  return std::unique_ptr<AnaSimulator>(new AnaSimulator(
+      simulator_config, std::move(trace),
+      [updates] {
+        return std::unique_ptr<AudioEncoder>(new RecordingEncoder(updates));
+      },
+      std::unique_ptr<EncodeNetEqInput::Generator>(new SineGenerator()),
+      SdpAudioFormat("L16", kSampleRateHz, 1),
+      CreateAudioDecoderFactory<AudioDecoderL16>()));
+}
+
+NetworkTraceSample Sample(int64_t time_ms,
+                          int bandwidth_bps,
+                          float loss_fraction = 0.0f,
+                          int rtt_ms = 0) {
+  NetworkTraceSample sample;
+  sample.time_ms = time_ms;
+  sample.uplink_bandwidth_bps = bandwidth_bps;
+  sample.packet_loss_fraction = loss_fraction;
+  sample.rtt_ms = rtt_ms;
+  return sample;
+}
+
+}  // namespace
+
+TEST(AnaSimulatorTest, ParsesNetworkTrace) {
+  std::vector<NetworkTraceSample> trace;
+  ASSERT_TRUE(ParseNetworkTrace(
+      "# time_ms bandwidth_bps loss_fraction rtt_ms\n"
+      "0 32000 0.01 120\n"
+      "\n"
+      "1000 16000 0.1\n",
+      &trace));
+  ASSERT_EQ(2u, trace.size());
+  EXPECT_EQ(0, trace[0].time_ms);
+  EXPECT_EQ(32000, trace[0].uplink_bandwidth_bps);
+  EXPECT_FLOAT_EQ(0.01f, trace[0].packet_loss_fraction);
+  EXPECT_EQ(120, trace[0].rtt_ms);
+  EXPECT_EQ(1000, trace[1].time_ms);
+  EXPECT_EQ(16000, trace[1].uplink_bandwidth_bps);
+  EXPECT_FLOAT_EQ(0.1f, trace[1].packet_loss_fraction);
+  EXPECT_EQ(0, trace[1].rtt_ms);
+}
+
+TEST(AnaSimulatorTest, RejectsMalformedNetworkTrace) {
+  std::vector<NetworkTraceSample> trace;
+  EXPECT_FALSE(ParseNetworkTrace("0 32000\n", &trace));
+  EXPECT_FALSE(ParseNetworkTrace("0 32000 0.1 100 7\n", &trace));
+  EXPECT_FALSE(ParseNetworkTrace("0 32000 0.1 100ms\n", &trace));
+  EXPECT_FALSE(ParseNetworkTrace("0 32000 1.5\n", &trace));
+  EXPECT_FALSE(ParseNetworkTrace("0 32000 0.1\n0 16000 0.1\n", &trace));
+  EXPECT_TRUE(trace.empty());
+}
+
+TEST(AnaSimulatorTest, DeliversEverythingWithEnoughBandwidth) {
+  AnaSimulator::Config config;
+  config.duration_ms = 5000;
+  AnaSimulationResult result =
+      CreateSimulator(config, {Sample(0, 2 * kSendBitrateBps)})->Run();
+  EXPECT_EQ(2 * kSendBitrateBps, result.available_bandwidth_bps);
+  EXPECT_NEAR(kSendBitrateBps, result.send_bitrate_bps, kSendBitrateBps / 100);
+  EXPECT_NEAR(0.5f, result.bandwidth_utilization, 0.01f);
+  EXPECT_NEAR(20.0f, result.frame_length_ms, 0.1f);
+  EXPECT_EQ(0.0f, result.random_loss_fraction);
+  EXPECT_EQ(0.0f, result.congestion_loss_fraction);
+  // One packet is sent on an idle link at a time.
+  EXPECT_NEAR(10.0f, result.mean_queue_delay_ms, 0.1f);
+  // Only while NetEq starts up.
+  EXPECT_LT(result.concealed_fraction, 0.05f);
+}
+
+TEST(AnaSimulatorTest, DropsPacketsThatOverflowTheBottleneck) {
+  AnaSimulator::Config config;
+  config.duration_ms = 10000;
+  config.max_queue_delay_ms = 200;
+  AnaSimulationResult result =
+      CreateSimulator(config, {Sample(0, kSendBitrateBps / 2)})->Run();
+  EXPECT_NEAR(0.5f, result.congestion_loss_fraction, 0.05f);
+  EXPECT_EQ(0.0f, result.random_loss_fraction);
+  // Waiting time plus the 40 ms it takes to send a packet.
+  EXPECT_LE(result.max_queue_delay_ms, 200 + 40);
+  EXPECT_GT(result.concealed_fraction, 0.3f);
+}
+
+TEST(AnaSimulatorTest, LosesPacketsAtTheRateOfTheTrace) {
+  AnaSimulator::Config config;
+  config.duration_ms = 60000;
+  config.mean_loss_burst_length = 3.0f;
+  AnaSimulationResult result =
+      CreateSimulator(config, {Sample(0, 2 * kSendBitrateBps, 0.1f)})->Run();
+  EXPECT_NEAR(0.1f, result.random_loss_fraction, 0.02f);
+  EXPECT_EQ(0.0f, result.congestion_loss_fraction);
+  EXPECT_GT(result.concealed_fraction, 0.05f);
+  EXPECT_GT(result.concealment_events, 0u);
+}
+
+TEST(AnaSimulatorTest, FeedsNetworkUpdatesToEncoder) {
+  AnaSimulator::Config config;
+  config.feedback_interval_ms = 1000;
+  config.overhead_bytes_per_packet = 50;
+  NetworkUpdates updates;
+  std::unique_ptr<AnaSimulator> simulator =
+      CreateSimulator(config,
+                      {Sample(0, 2 * kSendBitrateBps, 0.0f, 100),
+                       Sample(2500, 3 * kSendBitrateBps, 0.5f, 200),
+                       Sample(5000, 3 * kSendBitrateBps, 0.5f, 200)},
+                      &updates);
+  simulator->Run();
+  EXPECT_EQ(50u, updates.overhead_bytes_per_packet);
+  ASSERT_EQ(5u, updates.bandwidths_bps.size());
+  EXPECT_EQ(2 * kSendBitrateBps, updates.bandwidths_bps[2]);
+  EXPECT_EQ(3 * kSendBitrateBps, updates.bandwidths_bps[3]);
+  EXPECT_EQ(200, updates.rtt_ms);
+  // No loss is reported before any packets were sent, and the loss is
+  // measured on the simulated link.
+  ASSERT_EQ(4u, updates.loss_fractions.size());
+  EXPECT_EQ(0.0f, updates.loss_fractions[0]);
+  EXPECT_GT(updates.loss_fractions[3], 0.2f);
+}
+
+// Opus hands the smoothed bandwidth to ANA at most every 200 ms, by
+// rtc::TimeMillis(). That must be simulated time, or how many updates ANA
+// gets would depend on how fast the simulation runs.
+TEST(AnaSimulatorTest, AnaGetsBandwidthUpdatesInSimulatedTime) {
+  constexpr int kOpusPayloadType = 111;
+  AnaSimulator::Config config;
+  config.duration_ms = 10000;
+  config.payload_type = kOpusPayloadType;
+  std::vector<BandwidthRecordingController::Update> updates;
+  AnaSimulator simulator(
+      config, {Sample(0, 20000, 0.0f, 100), Sample(5000, 40000, 0.0f, 100)},
+      [&updates] { return CreateOpusWithAna(kOpusPayloadType, &updates); },
+      std::unique_ptr<EncodeNetEqInput::Generator>(new SineGenerator()),
+      SdpAudioFormat("opus", 48000, 2),
+      CreateAudioDecoderFactory<AudioDecoderOpus>());
+  simulator.Run();
+
+  ASSERT_EQ(50u, updates.size());
+  for (size_t i = 0; i < updates.size(); ++i)
+    EXPECT_EQ(static_cast<int64_t>(i) * 200, updates[i].time_ms);
+  EXPECT_NEAR(20000, updates.front().bandwidth_bps, 1);
+  EXPECT_NEAR(20000, updates[24].bandwidth_bps, 1);
+  // Smoothed with a 5 s time constant after the step to 40 kbps.
+  EXPECT_GT(updates.back().bandwidth_bps, 30000);
+  EXPECT_LT(updates.back().bandwidth_bps, 40000);
+
+  // A second run gets the same updates.
+  std::vector<BandwidthRecordingController::Update> first_updates;
+  first_updates.swap(updates);
+  simulator.Run();
+  ASSERT_EQ(first_updates.size(), updates.size());
+  for (size_t i = 0; i < updates.size(); ++i) {
+    EXPECT_EQ(first_updates[i].time_ms, updates[i].time_ms);
+    EXPECT_EQ(first_updates[i].bandwidth_bps, updates[i].bandwidth_bps);
+  }
+}
+
+TEST(AnaSimulatorTest, RunsAreDeterministicPerSeed) {
+  const std::vector<NetworkTraceSample> trace = {
+      Sample(0, 2 * kSendBitrateBps, 0.05f, 100),
+      Sample(1000, kSendBitrateBps / 2, 0.2f, 300),
+      Sample(3000, kSendBitrateBps, 0.1f, 200)};
+  AnaSimulator::Config config;
+  config.duration_ms = 5000;
+  config.mean_loss_burst_length = 2.0f;
+  std::vector<AnaSimulationResult> results;
+  std::vector<AnaSimulationResult> repeated_results;
+  for (uint64_t seed = 1; seed <= 2; ++seed) {
+    config.random_seed = seed;
+    results.push_back(CreateSimulator(config, trace)->Run());
+    repeated_results.push_back(CreateSimulator(config, trace)->Run());
+  }
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(results[i].send_bitrate_bps, repeated_results[i].send_bitrate_bps);
+    EXPECT_EQ(results[i].random_loss_fraction,
+              repeated_results[i].random_loss_fraction);
+    EXPECT_EQ(results[i].congestion_loss_fraction,
+              repeated_results[i].congestion_loss_fraction);
+    EXPECT_EQ(results[i].concealed_fraction,
+              repeated_results[i].concealed_fraction);
+  }
+  // Different seeds give different losses.
+  EXPECT_NE(results[0].random_loss_fraction, results[1].random_loss_fraction);
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -13,11 +13,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <deque>
 #include <vector>
 
 #include "rtc_base/constructormagic.h"
-#include "rtc_base/numerics/percentile_filter.h"
+#include "rtc_base/numerics/flat_percentile_filter.h"
 
 namespace webrtc {
 
@@ -59,10 +58,15 @@ class MedianSlopeEstimator {
   const double threshold_gain_;
   // Used by the existing threshold.
   unsigned int num_of_deltas_;
-  // Theil-Sen robust line fitting
+  // Theil-Sen robust line fitting. |delay_hist_| is a ring buffer of
+  // |window_size_| entries starting at |hist_begin_|, where each entry and the
+  // median filter reserve all the memory they need up front, so that updates
+  // don't allocate.
   double accumulated_delay_;
-  std::deque<DelayInfo> delay_hist_;
-  PercentileFilter<double> median_filter_;
+  std::vector<DelayInfo> delay_hist_;
+  size_t hist_begin_;
+  size_t hist_size_;
+  FlatPercentileFilter<double> median_filter_;
   double trendline_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(MedianSlopeEstimator);
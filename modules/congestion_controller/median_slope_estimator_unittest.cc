@@ -8,9 +8,13 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string>
+
 #include "modules/congestion_controller/median_slope_estimator.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -19,6 +23,7 @@ constexpr size_t kWindowSize = 20;
 constexpr double kGain = 1;
 constexpr int64_t kAvgTimeBetweenPackets = 10;
 constexpr size_t kPacketCount = 2 * kWindowSize + 1;
+constexpr size_t kBenchmarkUpdates = 1000000;
 
 void TestEstimator(double slope, double jitter_stddev, double tolerance) {
   MedianSlopeEstimator estimator(kWindowSize, kGain);
@@ -69,4 +74,21 @@ TEST(MedianSlopeEstimator, JitteryLineSlopeZero) {
   TestEstimator(0, kAvgTimeBetweenPackets / 3.0, 0.02);
 }
 
+TEST(MedianSlopeEstimator, DISABLED_UpdatePerformance) {
+  MedianSlopeEstimator estimator(kWindowSize, kGain);
+  Random random(0x1234567);
+  int64_t arrival_time_ms = random.Rand(1000000);
+  const int64_t start_ns = rtc::TimeNanos();
+  for (size_t i = 0; i < kBenchmarkUpdates; ++i) {
+    arrival_time_ms += kAvgTimeBetweenPackets;
+    double recv_delta = kAvgTimeBetweenPackets + random.Gaussian(0, 3);
+    estimator.Update(recv_delta, kAvgTimeBetweenPackets, arrival_time_ms);
+  }
+  const int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+  webrtc::test::PrintResult("median_slope_estimator_update_time", "",
+                            "window_" + std::to_string(kWindowSize),
+                            static_cast<double>(elapsed_ns) / kBenchmarkUpdates,
+                            "ns", false);
+}
+
 }  // namespace webrtc
@@ -12,38 +12,11 @@
 
 #include <algorithm>
 
-#include "api/optional.h"
 #include "modules/remote_bitrate_estimator/test/bwe_test_logging.h"
 #include "rtc_base/checks.h"
 
 namespace webrtc {
 
-namespace {
-rtc::Optional<double> LinearFitSlope(
-    const std::deque<std::pair<double, double>>& points) {
-  RTC_DCHECK(points.size() >= 2);
-  // Compute the "center of mass".
-  double sum_x = 0;
-  double sum_y = 0;
-  for (const auto& point : points) {
-    sum_x += point.first;
-    sum_y += point.second;
-  }
-  double x_avg = sum_x / points.size();
-  double y_avg = sum_y / points.size();
-  // Compute the slope k = \sum (x_i-x_avg)(y_i-y_avg) / \sum (x_i-x_avg)^2
-  double numerator = 0;
-  double denominator = 0;
-  for (const auto& point : points) {
-    numerator += (point.first - x_avg) * (point.second - y_avg);
-    denominator += (point.first - x_avg) * (point.first - x_avg);
-  }
-  if (denominator == 0)
-    return rtc::nullopt;
-  return numerator / denominator;
-}
-}  // namespace
-
 enum { kDeltaCounterMax = 1000 };
 
 TrendlineEstimator::TrendlineEstimator(size_t window_size,
@@ -56,8 +29,17 @@ TrendlineEstimator::TrendlineEstimator(size_t window_size,
       first_arrival_time_ms(-1),
       accumulated_delay_(0),
       smoothed_delay_(0),
-      delay_hist_(),
-      trendline_(0) {}
+      delay_hist_(window_size),
+      hist_index_(0),
+      hist_size_(0),
+      origin_(0, 0),
+      sum_x_(0),
+      sum_y_(0),
+      sum_xx_(0),
+      sum_xy_(0),
+      trendline_(0) {
+  RTC_DCHECK_GE(window_size, 2);
+}
 
 TrendlineEstimator::~TrendlineEstimator() {}
 
@@ -81,17 +63,65 @@ void TrendlineEstimator::Update(double recv_delta_ms,
                         smoothed_delay_);
 
   // Simple linear regression.
-  delay_hist_.push_back(std::make_pair(
+  const std::pair<double, double> point(
       static_cast<double>(arrival_time_ms - first_arrival_time_ms),
-      smoothed_delay_));
-  if (delay_hist_.size() > window_size_)
-    delay_hist_.pop_front();
-  if (delay_hist_.size() == window_size_) {
+      smoothed_delay_);
+  std::pair<double, double>& slot = delay_hist_[hist_index_];
+  if (hist_size_ == window_size_) {
+    // Remove the oldest point, which is the one about to be overwritten.
+    const double old_x = slot.first - origin_.first;
+    const double old_y = slot.second - origin_.second;
+    sum_x_ -= old_x;
+    sum_y_ -= old_y;
+    sum_xx_ -= old_x * old_x;
+    sum_xy_ -= old_x * old_y;
+  } else {
+    ++hist_size_;
+  }
+  slot = point;
+  const double x = point.first - origin_.first;
+  const double y = point.second - origin_.second;
+  sum_x_ += x;
+  sum_y_ += y;
+  sum_xx_ += x * x;
+  sum_xy_ += x * y;
+  if (++hist_index_ == window_size_) {
+    hist_index_ = 0;
+    RecomputeSums();
+  }
+
+  if (hist_size_ == window_size_) {
+    // Compute the slope k = \sum (x_i-x_avg)(y_i-y_avg) / \sum (x_i-x_avg)^2,
+    // expanded in terms of the running sums.
+    const double n = static_cast<double>(hist_size_);
+    const double numerator = n * sum_xy_ - sum_x_ * sum_y_;
+    const double denominator = n * sum_xx_ - sum_x_ * sum_x_;
     // Only update trendline_ if it is possible to fit a line to the data.
-    trendline_ = LinearFitSlope(delay_hist_).value_or(trendline_);
+    if (denominator != 0)
+      trendline_ = numerator / denominator;
   }
 
   BWE_TEST_LOGGING_PLOT(1, "trendline_slope", arrival_time_ms, trendline_);
 }
 
+void TrendlineEstimator::RecomputeSums() {
+  RTC_DCHECK_EQ(hist_size_, window_size_);
+  // The oldest point is at |hist_index_|, and since the slope is invariant to
+  // translations it becomes the new origin. This keeps the magnitude of the
+  // sums bounded by the time span of the window.
+  origin_ = delay_hist_[hist_index_];
+  sum_x_ = 0;
+  sum_y_ = 0;
+  sum_xx_ = 0;
+  sum_xy_ = 0;
+  for (const auto& point : delay_hist_) {
+    const double x = point.first - origin_.first;
+    const double y = point.second - origin_.second;
+    sum_x_ += x;
+    sum_y_ += y;
+    sum_xx_ += x * x;
+    sum_xy_ += x * y;
+  }
+}
+
 }  // namespace webrtc
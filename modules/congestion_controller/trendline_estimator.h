@@ -13,8 +13,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <deque>
 #include <utility>
+#include <vector>
 
 #include "rtc_base/constructormagic.h"
 
@@ -49,6 +49,10 @@ class TrendlineEstimator {
   unsigned int num_of_deltas() const { return num_of_deltas_; }
 
  private:
+  // Recomputes the regression sums from the points in |delay_hist_|, moving
+  // the origin to the oldest point.
+  void RecomputeSums();
+
   // Parameters.
   const size_t window_size_;
   const double smoothing_coef_;
@@ -60,8 +64,18 @@ class TrendlineEstimator {
   // Exponential backoff filtering.
   double accumulated_delay_;
   double smoothed_delay_;
-  // Linear least squares regression.
-  std::deque<std::pair<double, double>> delay_hist_;
+  // Linear least squares regression over a ring buffer holding the last
+  // |window_size_| points. The sums are kept relative to |origin_| and updated
+  // incrementally, so that each update is O(1). They are recomputed from the
+  // buffer once per window to keep the rounding errors from accumulating.
+  std::vector<std::pair<double, double>> delay_hist_;
+  size_t hist_index_;
+  size_t hist_size_;
+  std::pair<double, double> origin_;
+  double sum_x_;
+  double sum_y_;
+  double sum_xx_;
+  double sum_xy_;
   double trendline_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(TrendlineEstimator);
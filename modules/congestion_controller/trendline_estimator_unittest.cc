@@ -8,9 +8,13 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string>
+
 #include "modules/congestion_controller/trendline_estimator.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -20,6 +24,7 @@ constexpr double kSmoothing = 0.0;
 constexpr double kGain = 1;
 constexpr int64_t kAvgTimeBetweenPackets = 10;
 constexpr size_t kPacketCount = 2 * kWindowSize + 1;
+constexpr size_t kBenchmarkUpdates = 1000000;
 
 void TestEstimator(double slope, double jitter_stddev, double tolerance) {
   TrendlineEstimator estimator(kWindowSize, kSmoothing, kGain);
@@ -70,4 +75,37 @@ TEST(TrendlineEstimator, JitteryLineSlopeZero) {
   TestEstimator(0, kAvgTimeBetweenPackets / 3.0, 0.02);
 }
 
+TEST(TrendlineEstimator, StaysAccurateOverManyWindows) {
+  // The regression sums are updated incrementally; make sure that rounding
+  // errors don't build up over a long call.
+  TrendlineEstimator estimator(kWindowSize, kSmoothing, kGain);
+  const double kSlope = 0.5;
+  int64_t send_time_ms = 1000000000;
+  double recv_time_ms = 2000000000;
+  for (size_t i = 0; i < 100 * kWindowSize * kWindowSize; ++i) {
+    send_time_ms += kAvgTimeBetweenPackets;
+    recv_time_ms += kAvgTimeBetweenPackets / (1 - kSlope);
+    estimator.Update(kAvgTimeBetweenPackets / (1 - kSlope),
+                     kAvgTimeBetweenPackets, static_cast<int64_t>(recv_time_ms));
+  }
+  EXPECT_NEAR(estimator.trendline_slope(), kSlope, 0.001);
+}
+
+TEST(TrendlineEstimator, DISABLED_UpdatePerformance) {
+  TrendlineEstimator estimator(kWindowSize, kSmoothing, kGain);
+  Random random(0x1234567);
+  int64_t arrival_time_ms = random.Rand(1000000);
+  const int64_t start_ns = rtc::TimeNanos();
+  for (size_t i = 0; i < kBenchmarkUpdates; ++i) {
+    arrival_time_ms += kAvgTimeBetweenPackets;
+    double recv_delta = kAvgTimeBetweenPackets + random.Gaussian(0, 3);
+    estimator.Update(recv_delta, kAvgTimeBetweenPackets, arrival_time_ms);
+  }
+  const int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+  webrtc::test::PrintResult("trendline_estimator_update_time", "",
+                            "window_" + std::to_string(kWindowSize),
+                            static_cast<double>(elapsed_ns) / kBenchmarkUpdates,
+                            "ns", false);
+}
+
 }  // namespace webrtc
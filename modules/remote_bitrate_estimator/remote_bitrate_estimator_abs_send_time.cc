@@ -38,17 +38,21 @@ enum {
 static const double kTimestampToMs = 1000.0 /
     static_cast<double>(1 << kInterArrivalShift);
 
-template<typename K, typename V>
-std::vector<K> Keys(const std::map<K, V>& map) {
-  std::vector<K> keys;
-  keys.reserve(map.size());
-  for (typename std::map<K, V>::const_iterator it = map.begin();
-      it != map.end(); ++it) {
-    keys.push_back(it->first);
-  }
+namespace {
+std::vector<uint32_t> Keys(
+    const std::vector<std::pair<uint32_t, int64_t>>& ssrcs) {
+  std::vector<uint32_t> keys;
+  keys.reserve(ssrcs.size());
+  for (const auto& ssrc : ssrcs)
+    keys.push_back(ssrc.first);
   return keys;
 }
 
+bool SsrcLess(const std::pair<uint32_t, int64_t>& ssrc, uint32_t value) {
+  return ssrc.first < value;
+}
+}  // namespace
+
 uint32_t ConvertMsTo24Bits(int64_t time_ms) {
   uint32_t time_24_bits =
       static_cast<uint32_t>(
@@ -68,8 +72,14 @@ bool RemoteBitrateEstimatorAbsSendTime::IsWithinClusterBounds(
     return fabs(static_cast<float>(send_delta_ms) - cluster_mean) < 2.5f;
   }
 
+  bool RemoteBitrateEstimatorAbsSendTime::IsClusterComplete(
+      const Cluster& cluster) {
+    return cluster.count >= kMinClusterSize && cluster.send_mean_ms > 0.0f &&
+           cluster.recv_mean_ms > 0.0f;
+  }
+
   void RemoteBitrateEstimatorAbsSendTime::AddCluster(
-      std::list<Cluster>* clusters,
+      std::vector<Cluster>* clusters,
       Cluster* cluster) {
     cluster->send_mean_ms /= static_cast<float>(cluster->count);
     cluster->recv_mean_ms /= static_cast<float>(cluster->count);
@@ -90,55 +100,58 @@ bool RemoteBitrateEstimatorAbsSendTime::IsWithinClusterBounds(
         total_probes_received_(0),
         first_packet_time_ms_(-1),
         last_update_ms_(-1),
-        uma_recorded_(false) {
+        uma_recorded_(false),
+        oldest_ssrc_update_ms_(-1) {
     RTC_DCHECK(clock_);
     RTC_DCHECK(observer_);
     RTC_LOG(LS_INFO) << "RemoteBitrateEstimatorAbsSendTime: Instantiating.";
 }
 
-void RemoteBitrateEstimatorAbsSendTime::ComputeClusters(
-    std::list<Cluster>* clusters) const {
-  Cluster current;
-  int64_t prev_send_time = -1;
-  int64_t prev_recv_time = -1;
-  for (std::list<Probe>::const_iterator it = probes_.begin();
-       it != probes_.end();
-       ++it) {
-    if (prev_send_time >= 0) {
-      int send_delta_ms = it->send_time_ms - prev_send_time;
-      int recv_delta_ms = it->recv_time_ms - prev_recv_time;
-      if (send_delta_ms >= 1 && recv_delta_ms >= 1) {
-        ++current.num_above_min_delta;
-      }
-      if (!IsWithinClusterBounds(send_delta_ms, current)) {
-        if (current.count >= kMinClusterSize &&
-            current.send_mean_ms > 0.0f &&
-            current.recv_mean_ms > 0.0f) {
-          AddCluster(clusters, &current);
-        }
-        current = Cluster();
-      }
-      current.send_mean_ms += send_delta_ms;
-      current.recv_mean_ms += recv_delta_ms;
-      current.mean_size += it->payload_size;
-      ++current.count;
+void RemoteBitrateEstimatorAbsSendTime::AddProbe(const Probe& probe) {
+  if (!probes_.empty()) {
+    const Probe& prev = probes_.back();
+    int send_delta_ms = probe.send_time_ms - prev.send_time_ms;
+    int recv_delta_ms = probe.recv_time_ms - prev.recv_time_ms;
+    if (send_delta_ms >= 1 && recv_delta_ms >= 1) {
+      ++open_cluster_.num_above_min_delta;
+    }
+    if (!IsWithinClusterBounds(send_delta_ms, open_cluster_)) {
+      if (IsClusterComplete(open_cluster_))
+        AddCluster(&closed_clusters_, &open_cluster_);
+      open_cluster_ = Cluster();
     }
-    prev_send_time = it->send_time_ms;
-    prev_recv_time = it->recv_time_ms;
+    open_cluster_.send_mean_ms += send_delta_ms;
+    open_cluster_.recv_mean_ms += recv_delta_ms;
+    open_cluster_.mean_size += probe.payload_size;
+    ++open_cluster_.count;
   }
-  if (current.count >= kMinClusterSize &&
-      current.send_mean_ms > 0.0f &&
-      current.recv_mean_ms > 0.0f) {
+  probes_.push_back(probe);
+}
+
+void RemoteBitrateEstimatorAbsSendTime::RecomputeClusters() {
+  std::deque<Probe> probes;
+  probes.swap(probes_);
+  closed_clusters_.clear();
+  open_cluster_ = Cluster();
+  for (const Probe& probe : probes)
+    AddProbe(probe);
+}
+
+void RemoteBitrateEstimatorAbsSendTime::ComputeClusters(
+    std::vector<Cluster>* clusters) const {
+  *clusters = closed_clusters_;
+  if (IsClusterComplete(open_cluster_)) {
+    Cluster current = open_cluster_;
     AddCluster(clusters, &current);
   }
 }
 
-std::list<Cluster>::const_iterator
+std::vector<Cluster>::const_iterator
 RemoteBitrateEstimatorAbsSendTime::FindBestProbe(
-    const std::list<Cluster>& clusters) const {
+    const std::vector<Cluster>& clusters) const {
   int highest_probe_bitrate_bps = 0;
-  std::list<Cluster>::const_iterator best_it = clusters.end();
-  for (std::list<Cluster>::const_iterator it = clusters.begin();
+  std::vector<Cluster>::const_iterator best_it = clusters.end();
+  for (std::vector<Cluster>::const_iterator it = clusters.begin();
        it != clusters.end();
        ++it) {
     if (it->send_mean_ms == 0 || it->recv_mean_ms == 0)
@@ -168,17 +181,19 @@ RemoteBitrateEstimatorAbsSendTime::FindBestProbe(
 
 RemoteBitrateEstimatorAbsSendTime::ProbeResult
 RemoteBitrateEstimatorAbsSendTime::ProcessClusters(int64_t now_ms) {
-  std::list<Cluster> clusters;
+  std::vector<Cluster>& clusters = clusters_;
   ComputeClusters(&clusters);
   if (clusters.empty()) {
     // If we reach the max number of probe packets and still have no clusters,
     // we will remove the oldest one.
-    if (probes_.size() >= kMaxProbePackets)
+    if (probes_.size() >= kMaxProbePackets) {
       probes_.pop_front();
+      RecomputeClusters();
+    }
     return ProbeResult::kNoUpdate;
   }
 
-  std::list<Cluster>::const_iterator best_it = FindBestProbe(clusters);
+  std::vector<Cluster>::const_iterator best_it = FindBestProbe(clusters);
   if (best_it != clusters.end()) {
     int probe_bitrate_bps =
         std::min(best_it->GetSendBitrateBps(), best_it->GetRecvBitrateBps());
@@ -198,8 +213,11 @@ RemoteBitrateEstimatorAbsSendTime::ProcessClusters(int64_t now_ms) {
 
   // Not probing and received non-probe packet, or finished with current set
   // of probes.
-  if (clusters.size() >= kExpectedNumberOfProbes)
+  if (clusters.size() >= kExpectedNumberOfProbes) {
     probes_.clear();
+    closed_clusters_.clear();
+    open_cluster_ = Cluster();
+  }
   return ProbeResult::kNoUpdate;
 }
 
@@ -276,7 +294,7 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
     TimeoutStreams(now_ms);
     RTC_DCHECK(inter_arrival_.get());
     RTC_DCHECK(estimator_.get());
-    ssrcs_[ssrc] = now_ms;
+    UpdateSsrc(ssrc, now_ms);
 
     // For now only try to detect probes while we don't have a valid estimate.
     // We currently assume that only packets larger than 200 bytes are paced by
@@ -298,7 +316,7 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
                          << " ms, send delta=" << send_delta_ms
                          << " ms, recv delta=" << recv_delta_ms << " ms.";
       }
-      probes_.push_back(Probe(send_time_ms, arrival_time_ms, payload_size));
+      AddProbe(Probe(send_time_ms, arrival_time_ms, payload_size));
       ++total_probes_received_;
       // Make sure that a probe which updated the bitrate immediately has an
       // effect by calling the OnReceiveBitrateChanged callback.
@@ -357,12 +375,18 @@ int64_t RemoteBitrateEstimatorAbsSendTime::TimeUntilNextProcess() {
 }
 
 void RemoteBitrateEstimatorAbsSendTime::TimeoutStreams(int64_t now_ms) {
-  for (Ssrcs::iterator it = ssrcs_.begin(); it != ssrcs_.end();) {
-    if ((now_ms - it->second) > kStreamTimeOutMs) {
-      ssrcs_.erase(it++);
-    } else {
-      ++it;
-    }
+  // Nothing can have timed out unless the oldest update is old enough, which
+  // avoids walking all streams for every packet.
+  if (!ssrcs_.empty() && now_ms - oldest_ssrc_update_ms_ > kStreamTimeOutMs) {
+    oldest_ssrc_update_ms_ = now_ms;
+    auto it = std::remove_if(
+        ssrcs_.begin(), ssrcs_.end(),
+        [now_ms](const std::pair<uint32_t, int64_t>& ssrc) {
+          return (now_ms - ssrc.second) > kStreamTimeOutMs;
+        });
+    ssrcs_.erase(it, ssrcs_.end());
+    for (const auto& ssrc : ssrcs_)
+      oldest_ssrc_update_ms_ = std::min(oldest_ssrc_update_ms_, ssrc.second);
   }
   if (ssrcs_.empty()) {
     // We can't update the estimate if we don't have any active streams.
@@ -375,6 +399,18 @@ void RemoteBitrateEstimatorAbsSendTime::TimeoutStreams(int64_t now_ms) {
   }
 }
 
+void RemoteBitrateEstimatorAbsSendTime::UpdateSsrc(uint32_t ssrc,
+                                                   int64_t now_ms) {
+  if (ssrcs_.empty())
+    oldest_ssrc_update_ms_ = now_ms;
+  auto it = std::lower_bound(ssrcs_.begin(), ssrcs_.end(), ssrc, SsrcLess);
+  if (it != ssrcs_.end() && it->first == ssrc) {
+    it->second = now_ms;
+  } else {
+    ssrcs_.insert(it, std::make_pair(ssrc, now_ms));
+  }
+}
+
 void RemoteBitrateEstimatorAbsSendTime::OnRttUpdate(int64_t avg_rtt_ms,
                                                     int64_t max_rtt_ms) {
   rtc::CritScope lock(&crit_);
@@ -383,7 +419,9 @@ void RemoteBitrateEstimatorAbsSendTime::OnRttUpdate(int64_t avg_rtt_ms,
 
 void RemoteBitrateEstimatorAbsSendTime::RemoveStream(uint32_t ssrc) {
   rtc::CritScope lock(&crit_);
-  ssrcs_.erase(ssrc);
+  auto it = std::lower_bound(ssrcs_.begin(), ssrcs_.end(), ssrc, SsrcLess);
+  if (it != ssrcs_.end() && it->first == ssrc)
+    ssrcs_.erase(it);
 }
 
 bool RemoteBitrateEstimatorAbsSendTime::LatestEstimate(
@@ -11,9 +11,9 @@
 #ifndef MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_BITRATE_ESTIMATOR_ABS_SEND_TIME_H_
 #define MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_BITRATE_ESTIMATOR_ABS_SEND_TIME_H_
 
-#include <list>
-#include <map>
+#include <deque>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "modules/remote_bitrate_estimator/aimd_rate_control.h"
@@ -87,23 +87,38 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
   void SetMinBitrate(int min_bitrate_bps) override;
 
  private:
-  typedef std::map<uint32_t, int64_t> Ssrcs;
+  // Pairs of SSRC and the time the last packet was received on it, sorted by
+  // SSRC. Kept in a flat array since it is looked up for every packet and
+  // only changes when streams are added or time out.
+  typedef std::vector<std::pair<uint32_t, int64_t>> Ssrcs;
   enum class ProbeResult { kBitrateUpdated, kNoUpdate };
 
   static bool IsWithinClusterBounds(int send_delta_ms,
                                     const Cluster& cluster_aggregate);
 
-  static void AddCluster(std::list<Cluster>* clusters, Cluster* cluster);
+  static bool IsClusterComplete(const Cluster& cluster);
+
+  static void AddCluster(std::vector<Cluster>* clusters, Cluster* cluster);
 
   void IncomingPacketInfo(int64_t arrival_time_ms,
                           uint32_t send_time_24bits,
                           size_t payload_size,
                           uint32_t ssrc);
 
-  void ComputeClusters(std::list<Cluster>* clusters) const;
+  // Appends |probe| to |probes_| and extends the clusters with it. This is
+  // equivalent to computing the clusters from scratch over all probes, but
+  // only looks at the new probe.
+  void AddProbe(const Probe& probe);
+
+  // Rebuilds the clusters from |probes_|, needed when probes are removed.
+  void RecomputeClusters();
+
+  // Outputs the closed clusters followed by the open one, if it is large
+  // enough.
+  void ComputeClusters(std::vector<Cluster>* clusters) const;
 
-  std::list<Cluster>::const_iterator FindBestProbe(
-      const std::list<Cluster>& clusters) const;
+  std::vector<Cluster>::const_iterator FindBestProbe(
+      const std::vector<Cluster>& clusters) const;
 
   // Returns true if a probe which changed the estimate was detected.
   ProbeResult ProcessClusters(int64_t now_ms)
@@ -114,6 +129,9 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
 
   void TimeoutStreams(int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(&crit_);
 
+  void UpdateSsrc(uint32_t ssrc, int64_t now_ms)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(&crit_);
+
   rtc::RaceChecker network_race_;
   const Clock* const clock_;
   RemoteBitrateObserver* const observer_;
@@ -124,7 +142,10 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
   bool incoming_bitrate_initialized_;
   std::vector<int> recent_propagation_delta_ms_;
   std::vector<int64_t> recent_update_time_ms_;
-  std::list<Probe> probes_;
+  std::deque<Probe> probes_;
+  std::vector<Cluster> closed_clusters_;
+  Cluster open_cluster_;
+  std::vector<Cluster> clusters_;
   size_t total_probes_received_;
   int64_t first_packet_time_ms_;
   int64_t last_update_ms_;
@@ -132,6 +153,9 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
 
   rtc::CriticalSection crit_;
   Ssrcs ssrcs_ RTC_GUARDED_BY(&crit_);
+  // Lower bound of the last packet times in |ssrcs_|, used to only look for
+  // timed out streams when there may be one.
+  int64_t oldest_ssrc_update_ms_ RTC_GUARDED_BY(&crit_);
   AimdRateControl remote_rate_ RTC_GUARDED_BY(&crit_);
 
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(RemoteBitrateEstimatorAbsSendTime);
@@ -11,6 +11,8 @@
 #include "modules/remote_bitrate_estimator/remote_bitrate_estimator_abs_send_time.h"
 #include "modules/remote_bitrate_estimator/remote_bitrate_estimator_unittest_helper.h"
 #include "rtc_base/constructormagic.h"
+#include "rtc_base/timeutils.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -286,4 +288,34 @@ TEST_F(RemoteBitrateEstimatorAbsSendTimeTest, ProbingIgnoresSmallPackets) {
   EXPECT_TRUE(bitrate_observer_->updated());
   EXPECT_NEAR(bitrate_observer_->latest_bitrate(), 800000u, 10000);
 }
+
+// Measures the per-packet cost of IncomingPacket as the number of active
+// SSRCs grows. Each SSRC sends a 1200 byte packet every 20 ms.
+TEST_F(RemoteBitrateEstimatorAbsSendTimeTest, DISABLED_IncomingPacketCpuCost) {
+  const size_t kNumSsrcs[] = {1, 10, 100, 1000, 5000};
+  const int64_t kPacketIntervalMs = 20;
+  const int kPacketsPerSsrc = 500;
+  for (size_t num_ssrcs : kNumSsrcs) {
+    SetUp();
+    int64_t elapsed_ns = 0;
+    for (int i = 0; i < kPacketsPerSsrc; ++i) {
+      for (size_t ssrc = 0; ssrc < num_ssrcs; ++ssrc) {
+        // Spread the packets of all SSRCs evenly over the interval.
+        int64_t offset_us = ssrc * kPacketIntervalMs * 1000 / num_ssrcs;
+        int64_t send_time_us = i * kPacketIntervalMs * 1000 + offset_us;
+        uint32_t abs_send_time = AbsSendTime(send_time_us, 1000000);
+        const int64_t start_ns = rtc::TimeNanos();
+        IncomingPacket(static_cast<uint32_t>(ssrc), 1200,
+                       clock_.TimeInMilliseconds(), 0, abs_send_time);
+        elapsed_ns += rtc::TimeNanos() - start_ns;
+      }
+      clock_.AdvanceTimeMilliseconds(kPacketIntervalMs);
+    }
+    webrtc::test::PrintResult(
+        "remote_bitrate_estimator_abs_send_time_incoming_packet", "",
+        std::to_string(num_ssrcs) + "_ssrcs",
+        static_cast<double>(elapsed_ns) / (kPacketsPerSsrc * num_ssrcs), "ns",
+        false);
+  }
+}
 }  // namespace webrtc
@@ -57,6 +57,11 @@ class RtpHeaderExtensionMap {
     return ids_[type];
   }
 
+  // Id of each type, kInvalidId if not registered, indexed by type.
+  rtc::ArrayView<const uint8_t, kRtpExtensionNumberOfExtensions> ids() const {
+    return ids_;
+  }
+
   size_t GetTotalLengthInBytes(
       rtc::ArrayView<const RtpExtensionSize> extensions) const;
 
@@ -27,6 +27,7 @@
 namespace webrtc {
 
 // Forward declarations.
+class MemoryAccountant;
 class OverheadObserver;
 class RateLimiter;
 class ReceiveStatisticsProvider;
@@ -95,6 +96,9 @@ class RtpRtcp : public Module, public RtcpFeedbackSenderInterface {
     OverheadObserver* overhead_observer = nullptr;
     RtpKeepAliveConfig keepalive_config;
 
+    // Accounts the memory of the packet history, if not null.
+    MemoryAccountant* memory_accountant = nullptr;
+
    private:
     RTC_DISALLOW_COPY_AND_ASSIGN(Configuration);
   };
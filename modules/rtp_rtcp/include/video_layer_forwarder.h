@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_RTP_RTCP_INCLUDE_VIDEO_LAYER_FORWARDER_H_
+#define MODULES_RTP_RTCP_INCLUDE_VIDEO_LAYER_FORWARDER_H_
+
+#include <stdint.h>
+
+#include "api/array_view.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/numerics/sequence_number_util.h"
+
+namespace webrtc {
+
+// VideoLayerForwarder selects which spatial and temporal layers of one
+// incoming VP8 or VP9 RTP stream to forward to one receiver, SFU style.
+// Layers are dropped without decoding or repacketizing: only the RTP header
+// and the first bytes of the payload descriptor are parsed, and forwarded
+// packets are rewritten in place so that the receiver sees a continuous
+// stream (sequence numbers without gaps, VP8 picture ids without gaps and the
+// marker bit on the last forwarded VP9 spatial layer).
+//
+// The layers are picked from the bitrate of each layer measured on the
+// incoming stream and the target bitrate towards the receiver. Switching down
+// happens at the next picture. Switching up in the temporal domain waits for
+// a layer sync/switching up point, in the spatial domain for a key frame;
+// KeyFrameNeeded() tells when the sender should be asked for one.
+//
+// Packets are expected to arrive mostly in order. A packet that is reordered
+// across a dropped packet is dropped as well, since its place in the output
+// sequence can't be known any more.
+class VideoLayerForwarder {
+ public:
+  static constexpr int kMaxLayers = 8;
+
+  VideoLayerForwarder(int vp8_payload_type, int vp9_payload_type);
+  ~VideoLayerForwarder();
+
+  // Sets the bitrate available for this stream towards the receiver.
+  void SetTargetBitrate(uint32_t bitrate_bps);
+
+  // Caps the forwarded layers regardless of bitrate, e.g. to not send a
+  // higher resolution than the receiver renders.
+  void SetMaxLayers(int max_spatial_layer, int max_temporal_layer);
+
+  // Processes one packet of the incoming stream. Returns false if the packet
+  // should be dropped. Otherwise |packet| has been rewritten in place and
+  // should be sent to the receiver.
+  bool OnRtpPacket(int64_t now_ms, rtc::ArrayView<uint8_t> packet);
+
+  // Layers currently forwarded, -1 before the first key frame.
+  int spatial_layer() const { return current_spatial_layer_; }
+  int temporal_layer() const { return current_temporal_layer_; }
+
+  // True if a key frame is needed to start forwarding or to switch up to the
+  // selected spatial layer.
+  bool KeyFrameNeeded() const;
+
+ private:
+  void MaybeUpdateLayerRates(int64_t now_ms);
+  void SelectTargetLayers();
+  void OnNewPicture(int temporal_idx, bool key_frame, bool switch_point);
+  bool DropPacket(int64_t unwrapped_sequence_number);
+
+  const int vp8_payload_type_;
+  const int vp9_payload_type_;
+
+  uint32_t target_bitrate_bps_;
+  int max_spatial_layer_;
+  int max_temporal_layer_;
+
+  // Incoming bytes per layer during the current measurement window, and the
+  // bitrate per layer measured over the last complete window.
+  int64_t window_start_ms_;
+  size_t layer_bytes_[kMaxLayers][kMaxLayers];
+  uint32_t layer_bitrate_bps_[kMaxLayers][kMaxLayers];
+  int num_spatial_layers_;
+  int num_temporal_layers_;
+
+  int target_spatial_layer_;
+  int target_temporal_layer_;
+  int current_spatial_layer_;
+  int current_temporal_layer_;
+
+  bool has_picture_;
+  uint32_t picture_timestamp_;
+  bool picture_dropped_;
+
+  SeqNumUnwrapper<uint16_t> sequence_number_unwrapper_;
+  int64_t highest_sequence_number_;
+  int64_t last_dropped_sequence_number_;
+  uint16_t sequence_number_offset_;
+  uint16_t picture_id_offset_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(VideoLayerForwarder);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_RTP_RTCP_INCLUDE_VIDEO_LAYER_FORWARDER_H_
@@ -30,6 +30,31 @@ namespace webrtc {
 namespace {
 // Transport header size in bytes. Assume UDP/IPv4 as a reasonable minimum.
 constexpr size_t kTransportOverhead = 28;
+
+// Returns the position in the sorted |packets| before which a packet with
+// |seq_num| belongs, after any packets with the same sequence number. Searches
+// from the back, since packets mostly arrive in order.
+template <typename PacketListType>
+typename PacketListType::iterator FindInsertPosition(PacketListType* packets,
+                                                     uint16_t seq_num) {
+  auto it = packets->end();
+  while (it != packets->begin()) {
+    auto prev_it = std::prev(it);
+    if (!IsNewerSequenceNumber((*prev_it)->seq_num, seq_num))
+      break;
+    it = prev_it;
+  }
+  return it;
+}
+
+// True if the packet just before |position| has sequence number |seq_num|.
+template <typename PacketListType>
+bool IsDuplicate(const PacketListType& packets,
+                 typename PacketListType::const_iterator position,
+                 uint16_t seq_num) {
+  return position != packets.begin() &&
+         (*std::prev(position))->seq_num == seq_num;
+}
 }  // namespace
 
 ForwardErrorCorrection::Packet::Packet() : length(0), data(), ref_count_(0) {}
@@ -47,6 +72,10 @@ int32_t ForwardErrorCorrection::Packet::Release() {
   return ref_count;
 }
 
+bool ForwardErrorCorrection::Packet::HasOneRef() const {
+  return ref_count_ == 1;
+}
+
 // This comparator is used to compare std::unique_ptr's pointing to
 // subclasses of SortablePackets. It needs to be parametric since
 // the std::unique_ptr's are not covariant w.r.t. the types that
@@ -344,6 +373,7 @@ void ForwardErrorCorrection::ResetState(
   // Free the memory for any existing recovered packets, if the caller hasn't.
   recovered_packets->clear();
   received_fec_packets_.clear();
+  fec_packets_to_recover_from_.clear();
 }
 
 void ForwardErrorCorrection::InsertMediaPacket(
@@ -351,13 +381,11 @@ void ForwardErrorCorrection::InsertMediaPacket(
     const ReceivedPacket& received_packet) {
   RTC_DCHECK_EQ(received_packet.ssrc, protected_media_ssrc_);
 
-  // Search for duplicate packets.
-  for (const auto& recovered_packet : *recovered_packets) {
-    RTC_DCHECK_EQ(recovered_packet->ssrc, received_packet.ssrc);
-    if (recovered_packet->seq_num == received_packet.seq_num) {
-      // Duplicate packet, no need to add to list.
-      return;
-    }
+  auto position =
+      FindInsertPosition(recovered_packets, received_packet.seq_num);
+  if (IsDuplicate(*recovered_packets, position, received_packet.seq_num)) {
+    // Duplicate packet, no need to add to list.
+    return;
   }
 
   std::unique_ptr<RecoveredPacket> recovered_packet(new RecoveredPacket());
@@ -369,25 +397,33 @@ void ForwardErrorCorrection::InsertMediaPacket(
   recovered_packet->seq_num = received_packet.seq_num;
   recovered_packet->pkt = received_packet.pkt;
   recovered_packet->pkt->length = received_packet.pkt->length;
-  // TODO(holmer): Consider replacing this with a binary search for the right
-  // position, and then just insert the new packet. Would get rid of the sort.
   RecoveredPacket* recovered_packet_ptr = recovered_packet.get();
-  recovered_packets->push_back(std::move(recovered_packet));
-  recovered_packets->sort(SortablePacket::LessThan());
+  recovered_packets->insert(position, std::move(recovered_packet));
   UpdateCoveringFecPackets(*recovered_packet_ptr);
 }
 
 void ForwardErrorCorrection::UpdateCoveringFecPackets(
     const RecoveredPacket& packet) {
   for (auto& fec_packet : received_fec_packets_) {
-    // Is this FEC packet protecting the media packet |packet|?
-    auto protected_it = std::lower_bound(fec_packet->protected_packets.begin(),
-                                         fec_packet->protected_packets.end(),
-                                         &packet, SortablePacket::LessThan());
+    // Is this FEC packet protecting the media packet |packet|? Packets
+    // outside the range of its packet mask are rejected without searching.
+    const uint16_t mask_offset =
+        static_cast<uint16_t>(packet.seq_num - fec_packet->seq_num_base);
+    if (mask_offset >= fec_packet->packet_mask_size * 8)
+      continue;
+    auto protected_it = std::lower_bound(
+        fec_packet->protected_packets.begin(),
+        fec_packet->protected_packets.end(), packet.seq_num,
+        [](const ProtectedPacket& protected_packet, uint16_t seq_num) {
+          return IsNewerSequenceNumber(seq_num, protected_packet.seq_num);
+        });
     if (protected_it != fec_packet->protected_packets.end() &&
-        (*protected_it)->seq_num == packet.seq_num) {
+        protected_it->seq_num == packet.seq_num && !protected_it->pkt) {
       // Found an FEC packet which is protecting |packet|.
-      (*protected_it)->pkt = packet.pkt;
+      protected_it->pkt = packet.pkt;
+      RTC_DCHECK_GT(fec_packet->num_missing_packets, 0);
+      if (--fec_packet->num_missing_packets == 1)
+        fec_packets_to_recover_from_.push_back(fec_packet.get());
     }
   }
 }
@@ -397,13 +433,11 @@ void ForwardErrorCorrection::InsertFecPacket(
     const ReceivedPacket& received_packet) {
   RTC_DCHECK_EQ(received_packet.ssrc, ssrc_);
 
-  // Check for duplicate.
-  for (const auto& existing_fec_packet : received_fec_packets_) {
-    RTC_DCHECK_EQ(existing_fec_packet->ssrc, received_packet.ssrc);
-    if (existing_fec_packet->seq_num == received_packet.seq_num) {
-      // Drop duplicate FEC packet data.
-      return;
-    }
+  auto position =
+      FindInsertPosition(&received_fec_packets_, received_packet.seq_num);
+  if (IsDuplicate(received_fec_packets_, position, received_packet.seq_num)) {
+    // Drop duplicate FEC packet data.
+    return;
   }
 
   std::unique_ptr<ReceivedFecPacket> fec_packet(new ReceivedFecPacket());
@@ -424,33 +458,36 @@ void ForwardErrorCorrection::InsertFecPacket(
   }
 
   // Parse packet mask from header and represent as protected packets.
+  const uint8_t* packet_mask =
+      &fec_packet->pkt->data[fec_packet->packet_mask_offset];
+  size_t num_protected_packets = 0;
+  for (size_t byte_idx = 0; byte_idx < fec_packet->packet_mask_size;
+       ++byte_idx) {
+    for (uint8_t bits = packet_mask[byte_idx]; bits != 0; bits &= bits - 1)
+      ++num_protected_packets;
+  }
+  fec_packet->protected_packets.resize(num_protected_packets);
+  auto protected_it = fec_packet->protected_packets.begin();
   for (uint16_t byte_idx = 0; byte_idx < fec_packet->packet_mask_size;
        ++byte_idx) {
-    uint8_t packet_mask =
-        fec_packet->pkt->data[fec_packet->packet_mask_offset + byte_idx];
     for (uint16_t bit_idx = 0; bit_idx < 8; ++bit_idx) {
-      if (packet_mask & (1 << (7 - bit_idx))) {
-        std::unique_ptr<ProtectedPacket> protected_packet(
-            new ProtectedPacket());
+      if (packet_mask[byte_idx] & (1 << (7 - bit_idx))) {
         // This wraps naturally with the sequence number.
-        protected_packet->ssrc = protected_media_ssrc_;
-        protected_packet->seq_num = static_cast<uint16_t>(
+        protected_it->ssrc = protected_media_ssrc_;
+        protected_it->seq_num = static_cast<uint16_t>(
             fec_packet->seq_num_base + (byte_idx << 3) + bit_idx);
-        protected_packet->pkt = nullptr;
-        fec_packet->protected_packets.push_back(std::move(protected_packet));
+        ++protected_it;
       }
     }
   }
+  fec_packet->num_missing_packets = num_protected_packets;
 
   if (fec_packet->protected_packets.empty()) {
     // All-zero packet mask; we can discard this FEC packet.
     RTC_LOG(LS_WARNING) << "Received FEC packet has an all-zero packet mask.";
   } else {
     AssignRecoveredPackets(recovered_packets, fec_packet.get());
-    // TODO(holmer): Consider replacing this with a binary search for the right
-    // position, and then just insert the new packet. Would get rid of the sort.
-    received_fec_packets_.push_back(std::move(fec_packet));
-    received_fec_packets_.sort(SortablePacket::LessThan());
+    received_fec_packets_.insert(position, std::move(fec_packet));
     const size_t max_fec_packets = fec_header_reader_->MaxFecPackets();
     if (received_fec_packets_.size() > max_fec_packets) {
       received_fec_packets_.pop_front();
@@ -463,23 +500,22 @@ void ForwardErrorCorrection::AssignRecoveredPackets(
     const RecoveredPacketList& recovered_packets,
     ReceivedFecPacket* fec_packet) {
   ProtectedPacketList* protected_packets = &fec_packet->protected_packets;
-  std::vector<RecoveredPacket*> recovered_protected_packets;
 
   // Find intersection between the (sorted) containers |protected_packets|
   // and |recovered_packets|, i.e. all protected packets that have already
   // been recovered. Update the corresponding protected packets to point to
   // the recovered packets.
-  auto it_p = protected_packets->cbegin();
+  auto it_p = protected_packets->begin();
   auto it_r = recovered_packets.cbegin();
-  SortablePacket::LessThan less_than;
   while (it_p != protected_packets->end() && it_r != recovered_packets.end()) {
-    if (less_than(*it_p, *it_r)) {
+    if (IsNewerSequenceNumber((*it_r)->seq_num, it_p->seq_num)) {
       ++it_p;
-    } else if (less_than(*it_r, *it_p)) {
+    } else if (IsNewerSequenceNumber(it_p->seq_num, (*it_r)->seq_num)) {
       ++it_r;
     } else {  // *it_p == *it_r.
       // This protected packet has already been recovered.
-      (*it_p)->pkt = (*it_r)->pkt;
+      it_p->pkt = (*it_r)->pkt;
+      --fec_packet->num_missing_packets;
       ++it_p;
       ++it_r;
     }
@@ -536,7 +572,7 @@ bool ForwardErrorCorrection::StartPacketRecovery(
     return false;
   }
   // Initialize recovered packet data.
-  recovered_packet->pkt = new Packet();
+  RTC_DCHECK(recovered_packet->pkt);
   memset(recovered_packet->pkt->data, 0, IP_PACKET_SIZE);
   recovered_packet->returned = false;
   recovered_packet->was_recovered = true;
@@ -622,12 +658,12 @@ bool ForwardErrorCorrection::RecoverPacket(const ReceivedFecPacket& fec_packet,
     return false;
   }
   for (const auto& protected_packet : fec_packet.protected_packets) {
-    if (protected_packet->pkt == nullptr) {
+    if (protected_packet.pkt == nullptr) {
       // This is the packet we're recovering.
-      recovered_packet->seq_num = protected_packet->seq_num;
+      recovered_packet->seq_num = protected_packet.seq_num;
     } else {
-      XorHeaders(*protected_packet->pkt, recovered_packet->pkt);
-      XorPayloads(*protected_packet->pkt, protected_packet->pkt->length,
+      XorHeaders(*protected_packet.pkt, recovered_packet->pkt);
+      XorPayloads(*protected_packet.pkt, protected_packet.pkt->length,
                   kRtpHeaderSize, recovered_packet->pkt);
     }
   }
@@ -639,60 +675,62 @@ bool ForwardErrorCorrection::RecoverPacket(const ReceivedFecPacket& fec_packet,
 
 void ForwardErrorCorrection::AttemptRecovery(
     RecoveredPacketList* recovered_packets) {
-  auto fec_packet_it = received_fec_packets_.begin();
-  while (fec_packet_it != received_fec_packets_.end()) {
-    // Search for each FEC packet's protected media packets.
-    int packets_missing = NumCoveredPacketsMissing(**fec_packet_it);
+  // Recovering a packet only affects the FEC packets that protect it. Rather
+  // than rescanning all FEC packets after every recovered packet, start from
+  // the FEC packets that miss a single packet, and let
+  // UpdateCoveringFecPackets() add those that become usable.
+  fec_packets_to_recover_from_.clear();
+  for (const auto& fec_packet : received_fec_packets_) {
+    if (fec_packet->num_missing_packets == 1)
+      fec_packets_to_recover_from_.push_back(fec_packet.get());
+  }
+
+  while (!fec_packets_to_recover_from_.empty()) {
+    ReceivedFecPacket* fec_packet = fec_packets_to_recover_from_.back();
+    fec_packets_to_recover_from_.pop_back();
+    // The missing packet may have been recovered by another FEC packet.
+    if (fec_packet->num_missing_packets != 1)
+      continue;
 
     // We can only recover one packet with an FEC packet.
-    if (packets_missing == 1) {
-      // Recovery possible.
-      std::unique_ptr<RecoveredPacket> recovered_packet(new RecoveredPacket());
-      recovered_packet->pkt = nullptr;
-      if (!RecoverPacket(**fec_packet_it, recovered_packet.get())) {
-        // Can't recover using this packet, drop it.
-        fec_packet_it = received_fec_packets_.erase(fec_packet_it);
-        continue;
-      }
-
-      auto recovered_packet_ptr = recovered_packet.get();
-      // Add recovered packet to the list of recovered packets and update any
-      // FEC packets covering this packet with a pointer to the data.
-      // TODO(holmer): Consider replacing this with a binary search for the
-      // right position, and then just insert the new packet. Would get rid of
-      // the sort.
-      recovered_packets->push_back(std::move(recovered_packet));
-      recovered_packets->sort(SortablePacket::LessThan());
-      UpdateCoveringFecPackets(*recovered_packet_ptr);
-      DiscardOldRecoveredPackets(recovered_packets);
-      fec_packet_it = received_fec_packets_.erase(fec_packet_it);
-
-      // A packet has been recovered. We need to check the FEC list again, as
-      // this may allow additional packets to be recovered.
-      // Restart for first FEC packet.
-      fec_packet_it = received_fec_packets_.begin();
-    } else if (packets_missing == 0) {
-      // Either all protected packets arrived or have been recovered. We can
-      // discard this FEC packet.
-      fec_packet_it = received_fec_packets_.erase(fec_packet_it);
-    } else {
-      fec_packet_it++;
+    std::unique_ptr<RecoveredPacket> recovered_packet(new RecoveredPacket());
+    recovered_packet->pkt = AllocateRecoveredPacket();
+    if (!RecoverPacket(*fec_packet, recovered_packet.get())) {
+      // Can't recover using this packet, drop it below.
+      fec_packet->protected_packets.clear();
+      fec_packet->num_missing_packets = 0;
+      continue;
     }
-  }
-}
 
-int ForwardErrorCorrection::NumCoveredPacketsMissing(
-    const ReceivedFecPacket& fec_packet) {
-  int packets_missing = 0;
-  for (const auto& protected_packet : fec_packet.protected_packets) {
-    if (protected_packet->pkt == nullptr) {
-      ++packets_missing;
-      if (packets_missing > 1) {
-        break;  // We can't recover more than one packet.
-      }
-    }
-  }
-  return packets_missing;
+    auto recovered_packet_ptr = recovered_packet.get();
+    // Add recovered packet to the list of recovered packets and update any
+    // FEC packets covering this packet with a pointer to the data. This
+    // includes |fec_packet|, which then has no missing packets left.
+    recovered_packets->insert(
+        FindInsertPosition(recovered_packets, recovered_packet_ptr->seq_num),
+        std::move(recovered_packet));
+    UpdateCoveringFecPackets(*recovered_packet_ptr);
+    DiscardOldRecoveredPackets(recovered_packets);
+  }
+
+  // Either all protected packets of these FEC packets arrived or have been
+  // recovered, or they failed to recover a packet. We can discard them.
+  received_fec_packets_.remove_if(
+      [](const std::unique_ptr<ReceivedFecPacket>& fec_packet) {
+        return fec_packet->num_missing_packets == 0;
+      });
+}
+
+rtc::scoped_refptr<ForwardErrorCorrection::Packet>
+ForwardErrorCorrection::AllocateRecoveredPacket() {
+  for (const auto& packet : recovered_packet_pool_) {
+    if (packet->HasOneRef())
+      return packet;
+  }
+  rtc::scoped_refptr<Packet> packet(new Packet());
+  if (recovered_packet_pool_.size() < fec_header_reader_->MaxMediaPackets())
+    recovered_packet_pool_.push_back(packet);
+  return packet;
 }
 
 void ForwardErrorCorrection::DiscardOldRecoveredPackets(
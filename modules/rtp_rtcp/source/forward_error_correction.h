@@ -53,6 +53,9 @@ class ForwardErrorCorrection {
     // reaches zero.
     virtual int32_t Release();
 
+    // True if exactly one reference is held.
+    bool HasOneRef() const;
+
     size_t length;                 // Length of packet in bytes.
     uint8_t data[IP_PACKET_SIZE];  // Packet data.
 
@@ -116,7 +119,7 @@ class ForwardErrorCorrection {
     rtc::scoped_refptr<ForwardErrorCorrection::Packet> pkt;
   };
 
-  using ProtectedPacketList = std::list<std::unique_ptr<ProtectedPacket>>;
+  using ProtectedPacketList = std::vector<ProtectedPacket>;
 
   // Used for internal storage of received FEC packets in a list.
   //
@@ -126,8 +129,13 @@ class ForwardErrorCorrection {
     ReceivedFecPacket();
     ~ReceivedFecPacket();
 
-    // List of media packets that this FEC packet protects.
+    // List of media packets that this FEC packet protects, sorted by
+    // sequence number.
     ProtectedPacketList protected_packets;
+    // Number of |protected_packets| that have neither been received nor
+    // recovered. The FEC packet can recover a packet when this is one, and is
+    // useless when this is zero.
+    size_t num_missing_packets = 0;
     // RTP header fields.
     uint32_t ssrc;
     // FEC header fields.
@@ -278,6 +286,8 @@ class ForwardErrorCorrection {
   // Note: This reduces the complexity when we want to try to recover a packet
   // since we don't have to find the intersection between recovered packets and
   // packets covered by the FEC packet.
+  // FEC packets that become able to recover a packet are added to
+  // |fec_packets_to_recover_from_|.
   void UpdateCoveringFecPackets(const RecoveredPacket& packet);
 
   // Insert |received_packet| into internal FEC list. Deletes duplicates.
@@ -293,8 +303,12 @@ class ForwardErrorCorrection {
   // received FEC packets.
   void AttemptRecovery(RecoveredPacketList* recovered_packets);
 
+  // Returns storage for a recovered packet, reusing packets from
+  // |recovered_packet_pool_| that are no longer referenced elsewhere.
+  rtc::scoped_refptr<Packet> AllocateRecoveredPacket();
+
   // Initializes headers and payload before the XOR operation
-  // that recovers a packet.
+  // that recovers a packet. |recovered_packet->pkt| must be allocated.
   static bool StartPacketRecovery(const ReceivedFecPacket& fec_packet,
                                   RecoveredPacket* recovered_packet);
 
@@ -320,12 +334,6 @@ class ForwardErrorCorrection {
   static bool RecoverPacket(const ReceivedFecPacket& fec_packet,
                             RecoveredPacket* recovered_packet);
 
-  // Get the number of missing media packets which are covered by |fec_packet|.
-  // An FEC packet can recover at most one packet, and if zero packets are
-  // missing the FEC packet can be discarded. This function returns 2 when two
-  // or more packets are missing.
-  static int NumCoveredPacketsMissing(const ReceivedFecPacket& fec_packet);
-
   // Discards old packets in |recovered_packets|, which are no longer relevant
   // for recovering lost packets.
   void DiscardOldRecoveredPackets(RecoveredPacketList* recovered_packets);
@@ -340,6 +348,13 @@ class ForwardErrorCorrection {
   std::vector<Packet> generated_fec_packets_;
   ReceivedFecPacketList received_fec_packets_;
 
+  // FEC packets missing a single protected packet, to be used by
+  // AttemptRecovery(). Kept as a member to reuse its memory.
+  std::vector<ReceivedFecPacket*> fec_packets_to_recover_from_;
+  // Bounded by the maximum number of media packets, as more recovered packets
+  // are discarded anyway.
+  std::vector<rtc::scoped_refptr<Packet>> recovered_packet_pool_;
+
   // Arrays used to avoid dynamically allocating memory when generating
   // the packet masks.
   // (There are never more than |kUlpfecMaxMediaPackets| FEC packets generated.)
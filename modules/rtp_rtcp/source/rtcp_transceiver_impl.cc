@@ -10,6 +10,7 @@
 
 #include "modules/rtp_rtcp/source/rtcp_transceiver_impl.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "api/call/transport.h"
@@ -36,6 +37,26 @@
 namespace webrtc {
 namespace {
 
+// Common header and sender ssrc.
+constexpr size_t kReceiverReportBaseLength = 8;
+// Largest receiver report: base length and 31 report blocks.
+constexpr size_t kMaxReceiverReportLength =
+    kReceiverReportBaseLength +
+    rtcp::ReceiverReport::kMaxNumberOfReportBlocks * rtcp::ReportBlock::kLength;
+
+// Returns how many report blocks fit into |available_bytes| when they are
+// split into as many receiver reports as needed.
+size_t MaxReportBlocksInBytes(size_t available_bytes) {
+  size_t num_blocks = (available_bytes / kMaxReceiverReportLength) *
+                      rtcp::ReceiverReport::kMaxNumberOfReportBlocks;
+  size_t remaining_bytes = available_bytes % kMaxReceiverReportLength;
+  if (remaining_bytes > kReceiverReportBaseLength) {
+    num_blocks += (remaining_bytes - kReceiverReportBaseLength) /
+                  rtcp::ReportBlock::kLength;
+  }
+  return num_blocks;
+}
+
 struct SenderReportTimes {
   int64_t local_received_time_us;
   NtpTime remote_sent_time;
@@ -51,8 +72,6 @@ struct RtcpTransceiverImpl::RemoteSenderState {
 
 // Helper to put several RTCP packets into lower layer datagram composing
 // Compound or Reduced-Size RTCP packet, as defined by RFC 5506 section 2.
-// TODO(danilchap): When in compound mode and packets are so many that several
-// compound RTCP packets need to be generated, ensure each packet is compound.
 class RtcpTransceiverImpl::PacketSender {
  public:
   PacketSender(rtcp::RtcpPacket::PacketReadyCallback callback,
@@ -330,39 +349,68 @@ void RtcpTransceiverImpl::SchedulePeriodicCompoundPackets(int64_t delay_ms) {
     config_.task_queue->PostTask(std::move(task));
 }
 
-void RtcpTransceiverImpl::CreateCompoundPacket(PacketSender* sender) {
+void RtcpTransceiverImpl::CreateCompoundPacket(size_t reserved_bytes,
+                                               PacketSender* sender) {
   RTC_DCHECK(sender->IsEmpty());
   const uint32_t sender_ssrc = config_.feedback_ssrc;
   int64_t now_us = rtc::TimeMicros();
-  rtcp::ReceiverReport receiver_report;
-  receiver_report.SetSenderSsrc(sender_ssrc);
-  receiver_report.SetReportBlocks(CreateReportBlocks(now_us));
-  sender->AppendPacket(receiver_report);
 
+  // Build the rest of the compound packet first, so that the receiver reports
+  // can take all the space that is left.
+  rtc::Optional<rtcp::Sdes> sdes;
   if (!config_.cname.empty()) {
-    rtcp::Sdes sdes;
-    bool added = sdes.AddCName(config_.feedback_ssrc, config_.cname);
+    sdes.emplace();
+    bool added = sdes->AddCName(config_.feedback_ssrc, config_.cname);
     RTC_DCHECK(added) << "Failed to add cname " << config_.cname
                       << " to rtcp sdes packet.";
-    sender->AppendPacket(sdes);
+    reserved_bytes += sdes->BlockLength();
   }
   if (remb_) {
     remb_->SetSenderSsrc(sender_ssrc);
-    sender->AppendPacket(*remb_);
+    reserved_bytes += remb_->BlockLength();
   }
   // TODO(bugs.webrtc.org/8239): Do not send rrtr if this packet starts with
   // SenderReport instead of ReceiverReport
   // when RtcpTransceiver supports rtp senders.
+  rtc::Optional<rtcp::ExtendedReports> xr;
   if (config_.non_sender_rtt_measurement) {
-    rtcp::ExtendedReports xr;
-
+    xr.emplace();
     rtcp::Rrtr rrtr;
     rrtr.SetNtp(TimeMicrosToNtp(now_us));
-    xr.SetRrtr(rrtr);
+    xr->SetRrtr(rrtr);
+    xr->SetSenderSsrc(sender_ssrc);
+    reserved_bytes += xr->BlockLength();
+  }
 
-    xr.SetSenderSsrc(sender_ssrc);
-    sender->AppendPacket(xr);
+  // Report on as many remote ssrcs as fit into a single datagram, using
+  // several receiver reports when there are more than 31 of them. Other
+  // ssrcs are reported in the next compound packets.
+  size_t max_report_blocks = 0;
+  if (reserved_bytes < config_.max_packet_size) {
+    max_report_blocks =
+        MaxReportBlocksInBytes(config_.max_packet_size - reserved_bytes);
   }
+  std::vector<rtcp::ReportBlock> report_blocks =
+      CreateReportBlocks(now_us, max_report_blocks);
+  auto report_blocks_it = report_blocks.begin();
+  do {
+    const size_t num_blocks = std::min<size_t>(
+        report_blocks.end() - report_blocks_it,
+        rtcp::ReceiverReport::kMaxNumberOfReportBlocks);
+    rtcp::ReceiverReport receiver_report;
+    receiver_report.SetSenderSsrc(sender_ssrc);
+    receiver_report.SetReportBlocks(std::vector<rtcp::ReportBlock>(
+        report_blocks_it, report_blocks_it + num_blocks));
+    sender->AppendPacket(receiver_report);
+    report_blocks_it += num_blocks;
+  } while (report_blocks_it != report_blocks.end());
+
+  if (sdes)
+    sender->AppendPacket(*sdes);
+  if (remb_)
+    sender->AppendPacket(*remb_);
+  if (xr)
+    sender->AppendPacket(*xr);
 }
 
 void RtcpTransceiverImpl::SendPeriodicCompoundPacket() {
@@ -370,7 +418,7 @@ void RtcpTransceiverImpl::SendPeriodicCompoundPacket() {
     config_.outgoing_transport->SendRtcp(packet.data(), packet.size());
   };
   PacketSender sender(send_packet, config_.max_packet_size);
-  CreateCompoundPacket(&sender);
+  CreateCompoundPacket(/*reserved_bytes=*/0, &sender);
   sender.Send();
 }
 
@@ -383,7 +431,7 @@ void RtcpTransceiverImpl::SendImmediateFeedback(
   // Compound mode requires every sent rtcp packet to be compound, i.e. start
   // with a sender or receiver report.
   if (config_.rtcp_mode == RtcpMode::kCompound)
-    CreateCompoundPacket(&sender);
+    CreateCompoundPacket(rtcp_packet.BlockLength(), &sender);
 
   sender.AppendPacket(rtcp_packet);
   sender.Send();
@@ -394,14 +442,12 @@ void RtcpTransceiverImpl::SendImmediateFeedback(
 }
 
 std::vector<rtcp::ReportBlock> RtcpTransceiverImpl::CreateReportBlocks(
-    int64_t now_us) {
-  if (!config_.receive_statistics)
+    int64_t now_us,
+    size_t max_blocks) {
+  if (!config_.receive_statistics || max_blocks == 0)
     return {};
-  // TODO(danilchap): Support sending more than
-  // |ReceiverReport::kMaxNumberOfReportBlocks| per compound rtcp packet.
   std::vector<rtcp::ReportBlock> report_blocks =
-      config_.receive_statistics->RtcpReportBlocks(
-          rtcp::ReceiverReport::kMaxNumberOfReportBlocks);
+      config_.receive_statistics->RtcpReportBlocks(max_blocks);
   for (rtcp::ReportBlock& report_block : report_blocks) {
     auto it = remote_senders_.find(report_block.source_ssrc());
     if (it == remote_senders_.end() || !it->second.last_received_sender_report)
@@ -79,12 +79,14 @@ class RtcpTransceiverImpl {
   void SchedulePeriodicCompoundPackets(int64_t delay_ms);
   // Creates compound RTCP packet, as defined in
   // https://tools.ietf.org/html/rfc5506#section-2
-  void CreateCompoundPacket(PacketSender* sender);
+  // Leaves |reserved_bytes| of the first datagram for packets appended later.
+  void CreateCompoundPacket(size_t reserved_bytes, PacketSender* sender);
   // Sends RTCP packets.
   void SendPeriodicCompoundPacket();
   void SendImmediateFeedback(const rtcp::RtcpPacket& rtcp_packet);
   // Generate Report Blocks to be send in Sender or Receiver Report.
-  std::vector<rtcp::ReportBlock> CreateReportBlocks(int64_t now_us);
+  std::vector<rtcp::ReportBlock> CreateReportBlocks(int64_t now_us,
+                                                    size_t max_blocks);
 
   const RtcpTransceiverConfig config_;
 
@@ -10,6 +10,10 @@
 
 #include "modules/rtp_rtcp/source/rtcp_transceiver_impl.h"
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "modules/rtp_rtcp/include/receive_statistics.h"
@@ -26,6 +30,7 @@
 #include "test/gtest.h"
 #include "test/mock_transport.h"
 #include "test/rtcp_packet_parser.h"
+#include "test/testsupport/perf_test.h"
 
 namespace {
 
@@ -47,6 +52,7 @@ using ::webrtc::SaturatedUsToCompactNtp;
 using ::webrtc::TimeMicrosToNtp;
 using ::webrtc::rtcp::Bye;
 using ::webrtc::rtcp::CompoundPacket;
+using ::webrtc::rtcp::ReceiverReport;
 using ::webrtc::rtcp::ReportBlock;
 using ::webrtc::rtcp::SenderReport;
 using ::webrtc::test::RtcpPacketParser;
@@ -56,6 +62,32 @@ class MockReceiveStatisticsProvider : public webrtc::ReceiveStatisticsProvider {
   MOCK_METHOD1(RtcpReportBlocks, std::vector<ReportBlock>(size_t));
 };
 
+// Reports on |num_ssrcs| remote ssrcs, rotating through them like
+// ReceiveStatistics does when asked for fewer report blocks.
+class ReceiveStatisticsForSsrcs : public webrtc::ReceiveStatisticsProvider {
+ public:
+  ReceiveStatisticsForSsrcs(uint32_t first_ssrc, size_t num_ssrcs)
+      : first_ssrc_(first_ssrc), num_ssrcs_(num_ssrcs) {}
+
+  std::vector<ReportBlock> RtcpReportBlocks(size_t max_blocks) override {
+    std::vector<ReportBlock> report_blocks(std::min(max_blocks, num_ssrcs_));
+    for (ReportBlock& report_block : report_blocks) {
+      report_block.SetMediaSsrc(first_ssrc_ + next_index_);
+      reported_ssrcs_.insert(report_block.source_ssrc());
+      next_index_ = (next_index_ + 1) % num_ssrcs_;
+    }
+    return report_blocks;
+  }
+
+  bool ReportedAllSsrcs() const { return reported_ssrcs_.size() == num_ssrcs_; }
+
+ private:
+  const uint32_t first_ssrc_;
+  const size_t num_ssrcs_;
+  size_t next_index_ = 0;
+  std::set<uint32_t> reported_ssrcs_;
+};
+
 class MockMediaReceiverRtcpObserver : public webrtc::MediaReceiverRtcpObserver {
  public:
   MOCK_METHOD3(OnSenderReport, void(uint32_t, NtpTime, uint32_t));
@@ -122,6 +154,27 @@ class RtcpParserTransport : public webrtc::Transport {
   int num_packets_ = 0;
 };
 
+class RtcpCountingTransport : public webrtc::Transport {
+ public:
+  int num_packets() const { return num_packets_; }
+  size_t num_bytes() const { return num_bytes_; }
+
+ private:
+  bool SendRtcp(const uint8_t* data, size_t size) override {
+    ++num_packets_;
+    num_bytes_ += size;
+    return true;
+  }
+
+  bool SendRtp(const uint8_t*, size_t, const webrtc::PacketOptions&) override {
+    ADD_FAILURE() << "RtcpTransciver shouldn't send rtp packets.";
+    return true;
+  }
+
+  int num_packets_ = 0;
+  size_t num_bytes_ = 0;
+};
+
 RtcpTransceiverConfig DefaultTestConfig() {
   // RtcpTransceiverConfig default constructor sets default values for prod.
   // Test doesn't need to support all key features: Default test config returns
@@ -386,6 +439,83 @@ TEST(RtcpTransceiverImplTest, ReceiverReportUsesReceiveStatistics) {
             kMediaSsrc);
 }
 
+TEST(RtcpTransceiverImplTest, SplitsReportBlocksIntoSeveralReceiverReports) {
+  const uint32_t kSenderSsrc = 12345;
+  const size_t kNumRemoteSsrcs = 40;
+  ReceiveStatisticsForSsrcs receive_statistics(/*first_ssrc=*/1000,
+                                               kNumRemoteSsrcs);
+  RtcpTransceiverConfig config;
+  config.feedback_ssrc = kSenderSsrc;
+  RtcpPacketParser rtcp_parser;
+  RtcpParserTransport transport(&rtcp_parser);
+  config.outgoing_transport = &transport;
+  config.receive_statistics = &receive_statistics;
+  config.schedule_periodic_compound_packets = false;
+  RtcpTransceiverImpl rtcp_transceiver(config);
+
+  rtcp_transceiver.SendCompoundPacket();
+
+  // 40 report blocks need two receiver reports, in the same datagram.
+  EXPECT_EQ(transport.num_packets(), 1);
+  EXPECT_EQ(rtcp_parser.receiver_report()->num_packets(), 2);
+  EXPECT_EQ(rtcp_parser.receiver_report()->sender_ssrc(), kSenderSsrc);
+  // The parser keeps the last receiver report.
+  EXPECT_THAT(rtcp_parser.receiver_report()->report_blocks(),
+              SizeIs(kNumRemoteSsrcs -
+                     ReceiverReport::kMaxNumberOfReportBlocks));
+  EXPECT_TRUE(receive_statistics.ReportedAllSsrcs());
+}
+
+TEST(RtcpTransceiverImplTest, LimitsReportBlocksToMaxPacketSize) {
+  const size_t kMaxPacketSize = 500;
+  ReceiveStatisticsForSsrcs receive_statistics(/*first_ssrc=*/1000,
+                                               /*num_ssrcs=*/100);
+  RtcpTransceiverConfig config;
+  config.cname = "cname";
+  config.max_packet_size = kMaxPacketSize;
+  config.non_sender_rtt_measurement = true;
+  RtcpCountingTransport transport;
+  config.outgoing_transport = &transport;
+  config.receive_statistics = &receive_statistics;
+  config.schedule_periodic_compound_packets = false;
+  RtcpTransceiverImpl rtcp_transceiver(config);
+  rtcp_transceiver.SetRemb(/*bitrate_bps=*/10000, /*ssrcs=*/{54321});
+
+  rtcp_transceiver.SendCompoundPacket();
+  EXPECT_EQ(transport.num_packets(), 1);
+  EXPECT_LE(transport.num_bytes(), kMaxPacketSize);
+
+  // Remaining ssrcs are reported in the following compound packets.
+  while (!receive_statistics.ReportedAllSsrcs())
+    rtcp_transceiver.SendCompoundPacket();
+  EXPECT_LE(transport.num_bytes(), transport.num_packets() * kMaxPacketSize);
+}
+
+TEST(RtcpTransceiverImplTest, KeepsRoomForFeedbackInCompoundPacket) {
+  const size_t kMaxPacketSize = 500;
+  const uint32_t kRemoteSsrc = 4321;
+  const uint16_t kMissingSequenceNumbers[] = {10, 12, 14, 16, 18, 20};
+  ReceiveStatisticsForSsrcs receive_statistics(/*first_ssrc=*/1000,
+                                               /*num_ssrcs=*/100);
+  RtcpTransceiverConfig config;
+  config.max_packet_size = kMaxPacketSize;
+  config.rtcp_mode = webrtc::RtcpMode::kCompound;
+  RtcpPacketParser rtcp_parser;
+  RtcpParserTransport transport(&rtcp_parser);
+  config.outgoing_transport = &transport;
+  config.receive_statistics = &receive_statistics;
+  config.schedule_periodic_compound_packets = false;
+  RtcpTransceiverImpl rtcp_transceiver(config);
+
+  rtcp_transceiver.SendNack(
+      kRemoteSsrc, std::vector<uint16_t>(std::begin(kMissingSequenceNumbers),
+                                         std::end(kMissingSequenceNumbers)));
+
+  EXPECT_EQ(transport.num_packets(), 1);
+  EXPECT_EQ(rtcp_parser.receiver_report()->num_packets(), 1);
+  EXPECT_EQ(rtcp_parser.nack()->num_packets(), 1);
+}
+
 TEST(RtcpTransceiverImplTest, MultipleObserversOnSameSsrc) {
   const uint32_t kRemoteSsrc = 12345;
   StrictMock<MockMediaReceiverRtcpObserver> observer1;
@@ -863,4 +993,67 @@ TEST(RtcpTransceiverImplTest, IgnoresUnknownSsrcInDlrr) {
   rtcp_transceiver.ReceivePacket(raw_packet, time_us + 100000);
 }
 
+// Compares the RTCP rate of one RtcpTransceiverImpl per received stream with
+// one RtcpTransceiverImpl shared by all of them, with every stream reported
+// once per report period.
+TEST(RtcpTransceiverImplTest, DISABLED_RtcpRateAgainstStreamCount) {
+  const int kReportPeriodMs = RtcpTransceiverConfig().report_period_ms;
+  const double kReportsPerSecond = 1000.0 / kReportPeriodMs;
+  for (size_t num_streams : {1, 4, 16, 64, 256}) {
+    RtcpTransceiverConfig config;
+    config.cname = "cname";
+    config.schedule_periodic_compound_packets = false;
+    config.non_sender_rtt_measurement = true;
+
+    // One report period, in which every transceiver reports on its stream.
+    RtcpCountingTransport per_stream_transport;
+    config.outgoing_transport = &per_stream_transport;
+    for (size_t i = 0; i < num_streams; ++i) {
+      ReceiveStatisticsForSsrcs receive_statistics(/*first_ssrc=*/1000 + i,
+                                                   /*num_ssrcs=*/1);
+      config.feedback_ssrc = 1 + i;
+      config.receive_statistics = &receive_statistics;
+      RtcpTransceiverImpl rtcp_transceiver(config);
+      rtcp_transceiver.SendCompoundPacket();
+    }
+
+    // The shared transceiver sends one compound packet per report period, so
+    // it may take several periods until it has reported on every stream.
+    RtcpCountingTransport shared_transport;
+    config.outgoing_transport = &shared_transport;
+    ReceiveStatisticsForSsrcs receive_statistics(/*first_ssrc=*/1000,
+                                                 num_streams);
+    config.feedback_ssrc = 1;
+    config.receive_statistics = &receive_statistics;
+    RtcpTransceiverImpl rtcp_transceiver(config);
+    int num_periods = 0;
+    while (!receive_statistics.ReportedAllSsrcs()) {
+      rtcp_transceiver.SendCompoundPacket();
+      ++num_periods;
+    }
+
+    const std::string trace = std::to_string(num_streams) + "_streams";
+    webrtc::test::PrintResult(
+        "rtcp_packets_per_second", "_per_stream", trace,
+        per_stream_transport.num_packets() * kReportsPerSecond, "packets",
+        false);
+    webrtc::test::PrintResult(
+        "rtcp_packets_per_second", "_shared", trace,
+        shared_transport.num_packets() * kReportsPerSecond / num_periods,
+        "packets", false);
+    webrtc::test::PrintResult(
+        "rtcp_bytes_per_second", "_per_stream", trace,
+        per_stream_transport.num_bytes() * kReportsPerSecond, "bytes", false);
+    webrtc::test::PrintResult(
+        "rtcp_bytes_per_second", "_shared", trace,
+        shared_transport.num_bytes() * kReportsPerSecond / num_periods,
+        "bytes", false);
+    // How often each stream is reported on.
+    webrtc::test::PrintResult("rtcp_report_interval", "_per_stream", trace,
+                              kReportPeriodMs, "ms", false);
+    webrtc::test::PrintResult("rtcp_report_interval", "_shared", trace,
+                              num_periods * kReportPeriodMs, "ms", false);
+  }
+}
+
 }  // namespace
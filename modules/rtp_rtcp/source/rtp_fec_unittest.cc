@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <list>
 #include <memory>
+#include <string>
 
 #include "modules/rtp_rtcp/source/byte_io.h"
 #include "modules/rtp_rtcp/source/fec_test_helper.h"
@@ -19,7 +20,9 @@
 #include "modules/rtp_rtcp/source/ulpfec_header_reader_writer.h"
 #include "rtc_base/basictypes.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -47,6 +50,27 @@ void DeepCopyEveryNthPacket(const ForwardErrorCorrection::PacketList& src,
   }
 }
 
+// Sets |loss_mask[i]| to 1 for lost packets. Losses come in bursts of
+// |burst_length| packets, such that on average |loss_rate| of the packets are
+// lost.
+void GenerateLossMask(double loss_rate,
+                      int burst_length,
+                      int num_packets,
+                      Random* random,
+                      int* loss_mask) {
+  const double burst_start_probability = loss_rate / burst_length;
+  int remaining_burst = 0;
+  for (int i = 0; i < num_packets; ++i) {
+    if (remaining_burst == 0 &&
+        random->Rand<double>() < burst_start_probability) {
+      remaining_burst = burst_length;
+    }
+    loss_mask[i] = remaining_burst > 0 ? 1 : 0;
+    if (remaining_burst > 0)
+      --remaining_burst;
+  }
+}
+
 }  // namespace
 
 using ::testing::Types;
@@ -1160,4 +1184,70 @@ TYPED_TEST(RtpFecTest, FecRecoveryNonConsecutivePacketsWrap) {
   EXPECT_FALSE(this->IsRecoveryComplete());
 }
 
+// Measures the time DecodeFec() takes to receive a frame of 48 media packets
+// and 24 FEC packets, for a few loss patterns.
+TYPED_TEST(RtpFecTest, DISABLED_RecoveryBenchmark) {
+  constexpr int kNumImportantPackets = 0;
+  constexpr bool kUseUnequalProtection = false;
+  constexpr int kNumMediaPackets = kUlpfecMaxMediaPackets;
+  constexpr uint8_t kProtectionFactor = 128;
+  constexpr int kNumFrames = 2000;
+  struct LossPattern {
+    const char* name;
+    double loss_rate;
+    int burst_length;
+  };
+  const LossPattern kLossPatterns[] = {{"random_10", 0.1, 1},
+                                       {"random_30", 0.3, 1},
+                                       {"bursty_30", 0.3, 8}};
+  const char* trace =
+      TypeParam::kFecSsrc == kFlexfecSsrc ? "flexfec" : "ulpfec";
+
+  for (const LossPattern& loss_pattern : kLossPatterns) {
+    int64_t decode_time_ns = 0;
+    int num_lost = 0;
+    int num_recovered = 0;
+    for (int frame = 0; frame < kNumFrames; ++frame) {
+      this->media_packets_ =
+          this->media_packet_generator_.ConstructMediaPackets(kNumMediaPackets);
+      this->generated_fec_packets_.clear();
+      ASSERT_EQ(0, this->fec_.EncodeFec(
+                       this->media_packets_, kProtectionFactor,
+                       kNumImportantPackets, kUseUnequalProtection,
+                       kFecMaskRandom, &this->generated_fec_packets_));
+      const int num_fec_packets =
+          static_cast<int>(this->generated_fec_packets_.size());
+      // Media and FEC packets are sent, and lost, one after the other.
+      int loss_mask[2 * kUlpfecMaxMediaPackets];
+      GenerateLossMask(loss_pattern.loss_rate, loss_pattern.burst_length,
+                       kNumMediaPackets + num_fec_packets, &this->random_,
+                       loss_mask);
+      for (int i = 0; i < kNumMediaPackets; ++i)
+        num_lost += loss_mask[i];
+      this->NetworkReceivedPackets(loss_mask, loss_mask + kNumMediaPackets);
+
+      const int64_t start_ns = rtc::TimeNanos();
+      for (const auto& received_packet : this->received_packets_)
+        this->fec_.DecodeFec(*received_packet, &this->recovered_packets_);
+      decode_time_ns += rtc::TimeNanos() - start_ns;
+
+      for (const auto& recovered_packet : this->recovered_packets_) {
+        if (recovered_packet->was_recovered)
+          ++num_recovered;
+      }
+      // Every frame starts from scratch, since FlexFEC packets of different
+      // frames would get the same sequence numbers here.
+      this->fec_.ResetState(&this->recovered_packets_);
+    }
+
+    const std::string modifier = std::string("_") + loss_pattern.name;
+    webrtc::test::PrintResult(
+        "decode_time_per_frame", modifier, trace,
+        static_cast<double>(decode_time_ns) / kNumFrames / 1000, "us", false);
+    webrtc::test::PrintResult(
+        "recovered_packets", modifier, trace,
+        100.0 * num_recovered / std::max(num_lost, 1), "%", false);
+  }
+}
+
 }  // namespace webrtc
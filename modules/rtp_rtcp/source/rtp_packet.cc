@@ -70,16 +70,17 @@ RtpPacket::RtpPacket(const ExtensionManager* extensions, size_t capacity)
   if (extensions) {
     IdentifyExtensions(*extensions);
   } else {
-    for (size_t i = 0; i < kMaxExtensionHeaders; ++i)
-      extension_entries_[i].type = ExtensionManager::kInvalidType;
+    for (uint8_t& id : extension_ids_)
+      id = ExtensionManager::kInvalidId;
   }
 }
 
 RtpPacket::~RtpPacket() {}
 
 void RtpPacket::IdentifyExtensions(const ExtensionManager& extensions) {
-  for (int i = 0; i < kMaxExtensionHeaders; ++i)
-    extension_entries_[i].type = extensions.GetType(i + 1);
+  rtc::ArrayView<const uint8_t, kRtpExtensionNumberOfExtensions> ids =
+      extensions.ids();
+  memcpy(extension_ids_, ids.data(), ids.size());
 }
 
 bool RtpPacket::Parse(const uint8_t* buffer, size_t buffer_size) {
@@ -198,6 +199,7 @@ void RtpPacket::CopyHeaderFrom(const RtpPacket& packet) {
   for (size_t i = 0; i < kMaxExtensionHeaders; ++i) {
     extension_entries_[i] = packet.extension_entries_[i];
   }
+  memcpy(extension_ids_, packet.extension_ids_, sizeof(extension_ids_));
   extensions_size_ = packet.extensions_size_;
   buffer_.SetData(packet.data(), packet.headers_size());
   // Reset payload and padding.
@@ -293,8 +295,7 @@ rtc::ArrayView<uint8_t> RtpPacket::AllocateRawExtension(int id, size_t length) {
     if (extension_entry->length == length)
       return rtc::MakeArrayView(WriteAt(extension_entry->offset), length);
 
-    RTC_LOG(LS_ERROR) << "Length mismatch for extension id " << id << " type "
-                      << static_cast<int>(extension_entry->type)
+    RTC_LOG(LS_ERROR) << "Length mismatch for extension id " << id
                       << ": expected "
                       << static_cast<int>(extension_entry->length)
                       << ". received " << length;
@@ -516,30 +517,10 @@ bool RtpPacket::ParseBuffer(const uint8_t* buffer, size_t size) {
   return true;
 }
 
-rtc::ArrayView<const uint8_t> RtpPacket::FindExtension(
-    ExtensionType type) const {
-  for (const ExtensionInfo& extension : extension_entries_) {
-    if (extension.type == type) {
-      if (extension.length == 0) {
-        // Extension is registered but not set.
-        return nullptr;
-      }
-      return rtc::MakeArrayView(data() + extension.offset, extension.length);
-    }
-  }
-  return nullptr;
-}
-
 rtc::ArrayView<uint8_t> RtpPacket::AllocateExtension(ExtensionType type,
                                                      size_t length) {
-  for (int i = 0; i < kMaxExtensionHeaders; ++i) {
-    if (extension_entries_[i].type == type) {
-      int extension_id = i + 1;
-      return AllocateRawExtension(extension_id, length);
-    }
-  }
-  // Extension not registered.
-  return nullptr;
+  // Returns an empty view if the extension isn't registered.
+  return AllocateRawExtension(extension_ids_[type], length);
 }
 
 uint8_t* RtpPacket::WriteAt(size_t offset) {
@@ -48,7 +48,9 @@ class RtpPacket {
   // Parse and move given buffer into Packet.
   bool Parse(rtc::CopyOnWriteBuffer packet);
 
-  // Maps extensions id to their types.
+  // Maps extensions id to their types. Takes a copy of the id of each type
+  // registered in |extensions|, so that GetExtension and SetExtension don't
+  // need to search for it.
   void IdentifyExtensions(const ExtensionManager& extensions);
 
   // Header.
@@ -126,7 +128,6 @@ class RtpPacket {
 
  private:
   struct ExtensionInfo {
-    ExtensionType type;
     uint16_t offset;
     uint8_t length;
   };
@@ -137,7 +138,19 @@ class RtpPacket {
 
   // Find an extension |type|.
   // Returns view of the raw extension or empty view on failure.
-  rtc::ArrayView<const uint8_t> FindExtension(ExtensionType type) const;
+  // Inline, so that for GetExtension<Extension> this compiles to a lookup at
+  // a fixed index.
+  rtc::ArrayView<const uint8_t> FindExtension(ExtensionType type) const {
+    const uint8_t id = extension_ids_[type];
+    if (id == 0)
+      return nullptr;
+    const ExtensionInfo& extension = extension_entries_[id - 1];
+    if (extension.length == 0) {
+      // Extension is registered but not set.
+      return nullptr;
+    }
+    return rtc::MakeArrayView(data() + extension.offset, extension.length);
+  }
 
   // Find or allocate an extension |type|. Returns view of size |length|
   // to write raw extension to or an empty view on failure.
@@ -156,7 +169,10 @@ class RtpPacket {
   size_t payload_offset_;  // Match header size with csrcs and extensions.
   size_t payload_size_;
 
+  // Indexed by id - 1.
   ExtensionInfo extension_entries_[kMaxExtensionHeaders];
+  // Id of each extension type, 0 if not registered.
+  uint8_t extension_ids_[kRtpExtensionNumberOfExtensions];
   uint16_t extensions_size_ = 0;  // Unaligned.
   rtc::CopyOnWriteBuffer buffer_;
 };
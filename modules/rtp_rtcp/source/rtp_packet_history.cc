@@ -26,11 +26,19 @@ constexpr size_t kMinPacketRequestBytes = 50;
 // whichever is larger. Instead try to dynamically expand history.
 constexpr int64_t kMinPacketDurationMs = 1000;
 constexpr int kMinPacketDurationRtt = 3;
+
+size_t PacketBytes(const RtpPacketToSend& packet) {
+  return sizeof(packet) + packet.capacity();
+}
 }  // namespace
 constexpr size_t RtpPacketHistory::kMaxCapacity;
 
 RtpPacketHistory::RtpPacketHistory(Clock* clock)
-    : clock_(clock), store_(false), prev_index_(0), rtt_ms_(-1) {}
+    : clock_(clock),
+      store_(false),
+      prev_index_(0),
+      rtt_ms_(-1),
+      memory_account_(MemoryTag::kRtpPacketHistory) {}
 
 RtpPacketHistory::~RtpPacketHistory() {}
 
@@ -50,10 +58,18 @@ void RtpPacketHistory::SetStorePacketsStatus(bool enable,
   }
 }
 
+void RtpPacketHistory::SetMemoryAccountant(MemoryAccountant* accountant) {
+  rtc::CritScope cs(&critsect_);
+  memory_account_.SetAccountant(accountant);
+}
+
 void RtpPacketHistory::Allocate(size_t number_to_store) {
   RTC_DCHECK_GT(number_to_store, 0);
   RTC_DCHECK_LE(number_to_store, kMaxCapacity);
+  RTC_DCHECK_GE(number_to_store, stored_packets_.size());
   store_ = true;
+  memory_account_.Add((number_to_store - stored_packets_.size()) *
+                      sizeof(StoredPacket));
   stored_packets_.resize(number_to_store);
 }
 
@@ -63,6 +79,7 @@ void RtpPacketHistory::Free() {
   }
 
   stored_packets_.clear();
+  memory_account_.Clear();
 
   store_ = false;
   prev_index_ = 0;
@@ -87,14 +104,16 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
   // If index we're about to overwrite contains a packet that has not
   // yet been sent (probably pending in paced sender), or if the send time is
   // less than 3 round trip times ago, expand the buffer to avoid overwriting
-  // valid data.
+  // valid data. Over the memory budget, only the former is worth expanding
+  // for; a packet that is lost and no longer stored costs a keyframe at worst.
   StoredPacket* stored_packet = &stored_packets_[prev_index_];
   int64_t packet_duration_ms =
       std::max(kMinPacketDurationRtt * rtt_ms_, kMinPacketDurationMs);
   if (stored_packet->packet &&
       (stored_packet->send_time == 0 ||
        (rtt_ms_ >= 0 &&
-        now_ms - stored_packet->send_time <= packet_duration_ms))) {
+        now_ms - stored_packet->send_time <= packet_duration_ms &&
+        !memory_account_.OverBudget()))) {
     size_t current_size = stored_packets_.size();
     if (current_size < kMaxCapacity) {
       size_t expanded_size = std::max(current_size * 3 / 2, current_size + 1);
@@ -108,6 +127,9 @@ void RtpPacketHistory::PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
   }
 
   // Store packet.
+  if (stored_packet->packet)
+    memory_account_.Subtract(PacketBytes(*stored_packet->packet));
+  memory_account_.Add(PacketBytes(*packet));
   if (packet->capture_time_ms() <= 0)
     packet->set_capture_time_ms(now_ms);
   stored_packet->sequence_number = packet->SequenceNumber();
@@ -17,6 +17,7 @@
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "rtc_base/constructormagic.h"
 #include "rtc_base/criticalsection.h"
+#include "rtc_base/memory_accountant.h"
 #include "rtc_base/thread_annotations.h"
 #include "typedefs.h"  // NOLINT(build/include)
 
@@ -34,6 +35,11 @@ class RtpPacketHistory {
   void SetStorePacketsStatus(bool enable, uint16_t number_to_store);
   bool StorePackets() const;
 
+  // Accounts the stored packets with |accountant|, which may be null. While
+  // it is over budget, the history only expands for packets that haven't
+  // been sent yet, and overwrites the oldest packet otherwise.
+  void SetMemoryAccountant(MemoryAccountant* accountant);
+
   void PutRtpPacket(std::unique_ptr<RtpPacketToSend> packet,
                     StorageType type,
                     bool sent);
@@ -83,6 +89,7 @@ class RtpPacketHistory {
   size_t prev_index_ RTC_GUARDED_BY(critsect_);
   std::vector<StoredPacket> stored_packets_ RTC_GUARDED_BY(critsect_);
   int64_t rtt_ms_ RTC_GUARDED_BY(critsect_);
+  MemoryAccount memory_account_ RTC_GUARDED_BY(critsect_);
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(RtpPacketHistory);
 };
 }  // namespace webrtc
@@ -15,6 +15,8 @@
 
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "rtc_base/memory_accountant.h"
+#include "rtc_base/refcountedobject.h"
 #include "system_wrappers/include/clock.h"
 #include "test/gtest.h"
 #include "typedefs.h"  // NOLINT(build/include)
@@ -292,4 +294,64 @@ TEST_F(RtpPacketHistoryTest, ExpandIfPacketTooRecentlyTransmittedOnFastLink) {
   hist_.PutRtpPacket(std::move(packet), kAllowRetransmission, true);
   EXPECT_TRUE(hist_.HasRtpPacket(kSeqNum));
 }
+
+TEST_F(RtpPacketHistoryTest, AccountsStoredPackets) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  hist_.SetMemoryAccountant(accountant);
+  hist_.SetStorePacketsStatus(true, 10);
+  const int64_t empty_bytes = accountant->GetUsage().total_bytes;
+  EXPECT_GT(empty_bytes, 0);
+
+  for (int i = 0; i < 10; ++i) {
+    hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + i), kAllowRetransmission,
+                       true);
+  }
+  const int64_t full_bytes = accountant->GetUsage().total_bytes;
+  EXPECT_GT(full_bytes, empty_bytes);
+  EXPECT_EQ(full_bytes,
+            accountant->GetUsage().bytes[static_cast<size_t>(
+                MemoryTag::kRtpPacketHistory)]);
+
+  // Overwriting old packets doesn't change the total.
+  fake_clock_.AdvanceTimeMilliseconds(1000 + 1);
+  hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + 10), kAllowRetransmission,
+                     true);
+  EXPECT_EQ(full_bytes, accountant->GetUsage().total_bytes);
+
+  hist_.SetStorePacketsStatus(false, 0);
+  EXPECT_EQ(0, accountant->GetUsage().total_bytes);
+}
+
+TEST_F(RtpPacketHistoryTest, DontExpandForSentPacketsOverMemoryBudget) {
+  const size_t kSendSidePacketHistorySize = 600;
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  hist_.SetMemoryAccountant(accountant);
+  hist_.SetStorePacketsStatus(true, kSendSidePacketHistorySize);
+  hist_.SetRtt(5);
+  for (size_t i = 0; i < kSendSidePacketHistorySize; ++i) {
+    hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + i), kAllowRetransmission,
+                       true);
+  }
+  accountant->SetSoftBudget(1);
+
+  // The oldest packet was sent recently, but is overwritten anyway.
+  hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + kSendSidePacketHistorySize),
+                     kAllowRetransmission, true);
+  EXPECT_FALSE(hist_.HasRtpPacket(kSeqNum));
+
+  // Packets that haven't been sent are still kept.
+  hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + kSendSidePacketHistorySize + 1),
+                     kAllowRetransmission, false);
+  hist_.PutRtpPacket(CreateRtpPacket(kSeqNum + kSendSidePacketHistorySize + 2),
+                     kAllowRetransmission, false);
+  for (size_t i = 0; i < kSendSidePacketHistorySize; ++i) {
+    hist_.PutRtpPacket(
+        CreateRtpPacket(kSeqNum + kSendSidePacketHistorySize + 3 + i),
+        kAllowRetransmission, true);
+  }
+  EXPECT_TRUE(hist_.HasRtpPacket(kSeqNum + kSendSidePacketHistorySize + 1));
+  EXPECT_TRUE(hist_.HasRtpPacket(kSeqNum + kSendSidePacketHistorySize + 2));
+}
 }  // namespace webrtc
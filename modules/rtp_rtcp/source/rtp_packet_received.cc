@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "modules/rtp_rtcp/source/rtp_header_extensions.h"
+#include "rtc_base/checks.h"
 #include "rtc_base/numerics/safe_conversions.h"
 
 namespace webrtc {
@@ -23,7 +24,24 @@ RtpPacketReceived::RtpPacketReceived(const ExtensionManager* extensions)
 
 RtpPacketReceived::~RtpPacketReceived() {}
 
+void RtpPacketReceived::ResolveHeader() {
+  header_.emplace();
+  ParseHeader(&*header_);
+}
+
 void RtpPacketReceived::GetHeader(RTPHeader* header) const {
+  if (!header_) {
+    ParseHeader(header);
+    return;
+  }
+  RTC_DCHECK_EQ(header_->ssrc, Ssrc());
+  RTC_DCHECK_EQ(header_->sequenceNumber, SequenceNumber());
+  RTC_DCHECK_EQ(header_->headerLength, headers_size());
+  *header = *header_;
+  header->payload_type_frequency = payload_type_frequency();
+}
+
+void RtpPacketReceived::ParseHeader(RTPHeader* header) const {
   header->markerBit = Marker();
   header->payloadType = PayloadType();
   header->sequenceNumber = SequenceNumber();
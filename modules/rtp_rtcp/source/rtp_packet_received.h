@@ -12,6 +12,7 @@
 
 #include <vector>
 
+#include "api/optional.h"
 #include "common_types.h"  // NOLINT(build/include)
 #include "modules/rtp_rtcp/source/rtp_packet.h"
 #include "system_wrappers/include/ntp_time.h"
@@ -25,6 +26,12 @@ class RtpPacketReceived : public RtpPacket {
 
   ~RtpPacketReceived();
 
+  // Fills the header returned by GetHeader, including the values of all known
+  // header extensions, once. Receivers that the packet is passed on to then
+  // don't parse the extensions again. Call after IdentifyExtensions, and
+  // again if the packet is modified afterwards.
+  void ResolveHeader();
+
   // TODO(danilchap): Remove this function when all code update to use RtpPacket
   // directly. Function is there just for easier backward compatibilty.
   void GetHeader(RTPHeader* header) const;
@@ -57,11 +64,15 @@ class RtpPacketReceived : public RtpPacket {
   }
 
  private:
+  void ParseHeader(RTPHeader* header) const;
+
   NtpTime capture_time_;
   int64_t arrival_time_ms_ = 0;
   int payload_type_frequency_ = 0;
   bool recovered_ = false;
   std::vector<uint8_t> application_data_;
+  // Set by ResolveHeader().
+  rtc::Optional<RTPHeader> header_;
 };
 
 }  // namespace webrtc
@@ -13,8 +13,10 @@
 #include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
 #include "modules/rtp_rtcp/source/rtp_header_extensions.h"
 #include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace {
@@ -563,4 +565,201 @@ TEST(RtpPacketTest, ParseLegacyTimingFrameExtension) {
   EXPECT_EQ(receivied_timing.flags, 0);
 }
 
+TEST(RtpPacketTest, ResolvedHeaderMatchesParsedHeader) {
+  RtpPacketReceived::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(kTransmissionOffsetExtensionId);
+  extensions.Register<AudioLevel>(kAudioLevelExtensionId);
+  RtpPacketReceived packet(&extensions);
+  ASSERT_TRUE(packet.Parse(kPacketWithTOAndAL, sizeof(kPacketWithTOAndAL)));
+  RTPHeader parsed_header;
+  packet.GetHeader(&parsed_header);
+
+  packet.ResolveHeader();
+  packet.set_payload_type_frequency(90000);
+  RTPHeader header;
+  packet.GetHeader(&header);
+
+  EXPECT_EQ(parsed_header.ssrc, header.ssrc);
+  EXPECT_EQ(parsed_header.sequenceNumber, header.sequenceNumber);
+  EXPECT_EQ(parsed_header.timestamp, header.timestamp);
+  EXPECT_EQ(parsed_header.payloadType, header.payloadType);
+  EXPECT_EQ(parsed_header.headerLength, header.headerLength);
+  EXPECT_TRUE(header.extension.hasTransmissionTimeOffset);
+  EXPECT_EQ(kTimeOffset, header.extension.transmissionTimeOffset);
+  EXPECT_TRUE(header.extension.hasAudioLevel);
+  EXPECT_EQ(kVoiceActive, header.extension.voiceActivity);
+  EXPECT_EQ(kAudioLevel, header.extension.audioLevel);
+  EXPECT_FALSE(header.extension.hasAbsoluteSendTime);
+  EXPECT_EQ(90000, header.payload_type_frequency);
+}
+
+// Cost of the header handling for each received packet in Call and two
+// receivers, e.g. a video stream receiver and its receive statistics, that
+// use the legacy RTPHeader.
+TEST(RtpPacketTest, DISABLED_ReceivedPacketHeaderCost) {
+  const int kNumPackets = 100000;
+  const int kNumReceivers = 2;
+  RtpPacketReceived::ExtensionManager extensions;
+  extensions.Register<TransmissionOffset>(1);
+  extensions.Register<AbsoluteSendTime>(2);
+  extensions.Register<TransportSequenceNumber>(3);
+  extensions.Register<VideoOrientation>(4);
+  extensions.Register<PlayoutDelayLimits>(5);
+  RtpPacketToSend send_packet(&extensions);
+  send_packet.SetPayloadType(kPayloadType);
+  send_packet.SetSequenceNumber(kSeqNum);
+  send_packet.SetTimestamp(kTimestamp);
+  send_packet.SetSsrc(kSsrc);
+  send_packet.SetExtension<TransmissionOffset>(kTimeOffset);
+  send_packet.SetExtension<AbsoluteSendTime>(0x123456);
+  send_packet.SetExtension<TransportSequenceNumber>(kSeqNum);
+  send_packet.SetExtension<VideoOrientation>(kVideoRotation_90);
+  send_packet.SetExtension<PlayoutDelayLimits>(PlayoutDelay{100, 200});
+  send_packet.SetPayloadSize(1000);
+  const rtc::CopyOnWriteBuffer buffer = send_packet.Buffer();
+
+  for (bool resolve : {false, true}) {
+    uint32_t checksum = 0;
+    const int64_t start_ns = rtc::TimeNanos();
+    for (int i = 0; i < kNumPackets; ++i) {
+      RtpPacketReceived packet;
+      ASSERT_TRUE(packet.Parse(buffer));
+      packet.IdentifyExtensions(extensions);
+      if (resolve)
+        packet.ResolveHeader();
+      for (int receiver = 0; receiver < kNumReceivers; ++receiver) {
+        RTPHeader header;
+        packet.GetHeader(&header);
+        checksum += header.extension.absoluteSendTime;
+      }
+    }
+    const int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+    EXPECT_EQ(kNumPackets * kNumReceivers * 0x123456u, checksum);
+    test::PrintResult("received_packet_header", "_ns_per_packet",
+                      resolve ? "resolved_once" : "parsed_per_receiver",
+                      static_cast<double>(elapsed_ns) / kNumPackets, "ns",
+                      false);
+  }
+}
+
+namespace {
+// Extensions commonly negotiated by audio and video streams, with their ids
+// as in a typical offer.
+constexpr int kAbsSendTimeId = 3;
+constexpr int kVideoOrientationId = 4;
+constexpr int kTransportSequenceNumberId = 5;
+constexpr int kPlayoutDelayId = 6;
+constexpr int kAudioLevelId = 1;
+constexpr int kMidId = 9;
+constexpr int kRidId = 10;
+constexpr size_t kBenchmarkPayloadSize = 1000;
+
+RtpPacketToSend::ExtensionManager CommonExtensions(bool video) {
+  RtpPacketToSend::ExtensionManager extensions;
+  extensions.Register<AbsoluteSendTime>(kAbsSendTimeId);
+  extensions.Register<TransportSequenceNumber>(kTransportSequenceNumberId);
+  extensions.Register<RtpMid>(kMidId);
+  if (video) {
+    extensions.Register<VideoOrientation>(kVideoOrientationId);
+    extensions.Register<PlayoutDelayLimits>(kPlayoutDelayId);
+    extensions.Register<RtpStreamId>(kRidId);
+  } else {
+    extensions.Register<AudioLevel>(kAudioLevelId);
+  }
+  return extensions;
+}
+
+void WriteCommonExtensions(bool video, uint16_t seq_num,
+                           RtpPacketToSend* packet) {
+  packet->SetPayloadType(kPayloadType);
+  packet->SetSequenceNumber(seq_num);
+  packet->SetTimestamp(kTimestamp);
+  packet->SetSsrc(kSsrc);
+  if (video) {
+    packet->SetExtension<VideoOrientation>(kVideoRotation_90);
+    packet->SetExtension<PlayoutDelayLimits>(PlayoutDelay{100, 200});
+    packet->SetExtension<RtpStreamId>(kStreamId);
+  } else {
+    packet->SetExtension<AudioLevel>(kVoiceActive, kAudioLevel);
+  }
+  packet->SetExtension<AbsoluteSendTime>(0x123456);
+  packet->SetExtension<TransportSequenceNumber>(seq_num);
+  packet->SetExtension<RtpMid>(kMid);
+  packet->SetPayloadSize(kBenchmarkPayloadSize);
+}
+
+// Returns the sum of the numeric extension values, so that the reads are
+// not optimized away.
+uint32_t ReadCommonExtensions(bool video, const RtpPacketReceived& packet) {
+  uint32_t sum = 0;
+  if (video) {
+    VideoRotation rotation;
+    PlayoutDelay playout_delay;
+    std::string rid;
+    EXPECT_TRUE(packet.GetExtension<VideoOrientation>(&rotation));
+    EXPECT_TRUE(packet.GetExtension<PlayoutDelayLimits>(&playout_delay));
+    EXPECT_TRUE(packet.GetExtension<RtpStreamId>(&rid));
+    sum += rotation + playout_delay.max_ms;
+  } else {
+    bool voice_activity;
+    uint8_t audio_level;
+    EXPECT_TRUE(
+        packet.GetExtension<AudioLevel>(&voice_activity, &audio_level));
+    sum += audio_level;
+  }
+  uint32_t abs_send_time;
+  uint16_t transport_sequence_number;
+  std::string mid;
+  EXPECT_TRUE(packet.GetExtension<AbsoluteSendTime>(&abs_send_time));
+  EXPECT_TRUE(packet.GetExtension<TransportSequenceNumber>(
+      &transport_sequence_number));
+  EXPECT_TRUE(packet.GetExtension<RtpMid>(&mid));
+  return sum + abs_send_time + transport_sequence_number;
+}
+}  // namespace
+
+TEST(RtpPacketTest, DISABLED_CommonExtensionLayoutsWriteAndParseCost) {
+  const int kNumPackets = 100000;
+  for (bool video : {false, true}) {
+    const RtpPacketToSend::ExtensionManager extensions =
+        CommonExtensions(video);
+    const std::string trace = video ? "video" : "audio";
+
+    int64_t start_ns = rtc::TimeNanos();
+    size_t total_size = 0;
+    for (int i = 0; i < kNumPackets; ++i) {
+      RtpPacketToSend packet(&extensions);
+      WriteCommonExtensions(video, i, &packet);
+      total_size += packet.size();
+    }
+    int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+    EXPECT_GT(total_size, kNumPackets * kBenchmarkPayloadSize);
+    test::PrintResult("rtp_extensions_write", "_ns_per_packet", trace,
+                      static_cast<double>(elapsed_ns) / kNumPackets, "ns",
+                      false);
+
+    RtpPacketToSend send_packet(&extensions);
+    WriteCommonExtensions(video, kSeqNum, &send_packet);
+    const rtc::CopyOnWriteBuffer buffer = send_packet.Buffer();
+    const uint32_t expected_sum = ReadCommonExtensions(video, [&] {
+      RtpPacketReceived packet(&extensions);
+      EXPECT_TRUE(packet.Parse(buffer));
+      return packet;
+    }());
+    uint32_t sum = 0;
+    start_ns = rtc::TimeNanos();
+    for (int i = 0; i < kNumPackets; ++i) {
+      RtpPacketReceived packet;
+      ASSERT_TRUE(packet.Parse(buffer));
+      packet.IdentifyExtensions(extensions);
+      sum += ReadCommonExtensions(video, packet);
+    }
+    elapsed_ns = rtc::TimeNanos() - start_ns;
+    EXPECT_EQ(expected_sum * kNumPackets, sum);
+    test::PrintResult("rtp_extensions_parse", "_ns_per_packet", trace,
+                      static_cast<double>(elapsed_ns) / kNumPackets, "ns",
+                      false);
+  }
+}
+
 }  // namespace webrtc
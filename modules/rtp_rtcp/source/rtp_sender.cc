@@ -605,6 +605,11 @@ bool RTPSender::StorePackets() const {
   return packet_history_.StorePackets();
 }
 
+void RTPSender::SetMemoryAccountant(MemoryAccountant* accountant) {
+  packet_history_.SetMemoryAccountant(accountant);
+  flexfec_packet_history_.SetMemoryAccountant(accountant);
+}
+
 int32_t RTPSender::ReSendPacket(uint16_t packet_id, int64_t min_resend_time) {
   std::unique_ptr<RtpPacketToSend> packet =
       packet_history_.GetPacketAndSetSendTime(packet_id, min_resend_time, true);
@@ -133,6 +133,9 @@ class RTPSender {
 
   bool StorePackets() const;
 
+  // Accounts the packet histories with |accountant|, which may be null.
+  void SetMemoryAccountant(MemoryAccountant* accountant);
+
   int32_t ReSendPacket(uint16_t packet_id, int64_t min_resend_time = 0);
 
   // Feedback to decide when to stop sending playout delay.
@@ -0,0 +1,353 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/rtp_rtcp/include/video_layer_forwarder.h"
+
+#include <algorithm>
+
+#include "modules/rtp_rtcp/source/byte_io.h"
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kFixedRtpHeaderSize = 12;
+constexpr uint8_t kRtpMarkerBit = 0x80;
+constexpr int64_t kRateWindowMs = 1000;
+
+// The parts of the VP8 or VP9 payload descriptor needed for forwarding.
+struct LayerInfo {
+  int spatial_idx = 0;
+  int temporal_idx = 0;
+  bool key_frame = false;
+  // VP8 layer sync (Y) or VP9 switching up point (U).
+  bool switch_point = false;
+  // VP9 E bit, last packet of the layer frame.
+  bool end_of_layer_frame = false;
+  // Offset of the picture id in the payload, 0 if not present.
+  size_t picture_id_offset = 0;
+  bool long_picture_id = false;
+};
+
+//       0 1 2 3 4 5 6 7
+//      +-+-+-+-+-+-+-+-+
+//      |X|R|N|S|R| PID | (REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+// X:   |I|L|T|K| RSV   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+// I:   |M| PictureID   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+// L:   |   TL0PICIDX   | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+// T/K: |TID|Y| KEYIDX  | (OPTIONAL)
+//      +-+-+-+-+-+-+-+-+
+bool ParseVp8(rtc::ArrayView<const uint8_t> payload, LayerInfo* info) {
+  if (payload.empty())
+    return false;
+  const bool start_of_partition = payload[0] & 0x10;
+  const int partition_id = payload[0] & 0x07;
+  size_t offset = 1;
+  if (payload[0] & 0x80) {
+    if (offset >= payload.size())
+      return false;
+    const uint8_t extension = payload[offset++];
+    if (extension & 0x80) {
+      if (offset >= payload.size())
+        return false;
+      info->picture_id_offset = offset;
+      info->long_picture_id = payload[offset] & 0x80;
+      offset += info->long_picture_id ? 2 : 1;
+    }
+    if (extension & 0x40)
+      ++offset;
+    if (extension & 0x30) {
+      if (offset >= payload.size())
+        return false;
+      if (extension & 0x20) {
+        info->temporal_idx = payload[offset] >> 6;
+        info->switch_point = payload[offset] & 0x20;
+      }
+      ++offset;
+    }
+  }
+  if (offset >= payload.size())
+    return false;
+  // The P bit of the VP8 payload header is 0 for key frames.
+  info->key_frame =
+      start_of_partition && partition_id == 0 && !(payload[offset] & 0x01);
+  return true;
+}
+
+//       0 1 2 3 4 5 6 7
+//      +-+-+-+-+-+-+-+-+
+//      |I|P|L|F|B|E|V|-| (REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+// I:   |M| PICTURE ID  | (RECOMMENDED)
+//      +-+-+-+-+-+-+-+-+
+// M:   | EXTENDED PID  | (RECOMMENDED)
+//      +-+-+-+-+-+-+-+-+
+// L:   |  T  |U|  S  |D| (CONDITIONALLY RECOMMENDED)
+//      +-+-+-+-+-+-+-+-+
+//      |   TL0PICIDX   | (CONDITIONALLY REQUIRED)
+//      +-+-+-+-+-+-+-+-+
+bool ParseVp9(rtc::ArrayView<const uint8_t> payload, LayerInfo* info) {
+  if (payload.empty())
+    return false;
+  const bool inter_pic_predicted = payload[0] & 0x40;
+  const bool beginning_of_layer_frame = payload[0] & 0x08;
+  info->end_of_layer_frame = payload[0] & 0x04;
+  size_t offset = 1;
+  if (payload[0] & 0x80) {
+    if (offset >= payload.size())
+      return false;
+    info->picture_id_offset = offset;
+    info->long_picture_id = payload[offset] & 0x80;
+    offset += info->long_picture_id ? 2 : 1;
+  }
+  if (payload[0] & 0x20) {
+    if (offset >= payload.size())
+      return false;
+    info->temporal_idx = payload[offset] >> 5;
+    info->switch_point = payload[offset] & 0x10;
+    info->spatial_idx = (payload[offset] >> 1) & 0x07;
+    ++offset;
+    // TL0PICIDX in non-flexible mode.
+    if (!(payload[0] & 0x10))
+      ++offset;
+  }
+  if (offset > payload.size())
+    return false;
+  info->key_frame = !inter_pic_predicted && beginning_of_layer_frame &&
+                    info->spatial_idx == 0;
+  return true;
+}
+
+}  // namespace
+
+constexpr int VideoLayerForwarder::kMaxLayers;
+
+VideoLayerForwarder::VideoLayerForwarder(int vp8_payload_type,
+                                         int vp9_payload_type)
+    : vp8_payload_type_(vp8_payload_type),
+      vp9_payload_type_(vp9_payload_type),
+      target_bitrate_bps_(0),
+      max_spatial_layer_(kMaxLayers - 1),
+      max_temporal_layer_(kMaxLayers - 1),
+      window_start_ms_(-1),
+      layer_bytes_(),
+      layer_bitrate_bps_(),
+      num_spatial_layers_(0),
+      num_temporal_layers_(0),
+      target_spatial_layer_(0),
+      target_temporal_layer_(0),
+      current_spatial_layer_(-1),
+      current_temporal_layer_(-1),
+      has_picture_(false),
+      picture_timestamp_(0),
+      picture_dropped_(false),
+      highest_sequence_number_(-1),
+      last_dropped_sequence_number_(-1),
+      sequence_number_offset_(0),
+      picture_id_offset_(0) {}
+
+VideoLayerForwarder::~VideoLayerForwarder() = default;
+
+void VideoLayerForwarder::SetTargetBitrate(uint32_t bitrate_bps) {
+  target_bitrate_bps_ = bitrate_bps;
+  SelectTargetLayers();
+}
+
+void VideoLayerForwarder::SetMaxLayers(int max_spatial_layer,
+                                       int max_temporal_layer) {
+  RTC_DCHECK_GE(max_spatial_layer, 0);
+  RTC_DCHECK_GE(max_temporal_layer, 0);
+  max_spatial_layer_ = std::min(max_spatial_layer, kMaxLayers - 1);
+  max_temporal_layer_ = std::min(max_temporal_layer, kMaxLayers - 1);
+  SelectTargetLayers();
+}
+
+bool VideoLayerForwarder::KeyFrameNeeded() const {
+  return current_spatial_layer_ < 0 ||
+         target_spatial_layer_ > current_spatial_layer_;
+}
+
+bool VideoLayerForwarder::OnRtpPacket(int64_t now_ms,
+                                      rtc::ArrayView<uint8_t> packet) {
+  if (packet.size() < kFixedRtpHeaderSize || (packet[0] >> 6) != 2)
+    return false;
+  size_t header_size = kFixedRtpHeaderSize + 4 * (packet[0] & 0x0f);
+  if (packet[0] & 0x10) {
+    if (packet.size() < header_size + 4)
+      return false;
+    header_size +=
+        4 + 4 * ByteReader<uint16_t>::ReadBigEndian(&packet[header_size + 2]);
+  }
+  const size_t padding_size =
+      (packet[0] & 0x20) ? packet[packet.size() - 1] : 0;
+  if (header_size + padding_size > packet.size())
+    return false;
+
+  const int payload_type = packet[1] & 0x7f;
+  const uint16_t sequence_number =
+      ByteReader<uint16_t>::ReadBigEndian(&packet[2]);
+  const uint32_t timestamp = ByteReader<uint32_t>::ReadBigEndian(&packet[4]);
+  const int64_t unwrapped_sequence_number =
+      sequence_number_unwrapper_.Unwrap(sequence_number);
+  highest_sequence_number_ =
+      std::max(highest_sequence_number_, unwrapped_sequence_number);
+  rtc::ArrayView<uint8_t> payload = packet.subview(
+      header_size, packet.size() - header_size - padding_size);
+
+  MaybeUpdateLayerRates(now_ms);
+
+  // Padding only packets are the sender probing its own link.
+  if (payload.empty())
+    return DropPacket(unwrapped_sequence_number);
+
+  const bool is_vp9 = payload_type == vp9_payload_type_;
+  LayerInfo info;
+  if (payload_type == vp8_payload_type_) {
+    if (!ParseVp8(payload, &info))
+      return DropPacket(unwrapped_sequence_number);
+  } else if (is_vp9) {
+    if (!ParseVp9(payload, &info))
+      return DropPacket(unwrapped_sequence_number);
+  }
+  layer_bytes_[info.spatial_idx][info.temporal_idx] += packet.size();
+
+  const bool new_picture =
+      !has_picture_ || AheadOf<uint32_t>(timestamp, picture_timestamp_);
+  if (new_picture) {
+    has_picture_ = true;
+    picture_timestamp_ = timestamp;
+    OnNewPicture(info.temporal_idx, info.key_frame, info.switch_point);
+    // All layer frames of a picture have the same temporal index.
+    picture_dropped_ = current_spatial_layer_ < 0 ||
+                       info.temporal_idx > current_temporal_layer_;
+    // VP8 picture ids are kept continuous, so that the receiver doesn't wait
+    // for pictures that will never arrive. VP9 picture ids can't be changed
+    // since they are used to signal the frame references.
+    if (picture_dropped_ && !is_vp9 && info.picture_id_offset != 0)
+      ++picture_id_offset_;
+  }
+
+  if (picture_dropped_ || info.spatial_idx > current_spatial_layer_)
+    return DropPacket(unwrapped_sequence_number);
+  // The output sequence number of a packet reordered across a dropped packet
+  // is unknown.
+  if (unwrapped_sequence_number < last_dropped_sequence_number_)
+    return false;
+
+  ByteWriter<uint16_t>::WriteBigEndian(
+      &packet[2], sequence_number - sequence_number_offset_);
+  if (info.picture_id_offset != 0 && !is_vp9) {
+    uint8_t* picture_id = &payload[info.picture_id_offset];
+    if (info.long_picture_id) {
+      uint16_t id = ByteReader<uint16_t>::ReadBigEndian(picture_id);
+      ByteWriter<uint16_t>::WriteBigEndian(
+          picture_id, 0x8000 | ((id - picture_id_offset_) & 0x7fff));
+    } else {
+      *picture_id = (*picture_id - picture_id_offset_) & 0x7f;
+    }
+  }
+  // The last forwarded spatial layer ends the superframe.
+  if (is_vp9 && info.end_of_layer_frame &&
+      info.spatial_idx == current_spatial_layer_) {
+    packet[1] |= kRtpMarkerBit;
+  }
+  return true;
+}
+
+void VideoLayerForwarder::MaybeUpdateLayerRates(int64_t now_ms) {
+  if (window_start_ms_ < 0) {
+    window_start_ms_ = now_ms;
+    return;
+  }
+  const int64_t elapsed_ms = now_ms - window_start_ms_;
+  if (elapsed_ms < kRateWindowMs)
+    return;
+
+  num_spatial_layers_ = 0;
+  num_temporal_layers_ = 0;
+  for (int s = 0; s < kMaxLayers; ++s) {
+    for (int t = 0; t < kMaxLayers; ++t) {
+      layer_bitrate_bps_[s][t] =
+          static_cast<uint32_t>(layer_bytes_[s][t] * 8 * 1000 / elapsed_ms);
+      if (layer_bytes_[s][t] > 0) {
+        num_spatial_layers_ = std::max(num_spatial_layers_, s + 1);
+        num_temporal_layers_ = std::max(num_temporal_layers_, t + 1);
+      }
+      layer_bytes_[s][t] = 0;
+    }
+  }
+  window_start_ms_ = now_ms;
+  SelectTargetLayers();
+}
+
+void VideoLayerForwarder::SelectTargetLayers() {
+  // Prefer resolution over frame rate: the highest spatial layer that fits,
+  // then the highest temporal layer that fits with it. The base layer is
+  // always forwarded.
+  const int num_spatial = std::min(num_spatial_layers_, max_spatial_layer_ + 1);
+  const int num_temporal =
+      std::min(num_temporal_layers_, max_temporal_layer_ + 1);
+  int spatial = 0;
+  int temporal = 0;
+  for (int s = 0; s < num_spatial; ++s) {
+    uint64_t bitrate_bps = 0;
+    for (int t = 0; t < num_temporal; ++t) {
+      for (int lower_s = 0; lower_s <= s; ++lower_s)
+        bitrate_bps += layer_bitrate_bps_[lower_s][t];
+      if (bitrate_bps > target_bitrate_bps_)
+        break;
+      spatial = s;
+      temporal = t;
+    }
+  }
+  target_spatial_layer_ = spatial;
+  target_temporal_layer_ = temporal;
+}
+
+void VideoLayerForwarder::OnNewPicture(int temporal_idx,
+                                       bool key_frame,
+                                       bool switch_point) {
+  if (key_frame) {
+    current_spatial_layer_ = target_spatial_layer_;
+    current_temporal_layer_ = target_temporal_layer_;
+    return;
+  }
+  // Nothing decodable is forwarded before the first key frame.
+  if (current_spatial_layer_ < 0)
+    return;
+  current_spatial_layer_ =
+      std::min(current_spatial_layer_, target_spatial_layer_);
+  if (target_temporal_layer_ < current_temporal_layer_) {
+    current_temporal_layer_ = target_temporal_layer_;
+  } else if (switch_point && temporal_idx == current_temporal_layer_ + 1 &&
+             temporal_idx <= target_temporal_layer_) {
+    // Switch up one temporal layer at a time, as a switching point only
+    // guarantees that this layer doesn't depend on earlier frames of its own.
+    current_temporal_layer_ = temporal_idx;
+  }
+}
+
+bool VideoLayerForwarder::DropPacket(int64_t unwrapped_sequence_number) {
+  // Only the newest packet moves the output sequence; numbers have already
+  // been given to the packets after a reordered one, so it leaves a gap which
+  // the receiver treats as a loss.
+  if (unwrapped_sequence_number == highest_sequence_number_ &&
+      unwrapped_sequence_number > last_dropped_sequence_number_) {
+    last_dropped_sequence_number_ = unwrapped_sequence_number;
+    ++sequence_number_offset_;
+  }
+  return false;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,438 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "modules/rtp_rtcp/include/video_layer_forwarder.h"
+#include "modules/rtp_rtcp/source/byte_io.h"
+#include "modules/rtp_rtcp/source/rtp_format_vp8.h"
+#include "modules/rtp_rtcp/source/rtp_format_vp9.h"
+#include "modules/rtp_rtcp/source/rtp_packet_to_send.h"
+#include "rtc_base/timeutils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kVp8PayloadType = 100;
+constexpr int kVp9PayloadType = 101;
+constexpr uint32_t kSsrc = 0x1234;
+constexpr size_t kMaxPayloadSize = 1200;
+constexpr size_t kHeaderSize = 12;
+constexpr int64_t kFrameIntervalMs = 33;
+
+using Packet = std::vector<uint8_t>;
+
+// Produces the packets of a VP8 or VP9 stream with the real packetizers.
+class TestStream {
+ public:
+  std::vector<Packet> Vp8Frame(uint8_t temporal_idx,
+                               bool layer_sync,
+                               bool key_frame,
+                               size_t size) {
+    RTPVideoHeaderVP8 hdr;
+    hdr.InitRTPVideoHeaderVP8();
+    hdr.pictureId = picture_id_;
+    hdr.tl0PicIdx = tl0_pic_idx_;
+    hdr.temporalIdx = temporal_idx;
+    hdr.layerSync = layer_sync;
+    RtpPacketizerVp8 packetizer(hdr, kMaxPayloadSize, 0);
+    std::vector<uint8_t> payload(size, 0x01);
+    // Key frames have the P bit of the VP8 payload header cleared.
+    payload[0] = key_frame ? 0x00 : 0x01;
+    packetizer.SetPayloadData(payload.data(), payload.size(), nullptr);
+    std::vector<Packet> packets;
+    Packetize(&packetizer, kVp8PayloadType, &packets);
+    NextPicture(temporal_idx);
+    return packets;
+  }
+
+  std::vector<Packet> Vp9Superframe(uint8_t temporal_idx,
+                                    bool switch_point,
+                                    bool key_frame,
+                                    int num_spatial_layers,
+                                    size_t layer_size) {
+    std::vector<Packet> packets;
+    for (int s = 0; s < num_spatial_layers; ++s) {
+      RTPVideoHeaderVP9 hdr;
+      hdr.InitRTPVideoHeaderVP9();
+      hdr.picture_id = picture_id_;
+      hdr.max_picture_id = kMaxTwoBytePictureId;
+      hdr.tl0_pic_idx = tl0_pic_idx_;
+      hdr.temporal_idx = temporal_idx;
+      hdr.temporal_up_switch = switch_point;
+      hdr.spatial_idx = s;
+      hdr.num_spatial_layers = num_spatial_layers;
+      hdr.inter_pic_predicted = !key_frame;
+      hdr.inter_layer_predicted = s > 0;
+      RtpPacketizerVp9 packetizer(hdr, kMaxPayloadSize, 0);
+      std::vector<uint8_t> payload(layer_size << s, 0x55);
+      packetizer.SetPayloadData(payload.data(), payload.size(), nullptr);
+      Packetize(&packetizer, kVp9PayloadType, &packets);
+    }
+    NextPicture(temporal_idx);
+    return packets;
+  }
+
+  Packet Padding(uint8_t padding_size) {
+    RtpPacketToSend packet(nullptr);
+    packet.SetPayloadType(kVp8PayloadType);
+    packet.SetTimestamp(timestamp_);
+    packet.SetSsrc(kSsrc);
+    packet.SetSequenceNumber(sequence_number_++);
+    Packet padding(packet.data(), packet.data() + packet.size());
+    padding[0] |= 0x20;
+    padding.resize(padding.size() + padding_size);
+    padding.back() = padding_size;
+    return padding;
+  }
+
+ private:
+  void Packetize(RtpPacketizer* packetizer,
+                 int payload_type,
+                 std::vector<Packet>* packets) {
+    RtpPacketToSend packet(nullptr);
+    packet.SetPayloadType(payload_type);
+    packet.SetTimestamp(timestamp_);
+    packet.SetSsrc(kSsrc);
+    while (true) {
+      packet.SetSequenceNumber(sequence_number_);
+      if (!packetizer->NextPacket(&packet))
+        break;
+      ++sequence_number_;
+      packets->emplace_back(packet.data(), packet.data() + packet.size());
+    }
+  }
+
+  void NextPicture(uint8_t temporal_idx) {
+    picture_id_ = (picture_id_ + 1) & 0x7fff;
+    if (temporal_idx == 0)
+      ++tl0_pic_idx_;
+    timestamp_ += 90 * kFrameIntervalMs;
+  }
+
+  uint16_t sequence_number_ = 65000;
+  uint32_t timestamp_ = 1000;
+  int16_t picture_id_ = 32760;
+  uint8_t tl0_pic_idx_ = 0;
+};
+
+// Checks that the forwarded packets make a continuous stream.
+class OutputChecker {
+ public:
+  void OnForwarded(const Packet& packet) {
+    uint16_t sequence_number =
+        ByteReader<uint16_t>::ReadBigEndian(&packet[2]);
+    if (has_sequence_number_)
+      EXPECT_EQ(static_cast<uint16_t>(sequence_number_ + 1), sequence_number);
+    has_sequence_number_ = true;
+    sequence_number_ = sequence_number;
+
+    if ((packet[1] & 0x7f) != kVp8PayloadType)
+      return;
+    RtpDepacketizerVp8 depacketizer;
+    RtpDepacketizer::ParsedPayload parsed;
+    ASSERT_TRUE(depacketizer.Parse(&parsed, &packet[kHeaderSize],
+                                   packet.size() - kHeaderSize));
+    int16_t picture_id = parsed.type.Video.codecHeader.VP8.pictureId;
+    if (picture_id != picture_id_) {
+      if (picture_id_ >= 0)
+        EXPECT_EQ((picture_id_ + 1) & 0x7fff, picture_id);
+      picture_id_ = picture_id;
+    }
+  }
+
+ private:
+  bool has_sequence_number_ = false;
+  uint16_t sequence_number_ = 0;
+  int16_t picture_id_ = -1;
+};
+
+int TemporalIdx(const Packet& packet) {
+  const uint8_t* payload = &packet[kHeaderSize];
+  const size_t payload_size = packet.size() - kHeaderSize;
+  RtpDepacketizer::ParsedPayload parsed;
+  if ((packet[1] & 0x7f) == kVp8PayloadType) {
+    RtpDepacketizerVp8 depacketizer;
+    EXPECT_TRUE(depacketizer.Parse(&parsed, payload, payload_size));
+    return parsed.type.Video.codecHeader.VP8.temporalIdx;
+  }
+  RtpDepacketizerVp9 depacketizer;
+  EXPECT_TRUE(depacketizer.Parse(&parsed, payload, payload_size));
+  return parsed.type.Video.codecHeader.VP9.temporal_idx;
+}
+
+int SpatialIdx(const Packet& packet) {
+  RtpDepacketizerVp9 depacketizer;
+  RtpDepacketizer::ParsedPayload parsed;
+  EXPECT_TRUE(depacketizer.Parse(&parsed, &packet[kHeaderSize],
+                                 packet.size() - kHeaderSize));
+  return parsed.type.Video.codecHeader.VP9.spatial_idx;
+}
+
+bool Marker(const Packet& packet) {
+  return packet[1] & 0x80;
+}
+
+// Three VP8 temporal layers, 0212 pattern, with TL0 at 120 kbps, TL1 at
+// 60 kbps and TL2 at 60 kbps.
+std::vector<Packet> Vp8TemporalLayersFrame(TestStream* stream,
+                                           int frame,
+                                           bool key_frame) {
+  static const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  static const size_t kFrameSize[] = {2000, 1000, 500};
+  const uint8_t temporal_idx = kTemporalPattern[frame % 4];
+  return stream->Vp8Frame(temporal_idx, temporal_idx > 0, key_frame,
+                          kFrameSize[temporal_idx]);
+}
+
+}  // namespace
+
+TEST(VideoLayerForwarderTest, DropsUntilKeyFrame) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  forwarder.SetTargetBitrate(1000000);
+  EXPECT_TRUE(forwarder.KeyFrameNeeded());
+  for (Packet& packet : stream.Vp8Frame(0, false, false, 3000))
+    EXPECT_FALSE(forwarder.OnRtpPacket(0, packet));
+  EXPECT_TRUE(forwarder.KeyFrameNeeded());
+
+  OutputChecker checker;
+  for (Packet& packet : stream.Vp8Frame(0, false, true, 3000)) {
+    EXPECT_TRUE(forwarder.OnRtpPacket(kFrameIntervalMs, packet));
+    checker.OnForwarded(packet);
+  }
+  EXPECT_FALSE(forwarder.KeyFrameNeeded());
+  EXPECT_EQ(0, forwarder.spatial_layer());
+  EXPECT_EQ(0, forwarder.temporal_layer());
+}
+
+TEST(VideoLayerForwarderTest, Vp8ForwardsTemporalLayersThatFit) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  forwarder.SetTargetBitrate(200000);
+  OutputChecker checker;
+  int64_t now_ms = 0;
+  int max_forwarded_temporal_idx = 0;
+  for (int frame = 0; frame < 120; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet :
+         Vp8TemporalLayersFrame(&stream, frame, frame == 0)) {
+      if (forwarder.OnRtpPacket(now_ms, packet)) {
+        checker.OnForwarded(packet);
+        max_forwarded_temporal_idx =
+            std::max(max_forwarded_temporal_idx, TemporalIdx(packet));
+      }
+    }
+  }
+  // TL0 and TL1 need 180 kbps, TL2 would need another 60 kbps.
+  EXPECT_EQ(1, forwarder.temporal_layer());
+  EXPECT_EQ(1, max_forwarded_temporal_idx);
+
+  forwarder.SetTargetBitrate(1000000);
+  for (int frame = 120; frame < 124; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet : Vp8TemporalLayersFrame(&stream, frame, false)) {
+      if (forwarder.OnRtpPacket(now_ms, packet))
+        checker.OnForwarded(packet);
+    }
+  }
+  EXPECT_EQ(2, forwarder.temporal_layer());
+
+  forwarder.SetTargetBitrate(100000);
+  for (int frame = 124; frame < 128; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet : Vp8TemporalLayersFrame(&stream, frame, false)) {
+      if (forwarder.OnRtpPacket(now_ms, packet)) {
+        checker.OnForwarded(packet);
+        EXPECT_EQ(0, TemporalIdx(packet));
+      }
+    }
+  }
+  EXPECT_EQ(0, forwarder.temporal_layer());
+}
+
+TEST(VideoLayerForwarderTest, Vp8TemporalUpSwitchWaitsForLayerSync) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  int64_t now_ms = 0;
+  for (int frame = 0; frame < 40; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet : stream.Vp8Frame(frame % 2, false, frame == 0, 500))
+      forwarder.OnRtpPacket(now_ms, packet);
+  }
+  EXPECT_EQ(0, forwarder.temporal_layer());
+
+  forwarder.SetTargetBitrate(1000000);
+  for (Packet& packet : stream.Vp8Frame(1, false, false, 500))
+    EXPECT_FALSE(forwarder.OnRtpPacket(now_ms, packet));
+  now_ms += kFrameIntervalMs;
+  for (Packet& packet : stream.Vp8Frame(0, false, false, 500))
+    EXPECT_TRUE(forwarder.OnRtpPacket(now_ms, packet));
+  now_ms += kFrameIntervalMs;
+  for (Packet& packet : stream.Vp8Frame(1, true, false, 500))
+    EXPECT_TRUE(forwarder.OnRtpPacket(now_ms, packet));
+  EXPECT_EQ(1, forwarder.temporal_layer());
+}
+
+TEST(VideoLayerForwarderTest, Vp9ForwardsSpatialLayersThatFit) {
+  // Spatial layers of 1000, 2000 and 4000 bytes at 30 fps: 240, 480 and
+  // 960 kbps.
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  forwarder.SetTargetBitrate(800000);
+  int64_t now_ms = 0;
+  for (int frame = 0; frame < 40; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet : stream.Vp9Superframe(0, false, frame == 0, 3, 1000))
+      forwarder.OnRtpPacket(now_ms, packet);
+  }
+  // Spatial layer 1 fits, but needs a key frame.
+  EXPECT_EQ(0, forwarder.spatial_layer());
+  EXPECT_TRUE(forwarder.KeyFrameNeeded());
+
+  OutputChecker checker;
+  for (int frame = 0; frame < 3; ++frame, now_ms += kFrameIntervalMs) {
+    std::vector<Packet> packets =
+        stream.Vp9Superframe(0, false, frame == 0, 3, 1000);
+    std::vector<Packet> forwarded;
+    for (Packet& packet : packets) {
+      if (forwarder.OnRtpPacket(now_ms, packet))
+        forwarded.push_back(packet);
+    }
+    ASSERT_FALSE(forwarded.empty());
+    for (size_t i = 0; i < forwarded.size(); ++i) {
+      checker.OnForwarded(forwarded[i]);
+      EXPECT_LE(SpatialIdx(forwarded[i]), 1);
+      // Only the last forwarded packet of the superframe has the marker bit.
+      EXPECT_EQ(i == forwarded.size() - 1, Marker(forwarded[i]));
+    }
+    EXPECT_EQ(1, SpatialIdx(forwarded.back()));
+  }
+  EXPECT_EQ(1, forwarder.spatial_layer());
+  EXPECT_FALSE(forwarder.KeyFrameNeeded());
+
+  // Switching down doesn't need a key frame.
+  forwarder.SetTargetBitrate(300000);
+  for (Packet& packet : stream.Vp9Superframe(0, false, false, 3, 1000)) {
+    if (forwarder.OnRtpPacket(now_ms, packet)) {
+      checker.OnForwarded(packet);
+      EXPECT_EQ(0, SpatialIdx(packet));
+    }
+  }
+  EXPECT_EQ(0, forwarder.spatial_layer());
+}
+
+TEST(VideoLayerForwarderTest, SetMaxLayersCapsSelection) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  forwarder.SetTargetBitrate(10000000);
+  forwarder.SetMaxLayers(0, 1);
+  int64_t now_ms = 0;
+  for (int frame = 0; frame < 40; ++frame, now_ms += kFrameIntervalMs) {
+    for (Packet& packet :
+         stream.Vp9Superframe(frame % 4 == 0 ? 0 : 1 + frame % 2, true,
+                              frame == 0, 2, 1000)) {
+      forwarder.OnRtpPacket(now_ms, packet);
+    }
+  }
+  EXPECT_EQ(0, forwarder.spatial_layer());
+  EXPECT_EQ(1, forwarder.temporal_layer());
+  EXPECT_FALSE(forwarder.KeyFrameNeeded());
+}
+
+TEST(VideoLayerForwarderTest, DropsPaddingOnlyPackets) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  OutputChecker checker;
+  for (Packet& packet : stream.Vp8Frame(0, false, true, 500)) {
+    ASSERT_TRUE(forwarder.OnRtpPacket(0, packet));
+    checker.OnForwarded(packet);
+  }
+  Packet padding = stream.Padding(4);
+  EXPECT_FALSE(forwarder.OnRtpPacket(kFrameIntervalMs, padding));
+
+  for (Packet& packet : stream.Vp8Frame(0, false, false, 500)) {
+    EXPECT_TRUE(forwarder.OnRtpPacket(2 * kFrameIntervalMs, packet));
+    checker.OnForwarded(packet);
+  }
+}
+
+TEST(VideoLayerForwarderTest, DropsPacketReorderedAcrossDroppedPacket) {
+  TestStream stream;
+  VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+  for (Packet& packet : stream.Vp8Frame(0, false, true, 500))
+    ASSERT_TRUE(forwarder.OnRtpPacket(0, packet));
+  std::vector<Packet> tl0 = stream.Vp8Frame(0, false, false, 500);
+  std::vector<Packet> tl1 = stream.Vp8Frame(1, false, false, 500);
+  std::vector<Packet> next_tl0 = stream.Vp8Frame(0, false, false, 500);
+  ASSERT_EQ(1u, tl0.size());
+  ASSERT_EQ(1u, tl1.size());
+
+  // |tl0| arrives after the dropped |tl1|, which has already moved the output
+  // sequence, so |tl0| is dropped and leaves a gap for the receiver to NACK.
+  const uint16_t tl0_sequence_number =
+      ByteReader<uint16_t>::ReadBigEndian(&tl0[0][2]);
+  EXPECT_FALSE(forwarder.OnRtpPacket(kFrameIntervalMs, tl1[0]));
+  EXPECT_FALSE(forwarder.OnRtpPacket(kFrameIntervalMs, tl0[0]));
+  EXPECT_TRUE(forwarder.OnRtpPacket(2 * kFrameIntervalMs, next_tl0[0]));
+  EXPECT_EQ(static_cast<uint16_t>(tl0_sequence_number + 1),
+            ByteReader<uint16_t>::ReadBigEndian(&next_tl0[0][2]));
+}
+
+TEST(VideoLayerForwarderTest, DISABLED_ForwardingThroughput) {
+  // One minute of 3 spatial and 3 temporal layer VP9 with a key frame about
+  // every three seconds, as recorded from the sender, forwarded to receivers
+  // with different downlinks.
+  constexpr int kNumFrames = 30 * 60;
+  constexpr int kKeyFrameInterval = 96;
+  static const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  TestStream stream;
+  std::vector<Packet> recorded;
+  std::vector<int64_t> arrival_time_ms;
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    const uint8_t temporal_idx = kTemporalPattern[frame % 4];
+    for (Packet& packet :
+         stream.Vp9Superframe(temporal_idx, temporal_idx > 0,
+                              frame % kKeyFrameInterval == 0, 3,
+                              800 >> temporal_idx)) {
+      recorded.push_back(std::move(packet));
+      arrival_time_ms.push_back(frame * kFrameIntervalMs);
+    }
+  }
+
+  static const uint32_t kTargetBitratesBps[] = {100000, 500000, 1500000,
+                                                5000000};
+  for (uint32_t target_bitrate_bps : kTargetBitratesBps) {
+    VideoLayerForwarder forwarder(kVp8PayloadType, kVp9PayloadType);
+    forwarder.SetTargetBitrate(target_bitrate_bps);
+    uint8_t buffer[IP_PACKET_SIZE];
+    size_t forwarded_packets = 0;
+    int64_t start_ns = rtc::TimeNanos();
+    for (size_t i = 0; i < recorded.size(); ++i) {
+      // Every receiver gets its own copy to rewrite.
+      memcpy(buffer, recorded[i].data(), recorded[i].size());
+      if (forwarder.OnRtpPacket(arrival_time_ms[i],
+                                rtc::ArrayView<uint8_t>(
+                                    buffer, recorded[i].size()))) {
+        ++forwarded_packets;
+      }
+    }
+    int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+    const std::string trace =
+        std::to_string(target_bitrate_bps / 1000) + "kbps";
+    test::PrintResult("vp9_layer_forwarding", "_ns_per_packet", trace,
+                      static_cast<double>(elapsed_ns) / recorded.size(), "ns",
+                      false);
+    test::PrintResult("vp9_layer_forwarding", "_forwarded_packets", trace,
+                      forwarded_packets, "packets", false);
+  }
+}
+
+}  // namespace webrtc
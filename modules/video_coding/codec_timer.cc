@@ -20,11 +20,21 @@ const int kIgnoredSampleCount = 5;
 const float kPercentile = 0.95f;
 // The window size in ms.
 const int64_t kTimeLimitMs = 10000;
+// Decode times below this are counted without allocating, see
+// FenwickPercentileFilter.
+const size_t kNumDecodeTimeBuckets = 256;
+// Initial capacity of the history, enough for 10 s of video at low frame
+// rates.
+const size_t kInitialHistorySize = 128;
 
 }  // anonymous namespace
 
 VCMCodecTimer::VCMCodecTimer()
-    : ignored_sample_count_(0), filter_(kPercentile) {}
+    : ignored_sample_count_(0),
+      history_(kInitialHistorySize),
+      history_start_(0),
+      history_size_(0),
+      filter_(kPercentile, kNumDecodeTimeBuckets) {}
 
 void VCMCodecTimer::AddTiming(int64_t decode_time_ms, int64_t now_ms) {
   // Ignore the first |kIgnoredSampleCount| samples.
@@ -35,13 +45,24 @@ void VCMCodecTimer::AddTiming(int64_t decode_time_ms, int64_t now_ms) {
 
   // Insert new decode time value.
   filter_.Insert(decode_time_ms);
-  history_.emplace(decode_time_ms, now_ms);
+  if (history_size_ == history_.size()) {
+    // Full; unwrap the ring buffer into a larger one.
+    std::vector<Sample> history(history_.size() * 2);
+    for (size_t i = 0; i < history_size_; ++i)
+      history[i] = history_[(history_start_ + i) % history_.size()];
+    history_.swap(history);
+    history_start_ = 0;
+  }
+  history_[(history_start_ + history_size_) % history_.size()] = {
+      decode_time_ms, now_ms};
+  ++history_size_;
 
   // Pop old decode time values.
-  while (!history_.empty() &&
-         now_ms - history_.front().sample_time_ms > kTimeLimitMs) {
-    filter_.Erase(history_.front().decode_time_ms);
-    history_.pop();
+  while (history_size_ > 0 &&
+         now_ms - history_[history_start_].sample_time_ms > kTimeLimitMs) {
+    filter_.Erase(history_[history_start_].decode_time_ms);
+    history_start_ = (history_start_ + 1) % history_.size();
+    --history_size_;
   }
 }
 
@@ -50,7 +71,11 @@ int64_t VCMCodecTimer::RequiredDecodeTimeMs() const {
   return filter_.GetPercentileValue();
 }
 
-VCMCodecTimer::Sample::Sample(int64_t decode_time_ms, int64_t sample_time_ms)
-    : decode_time_ms(decode_time_ms), sample_time_ms(sample_time_ms) {}
+void VCMCodecTimer::Reset() {
+  ignored_sample_count_ = 0;
+  history_start_ = 0;
+  history_size_ = 0;
+  filter_.Reset();
+}
 
 }  // namespace webrtc
@@ -11,10 +11,10 @@
 #ifndef MODULES_VIDEO_CODING_CODEC_TIMER_H_
 #define MODULES_VIDEO_CODING_CODEC_TIMER_H_
 
-#include <queue>
+#include <vector>
 
 #include "modules/include/module_common_types.h"
-#include "rtc_base/numerics/percentile_filter.h"
+#include "rtc_base/numerics/fenwick_percentile_filter.h"
 #include "typedefs.h"  // NOLINT(build/include)
 
 namespace webrtc {
@@ -30,20 +30,26 @@ class VCMCodecTimer {
   // decode time within a time window.
   int64_t RequiredDecodeTimeMs() const;
 
+  // Removes all samples, as if newly constructed. Keeps the allocated memory.
+  void Reset();
+
  private:
   struct Sample {
-    Sample(int64_t decode_time_ms, int64_t sample_time_ms);
     int64_t decode_time_ms;
     int64_t sample_time_ms;
   };
 
   // The number of samples ignored so far.
   int ignored_sample_count_;
-  // Queue with history of latest decode time values.
-  std::queue<Sample> history_;
+  // Ring buffer with history of latest decode time values, oldest at
+  // |history_start_|. It only grows when a time window holds more samples
+  // than it ever has before.
+  std::vector<Sample> history_;
+  size_t history_start_;
+  size_t history_size_;
   // |filter_| contains the same values as |history_|, but in a data structure
   // that allows efficient retrieval of the percentile value.
-  PercentileFilter<int64_t> filter_;
+  FenwickPercentileFilter<int64_t> filter_;
 };
 
 }  // namespace webrtc
@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/codec_timer.h"
+
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "modules/video_coding/jitter_estimator.h"
+#include "modules/video_coding/timing.h"
+#include "rtc_base/numerics/percentile_filter.h"
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/clock.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+
+namespace {
+
+const int kIgnoredSampleCount = 5;
+const int64_t kTimeLimitMs = 10000;
+
+// The previous implementation, based on std::queue and PercentileFilter.
+class ReferenceCodecTimer {
+ public:
+  ReferenceCodecTimer() : ignored_sample_count_(0), filter_(0.95f) {}
+
+  void AddTiming(int64_t decode_time_ms, int64_t now_ms) {
+    if (ignored_sample_count_ < kIgnoredSampleCount) {
+      ++ignored_sample_count_;
+      return;
+    }
+    filter_.Insert(decode_time_ms);
+    history_.emplace(decode_time_ms, now_ms);
+    while (!history_.empty() &&
+           now_ms - history_.front().second > kTimeLimitMs) {
+      filter_.Erase(history_.front().first);
+      history_.pop();
+    }
+  }
+
+  int64_t RequiredDecodeTimeMs() const { return filter_.GetPercentileValue(); }
+
+ private:
+  int ignored_sample_count_;
+  std::queue<std::pair<int64_t, int64_t>> history_;
+  PercentileFilter<int64_t> filter_;
+};
+
+}  // namespace
+
+TEST(CodecTimerTest, IgnoresFirstSamples) {
+  VCMCodecTimer timer;
+  for (int i = 0; i < kIgnoredSampleCount; ++i) {
+    timer.AddTiming(100, i);
+    EXPECT_EQ(0, timer.RequiredDecodeTimeMs());
+  }
+  timer.AddTiming(10, kIgnoredSampleCount);
+  EXPECT_EQ(10, timer.RequiredDecodeTimeMs());
+}
+
+TEST(CodecTimerTest, ForgetsSamplesOutsideWindow) {
+  VCMCodecTimer timer;
+  for (int i = 0; i < kIgnoredSampleCount; ++i)
+    timer.AddTiming(0, 0);
+  timer.AddTiming(500, 0);
+  EXPECT_EQ(500, timer.RequiredDecodeTimeMs());
+  timer.AddTiming(20, kTimeLimitMs + 1);
+  EXPECT_EQ(20, timer.RequiredDecodeTimeMs());
+}
+
+TEST(CodecTimerTest, ResetForgetsAllSamples) {
+  VCMCodecTimer timer;
+  for (int i = 0; i < 100; ++i)
+    timer.AddTiming(30, i);
+  EXPECT_EQ(30, timer.RequiredDecodeTimeMs());
+  timer.Reset();
+  EXPECT_EQ(0, timer.RequiredDecodeTimeMs());
+  for (int i = 0; i < kIgnoredSampleCount; ++i)
+    timer.AddTiming(30, 100 + i);
+  EXPECT_EQ(0, timer.RequiredDecodeTimeMs());
+}
+
+TEST(CodecTimerTest, MatchesReferenceImplementation) {
+  Random random(0x1234);
+  VCMCodecTimer timer;
+  ReferenceCodecTimer reference;
+  int64_t now_ms = 0;
+  for (int i = 0; i < 20000; ++i) {
+    // Varying frame rates, so that the history grows and shrinks, and some
+    // decode times outside the range that is counted without allocating.
+    now_ms += random.Rand(1, i % 5000 < 2500 ? 10 : 100);
+    const int64_t decode_time_ms =
+        random.Rand(0, 10) == 0 ? random.Rand(0, 1000) : random.Rand(5, 40);
+    timer.AddTiming(decode_time_ms, now_ms);
+    reference.AddTiming(decode_time_ms, now_ms);
+    ASSERT_EQ(reference.RequiredDecodeTimeMs(), timer.RequiredDecodeTimeMs());
+  }
+}
+
+// Per-frame work of the jitter estimator and timing of many receive streams,
+// interleaved like a server handling all of them would be.
+TEST(CodecTimerTest, DISABLED_PerFrameTimingBenchmark) {
+  const int kNumStreams = 1000;
+  const int kNumFrames = 600;
+  SimulatedClock clock(0);
+  std::vector<std::unique_ptr<VCMJitterEstimator>> jitter_estimators;
+  std::vector<std::unique_ptr<VCMTiming>> timings;
+  for (int i = 0; i < kNumStreams; ++i) {
+    jitter_estimators.emplace_back(new VCMJitterEstimator(&clock));
+    timings.emplace_back(new VCMTiming(&clock));
+  }
+
+  Random random(0x1234);
+  const int64_t start_time_us = rtc::TimeMicros();
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    clock.AdvanceTimeMilliseconds(33);
+    const uint32_t timestamp = frame * 3000;
+    const int64_t now_ms = clock.TimeInMilliseconds();
+    for (int i = 0; i < kNumStreams; ++i) {
+      VCMJitterEstimator* jitter_estimator = jitter_estimators[i].get();
+      VCMTiming* timing = timings[i].get();
+      jitter_estimator->UpdateEstimate(random.Rand(-10, 10),
+                                       random.Rand(1000, 3000));
+      timing->IncomingTimestamp(timestamp, now_ms);
+      timing->SetJitterDelay(jitter_estimator->GetJitterEstimate(1.0));
+      timing->UpdateCurrentDelay(timestamp);
+      timing->MaxWaitingTime(timing->RenderTimeMs(timestamp, now_ms), now_ms);
+      timing->StopDecodeTimer(timestamp, random.Rand(5, 40), now_ms, now_ms);
+    }
+  }
+  test::PrintResult("per_frame_timing", "", "",
+                    (rtc::TimeMicros() - start_time_us) * 1000.0 /
+                        (kNumStreams * kNumFrames),
+                    "ns", false);
+}
+
+}  // namespace webrtc
@@ -357,8 +357,8 @@ int32_t H264DecoderImpl::Decode(const EncodedImage& input_image,
 
   rtc::Optional<uint8_t> qp;
   // TODO(sakal): Maybe it is possible to get QP directly from FFmpeg.
-  h264_bitstream_parser_.ParseBitstream(input_image._buffer,
-                                        input_image._length);
+  h264_bitstream_parser_.ParseFirstSlice(input_image._buffer,
+                                         input_image._length);
   int qp_int;
   if (h264_bitstream_parser_.GetLastSliceQp(&qp_int)) {
     qp.emplace(qp_int);
@@ -384,8 +384,8 @@ int32_t H264EncoderImpl::Encode(const VideoFrame& input_frame,
   // |encoded_image_._length| == 0.
   if (encoded_image_._length > 0) {
     // Parse QP.
-    h264_bitstream_parser_.ParseBitstream(encoded_image_._buffer,
-                                          encoded_image_._length);
+    h264_bitstream_parser_.ParseFirstSlice(encoded_image_._buffer,
+                                           encoded_image_._length);
     h264_bitstream_parser_.GetLastSliceQp(&encoded_image_.qp_);
 
     // Deliver encoded image.
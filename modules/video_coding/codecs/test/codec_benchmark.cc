@@ -0,0 +1,319 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/codecs/test/codec_benchmark.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "api/video_codecs/sdp_video_format.h"
+#include "common_types.h"  // NOLINT(build/include)
+#include "media/engine/internaldecoderfactory.h"
+#include "media/engine/internalencoderfactory.h"
+#include "modules/video_coding/codecs/test/stats.h"
+#include "modules/video_coding/codecs/test/videoprocessor.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/task_queue.h"
+#include "test/testsupport/frame_reader.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+// Degree of the polynomials fitted to the rate-distortion curves, as in
+// VCEG-M33. Curves with fewer points get a lower degree.
+const size_t kMaxPolynomialDegree = 3;
+
+CodecBenchmarkResult RunOne(const CodecBenchmarkRun& run) {
+  TestConfig config = run.config;
+  config.codec_settings.minBitrate = 0;
+  config.codec_settings.startBitrate = static_cast<int>(run.bitrate_kbps);
+  config.codec_settings.maxFramerate = static_cast<int>(run.framerate_fps);
+
+  const SdpVideoFormat format(
+      CodecTypeToPayloadString(config.codec_settings.codecType));
+  std::unique_ptr<VideoEncoder> encoder =
+      InternalEncoderFactory().CreateVideoEncoder(format);
+  std::unique_ptr<VideoDecoder> decoder =
+      InternalDecoderFactory().CreateVideoDecoder(format);
+  RTC_CHECK(encoder) << "No encoder for " << format.name;
+  RTC_CHECK(decoder) << "No decoder for " << format.name;
+
+  YuvFrameReaderImpl frame_reader(config.input_filename,
+                                  config.codec_settings.width,
+                                  config.codec_settings.height);
+  RTC_CHECK(frame_reader.Init()) << "Can't read " << config.input_filename;
+  const size_t num_frames =
+      std::min(config.num_frames,
+               static_cast<size_t>(frame_reader.NumberOfFrames()));
+
+  Stats stats;
+  std::unique_ptr<VideoProcessor> processor;
+  rtc::Event done(false, false);
+  {
+    // The VideoProcessor and the encode and decode callbacks run on this
+    // task queue, so the per frame CPU times are those of its thread.
+    rtc::TaskQueue task_queue("CodecBenchmark");
+    task_queue.PostTask([&] {
+      processor = rtc::MakeUnique<VideoProcessor>(
+          encoder.get(), decoder.get(), &frame_reader, config, &stats,
+          nullptr, nullptr);
+      processor->SetRates(run.bitrate_kbps, run.framerate_fps);
+    });
+    for (size_t i = 0; i < num_frames; ++i)
+      task_queue.PostTask([&processor] { processor->ProcessFrame(); });
+    task_queue.PostTask([&] {
+      processor.reset();
+      done.Set();
+    });
+    done.Wait(rtc::Event::kForever);
+  }
+  frame_reader.Close();
+
+  CodecBenchmarkResult result;
+  size_t encoded_bytes = 0;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const FrameStatistic& frame_stat = *stats.GetFrame(i);
+    if (frame_stat.encoding_successful &&
+        frame_stat.encoded_frame_size_bytes > 0) {
+      ++result.num_encoded_frames;
+      encoded_bytes += frame_stat.encoded_frame_size_bytes;
+      result.avg_encode_cpu_time_us += frame_stat.encode_cpu_time_us;
+    }
+    if (frame_stat.decoding_successful) {
+      ++result.num_decoded_frames;
+      result.avg_psnr += frame_stat.psnr;
+      result.avg_ssim += frame_stat.ssim;
+      result.avg_decode_cpu_time_us += frame_stat.decode_cpu_time_us;
+    }
+  }
+  if (result.num_encoded_frames > 0)
+    result.avg_encode_cpu_time_us /= result.num_encoded_frames;
+  if (result.num_decoded_frames > 0) {
+    result.avg_psnr /= result.num_decoded_frames;
+    result.avg_ssim /= result.num_decoded_frames;
+    result.avg_decode_cpu_time_us /= result.num_decoded_frames;
+  }
+  if (num_frames > 0) {
+    result.encoded_bitrate_kbps =
+        8.0 * encoded_bytes * run.framerate_fps / num_frames / 1000;
+  }
+  return result;
+}
+
+// State shared by the threads of RunCodecBenchmark().
+struct BenchmarkState {
+  BenchmarkState(const std::vector<CodecBenchmarkRun>& runs,
+                 std::vector<CodecBenchmarkResult>* results)
+      : runs(runs), results(results) {}
+
+  const std::vector<CodecBenchmarkRun>& runs;
+  std::vector<CodecBenchmarkResult>* const results;
+  rtc::CriticalSection crit;
+  size_t next_run RTC_GUARDED_BY(crit) = 0;
+};
+
+void RunBenchmarkThread(void* obj) {
+  BenchmarkState* state = static_cast<BenchmarkState*>(obj);
+  while (true) {
+    size_t run;
+    {
+      rtc::CritScope lock(&state->crit);
+      if (state->next_run == state->runs.size())
+        return;
+      run = state->next_run++;
+    }
+    // Each thread writes different elements.
+    (*state->results)[run] = RunOne(state->runs[run]);
+  }
+}
+
+// Least squares fit of a polynomial of |degree| to the points (x, y), by
+// solving the normal equations. Returns the coefficients, lowest degree
+// first.
+std::vector<double> FitPolynomial(const std::vector<double>& x,
+                                  const std::vector<double>& y,
+                                  size_t degree) {
+  const size_t n = degree + 1;
+  // Augmented matrix of the normal equations.
+  std::vector<std::vector<double>> a(n, std::vector<double>(n + 1, 0.0));
+  for (size_t k = 0; k < x.size(); ++k) {
+    std::vector<double> powers(2 * n - 1, 1.0);
+    for (size_t p = 1; p < powers.size(); ++p)
+      powers[p] = powers[p - 1] * x[k];
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j)
+        a[i][j] += powers[i + j];
+      a[i][n] += powers[i] * y[k];
+    }
+  }
+  // Gaussian elimination with partial pivoting.
+  for (size_t col = 0; col < n; ++col) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < n; ++row) {
+      if (fabs(a[row][col]) > fabs(a[pivot][col]))
+        pivot = row;
+    }
+    std::swap(a[col], a[pivot]);
+    for (size_t row = col + 1; row < n; ++row) {
+      const double factor = a[row][col] / a[col][col];
+      for (size_t j = col; j <= n; ++j)
+        a[row][j] -= factor * a[col][j];
+    }
+  }
+  std::vector<double> coefficients(n);
+  for (size_t i = n; i-- > 0;) {
+    double sum = a[i][n];
+    for (size_t j = i + 1; j < n; ++j)
+      sum -= a[i][j] * coefficients[j];
+    coefficients[i] = sum / a[i][i];
+  }
+  return coefficients;
+}
+
+double IntegratePolynomial(const std::vector<double>& coefficients,
+                           double from,
+                           double to) {
+  double integral = 0.0;
+  for (size_t i = 0; i < coefficients.size(); ++i) {
+    integral += coefficients[i] * (pow(to, i + 1) - pow(from, i + 1)) / (i + 1);
+  }
+  return integral;
+}
+
+struct LabelSummary {
+  std::string label;
+  std::vector<RateDistortionPoint> curve;
+  double encode_cpu_time_us = 0.0;
+  double decode_cpu_time_us = 0.0;
+  size_t num_runs = 0;
+};
+
+}  // namespace
+
+std::vector<CodecBenchmarkResult> RunCodecBenchmark(
+    const std::vector<CodecBenchmarkRun>& runs,
+    size_t num_threads) {
+  std::vector<CodecBenchmarkResult> results(runs.size());
+  BenchmarkState state(runs, &results);
+  num_threads = std::min(std::max(num_threads, size_t{1}), runs.size());
+  if (num_threads <= 1) {
+    RunBenchmarkThread(&state);
+    return results;
+  }
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(new rtc::PlatformThread(&RunBenchmarkThread, &state,
+                                                 "CodecBenchmark"));
+    threads.back()->Start();
+  }
+  for (const auto& thread : threads)
+    thread->Stop();
+  return results;
+}
+
+rtc::Optional<double> BjontegaardDeltaRate(
+    const std::vector<RateDistortionPoint>& anchor,
+    const std::vector<RateDistortionPoint>& test) {
+  if (anchor.size() < 2 || test.size() < 2)
+    return rtc::nullopt;
+  auto psnr_less = [](const RateDistortionPoint& a,
+                      const RateDistortionPoint& b) { return a.psnr < b.psnr; };
+  const auto anchor_range =
+      std::minmax_element(anchor.begin(), anchor.end(), psnr_less);
+  const auto test_range =
+      std::minmax_element(test.begin(), test.end(), psnr_less);
+  const double min_psnr =
+      std::max(anchor_range.first->psnr, test_range.first->psnr);
+  const double max_psnr =
+      std::min(anchor_range.second->psnr, test_range.second->psnr);
+  if (min_psnr >= max_psnr)
+    return rtc::nullopt;
+
+  // Fit log10(bitrate) as a function of PSNR, relative to |min_psnr| to keep
+  // the normal equations well conditioned.
+  double integrals[2];
+  const std::vector<RateDistortionPoint>* curves[] = {&anchor, &test};
+  for (int c = 0; c < 2; ++c) {
+    std::vector<double> psnr;
+    std::vector<double> log_rate;
+    for (const RateDistortionPoint& point : *curves[c]) {
+      if (point.bitrate_kbps <= 0)
+        return rtc::nullopt;
+      psnr.push_back(point.psnr - min_psnr);
+      log_rate.push_back(log10(point.bitrate_kbps));
+    }
+    const size_t degree = std::min(kMaxPolynomialDegree, psnr.size() - 1);
+    integrals[c] = IntegratePolynomial(FitPolynomial(psnr, log_rate, degree),
+                                       0.0, max_psnr - min_psnr);
+  }
+  const double avg_log_rate_diff =
+      (integrals[1] - integrals[0]) / (max_psnr - min_psnr);
+  return (pow(10.0, avg_log_rate_diff) - 1.0) * 100.0;
+}
+
+void PrintCodecBenchmarkTable(
+    FILE* output,
+    const std::vector<CodecBenchmarkRun>& runs,
+    const std::vector<CodecBenchmarkResult>& results) {
+  RTC_CHECK_EQ(runs.size(), results.size());
+  std::vector<LabelSummary> summaries;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    auto it = std::find_if(summaries.begin(), summaries.end(),
+                           [&](const LabelSummary& summary) {
+                             return summary.label == runs[i].label;
+                           });
+    if (it == summaries.end()) {
+      summaries.emplace_back();
+      summaries.back().label = runs[i].label;
+      it = summaries.end() - 1;
+    }
+    it->curve.push_back({results[i].encoded_bitrate_kbps, results[i].avg_psnr});
+    it->encode_cpu_time_us += results[i].avg_encode_cpu_time_us;
+    it->decode_cpu_time_us += results[i].avg_decode_cpu_time_us;
+    ++it->num_runs;
+  }
+  if (summaries.empty())
+    return;
+  for (LabelSummary& summary : summaries) {
+    summary.encode_cpu_time_us /= summary.num_runs;
+    summary.decode_cpu_time_us /= summary.num_runs;
+  }
+
+  const LabelSummary& anchor = summaries[0];
+  fprintf(output, "%-30s %10s %14s %14s %10s %10s\n", "label", "bd_rate_%",
+          "enc_cpu_us", "dec_cpu_us", "enc_cpu_x", "dec_cpu_x");
+  for (const LabelSummary& summary : summaries) {
+    const rtc::Optional<double> bd_rate =
+        BjontegaardDeltaRate(anchor.curve, summary.curve);
+    char bd_rate_string[32];
+    if (bd_rate) {
+      snprintf(bd_rate_string, sizeof(bd_rate_string), "%.2f", *bd_rate);
+    } else {
+      snprintf(bd_rate_string, sizeof(bd_rate_string), "n/a");
+    }
+    fprintf(output, "%-30s %10s %14.1f %14.1f %10.3f %10.3f\n",
+            summary.label.c_str(), bd_rate_string, summary.encode_cpu_time_us,
+            summary.decode_cpu_time_us,
+            summary.encode_cpu_time_us / anchor.encode_cpu_time_us,
+            summary.decode_cpu_time_us / anchor.decode_cpu_time_us);
+  }
+}
+
+}  // namespace test
+}  // namespace webrtc
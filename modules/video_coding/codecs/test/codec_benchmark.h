@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_VIDEO_CODING_CODECS_TEST_CODEC_BENCHMARK_H_
+#define MODULES_VIDEO_CODING_CODECS_TEST_CODEC_BENCHMARK_H_
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "api/optional.h"
+#include "modules/video_coding/codecs/test/test_config.h"
+
+namespace webrtc {
+namespace test {
+
+// One run of a codec benchmark: |config| encoded and decoded with the
+// software codecs at a constant |bitrate_kbps| and |framerate_fps|. Runs with
+// the same |label| are the points of one rate-distortion curve, so they
+// should only differ in bitrate.
+struct CodecBenchmarkRun {
+  std::string label;
+  TestConfig config;
+  size_t bitrate_kbps = 0;
+  size_t framerate_fps = 30;
+};
+
+struct CodecBenchmarkResult {
+  size_t num_encoded_frames = 0;
+  size_t num_decoded_frames = 0;
+  double encoded_bitrate_kbps = 0.0;
+  double avg_psnr = 0.0;
+  double avg_ssim = 0.0;
+  // Average CPU time per frame of the thread calling the codec. CPU time of
+  // threads the codec starts itself isn't included.
+  double avg_encode_cpu_time_us = 0.0;
+  double avg_decode_cpu_time_us = 0.0;
+};
+
+// Runs |runs| on |num_threads| threads at the same time, each run on its own
+// task queue, as fast as the codecs allow. Since the CPU time is measured per
+// thread, the runs don't disturb each other's measurements as long as there
+// are enough cores. Returns one result per run, in the same order.
+std::vector<CodecBenchmarkResult> RunCodecBenchmark(
+    const std::vector<CodecBenchmarkRun>& runs,
+    size_t num_threads);
+
+struct RateDistortionPoint {
+  double bitrate_kbps;
+  double psnr;
+};
+
+// Returns the Bjontegaard delta rate of |test| relative to |anchor| in
+// percent: the average bitrate difference at the same PSNR, over the PSNR
+// range both curves cover. Each curve needs at least two points with
+// different PSNR, and the curves have to overlap. See G. Bjontegaard,
+// "Calculation of average PSNR differences between RD-curves", VCEG-M33.
+rtc::Optional<double> BjontegaardDeltaRate(
+    const std::vector<RateDistortionPoint>& anchor,
+    const std::vector<RateDistortionPoint>& test);
+
+// Prints a table with one row per label of |runs|: the BD-rate against the
+// curve of the first label and the average encode and decode CPU time per
+// frame, absolute and relative to the first label.
+void PrintCodecBenchmarkTable(FILE* output,
+                              const std::vector<CodecBenchmarkRun>& runs,
+                              const std::vector<CodecBenchmarkResult>& results);
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // MODULES_VIDEO_CODING_CODECS_TEST_CODEC_BENCHMARK_H_
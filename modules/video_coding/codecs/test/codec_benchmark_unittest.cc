@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/codecs/test/codec_benchmark.h"
+
+#include <vector>
+
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace test {
+
+namespace {
+
+const std::vector<RateDistortionPoint> kAnchor = {
+    {200, 31.2}, {400, 34.5}, {700, 37.1}, {1000, 38.6}};
+
+std::vector<RateDistortionPoint> ScaleBitrates(
+    const std::vector<RateDistortionPoint>& curve,
+    double factor) {
+  std::vector<RateDistortionPoint> scaled = curve;
+  for (RateDistortionPoint& point : scaled)
+    point.bitrate_kbps *= factor;
+  return scaled;
+}
+
+}  // namespace
+
+TEST(CodecBenchmarkTest, BdRateOfSameCurveIsZero) {
+  rtc::Optional<double> bd_rate = BjontegaardDeltaRate(kAnchor, kAnchor);
+  ASSERT_TRUE(bd_rate);
+  EXPECT_NEAR(0.0, *bd_rate, 1e-9);
+}
+
+TEST(CodecBenchmarkTest, BdRateOfScaledCurveIsScaleFactor) {
+  rtc::Optional<double> bd_rate =
+      BjontegaardDeltaRate(kAnchor, ScaleBitrates(kAnchor, 0.9));
+  ASSERT_TRUE(bd_rate);
+  EXPECT_NEAR(-10.0, *bd_rate, 1e-6);
+
+  bd_rate = BjontegaardDeltaRate(kAnchor, ScaleBitrates(kAnchor, 1.25));
+  ASSERT_TRUE(bd_rate);
+  EXPECT_NEAR(25.0, *bd_rate, 1e-6);
+}
+
+TEST(CodecBenchmarkTest, BdRateWithFewerPointsThanPolynomialDegree) {
+  const std::vector<RateDistortionPoint> anchor = {{300, 33.0}, {600, 36.0}};
+  rtc::Optional<double> bd_rate =
+      BjontegaardDeltaRate(anchor, ScaleBitrates(anchor, 2.0));
+  ASSERT_TRUE(bd_rate);
+  EXPECT_NEAR(100.0, *bd_rate, 1e-6);
+}
+
+TEST(CodecBenchmarkTest, BdRateNeedsOverlappingCurves) {
+  EXPECT_FALSE(BjontegaardDeltaRate(kAnchor, {{1000, 38.6}}));
+  EXPECT_FALSE(BjontegaardDeltaRate(kAnchor, {{2000, 40.0}, {3000, 42.0}}));
+  EXPECT_FALSE(BjontegaardDeltaRate(kAnchor, {{0, 32.0}, {3000, 42.0}}));
+}
+
+}  // namespace test
+}  // namespace webrtc
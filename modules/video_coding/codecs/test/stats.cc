@@ -27,6 +27,8 @@ std::string FrameStatistic::ToString() const {
   ss << " ssim " << ssim;
   ss << " enc_time_us " << encode_time_us;
   ss << " dec_time_us " << decode_time_us;
+  ss << " enc_cpu_time_us " << encode_cpu_time_us;
+  ss << " dec_cpu_time_us " << decode_cpu_time_us;
   ss << " rtp_ts " << rtp_timestamp;
   ss << " bitrate_kbps " << target_bitrate_kbps;
   return ss.str();
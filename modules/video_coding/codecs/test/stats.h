@@ -32,9 +32,13 @@ struct FrameStatistic {
 
   // Encoding.
   int64_t encode_start_ns = 0;
+  int64_t encode_start_cpu_ns = 0;
   int encode_return_code = 0;
   bool encoding_successful = false;
   size_t encode_time_us = 0;
+  // CPU time of the thread calling the encoder, which only covers the
+  // encoding itself for software encoders.
+  size_t encode_cpu_time_us = 0;
   size_t target_bitrate_kbps = 0;
   size_t encoded_frame_size_bytes = 0;
   webrtc::FrameType frame_type = kVideoFrameDelta;
@@ -48,9 +52,11 @@ struct FrameStatistic {
 
   // Decoding.
   int64_t decode_start_ns = 0;
+  int64_t decode_start_cpu_ns = 0;
   int decode_return_code = 0;
   bool decoding_successful = false;
   size_t decode_time_us = 0;
+  size_t decode_cpu_time_us = 0;
   size_t decoded_width = 0;
   size_t decoded_height = 0;
 
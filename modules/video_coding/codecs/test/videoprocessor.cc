@@ -22,6 +22,7 @@
 #include "modules/video_coding/include/video_codec_initializer.h"
 #include "modules/video_coding/utility/default_video_bitrate_allocator.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/cpu_time.h"
 #include "rtc_base/timeutils.h"
 #include "test/gtest.h"
 
@@ -175,6 +176,7 @@ void VideoProcessor::ProcessFrame() {
 
   // For the highest measurement accuracy of the encode time, the start/stop
   // time recordings should wrap the Encode call as tightly as possible.
+  frame_stat->encode_start_cpu_ns = rtc::GetThreadCpuTimeNanos();
   frame_stat->encode_start_ns = rtc::TimeNanos();
   frame_stat->encode_return_code =
       encoder_->Encode(*input_frames_[frame_number], nullptr, &frame_types);
@@ -199,6 +201,7 @@ void VideoProcessor::FrameEncoded(webrtc::VideoCodecType codec,
   // For the highest measurement accuracy of the encode time, the start/stop
   // time recordings should wrap the Encode call as tightly as possible.
   int64_t encode_stop_ns = rtc::TimeNanos();
+  int64_t encode_stop_cpu_ns = rtc::GetThreadCpuTimeNanos();
 
   if (config_.encoded_frame_checker) {
     config_.encoded_frame_checker->CheckEncodedFrame(codec, encoded_image);
@@ -218,6 +221,8 @@ void VideoProcessor::FrameEncoded(webrtc::VideoCodecType codec,
   // Update frame statistics.
   frame_stat->encode_time_us =
       GetElapsedTimeMicroseconds(frame_stat->encode_start_ns, encode_stop_ns);
+  frame_stat->encode_cpu_time_us = GetElapsedTimeMicroseconds(
+      frame_stat->encode_start_cpu_ns, encode_stop_cpu_ns);
   frame_stat->encoding_successful = true;
   frame_stat->encoded_frame_size_bytes = encoded_image._length;
   frame_stat->frame_type = encoded_image._frameType;
@@ -229,6 +234,7 @@ void VideoProcessor::FrameEncoded(webrtc::VideoCodecType codec,
 
   // For the highest measurement accuracy of the decode time, the start/stop
   // time recordings should wrap the Decode call as tightly as possible.
+  frame_stat->decode_start_cpu_ns = rtc::GetThreadCpuTimeNanos();
   frame_stat->decode_start_ns = rtc::TimeNanos();
   frame_stat->decode_return_code =
       decoder_->Decode(encoded_image, false, nullptr);
@@ -246,6 +252,7 @@ void VideoProcessor::FrameDecoded(const VideoFrame& decoded_frame) {
   // For the highest measurement accuracy of the decode time, the start/stop
   // time recordings should wrap the Decode call as tightly as possible.
   int64_t decode_stop_ns = rtc::TimeNanos();
+  int64_t decode_stop_cpu_ns = rtc::GetThreadCpuTimeNanos();
 
   // Update frame statistics.
   FrameStatistic* frame_stat =
@@ -254,6 +261,8 @@ void VideoProcessor::FrameDecoded(const VideoFrame& decoded_frame) {
   frame_stat->decoded_height = decoded_frame.height();
   frame_stat->decode_time_us =
       GetElapsedTimeMicroseconds(frame_stat->decode_start_ns, decode_stop_ns);
+  frame_stat->decode_cpu_time_us = GetElapsedTimeMicroseconds(
+      frame_stat->decode_start_cpu_ns, decode_stop_cpu_ns);
   frame_stat->decoding_successful = true;
 
   // Ensure strict monotonicity.
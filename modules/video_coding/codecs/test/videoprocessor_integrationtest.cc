@@ -347,6 +347,12 @@ std::vector<FrameStatistic> VideoProcessorIntegrationTest::ExtractLayerStats(
               superframe_stat.encode_time_us, frame_stat->encode_time_us);
           superframe_stat.decode_time_us = std::max(
               superframe_stat.decode_time_us, frame_stat->decode_time_us);
+          superframe_stat.encode_cpu_time_us =
+              std::max(superframe_stat.encode_cpu_time_us,
+                       frame_stat->encode_cpu_time_us);
+          superframe_stat.decode_cpu_time_us =
+              std::max(superframe_stat.decode_cpu_time_us,
+                       frame_stat->decode_cpu_time_us);
         }
       }
 
@@ -582,6 +588,8 @@ void VideoProcessorIntegrationTest::AnalyzeAndPrintStats(
 
   Statistics encoding_time_us;
   Statistics decoding_time_us;
+  Statistics encoding_cpu_time_us;
+  Statistics decoding_cpu_time_us;
   Statistics psnr;
   Statistics ssim;
 
@@ -622,6 +630,7 @@ void VideoProcessorIntegrationTest::AnalyzeAndPrintStats(
       }
 
       encoding_time_us.AddSample(frame_stat.encode_time_us);
+      encoding_cpu_time_us.AddSample(frame_stat.encode_cpu_time_us);
       qp.AddSample(frame_stat.qp);
 
       max_nalu_size_bytes =
@@ -640,6 +649,7 @@ void VideoProcessorIntegrationTest::AnalyzeAndPrintStats(
         }
       }
       decoding_time_us.AddSample(frame_stat.decode_time_us);
+      decoding_cpu_time_us.AddSample(frame_stat.decode_cpu_time_us);
       last_successfully_decoded_frame = frame_stat;
       ++num_decoded_frames;
     }
@@ -682,6 +692,10 @@ void VideoProcessorIntegrationTest::AnalyzeAndPrintStats(
   printf("Decoding framerate             : %f fps\n", decoded_framerate_fps);
   printf("Frame encoding time            : %f us\n", encoding_time_us.Mean());
   printf("Frame decoding time            : %f us\n", decoding_time_us.Mean());
+  printf("Frame encoding CPU time        : %f us\n",
+         encoding_cpu_time_us.Mean());
+  printf("Frame decoding CPU time        : %f us\n",
+         decoding_cpu_time_us.Mean());
   printf("Framerate mismatch percent     : %f %%\n",
          framerate_mismatch_percent);
   printf("Avg buffer level               : %f sec\n", buffer_level_sec.Mean());
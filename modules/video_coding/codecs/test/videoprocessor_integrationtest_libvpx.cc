@@ -10,10 +10,13 @@
 
 #include "modules/video_coding/codecs/test/videoprocessor_integrationtest.h"
 
+#include <string>
 #include <vector>
 
+#include "modules/video_coding/codecs/test/codec_benchmark.h"
 #include "modules/video_coding/codecs/test/test_config.h"
 #include "rtc_base/ptr_util.h"
+#include "system_wrappers/include/cpu_info.h"
 #include "test/testsupport/fileutils.h"
 
 namespace webrtc {
@@ -314,5 +317,56 @@ TEST_F(VideoProcessorIntegrationTestLibvpx, MAYBE_TemporalLayersVP8) {
                               kNoVisualizationParams);
 }
 
+// Compares the rate-distortion performance and the CPU cost of the VP8
+// complexity settings, which select the libvpx speed, and of VP9. Prints a
+// BD-rate versus CPU time table with VP8 at normal complexity as anchor.
+TEST(CodecBenchmarkLibvpx, DISABLED_SpeedSettings) {
+  struct Codec {
+    const char* label;
+    VideoCodecType type;
+    VideoCodecComplexity complexity;
+  };
+  std::vector<Codec> codecs = {
+      {"vp8_normal", kVideoCodecVP8, kComplexityNormal},
+      {"vp8_high", kVideoCodecVP8, kComplexityHigh},
+      {"vp8_higher", kVideoCodecVP8, kComplexityHigher},
+      {"vp8_max", kVideoCodecVP8, kComplexityMax},
+  };
+#if !defined(RTC_DISABLE_VP9)
+  codecs.push_back({"vp9", kVideoCodecVP9, kComplexityNormal});
+#endif
+  const size_t kBitratesKbps[] = {200, 400, 700, 1000};
+
+  std::vector<CodecBenchmarkRun> runs;
+  for (const Codec& codec : codecs) {
+    for (size_t bitrate_kbps : kBitratesKbps) {
+      CodecBenchmarkRun run;
+      run.label = codec.label;
+      run.bitrate_kbps = bitrate_kbps;
+      run.config.filename = "foreman_cif";
+      run.config.input_filename = ResourcePath(run.config.filename, "yuv");
+      run.config.num_frames = kNumFramesLong;
+      run.config.use_single_core = true;
+      run.config.SetCodecSettings(codec.type, 1, 1, 1, false, false, false,
+                                  false, false, kCifWidth, kCifHeight);
+      if (codec.type == kVideoCodecVP8)
+        run.config.codec_settings.VP8()->complexity = codec.complexity;
+      runs.push_back(run);
+    }
+  }
+
+  const std::vector<CodecBenchmarkResult> results =
+      RunCodecBenchmark(runs, CpuInfo::DetectNumberOfCores());
+  for (size_t i = 0; i < runs.size(); ++i) {
+    printf("%s %zu kbps: %.1f kbps, %.2f dB, encode %.1f us, decode %.1f us\n",
+           runs[i].label.c_str(), runs[i].bitrate_kbps,
+           results[i].encoded_bitrate_kbps, results[i].avg_psnr,
+           results[i].avg_encode_cpu_time_us,
+           results[i].avg_decode_cpu_time_us);
+  }
+  printf("\n");
+  PrintCodecBenchmarkTable(stdout, runs, results);
+}
+
 }  // namespace test
 }  // namespace webrtc
@@ -11,6 +11,8 @@
 #include "common_video/libyuv/include/webrtc_libyuv.h"
 #include "modules/video_coding/codecs/vp9/include/vp9.h"
 #include "modules/video_coding/codecs/test/video_codec_test.h"
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
+#include "test/field_trial.h"
 
 namespace webrtc {
 
@@ -202,4 +204,14 @@ TEST_F(TestVp9Impl, EncoderRetainsRtpStateAfterRelease) {
                   1);
 }
 
+TEST_F(TestVp9Impl, SetsFrameBufferMemoryLimitFromFieldTrial) {
+  test::ScopedFieldTrials field_trials(
+      "WebRTC-Vp9FrameBufferMemoryLimit/Enabled-64/");
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            decoder_->InitDecode(&codec_settings_, 1 /* number of cores */));
+  EXPECT_EQ(64u * 1024 * 1024,
+            FrameBufferMemoryBudget::GetStats().limit_bytes);
+  FrameBufferMemoryBudget::SetLimitBytes(0);
+}
+
 }  // namespace webrtc
@@ -15,12 +15,41 @@
 #include "vpx/vpx_decoder.h"
 #include "vpx/vpx_frame_buffer.h"
 
+#include <utility>
+
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
-#include "rtc_base/refcountedobject.h"
 
 namespace webrtc {
 
+namespace {
+
+// Buffers up to this size share the smallest size class.
+const size_t kMinSizeClassCapacityLog2 = 12;
+// Available buffers of a size class that wasn't requested in this many
+// requests are deleted. This is ~10 seconds of 30 fps video, long enough to
+// not thrash when the resolution goes back and forth.
+const uint64_t kMaxUnusedRequests = 300;
+// How often to look for stale size classes.
+const uint64_t kStaleCheckIntervalRequests = 32;
+
+}  // namespace
+
+Vp9FrameBufferPool::Vp9FrameBuffer::Vp9FrameBuffer(
+    rtc::scoped_refptr<FreeLists> free_lists,
+    size_t size_class,
+    uint32_t generation)
+    : ref_count_(0),
+      free_lists_(std::move(free_lists)),
+      size_class_(size_class),
+      generation_(generation),
+      data_(0, SizeClassCapacity(size_class)) {}
+
+Vp9FrameBufferPool::Vp9FrameBuffer::~Vp9FrameBuffer() {
+  FrameBufferMemoryBudget::Free(data_.capacity());
+}
+
 uint8_t* Vp9FrameBufferPool::Vp9FrameBuffer::GetData() {
   return data_.data<uint8_t>();
 }
@@ -30,9 +59,136 @@ size_t Vp9FrameBufferPool::Vp9FrameBuffer::GetDataSize() const {
 }
 
 void Vp9FrameBufferPool::Vp9FrameBuffer::SetSize(size_t size) {
+  RTC_DCHECK_LE(size, data_.capacity());
   data_.SetSize(size);
 }
 
+bool Vp9FrameBufferPool::Vp9FrameBuffer::HasOneRef() const {
+  return ref_count_.HasOneRef();
+}
+
+void Vp9FrameBufferPool::Vp9FrameBuffer::AddRef() const {
+  ref_count_.IncRef();
+}
+
+rtc::RefCountReleaseStatus Vp9FrameBufferPool::Vp9FrameBuffer::Release()
+    const {
+  const rtc::RefCountReleaseStatus status = ref_count_.DecRef();
+  if (status == rtc::RefCountReleaseStatus::kDroppedLastRef)
+    free_lists_->Return(this);
+  return status;
+}
+
+Vp9FrameBufferPool::FreeLists::FreeLists()
+    : num_requests_(0), generation_(0) {}
+
+Vp9FrameBufferPool::FreeLists::~FreeLists() {
+  // Available buffers keep the free lists alive, so they are all gone.
+  RTC_DCHECK_EQ(stats_.num_buffers, 0);
+}
+
+Vp9FrameBufferPool::Vp9FrameBuffer* Vp9FrameBufferPool::FreeLists::Take(
+    size_t size_class) {
+  rtc::CritScope cs(&lock_);
+  ++num_requests_;
+  if (num_requests_ % kStaleCheckIntervalRequests == 0)
+    DeleteStaleAvailable();
+  if (size_class >= size_classes_.size())
+    size_classes_.resize(size_class + 1);
+  SizeClass& free_list = size_classes_[size_class];
+  free_list.last_request = num_requests_;
+  if (free_list.available.empty())
+    return nullptr;
+  const Vp9FrameBuffer* buffer = free_list.available.back();
+  free_list.available.pop_back();
+  ++stats_.num_buffers_in_use;
+  return const_cast<Vp9FrameBuffer*>(buffer);
+}
+
+void Vp9FrameBufferPool::FreeLists::AddInUse(const Vp9FrameBuffer* buffer) {
+  rtc::CritScope cs(&lock_);
+  ++stats_.num_buffers;
+  ++stats_.num_buffers_in_use;
+  stats_.allocated_bytes += buffer->data_.capacity();
+}
+
+void Vp9FrameBufferPool::FreeLists::Return(const Vp9FrameBuffer* buffer) {
+  // Deleting the last buffer may delete the free lists, so it is done
+  // without holding the lock.
+  {
+    rtc::CritScope cs(&lock_);
+    RTC_DCHECK_GT(stats_.num_buffers_in_use, 0);
+    --stats_.num_buffers_in_use;
+    if (buffer->generation_ == generation_) {
+      RTC_DCHECK_LT(buffer->size_class_, size_classes_.size());
+      size_classes_[buffer->size_class_].available.push_back(buffer);
+      return;
+    }
+    --stats_.num_buffers;
+    stats_.allocated_bytes -= buffer->data_.capacity();
+  }
+  delete buffer;
+}
+
+size_t Vp9FrameBufferPool::FreeLists::DeleteAvailableExcept(
+    size_t size_class) {
+  rtc::CritScope cs(&lock_);
+  size_t num_deleted = 0;
+  for (size_t i = 0; i < size_classes_.size(); ++i) {
+    if (i != size_class)
+      num_deleted += DeleteAvailable(&size_classes_[i]);
+  }
+  return num_deleted;
+}
+
+void Vp9FrameBufferPool::FreeLists::Clear() {
+  rtc::CritScope cs(&lock_);
+  for (SizeClass& free_list : size_classes_)
+    DeleteAvailable(&free_list);
+  ++generation_;
+}
+
+uint32_t Vp9FrameBufferPool::FreeLists::generation() const {
+  rtc::CritScope cs(&lock_);
+  return generation_;
+}
+
+Vp9FrameBufferPool::Stats Vp9FrameBufferPool::FreeLists::GetStats() const {
+  rtc::CritScope cs(&lock_);
+  return stats_;
+}
+
+size_t Vp9FrameBufferPool::FreeLists::DeleteAvailable(SizeClass* free_list) {
+  const size_t num_deleted = free_list->available.size();
+  for (const Vp9FrameBuffer* buffer : free_list->available) {
+    --stats_.num_buffers;
+    stats_.allocated_bytes -= buffer->data_.capacity();
+    // The pool holds a reference to the free lists, so this doesn't delete
+    // them.
+    delete buffer;
+  }
+  free_list->available.clear();
+  return num_deleted;
+}
+
+void Vp9FrameBufferPool::FreeLists::DeleteStaleAvailable() {
+  for (SizeClass& free_list : size_classes_) {
+    if (!free_list.available.empty() &&
+        num_requests_ - free_list.last_request > kMaxUnusedRequests) {
+      stats_.num_trimmed_buffers += DeleteAvailable(&free_list);
+    }
+  }
+}
+
+Vp9FrameBufferPool::Vp9FrameBufferPool()
+    : free_lists_(new rtc::RefCountedObject<FreeLists>()) {}
+
+Vp9FrameBufferPool::~Vp9FrameBufferPool() {
+  // Breaks the reference cycle between the free lists and the available
+  // buffers. Buffers still in use are deleted when released.
+  ClearPool();
+}
+
 bool Vp9FrameBufferPool::InitializeVpxUsePool(
     vpx_codec_ctx* vpx_codec_context) {
   RTC_DCHECK(vpx_codec_context);
@@ -55,50 +211,76 @@ bool Vp9FrameBufferPool::InitializeVpxUsePool(
 rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer>
 Vp9FrameBufferPool::GetFrameBuffer(size_t min_size) {
   RTC_DCHECK_GT(min_size, 0);
-  rtc::scoped_refptr<Vp9FrameBuffer> available_buffer = nullptr;
-  {
-    rtc::CritScope cs(&buffers_lock_);
-    // Do we have a buffer we can recycle?
-    for (const auto& buffer : allocated_buffers_) {
-      if (buffer->HasOneRef()) {
-        available_buffer = buffer;
-        break;
+  const size_t size_class = SizeClass(min_size);
+  // Do we have a buffer we can recycle?
+  rtc::scoped_refptr<Vp9FrameBuffer> buffer = free_lists_->Take(size_class);
+  // Otherwise create one.
+  if (!buffer) {
+    const size_t capacity = SizeClassCapacity(size_class);
+    if (!FrameBufferMemoryBudget::TryReserve(capacity)) {
+      // Make room by deleting the available buffers of other sizes, which
+      // are likely left over from before a resolution change.
+      if (free_lists_->DeleteAvailableExcept(size_class) == 0 ||
+          !FrameBufferMemoryBudget::TryReserve(capacity)) {
+        RTC_LOG(LS_WARNING) << "Not allocating a " << capacity
+                            << " byte Vp9FrameBuffer, the frame buffer "
+                            << "memory limit is reached.";
+        return nullptr;
       }
     }
-    // Otherwise create one.
-    if (available_buffer == nullptr) {
-      available_buffer = new rtc::RefCountedObject<Vp9FrameBuffer>();
-      allocated_buffers_.push_back(available_buffer);
-      if (allocated_buffers_.size() > max_num_buffers_) {
-        RTC_LOG(LS_WARNING)
-            << allocated_buffers_.size() << " Vp9FrameBuffers have been "
-            << "allocated by a Vp9FrameBufferPool (exceeding what is "
-            << "considered reasonable, " << max_num_buffers_ << ").";
-
-        // TODO(phoglund): this limit is being hit in tests since Oct 5 2016.
-        // See https://bugs.chromium.org/p/webrtc/issues/detail?id=6484.
-        // RTC_NOTREACHED();
-      }
+    buffer = new Vp9FrameBuffer(free_lists_, size_class,
+                                free_lists_->generation());
+    free_lists_->AddInUse(buffer.get());
+    const size_t num_buffers = free_lists_->GetStats().num_buffers;
+    if (num_buffers > max_num_buffers_) {
+      RTC_LOG(LS_WARNING)
+          << num_buffers << " Vp9FrameBuffers have been "
+          << "allocated by a Vp9FrameBufferPool (exceeding what is "
+          << "considered reasonable, " << max_num_buffers_ << ").";
+
+      // TODO(phoglund): this limit is being hit in tests since Oct 5 2016.
+      // See https://bugs.chromium.org/p/webrtc/issues/detail?id=6484.
+      // RTC_NOTREACHED();
     }
   }
 
-  available_buffer->SetSize(min_size);
-  return available_buffer;
+  buffer->SetSize(min_size);
+  return buffer;
 }
 
 int Vp9FrameBufferPool::GetNumBuffersInUse() const {
-  int num_buffers_in_use = 0;
-  rtc::CritScope cs(&buffers_lock_);
-  for (const auto& buffer : allocated_buffers_) {
-    if (!buffer->HasOneRef())
-      ++num_buffers_in_use;
-  }
-  return num_buffers_in_use;
+  return static_cast<int>(free_lists_->GetStats().num_buffers_in_use);
+}
+
+Vp9FrameBufferPool::Stats Vp9FrameBufferPool::GetStats() const {
+  return free_lists_->GetStats();
 }
 
 void Vp9FrameBufferPool::ClearPool() {
-  rtc::CritScope cs(&buffers_lock_);
-  allocated_buffers_.clear();
+  free_lists_->Clear();
+}
+
+// static
+size_t Vp9FrameBufferPool::SizeClass(size_t size) {
+  if (size <= (size_t{1} << kMinSizeClassCapacityLog2))
+    return 0;
+  // Size class 1 + 4 * k + q, for k >= 0 and 0 <= q < 4, holds the sizes
+  // (4 + q) * 2^s < size <= (5 + q) * 2^s, with s = k + 10.
+  const size_t n = size - 1;
+  size_t msb = kMinSizeClassCapacityLog2;
+  while ((n >> (msb + 1)) != 0)
+    ++msb;
+  const size_t quarter = (n >> (msb - 2)) & 3;
+  return 1 + 4 * (msb - kMinSizeClassCapacityLog2) + quarter;
+}
+
+// static
+size_t Vp9FrameBufferPool::SizeClassCapacity(size_t size_class) {
+  if (size_class == 0)
+    return size_t{1} << kMinSizeClassCapacityLog2;
+  const size_t msb = kMinSizeClassCapacityLog2 + (size_class - 1) / 4;
+  const size_t quarter = (size_class - 1) % 4;
+  return (5 + quarter) << (msb - 2);
 }
 
 // static
@@ -110,6 +292,8 @@ int32_t Vp9FrameBufferPool::VpxGetFrameBuffer(void* user_priv,
   Vp9FrameBufferPool* pool = static_cast<Vp9FrameBufferPool*>(user_priv);
 
   rtc::scoped_refptr<Vp9FrameBuffer> buffer = pool->GetFrameBuffer(min_size);
+  if (!buffer)
+    return -1;
   fb->data = buffer->GetData();
   fb->size = buffer->GetDataSize();
   // Store Vp9FrameBuffer* in |priv| for use in VpxReleaseFrameBuffer.
@@ -16,8 +16,11 @@
 
 #include "rtc_base/basictypes.h"
 #include "rtc_base/buffer.h"
+#include "rtc_base/constructormagic.h"
 #include "rtc_base/criticalsection.h"
 #include "rtc_base/refcount.h"
+#include "rtc_base/refcountedobject.h"
+#include "rtc_base/refcounter.h"
 #include "rtc_base/scoped_ref_ptr.h"
 
 struct vpx_codec_ctx;
@@ -52,30 +55,69 @@ namespace webrtc {
 //    // Destroying the codec will make libvpx release any buffers it was using.
 //    vpx_codec_destroy(decoder_ctx);
 class Vp9FrameBufferPool {
+ private:
+  class FreeLists;
+
  public:
   class Vp9FrameBuffer : public rtc::RefCountInterface {
    public:
     uint8_t* GetData();
     size_t GetDataSize() const;
+    // Sets the size of the data, which must fit in the capacity of the
+    // buffer's size class.
     void SetSize(size_t size);
 
-    virtual bool HasOneRef() const = 0;
+    bool HasOneRef() const;
+
+    void AddRef() const override;
+    // When the last reference is released the buffer returns to the pool it
+    // came from instead of being deleted.
+    rtc::RefCountReleaseStatus Release() const override;
 
    private:
+    friend class Vp9FrameBufferPool;
+    friend class FreeLists;
+
+    Vp9FrameBuffer(rtc::scoped_refptr<FreeLists> free_lists,
+                   size_t size_class,
+                   uint32_t generation);
+    ~Vp9FrameBuffer() override;
+
+    mutable webrtc_impl::RefCounter ref_count_;
+    const rtc::scoped_refptr<FreeLists> free_lists_;
+    const size_t size_class_;
+    // Value of FreeLists::generation() when the buffer was created. Buffers
+    // created before the last ClearPool() are deleted when released.
+    const uint32_t generation_;
     // Data as an easily resizable buffer.
     rtc::Buffer data_;
   };
 
+  struct Stats {
+    // All buffers, and the buffers that are referenced from the outside.
+    size_t num_buffers = 0;
+    size_t num_buffers_in_use = 0;
+    size_t allocated_bytes = 0;
+    // Buffers freed because their size wasn't requested for a while.
+    size_t num_trimmed_buffers = 0;
+  };
+
+  Vp9FrameBufferPool();
+  ~Vp9FrameBufferPool();
+
   // Configures libvpx to, in the specified context, use this memory pool for
   // buffers used to decompress frames. This is only supported for VP9.
   bool InitializeVpxUsePool(vpx_codec_ctx* vpx_codec_context);
 
-  // Gets a frame buffer of at least |min_size|, recycling an available one or
-  // creating a new one. When no longer referenced from the outside the buffer
-  // becomes recyclable.
+  // Gets a frame buffer of at least |min_size|, recycling an available one of
+  // the same size class or creating a new one. When no longer referenced
+  // from the outside the buffer becomes recyclable. Returns null if a new
+  // buffer would exceed the FrameBufferMemoryBudget limit, even after freeing
+  // the available buffers of other sizes.
   rtc::scoped_refptr<Vp9FrameBuffer> GetFrameBuffer(size_t min_size);
   // Gets the number of buffers currently in use (not ready to be recycled).
   int GetNumBuffersInUse() const;
+  Stats GetStats() const;
   // Releases allocated buffers, deleting available buffers. Buffers in use are
   // not deleted until they are no longer referenced.
   void ClearPool();
@@ -101,12 +143,61 @@ class Vp9FrameBufferPool {
   static int32_t VpxReleaseFrameBuffer(void* user_priv,
                                        vpx_codec_frame_buffer* fb);
 
+  // Returns the size class of |size|. The capacities of the classes grow in
+  // steps of a quarter of a power of two, so a buffer is at most 25% larger
+  // than requested.
+  static size_t SizeClass(size_t size);
+  static size_t SizeClassCapacity(size_t size_class);
+
  private:
-  // Protects |allocated_buffers_|.
-  rtc::CriticalSection buffers_lock_;
-  // All buffers, in use or ready to be recycled.
-  std::vector<rtc::scoped_refptr<Vp9FrameBuffer>> allocated_buffers_
-      RTC_GUARDED_BY(buffers_lock_);
+  // The available buffers of each size class, as a free list per class.
+  // Shared with the buffers, which return themselves here when released,
+  // also after the pool is gone.
+  class FreeLists : public rtc::RefCountInterface {
+   public:
+    FreeLists();
+
+    // Takes an available buffer of |size_class| for use, or returns null.
+    // Every call counts as a request for |size_class|, and now and then the
+    // available buffers of size classes that weren't requested for a while
+    // are deleted.
+    Vp9FrameBuffer* Take(size_t size_class);
+    // Counts a buffer that was created for use.
+    void AddInUse(const Vp9FrameBuffer* buffer);
+    // Makes a buffer that is no longer used available, or deletes it if it
+    // was created before the last Clear().
+    void Return(const Vp9FrameBuffer* buffer);
+    // Deletes the available buffers of all size classes but |size_class|.
+    // Returns the number of deleted buffers.
+    size_t DeleteAvailableExcept(size_t size_class);
+    // Deletes all available buffers, and makes buffers in use be deleted
+    // when returned.
+    void Clear();
+    uint32_t generation() const;
+    Stats GetStats() const;
+
+   protected:
+    ~FreeLists() override;
+
+   private:
+    struct SizeClass {
+      std::vector<const Vp9FrameBuffer*> available;
+      uint64_t last_request = 0;
+    };
+
+    size_t DeleteAvailable(SizeClass* size_class)
+        RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+    void DeleteStaleAvailable() RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+    rtc::CriticalSection lock_;
+    // Indexed by size class, grown as needed.
+    std::vector<SizeClass> size_classes_ RTC_GUARDED_BY(lock_);
+    uint64_t num_requests_ RTC_GUARDED_BY(lock_);
+    uint32_t generation_ RTC_GUARDED_BY(lock_);
+    Stats stats_ RTC_GUARDED_BY(lock_);
+  };
+
+  const rtc::scoped_refptr<FreeLists> free_lists_;
   // If more buffers than this are allocated we print warnings and crash if in
   // debug mode. VP9 is defined to have 8 reference buffers, of which 3 can be
   // referenced by any frame, see
@@ -117,6 +208,8 @@ class Vp9FrameBufferPool {
   // then the application has ~1 second to e.g. render each frame of a 60 fps
   // video.
   static const size_t max_num_buffers_ = 68;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(Vp9FrameBufferPool);
 };
 
 }  // namespace webrtc
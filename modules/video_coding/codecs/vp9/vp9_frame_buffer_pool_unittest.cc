@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/codecs/vp9/vp9_frame_buffer_pool.h"
+
+#include <memory>
+
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+// Frame buffer sizes libvpx asks for at 640x360 and 1280x720.
+const size_t kSmallSize = 640 * 360 * 3 / 2 + 48000;
+const size_t kLargeSize = 1280 * 720 * 3 / 2 + 96000;
+
+class Vp9FrameBufferPoolTest : public ::testing::Test {
+ protected:
+  ~Vp9FrameBufferPoolTest() override {
+    FrameBufferMemoryBudget::SetLimitBytes(0);
+  }
+
+  Vp9FrameBufferPool pool_;
+};
+
+}  // namespace
+
+TEST(Vp9FrameBufferPoolSizeClassTest, CapacityIsAtMostQuarterLarger) {
+  for (size_t size = 1; size < (1 << 24); size = size * 9 / 8 + 1) {
+    const size_t capacity = Vp9FrameBufferPool::SizeClassCapacity(
+        Vp9FrameBufferPool::SizeClass(size));
+    EXPECT_GE(capacity, size);
+    if (size > 4096)
+      EXPECT_LE(capacity, size + size / 4);
+  }
+}
+
+TEST(Vp9FrameBufferPoolSizeClassTest, CapacityIsInItsOwnSizeClass) {
+  for (size_t size_class = 0; size_class < 60; ++size_class) {
+    EXPECT_EQ(size_class, Vp9FrameBufferPool::SizeClass(
+                              Vp9FrameBufferPool::SizeClassCapacity(
+                                  size_class)));
+  }
+}
+
+TEST_F(Vp9FrameBufferPoolTest, RecyclesReleasedBufferOfSameSizeClass) {
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> buffer =
+      pool_.GetFrameBuffer(kSmallSize);
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(kSmallSize, buffer->GetDataSize());
+  EXPECT_EQ(1, pool_.GetNumBuffersInUse());
+  const uint8_t* data = buffer->GetData();
+  buffer = nullptr;
+  EXPECT_EQ(0, pool_.GetNumBuffersInUse());
+
+  buffer = pool_.GetFrameBuffer(kSmallSize - 100);
+  EXPECT_EQ(data, buffer->GetData());
+  EXPECT_EQ(kSmallSize - 100, buffer->GetDataSize());
+  EXPECT_EQ(1u, pool_.GetStats().num_buffers);
+
+  // A larger size gets a buffer of its own.
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> large_buffer =
+      pool_.GetFrameBuffer(kLargeSize);
+  EXPECT_NE(data, large_buffer->GetData());
+  EXPECT_EQ(2u, pool_.GetStats().num_buffers);
+  EXPECT_EQ(2, pool_.GetNumBuffersInUse());
+}
+
+TEST_F(Vp9FrameBufferPoolTest, DeletesAvailableBuffersOfUnusedSizes) {
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> large_buffers[3];
+  for (auto& buffer : large_buffers)
+    buffer = pool_.GetFrameBuffer(kLargeSize);
+  for (auto& buffer : large_buffers)
+    buffer = nullptr;
+  EXPECT_EQ(3u, pool_.GetStats().num_buffers);
+
+  // After a resolution change the large buffers are freed eventually.
+  for (int i = 0; i < 1000; ++i)
+    pool_.GetFrameBuffer(kSmallSize);
+  const Vp9FrameBufferPool::Stats stats = pool_.GetStats();
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_EQ(3u, stats.num_trimmed_buffers);
+  EXPECT_EQ(Vp9FrameBufferPool::SizeClassCapacity(
+                Vp9FrameBufferPool::SizeClass(kSmallSize)),
+            stats.allocated_bytes);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, FreesOtherSizesToStayWithinMemoryLimit) {
+  const size_t small_capacity = Vp9FrameBufferPool::SizeClassCapacity(
+      Vp9FrameBufferPool::SizeClass(kSmallSize));
+  const size_t large_capacity = Vp9FrameBufferPool::SizeClassCapacity(
+      Vp9FrameBufferPool::SizeClass(kLargeSize));
+  const size_t allocated_bytes =
+      FrameBufferMemoryBudget::GetStats().allocated_bytes;
+  FrameBufferMemoryBudget::SetLimitBytes(allocated_bytes + large_capacity +
+                                         small_capacity);
+
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> buffer =
+      pool_.GetFrameBuffer(kLargeSize);
+  ASSERT_TRUE(buffer);
+  buffer = nullptr;
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> small_buffer =
+      pool_.GetFrameBuffer(kSmallSize);
+  ASSERT_TRUE(small_buffer);
+
+  // The available large buffer is deleted to make room for this one.
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> small_buffer2 =
+      pool_.GetFrameBuffer(kSmallSize);
+  ASSERT_TRUE(small_buffer2);
+  EXPECT_EQ(2u, pool_.GetStats().num_buffers);
+
+  // Nothing left to free.
+  const uint32_t num_failed_reservations =
+      FrameBufferMemoryBudget::GetStats().num_failed_reservations;
+  EXPECT_FALSE(pool_.GetFrameBuffer(kLargeSize));
+  EXPECT_LT(num_failed_reservations,
+            FrameBufferMemoryBudget::GetStats().num_failed_reservations);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, BuffersInUseAreDeletedWhenReleasedAfterClear) {
+  const size_t allocated_bytes =
+      FrameBufferMemoryBudget::GetStats().allocated_bytes;
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> buffer =
+      pool_.GetFrameBuffer(kSmallSize);
+  pool_.GetFrameBuffer(kSmallSize);
+  EXPECT_LT(allocated_bytes,
+            FrameBufferMemoryBudget::GetStats().allocated_bytes);
+
+  pool_.ClearPool();
+  EXPECT_EQ(1u, pool_.GetStats().num_buffers);
+  buffer = nullptr;
+  EXPECT_EQ(0u, pool_.GetStats().num_buffers);
+  EXPECT_EQ(allocated_bytes,
+            FrameBufferMemoryBudget::GetStats().allocated_bytes);
+}
+
+TEST(Vp9FrameBufferPoolLifetimeTest, BuffersOutliveThePool) {
+  const size_t allocated_bytes =
+      FrameBufferMemoryBudget::GetStats().allocated_bytes;
+  std::unique_ptr<Vp9FrameBufferPool> pool(new Vp9FrameBufferPool());
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> buffer =
+      pool->GetFrameBuffer(kSmallSize);
+  pool->GetFrameBuffer(kSmallSize);
+  pool.reset();
+
+  buffer->GetData()[kSmallSize - 1] = 17;
+  buffer = nullptr;
+  EXPECT_EQ(allocated_bytes,
+            FrameBufferMemoryBudget::GetStats().allocated_bytes);
+}
+
+}  // namespace webrtc
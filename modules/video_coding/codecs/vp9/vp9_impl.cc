@@ -11,9 +11,11 @@
 
 #include "modules/video_coding/codecs/vp9/vp9_impl.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <string>
 #include <vector>
 
 #include "vpx/vpx_encoder.h"
@@ -24,6 +26,7 @@
 #include "common_video/include/video_frame_buffer.h"
 #include "common_video/libyuv/include/webrtc_libyuv.h"
 #include "modules/video_coding/codecs/vp9/screenshare_layers.h"
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/keep_ref_until_done.h"
 #include "rtc_base/logging.h"
@@ -31,9 +34,34 @@
 #include "rtc_base/random.h"
 #include "rtc_base/timeutils.h"
 #include "rtc_base/trace_event.h"
+#include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
 
+namespace {
+
+const char kVp9FrameBufferMemoryLimitFieldTrial[] =
+    "WebRTC-Vp9FrameBufferMemoryLimit";
+
+bool GetFrameBufferMemoryLimitFromFieldTrialGroup(size_t* limit_bytes) {
+  std::string group =
+      webrtc::field_trial::FindFullName(kVp9FrameBufferMemoryLimitFieldTrial);
+  if (group.empty())
+    return false;
+
+  int limit_mb;
+  if (sscanf(group.c_str(), "Enabled-%d", &limit_mb) != 1)
+    return false;
+
+  if (limit_mb <= 0)
+    return false;
+
+  *limit_bytes = static_cast<size_t>(limit_mb) * 1024 * 1024;
+  return true;
+}
+
+}  // namespace
+
 // Only positive speeds, range for real-time coding currently is: 5 - 8.
 // Lower means slower/better quality, higher means fastest/lower quality.
 int GetCpuSpeed(int width, int height) {
@@ -898,6 +926,10 @@ int VP9DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
     codec_ = *inst;
   }
 
+  size_t memory_limit_bytes;
+  if (GetFrameBufferMemoryLimitFromFieldTrialGroup(&memory_limit_bytes))
+    FrameBufferMemoryBudget::SetLimitBytes(memory_limit_bytes);
+
   if (!frame_buffer_pool_.InitializeVpxUsePool(decoder_)) {
     return WEBRTC_VIDEO_CODEC_MEMORY;
   }
@@ -41,6 +41,7 @@ PacketBuffer::PacketBuffer(Clock* clock,
                            OnReceivedFrameCallback* received_frame_callback)
     : clock_(clock),
       size_(start_buffer_size),
+      start_size_(start_buffer_size),
       max_size_(max_buffer_size),
       first_seq_num_(0),
       first_packet_received_(false),
@@ -48,12 +49,14 @@ PacketBuffer::PacketBuffer(Clock* clock,
       data_buffer_(start_buffer_size),
       sequence_buffer_(start_buffer_size),
       received_frame_callback_(received_frame_callback),
+      memory_account_(MemoryTag::kVideoPacketBuffer),
       sps_pps_idr_is_h264_keyframe_(
           field_trial::IsEnabled("WebRTC-SpsPpsIdrIsH264Keyframe")) {
   RTC_DCHECK_LE(start_buffer_size, max_buffer_size);
   // Buffer size must always be a power of 2.
   RTC_DCHECK((start_buffer_size & (start_buffer_size - 1)) == 0);
   RTC_DCHECK((max_buffer_size & (max_buffer_size - 1)) == 0);
+  memory_account_.Add(SlotBytes(start_buffer_size));
 }
 
 PacketBuffer::~PacketBuffer() {
@@ -112,6 +115,7 @@ bool PacketBuffer::InsertPacket(VCMPacket* packet) {
     sequence_buffer_[index].used = true;
     data_buffer_[index] = *packet;
     packet->dataPtr = nullptr;
+    memory_account_.Add(packet->sizeBytes);
 
     UpdateMissingPackets(packet->seqNum);
 
@@ -149,11 +153,8 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
   for (size_t i = 0; i < iterations; ++i) {
     size_t index = first_seq_num_ % size_;
     RTC_DCHECK_EQ(data_buffer_[index].seqNum, sequence_buffer_[index].seq_num);
-    if (AheadOf<uint16_t>(seq_num, sequence_buffer_[index].seq_num)) {
-      delete[] data_buffer_[index].dataPtr;
-      data_buffer_[index].dataPtr = nullptr;
-      sequence_buffer_[index].used = false;
-    }
+    if (AheadOf<uint16_t>(seq_num, sequence_buffer_[index].seq_num))
+      ClearSlot(index);
     ++first_seq_num_;
   }
 
@@ -167,15 +168,17 @@ void PacketBuffer::ClearTo(uint16_t seq_num) {
     --clear_to_it;
     missing_packets_.erase(missing_packets_.begin(), clear_to_it);
   }
+
+  // Shrinking is cheapest right after the decoded packets have been removed.
+  while (size_ > start_size_ && memory_account_.OverBudget() &&
+         ShrinkBufferSize()) {
+  }
 }
 
 void PacketBuffer::Clear() {
   rtc::CritScope lock(&crit_);
-  for (size_t i = 0; i < size_; ++i) {
-    delete[] data_buffer_[i].dataPtr;
-    data_buffer_[i].dataPtr = nullptr;
-    sequence_buffer_[i].used = false;
-  }
+  for (size_t i = 0; i < size_; ++i)
+    ClearSlot(i);
 
   first_packet_received_ = false;
   is_cleared_to_first_seq_num_ = false;
@@ -197,6 +200,11 @@ void PacketBuffer::PaddingReceived(uint16_t seq_num) {
     received_frame_callback_->OnReceivedFrame(std::move(frame));
 }
 
+void PacketBuffer::SetMemoryAccountant(MemoryAccountant* accountant) {
+  rtc::CritScope lock(&crit_);
+  memory_account_.SetAccountant(accountant);
+}
+
 rtc::Optional<int64_t> PacketBuffer::LastReceivedPacketMs() const {
   rtc::CritScope lock(&crit_);
   return last_received_packet_ms_;
@@ -214,24 +222,65 @@ bool PacketBuffer::ExpandBufferSize() {
     Clear();
     return false;
   }
+  if (memory_account_.OverBudget()) {
+    RTC_LOG(LS_WARNING) << "PacketBuffer is over the memory budget at size "
+                        << size_ << ", failed to increase size. Clearing "
+                        << "PacketBuffer.";
+    Clear();
+    return false;
+  }
 
   size_t new_size = std::min(max_size_, 2 * size_);
+  // Expanding never moves two packets to the same slot.
+  RTC_CHECK(ResizeBuffer(new_size));
+  RTC_LOG(LS_INFO) << "PacketBuffer size expanded to " << new_size;
+  return true;
+}
+
+bool PacketBuffer::ShrinkBufferSize() {
+  RTC_DCHECK_GT(size_, start_size_);
+  size_t new_size = std::max(start_size_, size_ / 2);
+  if (!ResizeBuffer(new_size))
+    return false;
+  RTC_LOG(LS_INFO) << "PacketBuffer size shrunk to " << new_size;
+  return true;
+}
+
+bool PacketBuffer::ResizeBuffer(size_t new_size) {
   std::vector<VCMPacket> new_data_buffer(new_size);
   std::vector<ContinuityInfo> new_sequence_buffer(new_size);
   for (size_t i = 0; i < size_; ++i) {
     if (sequence_buffer_[i].used) {
       size_t index = sequence_buffer_[i].seq_num % new_size;
+      if (new_sequence_buffer[index].used)
+        return false;
       new_sequence_buffer[index] = sequence_buffer_[i];
       new_data_buffer[index] = data_buffer_[i];
     }
   }
+  if (new_size > size_) {
+    memory_account_.Add(SlotBytes(new_size - size_));
+  } else {
+    memory_account_.Subtract(SlotBytes(size_ - new_size));
+  }
   size_ = new_size;
   sequence_buffer_ = std::move(new_sequence_buffer);
   data_buffer_ = std::move(new_data_buffer);
-  RTC_LOG(LS_INFO) << "PacketBuffer size expanded to " << new_size;
   return true;
 }
 
+void PacketBuffer::ClearSlot(size_t index) {
+  if (sequence_buffer_[index].used)
+    memory_account_.Subtract(data_buffer_[index].sizeBytes);
+  delete[] data_buffer_[index].dataPtr;
+  data_buffer_[index].dataPtr = nullptr;
+  sequence_buffer_[index].used = false;
+}
+
+size_t PacketBuffer::SlotBytes(size_t num_slots) {
+  return num_slots * (sizeof(VCMPacket) + sizeof(ContinuityInfo));
+}
+
 bool PacketBuffer::PotentialNewFrame(uint16_t seq_num) const {
   size_t index = seq_num % size_;
   int prev_index = index > 0 ? index - 1 : size_ - 1;
@@ -393,11 +442,8 @@ void PacketBuffer::ReturnFrame(RtpFrameObject* frame) {
   size_t end = (frame->last_seq_num() + 1) % size_;
   uint16_t seq_num = frame->first_seq_num();
   while (index != end) {
-    if (sequence_buffer_[index].seq_num == seq_num) {
-      delete[] data_buffer_[index].dataPtr;
-      data_buffer_[index].dataPtr = nullptr;
-      sequence_buffer_[index].used = false;
-    }
+    if (sequence_buffer_[index].seq_num == seq_num)
+      ClearSlot(index);
 
     index = (index + 1) % size_;
     ++seq_num;
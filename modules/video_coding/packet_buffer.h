@@ -19,6 +19,7 @@
 #include "modules/video_coding/packet.h"
 #include "modules/video_coding/rtp_frame_reference_finder.h"
 #include "rtc_base/criticalsection.h"
+#include "rtc_base/memory_accountant.h"
 #include "rtc_base/numerics/sequence_number_util.h"
 #include "rtc_base/scoped_ref_ptr.h"
 #include "rtc_base/thread_annotations.h"
@@ -57,6 +58,12 @@ class PacketBuffer {
   void Clear();
   void PaddingReceived(uint16_t seq_num);
 
+  // Accounts the slots and stored payloads with |accountant|, which may be
+  // null. While it is over budget, the buffer doesn't expand, as if it was
+  // at its max size, and shrinks back towards its start size when the
+  // stored packets allow it.
+  void SetMemoryAccountant(MemoryAccountant* accountant);
+
   // Timestamp (not RTP timestamp) of the last received packet/keyframe packet.
   rtc::Optional<int64_t> LastReceivedPacketMs() const;
   rtc::Optional<int64_t> LastReceivedKeyframePacketMs() const;
@@ -101,6 +108,20 @@ class PacketBuffer {
   // Tries to expand the buffer.
   bool ExpandBufferSize() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
+  // Tries to halve the buffer, which fails if two stored packets would end up
+  // in the same slot.
+  bool ShrinkBufferSize() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Moves the used slots to buffers of |new_size|. Returns false and leaves
+  // the buffers as they are if two packets would end up in the same slot.
+  bool ResizeBuffer(size_t new_size) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Deletes the payload of the packet in slot |index| and frees the slot.
+  void ClearSlot(size_t index) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Memory used by |num_slots| slots, not counting the payloads.
+  static size_t SlotBytes(size_t num_slots);
+
   // Test if all previous packets has arrived for the given sequence number.
   bool PotentialNewFrame(uint16_t seq_num) const
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
@@ -128,8 +149,9 @@ class PacketBuffer {
 
   rtc::CriticalSection crit_;
 
-  // Buffer size_ and max_size_ must always be a power of two.
+  // Buffer size_, start_size_ and max_size_ must always be a power of two.
   size_t size_ RTC_GUARDED_BY(crit_);
+  const size_t start_size_;
   const size_t max_size_;
 
   // The fist sequence number currently in the buffer.
@@ -157,6 +179,7 @@ class PacketBuffer {
       RTC_GUARDED_BY(crit_);
 
   rtc::Optional<uint16_t> newest_inserted_seq_num_ RTC_GUARDED_BY(crit_);
+  MemoryAccount memory_account_ RTC_GUARDED_BY(crit_);
   std::set<uint16_t, DescendingSeqNumComp<uint16_t>> missing_packets_
       RTC_GUARDED_BY(crit_);
 
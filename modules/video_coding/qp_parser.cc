@@ -10,20 +10,34 @@
 
 #include "modules/video_coding/qp_parser.h"
 
-#include "common_types.h"  // NOLINT(build/include)
 #include "modules/video_coding/utility/vp8_header_parser.h"
 #include "modules/video_coding/utility/vp9_uncompressed_header_parser.h"
 
 namespace webrtc {
 
+QpParser::QpParser() {}
+QpParser::~QpParser() {}
+
 bool QpParser::GetQp(const VCMEncodedFrame& frame, int* qp) {
-  switch (frame.CodecSpecific()->codecType) {
+  return GetQp(frame.CodecSpecific()->codecType, frame.Buffer(),
+               frame.Length(), qp);
+}
+
+bool QpParser::GetQp(VideoCodecType codec_type,
+                     const uint8_t* buffer,
+                     size_t length,
+                     int* qp) {
+  switch (codec_type) {
     case kVideoCodecVP8:
       // QP range: [0, 127].
-      return vp8::GetQp(frame.Buffer(), frame.Length(), qp);
+      return vp8::GetQp(buffer, length, qp);
     case kVideoCodecVP9:
       // QP range: [0, 255].
-      return vp9::GetQp(frame.Buffer(), frame.Length(), qp);
+      return vp9::GetQp(buffer, length, qp);
+    case kVideoCodecH264:
+      // QP range: [0, 51].
+      h264_parser_.ParseFirstSlice(buffer, length);
+      return h264_parser_.GetLastSliceQp(qp);
     default:
       return false;
   }
@@ -11,18 +11,40 @@
 #ifndef MODULES_VIDEO_CODING_QP_PARSER_H_
 #define MODULES_VIDEO_CODING_QP_PARSER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common_types.h"  // NOLINT(build/include)
+#include "common_video/h264/h264_bitstream_parser.h"
 #include "modules/video_coding/encoded_frame.h"
+#include "rtc_base/constructormagic.h"
 
 namespace webrtc {
 
+// Extracts the QP of encoded frames by parsing as little as possible: the VP8
+// and VP9 frame headers, and for H.264 the parameter sets and the header of
+// the first slice. The H.264 SPS/PPS state is kept between frames, so a
+// QpParser should be used for one stream only.
 class QpParser {
  public:
-  QpParser() {}
-  ~QpParser() {}
+  QpParser();
+  ~QpParser();
 
   // Parses an encoded |frame| and extracts the |qp|.
   // Returns true on success, false otherwise.
   bool GetQp(const VCMEncodedFrame& frame, int* qp);
+
+  // Same as above for an encoded frame that is just a buffer, e.g. when
+  // forwarding a stream without decoding it.
+  bool GetQp(VideoCodecType codec_type,
+             const uint8_t* buffer,
+             size_t length,
+             int* qp);
+
+ private:
+  H264BitstreamParser h264_parser_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(QpParser);
 };
 
 }  // namespace webrtc
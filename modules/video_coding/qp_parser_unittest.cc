@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/qp_parser.h"
+
+#include "rtc_base/bitbuffer.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+// SPS, PPS and the start of an IDR slice with QP 35.
+const uint8_t kH264KeyFrame[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x80, 0x20, 0xda, 0x01, 0x40, 0x16,
+    0xe8, 0x06, 0xd0, 0xa1, 0x35, 0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x06,
+    0xe2, 0x00, 0x00, 0x00, 0x01, 0x65, 0xb8, 0x40, 0xf0, 0x8c, 0x03, 0xf2,
+    0x75, 0x67, 0xad, 0x41, 0x64, 0x24, 0x0e, 0xa0, 0xb2, 0x12, 0x1e, 0xf8,
+};
+
+// The start of a non-IDR slice with QP 37, using the parameter sets above.
+const uint8_t kH264DeltaFrame[] = {
+    0x00, 0x00, 0x00, 0x01, 0x41, 0xe2, 0x01, 0x16, 0x0e, 0x3e, 0x2b, 0x86,
+};
+
+// Writes the uncompressed header of a VP9 profile 0 error resilient inter
+// frame, with the size taken from a reference frame.
+size_t WriteVp9InterFrameHeader(uint8_t base_qindex,
+                                uint8_t* buffer,
+                                size_t size) {
+  rtc::BitBufferWriter writer(buffer, size);
+  writer.WriteBits(2, 2);   // Frame marker.
+  writer.WriteBits(0, 2);   // Profile 0.
+  writer.WriteBits(0, 1);   // Show existing frame.
+  writer.WriteBits(1, 1);   // Frame type: inter frame.
+  writer.WriteBits(1, 1);   // Show frame.
+  writer.WriteBits(1, 1);   // Error resilient.
+  writer.WriteBits(0, 8);   // Refresh frame flags.
+  writer.WriteBits(0, 12);  // Reference indices and sign biases.
+  writer.WriteBits(1, 1);   // Size from the first reference.
+  writer.WriteBits(0, 1);   // No render size.
+  writer.WriteBits(0, 1);   // Allow high precision mv.
+  writer.WriteBits(1, 1);   // Switchable interpolation filter.
+  writer.WriteBits(0, 2);   // Frame context index.
+  writer.WriteBits(0, 9);   // Loop filter level and sharpness.
+  writer.WriteBits(0, 1);   // No mode/ref deltas.
+  writer.WriteUInt8(base_qindex);
+  size_t byte_offset;
+  size_t bit_offset;
+  writer.GetCurrentOffset(&byte_offset, &bit_offset);
+  return byte_offset + (bit_offset > 0 ? 1 : 0);
+}
+
+}  // namespace
+
+TEST(QpParserTest, ParsesH264QpWithParameterSetsFromEarlierFrames) {
+  QpParser qp_parser;
+  int qp = -1;
+  ASSERT_TRUE(qp_parser.GetQp(kVideoCodecH264, kH264KeyFrame,
+                              sizeof(kH264KeyFrame), &qp));
+  EXPECT_EQ(35, qp);
+  ASSERT_TRUE(qp_parser.GetQp(kVideoCodecH264, kH264DeltaFrame,
+                              sizeof(kH264DeltaFrame), &qp));
+  EXPECT_EQ(37, qp);
+}
+
+TEST(QpParserTest, FailsOnH264SliceWithoutParameterSets) {
+  QpParser qp_parser;
+  int qp = -1;
+  EXPECT_FALSE(qp_parser.GetQp(kVideoCodecH264, kH264DeltaFrame,
+                               sizeof(kH264DeltaFrame), &qp));
+}
+
+TEST(QpParserTest, ParsesVp9Qp) {
+  uint8_t frame[16] = {};
+  const size_t length = WriteVp9InterFrameHeader(123, frame, sizeof(frame));
+  QpParser qp_parser;
+  int qp = -1;
+  ASSERT_TRUE(qp_parser.GetQp(kVideoCodecVP9, frame, length, &qp));
+  EXPECT_EQ(123, qp);
+  EXPECT_FALSE(qp_parser.GetQp(kVideoCodecVP9, frame, length - 1, &qp));
+}
+
+TEST(QpParserTest, FailsForCodecsWithoutParser) {
+  QpParser qp_parser;
+  int qp = -1;
+  EXPECT_FALSE(qp_parser.GetQp(kVideoCodecGeneric, kH264KeyFrame,
+                               sizeof(kH264KeyFrame), &qp));
+}
+
+}  // namespace webrtc
@@ -74,7 +74,7 @@ void VCMTiming::UpdateHistograms() const {
 void VCMTiming::Reset() {
   rtc::CritScope cs(&crit_sect_);
   ts_extrapolator_->Reset(clock_->TimeInMilliseconds());
-  codec_timer_.reset(new VCMCodecTimer());
+  codec_timer_->Reset();
   render_delay_ms_ = kDefaultRenderDelayMs;
   min_playout_delay_ms_ = 0;
   jitter_delay_ms_ = 0;
@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
+
+#include "rtc_base/checks.h"
+#include "rtc_base/criticalsection.h"
+
+namespace webrtc {
+
+namespace {
+// Plain old data, so that there are no static initializers.
+rtc::GlobalLockPod g_budget_lock;
+size_t g_allocated_bytes = 0;
+size_t g_limit_bytes = 0;
+uint32_t g_num_failed_reservations = 0;
+}  // namespace
+
+void FrameBufferMemoryBudget::SetLimitBytes(size_t limit_bytes) {
+  rtc::GlobalLockScope lock(&g_budget_lock);
+  g_limit_bytes = limit_bytes;
+}
+
+bool FrameBufferMemoryBudget::TryReserve(size_t bytes) {
+  rtc::GlobalLockScope lock(&g_budget_lock);
+  if (g_limit_bytes > 0 && g_allocated_bytes + bytes > g_limit_bytes) {
+    ++g_num_failed_reservations;
+    return false;
+  }
+  g_allocated_bytes += bytes;
+  return true;
+}
+
+void FrameBufferMemoryBudget::Free(size_t bytes) {
+  rtc::GlobalLockScope lock(&g_budget_lock);
+  RTC_DCHECK_GE(g_allocated_bytes, bytes);
+  g_allocated_bytes -= bytes;
+}
+
+FrameBufferMemoryBudget::Stats FrameBufferMemoryBudget::GetStats() {
+  rtc::GlobalLockScope lock(&g_budget_lock);
+  Stats stats;
+  stats.allocated_bytes = g_allocated_bytes;
+  stats.limit_bytes = g_limit_bytes;
+  stats.num_failed_reservations = g_num_failed_reservations;
+  return stats;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_VIDEO_CODING_UTILITY_FRAME_BUFFER_MEMORY_BUDGET_H_
+#define MODULES_VIDEO_CODING_UTILITY_FRAME_BUFFER_MEMORY_BUDGET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace webrtc {
+
+// Process wide accounting of the memory held by the frame buffer pools of all
+// decoders, with an optional limit shared by all of them. Pools reserve the
+// memory of a buffer before allocating it, and free unused buffers to make
+// room when a reservation fails.
+class FrameBufferMemoryBudget {
+ public:
+  struct Stats {
+    size_t allocated_bytes = 0;
+    size_t limit_bytes = 0;
+    // Reservations refused because of the limit.
+    uint32_t num_failed_reservations = 0;
+  };
+
+  // Sets the limit for all pools. 0, the default, means no limit. Lowering
+  // the limit doesn't free memory that is already reserved. VP9 decoders set
+  // it from the WebRTC-Vp9FrameBufferMemoryLimit field trial, given in
+  // megabytes as "Enabled-<limit>", when they are initialized.
+  static void SetLimitBytes(size_t limit_bytes);
+
+  // Returns false, and reserves nothing, if reserving |bytes| would exceed
+  // the limit.
+  static bool TryReserve(size_t bytes);
+  static void Free(size_t bytes);
+
+  static Stats GetStats();
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_VIDEO_CODING_UTILITY_FRAME_BUFFER_MEMORY_BUDGET_H_
@@ -16,7 +16,9 @@
 #include "common_video/h264/h264_common.h"
 #include "modules/video_coding/frame_object.h"
 #include "modules/video_coding/packet_buffer.h"
+#include "rtc_base/memory_accountant.h"
 #include "rtc_base/random.h"
+#include "rtc_base/refcountedobject.h"
 #include "system_wrappers/include/clock.h"
 #include "test/field_trial.h"
 #include "test/gtest.h"
@@ -641,6 +643,82 @@ TEST_F(TestPacketBuffer, DontLeakPayloadData) {
   EXPECT_TRUE(Insert(2 + kMaxSize, kKeyFrame, kFirst, kNotLast, 5, data4));
 }
 
+TEST_F(TestPacketBuffer, AccountsSlotsAndPayloads) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  packet_buffer_->SetMemoryAccountant(accountant);
+  const int64_t empty_bytes = accountant->GetUsage().total_bytes;
+  EXPECT_GT(empty_bytes, 0);
+
+  const uint16_t seq_num = Rand();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(Insert(seq_num + i, kKeyFrame, kNotFirst, kNotLast, 10,
+                       new uint8_t[10]));
+  }
+  EXPECT_EQ(empty_bytes + 30, accountant->GetUsage().total_bytes);
+  EXPECT_EQ(empty_bytes + 30,
+            accountant->GetUsage().bytes[static_cast<size_t>(
+                MemoryTag::kVideoPacketBuffer)]);
+
+  packet_buffer_->ClearTo(seq_num);
+  EXPECT_EQ(empty_bytes + 20, accountant->GetUsage().total_bytes);
+  packet_buffer_->Clear();
+  EXPECT_EQ(empty_bytes, accountant->GetUsage().total_bytes);
+
+  packet_buffer_ = nullptr;
+  EXPECT_EQ(0, accountant->GetUsage().total_bytes);
+}
+
+TEST_F(TestPacketBuffer, DontExpandOverMemoryBudget) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  packet_buffer_->SetMemoryAccountant(accountant);
+  const int64_t empty_bytes = accountant->GetUsage().total_bytes;
+  accountant->SetSoftBudget(1);
+
+  const uint16_t seq_num = Rand();
+  for (int i = 0; i < kStartSize + 1; ++i) {
+    EXPECT_TRUE(Insert(seq_num + i, kKeyFrame, kNotFirst, kNotLast, 10,
+                       new uint8_t[10]));
+  }
+  // The buffer was cleared instead of expanded before the last packet.
+  EXPECT_EQ(empty_bytes + 10, accountant->GetUsage().total_bytes);
+}
+
+TEST_F(TestPacketBuffer, ShrinkOverMemoryBudget) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  packet_buffer_->SetMemoryAccountant(accountant);
+  const int64_t empty_bytes = accountant->GetUsage().total_bytes;
+
+  // Expands the buffer to four times its start size, with a frame starting
+  // at |frame_seq_num| that is missing its last packet.
+  const uint16_t seq_num = Rand();
+  const uint16_t frame_seq_num = seq_num + kStartSize + 4;
+  for (int i = 0; i < 2 * kStartSize + 1; ++i) {
+    EXPECT_TRUE(Insert(seq_num + i, kKeyFrame,
+                       seq_num + i == frame_seq_num ? kFirst : kNotFirst,
+                       kNotLast));
+  }
+  const int64_t expanded_bytes = accountant->GetUsage().total_bytes;
+  EXPECT_GT(expanded_bytes, empty_bytes);
+
+  // The remaining packets fit in twice the start size.
+  accountant->SetSoftBudget(1);
+  packet_buffer_->ClearTo(seq_num + kStartSize - 1);
+  EXPECT_LT(accountant->GetUsage().total_bytes, expanded_bytes);
+  EXPECT_GT(accountant->GetUsage().total_bytes, empty_bytes);
+
+  packet_buffer_->ClearTo(seq_num + kStartSize + 1);
+  EXPECT_EQ(empty_bytes, accountant->GetUsage().total_bytes);
+
+  // The packets of the frame are still there.
+  EXPECT_TRUE(
+      Insert(seq_num + 2 * kStartSize + 1, kKeyFrame, kNotFirst, kLast));
+  ASSERT_EQ(1UL, frames_from_callback_.size());
+  CheckFrame(frame_seq_num);
+}
+
 TEST_F(TestPacketBuffer, ContinuousSeqNumDoubleMarkerBit) {
   Insert(2, kKeyFrame, kNotFirst, kNotLast);
   Insert(1, kKeyFrame, kFirst, kLast);
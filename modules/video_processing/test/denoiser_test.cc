@@ -10,16 +10,47 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "api/video/i420_buffer.h"
 #include "common_video/include/i420_buffer_pool.h"
 #include "modules/video_processing/video_denoiser.h"
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
 #include "test/gtest.h"
 #include "test/frame_utils.h"
 #include "test/testsupport/fileutils.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
+namespace {
+
+// A noisy frame with a pattern that moves by |frame_number| pixels.
+rtc::scoped_refptr<I420BufferInterface> CreateMovingFrame(int width,
+                                                          int height,
+                                                          int frame_number,
+                                                          Random* random) {
+  rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int value = 64 + (((x + frame_number) / 32 + y / 32) % 2) * 128 +
+                        random->Rand(-6, 6);
+      buffer->MutableDataY()[y * buffer->StrideY() + x] =
+          static_cast<uint8_t>(value);
+    }
+  }
+  const int chroma_height = (height + 1) / 2;
+  memset(buffer->MutableDataU(), 128, buffer->StrideU() * chroma_height);
+  memset(buffer->MutableDataV(), 128, buffer->StrideV() * chroma_height);
+  return buffer;
+}
+
+}  // namespace
+
 TEST(VideoDenoiserTest, CopyMem) {
   std::unique_ptr<DenoiserFilter> df_c(DenoiserFilter::Create(false, nullptr));
   std::unique_ptr<DenoiserFilter> df_sse_neon(
@@ -125,6 +156,38 @@ TEST(VideoDenoiserTest, MbDenoise) {
   EXPECT_EQ(COPY_BLOCK, decision);
 }
 
+TEST(VideoDenoiserTest, MbDenoiseRandomBlocks) {
+  std::unique_ptr<DenoiserFilter> df_c(DenoiserFilter::Create(false, nullptr));
+  std::unique_ptr<DenoiserFilter> df_simd(
+      DenoiserFilter::Create(true, nullptr));
+  Random random(1234);
+  uint8_t running_src[16 * 16], src[16 * 16];
+  uint8_t dst[16 * 16], dst_simd[16 * 16];
+  for (int i = 0; i < 1000; ++i) {
+    // Differences of up to 4, 8, 16 and 32 around the clamping limits.
+    const int max_diff = 4 << (i % 4);
+    for (int j = 0; j < 16 * 16; ++j) {
+      running_src[j] = random.Rand<uint8_t>();
+      src[j] = static_cast<uint8_t>(std::min(
+          255, std::max(0, running_src[j] + random.Rand(-max_diff, max_diff))));
+    }
+    const int increase_denoising = i % 2;
+    const uint8_t motion_magnitude = (i / 2) % 2 ? 0 : 255;
+    memset(dst, 0, 16 * 16);
+    memset(dst_simd, 0, 16 * 16);
+    EXPECT_EQ(df_c->MbDenoise(running_src, 16, dst, 16, src, 16,
+                              motion_magnitude, increase_denoising),
+              df_simd->MbDenoise(running_src, 16, dst_simd, 16, src, 16,
+                                 motion_magnitude, increase_denoising));
+    ASSERT_EQ(0, memcmp(dst, dst_simd, 16 * 16));
+
+    uint32_t sse_c = 0, sse_simd = 0;
+    EXPECT_EQ(df_c->Variance16x8(running_src, 16, src, 16, &sse_c),
+              df_simd->Variance16x8(running_src, 16, src, 16, &sse_simd));
+    EXPECT_EQ(sse_c, sse_simd);
+  }
+}
+
 TEST(VideoDenoiserTest, Denoiser) {
   const int kWidth = 352;
   const int kHeight = 288;
@@ -158,4 +221,51 @@ TEST(VideoDenoiserTest, Denoiser) {
   ASSERT_NE(0, feof(source_file)) << "Error reading source file";
 }
 
+TEST(VideoDenoiserTest, MultithreadedDenoiserIsBitExact) {
+  // Not divisible by 16, and not by the number of threads in macroblock rows.
+  const int kWidth = 360;
+  const int kHeight = 250;
+  VideoDenoiser denoiser(true);
+  VideoDenoiser denoiser_threads(true, 4);
+  Random random(1234);
+  for (int i = 0; i < 30; ++i) {
+    rtc::scoped_refptr<I420BufferInterface> frame =
+        CreateMovingFrame(kWidth, kHeight, i, &random);
+    ASSERT_TRUE(
+        test::FrameBufsEqual(denoiser.DenoiseFrame(frame, true),
+                             denoiser_threads.DenoiseFrame(frame, true)));
+  }
+}
+
+TEST(VideoDenoiserPerfTest, DISABLED_DenoiseFrame1080p) {
+  const int kWidth = 1920;
+  const int kHeight = 1080;
+  const int kNumFrames = 30;
+  Random random(1234);
+  std::vector<rtc::scoped_refptr<I420BufferInterface>> frames;
+  for (int i = 0; i < kNumFrames; ++i)
+    frames.push_back(CreateMovingFrame(kWidth, kHeight, i, &random));
+
+  const struct {
+    bool runtime_cpu_detection;
+    int num_threads;
+    const char* trace;
+  } kConfigs[] = {{false, 1, "c_1_thread"},
+                  {true, 1, "simd_1_thread"},
+                  {true, 2, "simd_2_threads"},
+                  {true, 4, "simd_4_threads"}};
+  for (const auto& config : kConfigs) {
+    VideoDenoiser denoiser(config.runtime_cpu_detection, config.num_threads);
+    // The first frame only initializes the denoiser.
+    denoiser.DenoiseFrame(frames[0], true);
+    const int64_t start_time_us = rtc::TimeMicros();
+    for (int i = 1; i < kNumFrames; ++i)
+      denoiser.DenoiseFrame(frames[i], true);
+    test::PrintResult("denoise_frame_1080p", "", config.trace,
+                      (rtc::TimeMicros() - start_time_us) / 1000.0 /
+                          (kNumFrames - 1),
+                      "ms", false);
+  }
+}
+
 }  // namespace webrtc
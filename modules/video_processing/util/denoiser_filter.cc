@@ -9,6 +9,7 @@
  */
 
 #include "modules/video_processing/util/denoiser_filter.h"
+#include "modules/video_processing/util/denoiser_filter_avx2.h"
 #include "modules/video_processing/util/denoiser_filter_c.h"
 #include "modules/video_processing/util/denoiser_filter_neon.h"
 #include "modules/video_processing/util/denoiser_filter_sse2.h"
@@ -31,16 +32,23 @@ std::unique_ptr<DenoiserFilter> DenoiserFilter::Create(
   if (runtime_cpu_detection) {
 // If we know the minimum architecture at compile time, avoid CPU detection.
 #if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(WEBRTC_VIDEO_PROCESSING_AVX2)
+    // AVX2 is never assumed at compile time.
+    if (WebRtc_GetCPUInfo(kAVX2))
+      filter.reset(new DenoiserFilterAVX2());
+#endif
+    if (!filter) {
 #if defined(__SSE2__)
-    filter.reset(new DenoiserFilterSSE2());
-#else
-    // x86 CPU detection required.
-    if (WebRtc_GetCPUInfo(kSSE2)) {
       filter.reset(new DenoiserFilterSSE2());
-    } else {
-      filter.reset(new DenoiserFilterC());
-    }
+#else
+      // x86 CPU detection required.
+      if (WebRtc_GetCPUInfo(kSSE2)) {
+        filter.reset(new DenoiserFilterSSE2());
+      } else {
+        filter.reset(new DenoiserFilterC());
+      }
 #endif
+    }
 #elif defined(WEBRTC_HAS_NEON)
     filter.reset(new DenoiserFilterNEON());
     if (cpu_type != nullptr)
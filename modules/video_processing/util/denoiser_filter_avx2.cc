@@ -0,0 +1,188 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "modules/video_processing/util/denoiser_filter_avx2.h"
+
+namespace webrtc {
+
+// Loads row |row| of |src| into the low and row |row| + |row_step| into the
+// high 128 bits.
+static __m256i LoadTwoRows(const uint8_t* src,
+                           int stride,
+                           int row,
+                           int row_step) {
+  const __m128i lo =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + row * stride));
+  const __m128i hi = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(src + (row + row_step) * stride));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Loads 16 pixels as 16-bit values.
+static __m256i LoadRowEpi16(const uint8_t* src) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+}
+
+// Compute the sum of all pixel differences of this MB. Each byte of
+// |acc_diff| holds the differences of eight rows of one column, so it hasn't
+// saturated; like the C version, only the column sums are clamped to 127.
+static uint32_t AbsSumDiff16x1(__m256i acc_diff) {
+  const __m256i col_sum = _mm256_add_epi16(
+      _mm256_cvtepi8_epi16(_mm256_castsi256_si128(acc_diff)),
+      _mm256_cvtepi8_epi16(_mm256_extracti128_si256(acc_diff, 1)));
+  const __m256i clamped_col_sum =
+      _mm256_min_epi16(col_sum, _mm256_set1_epi16(127));
+  const __m256i sum_8x32 =
+      _mm256_madd_epi16(clamped_col_sum, _mm256_set1_epi16(1));
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sum_8x32),
+                              _mm256_extracti128_si256(sum_8x32, 1));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return abs(_mm_cvtsi128_si32(sum));
+}
+
+void DenoiserFilterAVX2::CopyMem16x16(const uint8_t* src,
+                                      int src_stride,
+                                      uint8_t* dst,
+                                      int dst_stride) {
+  for (int i = 0; i < 16; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
+
+uint32_t DenoiserFilterAVX2::Variance16x8(const uint8_t* src,
+                                          int src_stride,
+                                          const uint8_t* ref,
+                                          int ref_stride,
+                                          uint32_t* sse) {
+  // Like the other versions, every other row of the 16x16 block is used.
+  __m256i vsum = _mm256_setzero_si256();
+  __m256i vsse = _mm256_setzero_si256();
+  for (int i = 0; i < 16; i += 2) {
+    const __m256i src0 = LoadRowEpi16(src + i * src_stride);
+    const __m256i ref0 = LoadRowEpi16(ref + i * ref_stride);
+    const __m256i diff = _mm256_sub_epi16(src0, ref0);
+    // At most 8 * 255 in each lane.
+    vsum = _mm256_add_epi16(vsum, diff);
+    vsse = _mm256_add_epi32(vsse, _mm256_madd_epi16(diff, diff));
+  }
+
+  // sum
+  const __m256i vsum_32 = _mm256_madd_epi16(vsum, _mm256_set1_epi16(1));
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(vsum_32),
+                              _mm256_extracti128_si256(vsum_32, 1));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  const int64_t sum_all = _mm_cvtsi128_si32(sum);
+
+  // sse
+  __m128i sse_all = _mm_add_epi32(_mm256_castsi256_si128(vsse),
+                                  _mm256_extracti128_si256(vsse, 1));
+  sse_all = _mm_add_epi32(sse_all, _mm_srli_si128(sse_all, 8));
+  sse_all = _mm_add_epi32(sse_all, _mm_srli_si128(sse_all, 4));
+  *sse = _mm_cvtsi128_si32(sse_all);
+
+  return *sse - ((sum_all * sum_all) >> 7);
+}
+
+DenoiserDecision DenoiserFilterAVX2::MbDenoise(const uint8_t* mc_running_avg_y,
+                                               int mc_avg_y_stride,
+                                               uint8_t* running_avg_y,
+                                               int avg_y_stride,
+                                               const uint8_t* sig,
+                                               int sig_stride,
+                                               uint8_t motion_magnitude,
+                                               int increase_denoising) {
+  DenoiserDecision decision = FILTER_BLOCK;
+  unsigned int sum_diff_thresh = 0;
+  int shift_inc =
+      (increase_denoising && motion_magnitude <= kMotionMagnitudeThreshold) ? 1
+                                                                            : 0;
+  __m256i acc_diff = _mm256_setzero_si256();
+  const __m256i k_0 = _mm256_setzero_si256();
+  const __m256i k_4 = _mm256_set1_epi8(4 + shift_inc);
+  const __m256i k_8 = _mm256_set1_epi8(8);
+  const __m256i k_16 = _mm256_set1_epi8(16);
+  // Modify each level's adjustment according to motion_magnitude.
+  const __m256i l3 = _mm256_set1_epi8(
+      (motion_magnitude <= kMotionMagnitudeThreshold) ? 7 + shift_inc : 6);
+  // Difference between level 3 and level 2 is 2.
+  const __m256i l32 = _mm256_set1_epi8(2);
+  // Difference between level 2 and level 1 is 1.
+  const __m256i l21 = _mm256_set1_epi8(1);
+
+  // Rows r and r + 8 are filtered together.
+  for (int r = 0; r < 8; ++r) {
+    // Calculate differences.
+    const __m256i v_sig = LoadTwoRows(sig, sig_stride, r, 8);
+    const __m256i v_mc_running_avg_y =
+        LoadTwoRows(mc_running_avg_y, mc_avg_y_stride, r, 8);
+    __m256i v_running_avg_y;
+    const __m256i pdiff = _mm256_subs_epu8(v_mc_running_avg_y, v_sig);
+    const __m256i ndiff = _mm256_subs_epu8(v_sig, v_mc_running_avg_y);
+    // Obtain the sign. FF if diff is negative.
+    const __m256i diff_sign = _mm256_cmpeq_epi8(pdiff, k_0);
+    // Clamp absolute difference to 16 to be used to get mask. Doing this
+    // allows us to use _mm256_cmpgt_epi8, which operates on signed byte.
+    const __m256i clamped_absdiff =
+        _mm256_min_epu8(_mm256_or_si256(pdiff, ndiff), k_16);
+    // Get masks for l2 l1 and l0 adjustments.
+    const __m256i mask2 = _mm256_cmpgt_epi8(k_16, clamped_absdiff);
+    const __m256i mask1 = _mm256_cmpgt_epi8(k_8, clamped_absdiff);
+    const __m256i mask0 = _mm256_cmpgt_epi8(k_4, clamped_absdiff);
+    // Get adjustments for l2, l1, and l0.
+    __m256i adj2 = _mm256_and_si256(mask2, l32);
+    const __m256i adj1 = _mm256_and_si256(mask1, l21);
+    const __m256i adj0 = _mm256_and_si256(mask0, clamped_absdiff);
+    __m256i adj, padj, nadj;
+
+    // Combine the adjustments and get absolute adjustments.
+    adj2 = _mm256_add_epi8(adj2, adj1);
+    adj = _mm256_sub_epi8(l3, adj2);
+    adj = _mm256_andnot_si256(mask0, adj);
+    adj = _mm256_or_si256(adj, adj0);
+
+    // Restore the sign and get positive and negative adjustments.
+    padj = _mm256_andnot_si256(diff_sign, adj);
+    nadj = _mm256_and_si256(diff_sign, adj);
+
+    // Calculate filtered value.
+    v_running_avg_y = _mm256_adds_epu8(v_sig, padj);
+    v_running_avg_y = _mm256_subs_epu8(v_running_avg_y, nadj);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(running_avg_y + r * avg_y_stride),
+        _mm256_castsi256_si128(v_running_avg_y));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(running_avg_y + (r + 8) * avg_y_stride),
+        _mm256_extracti128_si256(v_running_avg_y, 1));
+
+    // Adjustments <= 8, and each element in acc_diff sums eight rows, so it
+    // fits in signed char.
+    acc_diff = _mm256_add_epi8(acc_diff, padj);
+    acc_diff = _mm256_sub_epi8(acc_diff, nadj);
+  }
+
+  // Compute the sum of all pixel differences of this MB.
+  unsigned int abs_sum_diff = AbsSumDiff16x1(acc_diff);
+  sum_diff_thresh =
+      increase_denoising ? kSumDiffThresholdHigh : kSumDiffThreshold;
+  if (abs_sum_diff > sum_diff_thresh)
+    decision = COPY_BLOCK;
+  return decision;
+}
+
+}  // namespace webrtc
@@ -9,7 +9,11 @@
  */
 
 #include "modules/video_processing/video_denoiser.h"
+
+#include <algorithm>
+
 #include "common_video/libyuv/include/webrtc_libyuv.h"
+#include "rtc_base/checks.h"
 #include "third_party/libyuv/include/libyuv/planar_functions.h"
 
 namespace webrtc {
@@ -67,10 +71,22 @@ static void ShowRect(const std::unique_ptr<DenoiserFilter>& filter,
 #endif
 
 VideoDenoiser::VideoDenoiser(bool runtime_cpu_detection)
+    : VideoDenoiser(runtime_cpu_detection, 1) {}
+
+VideoDenoiser::VideoDenoiser(bool runtime_cpu_detection, int num_threads)
     : width_(0),
       height_(0),
       filter_(DenoiserFilter::Create(runtime_cpu_detection, &cpu_type_)),
-      ne_(new NoiseEstimation()) {}
+      ne_(new NoiseEstimation()),
+      num_threads_(num_threads) {
+  RTC_DCHECK_GE(num_threads_, 1);
+  for (int i = 0; i < num_threads_ - 1; ++i) {
+    band_queues_.emplace_back(new rtc::TaskQueue("VideoDenoiser"));
+    band_done_.emplace_back(new rtc::Event(false, false));
+  }
+}
+
+VideoDenoiser::~VideoDenoiser() = default;
 
 void VideoDenoiser::DenoiserReset(
     rtc::scoped_refptr<I420BufferInterface> frame) {
@@ -86,9 +102,13 @@ void VideoDenoiser::DenoiserReset(
   x_density_.reset(new uint8_t[mb_cols_]);
   y_density_.reset(new uint8_t[mb_rows_]);
   moving_object_.reset(new uint8_t[mb_cols_ * mb_rows_]);
+  noise_samples_.reset(new NoiseSample[mb_cols_ * mb_rows_]);
+  band_x_density_.reset(new uint8_t[num_threads_ * mb_cols_]);
 }
 
-int VideoDenoiser::PositionCheck(int mb_row, int mb_col, int noise_level) {
+int VideoDenoiser::PositionCheck(int mb_row,
+                                 int mb_col,
+                                 int noise_level) const {
   if (noise_level == 0)
     return 1;
   if ((mb_row <= (mb_rows_ >> 4)) || (mb_col <= (mb_cols_ >> 4)) ||
@@ -153,7 +173,7 @@ void VideoDenoiser::ReduceFalseDetection(
 
 bool VideoDenoiser::IsTrailingBlock(const std::unique_ptr<uint8_t[]>& d_status,
                                     int mb_row,
-                                    int mb_col) {
+                                    int mb_col) const {
   bool ret = false;
   int mb_index = mb_row * mb_cols_ + mb_col;
   if (!mb_row || !mb_col || mb_row == mb_rows_ - 1 || mb_col == mb_cols_ - 1)
@@ -212,22 +232,15 @@ void VideoDenoiser::CopyLumaOnMargin(const uint8_t* y_src,
   }
 }
 
-rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
-    rtc::scoped_refptr<I420BufferInterface> frame,
-    bool noise_estimation_enabled) {
-  // If previous width and height are different from current frame's, need to
-  // reallocate the buffers and no denoising for the current frame.
-  if (!prev_buffer_ || width_ != frame->width() || height_ != frame->height()) {
-    DenoiserReset(frame);
-    prev_buffer_ = frame;
-    return frame;
-  }
-
+void VideoDenoiser::DenoiseBand(int mb_row_start,
+                                int mb_row_end,
+                                const I420BufferInterface& src,
+                                I420Buffer* dst,
+                                uint8_t noise_level,
+                                uint8_t* x_density) {
   // Set buffer pointers.
-  const uint8_t* y_src = frame->DataY();
-  int stride_y_src = frame->StrideY();
-  rtc::scoped_refptr<I420Buffer> dst =
-      buffer_pool_.CreateBuffer(width_, height_);
+  const uint8_t* y_src = src.DataY();
+  int stride_y_src = src.StrideY();
 
   uint8_t* y_dst = dst->MutableDataY();
   int stride_y_dst = dst->StrideY();
@@ -235,15 +248,12 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
   const uint8_t* y_dst_prev = prev_buffer_->DataY();
   int stride_prev = prev_buffer_->StrideY();
 
-  memset(x_density_.get(), 0, mb_cols_);
-  memset(y_density_.get(), 0, mb_rows_);
-  memset(moving_object_.get(), 1, mb_cols_ * mb_rows_);
+  memset(x_density, 0, mb_cols_);
 
-  uint8_t noise_level = noise_estimation_enabled ? ne_->GetNoiseLevel() : 0;
   int thr_var_base = 16 * 16 * 2;
   // Loop over blocks to accumulate/extract noise level and update x/y_density
   // factors for moving object detection.
-  for (int mb_row = 0; mb_row < mb_rows_; ++mb_row) {
+  for (int mb_row = mb_row_start; mb_row < mb_row_end; ++mb_row) {
     const int mb_index_base = mb_row * mb_cols_;
     const uint8_t* mb_src_base = y_src + (mb_row << 4) * stride_y_src;
     uint8_t* mb_dst_base = y_dst + (mb_row << 4) * stride_y_dst;
@@ -283,7 +293,7 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
           // time t (mb_src) and filtered block in time t-1 (mb_dist_prev).
           uint32_t noise_var = filter_->Variance16x8(
               mb_dst_prev, stride_y_dst, mb_src, stride_y_src, &sse_t);
-          ne_->GetNoise(mb_index, noise_var, luma);
+          noise_samples_[mb_index] = {false, noise_var, luma};
         }
         moving_edge_[mb_index] = 0;  // Not a moving edge block.
       } else {
@@ -294,10 +304,10 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
             mb_dst_prev, stride_prev, mb_dst, stride_y_dst, &sse_t);
         if (noise_var > thr_var_adp) {  // Moving edge checking.
           if (ne_enable) {
-            ne_->ResetConsecLowVar(mb_index);
+            noise_samples_[mb_index] = {true, 0, 0};
           }
           moving_edge_[mb_index] = 1;  // Mark as moving edge block.
-          x_density_[mb_col] += (pos_factor < 3);
+          x_density[mb_col] += (pos_factor < 3);
           y_density_[mb_row] += (pos_factor < 3);
         } else {
           moving_edge_[mb_index] = 0;
@@ -306,12 +316,76 @@ rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
             // in time t (mb_src) and filtered block in time t-1 (mb_dist_prev).
             uint32_t noise_var = filter_->Variance16x8(
                 mb_dst_prev, stride_prev, mb_src, stride_y_src, &sse_t);
-            ne_->GetNoise(mb_index, noise_var, luma);
+            noise_samples_[mb_index] = {false, noise_var, luma};
           }
         }
       }
     }  // End of for loop
   }    // End of for loop
+}
+
+rtc::scoped_refptr<I420BufferInterface> VideoDenoiser::DenoiseFrame(
+    rtc::scoped_refptr<I420BufferInterface> frame,
+    bool noise_estimation_enabled) {
+  // If previous width and height are different from current frame's, need to
+  // reallocate the buffers and no denoising for the current frame.
+  if (!prev_buffer_ || width_ != frame->width() || height_ != frame->height()) {
+    DenoiserReset(frame);
+    prev_buffer_ = frame;
+    return frame;
+  }
+
+  // Set buffer pointers.
+  const uint8_t* y_src = frame->DataY();
+  int stride_y_src = frame->StrideY();
+  rtc::scoped_refptr<I420Buffer> dst =
+      buffer_pool_.CreateBuffer(width_, height_);
+
+  uint8_t* y_dst = dst->MutableDataY();
+  int stride_y_dst = dst->StrideY();
+
+  memset(y_density_.get(), 0, mb_rows_);
+  memset(moving_object_.get(), 1, mb_cols_ * mb_rows_);
+
+  uint8_t noise_level = noise_estimation_enabled ? ne_->GetNoiseLevel() : 0;
+  // Denoise bands of whole macroblock rows, the last one on this thread. The
+  // blocks of a band only depend on the source and previous frames.
+  const int num_bands = std::max(1, std::min(num_threads_, mb_rows_));
+  for (int band = 0; band < num_bands - 1; ++band) {
+    const int mb_row_start = band * mb_rows_ / num_bands;
+    const int mb_row_end = (band + 1) * mb_rows_ / num_bands;
+    uint8_t* const x_density = &band_x_density_[band * mb_cols_];
+    rtc::Event* const done = band_done_[band].get();
+    I420BufferInterface* const src = frame.get();
+    I420Buffer* const band_dst = dst.get();
+    band_queues_[band]->PostTask([this, mb_row_start, mb_row_end, src,
+                                  band_dst, noise_level, x_density, done] {
+      DenoiseBand(mb_row_start, mb_row_end, *src, band_dst, noise_level,
+                  x_density);
+      done->Set();
+    });
+  }
+  const int last_band = num_bands - 1;
+  DenoiseBand(last_band * mb_rows_ / num_bands, mb_rows_, *frame, dst.get(),
+              noise_level, &band_x_density_[last_band * mb_cols_]);
+  for (int band = 0; band < num_bands - 1; ++band)
+    band_done_[band]->Wait(rtc::Event::kForever);
+
+  // Merge the bands in a fixed order.
+  memset(x_density_.get(), 0, mb_cols_);
+  for (int band = 0; band < num_bands; ++band) {
+    for (int mb_col = 0; mb_col < mb_cols_; ++mb_col)
+      x_density_[mb_col] += band_x_density_[band * mb_cols_ + mb_col];
+  }
+  for (int mb_index = 0; mb_index < mb_rows_ * mb_cols_;
+       mb_index += NOISE_SUBSAMPLE_INTERVAL) {
+    const NoiseSample& sample = noise_samples_[mb_index];
+    if (sample.moving_edge) {
+      ne_->ResetConsecLowVar(mb_index);
+    } else {
+      ne_->GetNoise(mb_index, sample.var, sample.luma);
+    }
+  }
 
   ReduceFalseDetection(moving_edge_, &moving_object_, noise_level);
 
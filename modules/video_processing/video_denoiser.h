@@ -12,29 +12,57 @@
 #define MODULES_VIDEO_PROCESSING_VIDEO_DENOISER_H_
 
 #include <memory>
+#include <vector>
 
 #include "common_video/include/i420_buffer_pool.h"
 #include "modules/video_processing/util/denoiser_filter.h"
 #include "modules/video_processing/util/noise_estimation.h"
 #include "modules/video_processing/util/skin_detection.h"
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/event.h"
+#include "rtc_base/task_queue.h"
 
 namespace webrtc {
 
 class VideoDenoiser {
  public:
   explicit VideoDenoiser(bool runtime_cpu_detection);
+  // Splits each frame into |num_threads| bands of macroblock rows that are
+  // denoised in parallel. The output is the same for any number of threads.
+  VideoDenoiser(bool runtime_cpu_detection, int num_threads);
+  ~VideoDenoiser();
 
   rtc::scoped_refptr<I420BufferInterface> DenoiseFrame(
       rtc::scoped_refptr<I420BufferInterface> frame,
       bool noise_estimation_enabled);
 
  private:
+  // Noise estimation input of a subsampled block. The bands only record it,
+  // and it's given to |ne_| in block order once all bands are done.
+  struct NoiseSample {
+    // Moving edge blocks reset the counter for consecutive low-var blocks
+    // instead of collecting noise data.
+    bool moving_edge;
+    uint32_t var;
+    uint32_t luma;
+  };
+
   void DenoiserReset(rtc::scoped_refptr<I420BufferInterface> frame);
 
+  // Filters the blocks of macroblock rows [|mb_row_start|, |mb_row_end|) and
+  // detects moving edges in them. Only touches state of those rows, and the
+  // |x_density| of its band.
+  void DenoiseBand(int mb_row_start,
+                   int mb_row_end,
+                   const I420BufferInterface& src,
+                   I420Buffer* dst,
+                   uint8_t noise_level,
+                   uint8_t* x_density);
+
   // Check the mb position, return 1: close to the frame center (between 1/8
   // and 7/8 of width/height), 3: close to the border (out of 1/16 and 15/16
   // of width/height), 2: in between.
-  int PositionCheck(int mb_row, int mb_col, int noise_level);
+  int PositionCheck(int mb_row, int mb_col, int noise_level) const;
 
   // To reduce false detection in moving object detection (MOD).
   void ReduceFalseDetection(const std::unique_ptr<uint8_t[]>& d_status,
@@ -45,7 +73,7 @@ class VideoDenoiser {
   // its neighbor blocks is a moving edge block.
   bool IsTrailingBlock(const std::unique_ptr<uint8_t[]>& d_status,
                        int mb_row,
-                       int mb_col);
+                       int mb_col) const;
 
   // Copy input blocks to dst buffer on moving object blocks (MOB).
   void CopySrcOnMOB(const uint8_t* y_src,
@@ -75,8 +103,18 @@ class VideoDenoiser {
   std::unique_ptr<uint8_t[]> y_density_;
   // Save the return values by MbDenoise for each block.
   std::unique_ptr<DenoiserDecision[]> mb_filter_decision_;
+  std::unique_ptr<NoiseSample[]> noise_samples_;
+  // The x_density_ of each band, summed up when all bands are done.
+  std::unique_ptr<uint8_t[]> band_x_density_;
   I420BufferPool buffer_pool_;
   rtc::scoped_refptr<I420BufferInterface> prev_buffer_;
+  const int num_threads_;
+  // All bands but the last have a queue of their own, the last one is
+  // denoised on the calling thread.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> band_queues_;
+  std::vector<std::unique_ptr<rtc::Event>> band_done_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(VideoDenoiser);
 };
 
 }  // namespace webrtc
@@ -63,6 +63,10 @@ bool ChannelManager::SetVideoRtxEnabled(bool enable) {
 
 void ChannelManager::GetSupportedAudioSendCodecs(
     std::vector<AudioCodec>* codecs) const {
+  if (initialized_) {
+    *codecs = capabilities_.audio_send_codecs;
+    return;
+  }
   if (!media_engine_) {
     return;
   }
@@ -71,6 +75,10 @@ void ChannelManager::GetSupportedAudioSendCodecs(
 
 void ChannelManager::GetSupportedAudioReceiveCodecs(
     std::vector<AudioCodec>* codecs) const {
+  if (initialized_) {
+    *codecs = capabilities_.audio_receive_codecs;
+    return;
+  }
   if (!media_engine_) {
     return;
   }
@@ -79,6 +87,10 @@ void ChannelManager::GetSupportedAudioReceiveCodecs(
 
 void ChannelManager::GetSupportedAudioRtpHeaderExtensions(
     RtpHeaderExtensions* ext) const {
+  if (initialized_) {
+    *ext = capabilities_.audio_rtp_header_extensions;
+    return;
+  }
   if (!media_engine_) {
     return;
   }
@@ -87,6 +99,10 @@ void ChannelManager::GetSupportedAudioRtpHeaderExtensions(
 
 void ChannelManager::GetSupportedVideoCodecs(
     std::vector<VideoCodec>* codecs) const {
+  if (initialized_) {
+    *codecs = capabilities_.video_codecs;
+    return;
+  }
   if (!media_engine_) {
     return;
   }
@@ -104,6 +120,10 @@ void ChannelManager::GetSupportedVideoCodecs(
 
 void ChannelManager::GetSupportedVideoRtpHeaderExtensions(
     RtpHeaderExtensions* ext) const {
+  if (initialized_) {
+    *ext = capabilities_.video_rtp_header_extensions;
+    return;
+  }
   if (!media_engine_) {
     return;
   }
@@ -112,6 +132,10 @@ void ChannelManager::GetSupportedVideoRtpHeaderExtensions(
 
 void ChannelManager::GetSupportedDataCodecs(
     std::vector<DataCodec>* codecs) const {
+  if (initialized_) {
+    *codecs = capabilities_.data_codecs;
+    return;
+  }
   *codecs = data_engine_->data_codecs();
 }
 
@@ -128,13 +152,24 @@ bool ChannelManager::Init() {
         RTC_FROM_HERE, [&] { network_thread_->SetAllowBlockingCalls(false); });
   }
 
+  bool initialized = true;
   if (media_engine_) {
-    initialized_ = worker_thread_->Invoke<bool>(
+    initialized = worker_thread_->Invoke<bool>(
         RTC_FROM_HERE, [&] { return media_engine_->Init(); });
-    RTC_DCHECK(initialized_);
-  } else {
-    initialized_ = true;
-  }
+    RTC_DCHECK(initialized);
+  }
+  if (initialized) {
+    // Query the engines while |initialized_| is still false.
+    GetSupportedAudioSendCodecs(&capabilities_.audio_send_codecs);
+    GetSupportedAudioReceiveCodecs(&capabilities_.audio_receive_codecs);
+    GetSupportedAudioRtpHeaderExtensions(
+        &capabilities_.audio_rtp_header_extensions);
+    GetSupportedVideoCodecs(&capabilities_.video_codecs);
+    GetSupportedVideoRtpHeaderExtensions(
+        &capabilities_.video_rtp_header_extensions);
+    GetSupportedDataCodecs(&capabilities_.data_codecs);
+  }
+  initialized_ = initialized;
   return initialized_;
 }
 
@@ -150,6 +185,7 @@ void ChannelManager::Terminate() {
     data_channels_.clear();
   });
   initialized_ = false;
+  capabilities_ = SupportedCapabilities();
 }
 
 VoiceChannel* ChannelManager::CreateVoiceChannel(
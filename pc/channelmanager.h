@@ -60,7 +60,8 @@ class ChannelManager final {
   MediaEngineInterface* media_engine() { return media_engine_.get(); }
 
   // Retrieves the list of supported audio & video codec types.
-  // Can be called before starting the media engine.
+  // Can be called before starting the media engine. While initialized, these
+  // return copies of lists queried once by Init().
   void GetSupportedAudioSendCodecs(std::vector<AudioCodec>* codecs) const;
   void GetSupportedAudioReceiveCodecs(std::vector<AudioCodec>* codecs) const;
   void GetSupportedAudioRtpHeaderExtensions(RtpHeaderExtensions* ext) const;
@@ -214,9 +215,24 @@ class ChannelManager final {
       bool srtp_required,
       const VideoOptions& options);
 
+  // What the GetSupported* methods return, which can't change while the
+  // media engine is initialized. Querying the engines builds the lists from
+  // their encoder and decoder factories every time, which is significant when
+  // many PeerConnections are created.
+  struct SupportedCapabilities {
+    std::vector<AudioCodec> audio_send_codecs;
+    std::vector<AudioCodec> audio_receive_codecs;
+    RtpHeaderExtensions audio_rtp_header_extensions;
+    std::vector<VideoCodec> video_codecs;
+    RtpHeaderExtensions video_rtp_header_extensions;
+    std::vector<DataCodec> data_codecs;
+  };
+
   std::unique_ptr<MediaEngineInterface> media_engine_;  // Nullable.
   std::unique_ptr<DataEngineInterface> data_engine_;    // Non-null.
   bool initialized_ = false;
+  // Filled in by Init().
+  SupportedCapabilities capabilities_;
   rtc::Thread* main_thread_;
   rtc::Thread* worker_thread_;
   rtc::Thread* network_thread_;
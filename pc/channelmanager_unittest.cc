@@ -187,6 +187,23 @@ TEST_F(ChannelManagerTest, SetVideoRtxEnabled) {
   EXPECT_TRUE(ContainsMatchingCodec(codecs, rtx_codec));
 }
 
+// The codecs are queried from the media engine once while initialized.
+TEST_F(ChannelManagerTest, SupportedCodecsAreKeptWhileInitialized) {
+  EXPECT_TRUE(cm_->Init());
+  std::vector<VideoCodec> initial_codecs;
+  cm_->GetSupportedVideoCodecs(&initial_codecs);
+  EXPECT_FALSE(initial_codecs.empty());
+
+  fme_->SetVideoCodecs(std::vector<VideoCodec>());
+  std::vector<VideoCodec> codecs;
+  cm_->GetSupportedVideoCodecs(&codecs);
+  EXPECT_EQ(initial_codecs, codecs);
+
+  cm_->Terminate();
+  cm_->GetSupportedVideoCodecs(&codecs);
+  EXPECT_TRUE(codecs.empty());
+}
+
 enum class RTPTransportType { kRtp, kSrtp, kDtlsSrtp };
 
 class ChannelManagerTestWithRtpTransport
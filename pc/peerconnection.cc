@@ -601,6 +601,7 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
     bool redetermine_role_on_ice_restart;
     rtc::Optional<int> ice_check_min_interval;
     rtc::Optional<rtc::IntervalRange> ice_regather_interval_range;
+    rtc::Optional<int> soft_memory_budget_bytes;
     webrtc::TurnCustomizer* turn_customizer;
     SdpSemantics sdp_semantics;
   };
@@ -638,6 +639,7 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
          redetermine_role_on_ice_restart == o.redetermine_role_on_ice_restart &&
          ice_check_min_interval == o.ice_check_min_interval &&
          ice_regather_interval_range == o.ice_regather_interval_range &&
+         soft_memory_budget_bytes == o.soft_memory_budget_bytes &&
          turn_customizer == o.turn_customizer &&
          sdp_semantics == o.sdp_semantics;
 }
@@ -718,13 +720,15 @@ bool ConvertConstraintsToOfferAnswerOptions(
 
 PeerConnection::PeerConnection(PeerConnectionFactory* factory,
                                std::unique_ptr<RtcEventLog> event_log,
-                               std::unique_ptr<Call> call)
+                               rtc::scoped_refptr<MemoryAccountant> accountant)
     : factory_(factory),
       event_log_(std::move(event_log)),
       rtcp_cname_(GenerateRtcpCname()),
       local_streams_(StreamCollection::Create()),
       remote_streams_(StreamCollection::Create()),
-      call_(std::move(call)) {}
+      memory_accountant_(std::move(accountant)) {
+  RTC_DCHECK(memory_accountant_);
+}
 
 PeerConnection::~PeerConnection() {
   TRACE_EVENT0("webrtc", "PeerConnection::~PeerConnection");
@@ -842,6 +846,8 @@ bool PeerConnection::Initialize(
   stats_collector_ = RTCStatsCollector::Create(this);
 
   configuration_ = configuration;
+  memory_accountant_->SetSoftBudget(
+      configuration.soft_memory_budget_bytes.value_or(0));
 
   const PeerConnectionFactoryInterface::Options& options = factory_->options();
 
@@ -937,6 +943,10 @@ RTCError PeerConnection::ValidateConfiguration(
                     "ice_regather_interval_range specified but continual "
                     "gathering policy is GATHER_ONCE");
   }
+  if (config.soft_memory_budget_bytes && *config.soft_memory_budget_bytes < 0) {
+    return RTCError(RTCErrorType::INVALID_RANGE,
+                    "soft_memory_budget_bytes must not be negative");
+  }
   return RTCError::OK();
 }
 
@@ -2519,6 +2529,8 @@ bool PeerConnection::SetConfiguration(const RTCConfiguration& configuration,
   modified_config.prune_turn_ports = configuration.prune_turn_ports;
   modified_config.ice_check_min_interval = configuration.ice_check_min_interval;
   modified_config.turn_customizer = configuration.turn_customizer;
+  modified_config.soft_memory_budget_bytes =
+      configuration.soft_memory_budget_bytes;
   if (configuration != modified_config) {
     RTC_LOG(LS_ERROR) << "Modifying the configuration in an unsupported way.";
     return SafeSetError(RTCErrorType::INVALID_MODIFICATION, error);
@@ -2572,6 +2584,9 @@ bool PeerConnection::SetConfiguration(const RTCConfiguration& configuration,
     transport_controller_->SetIceConfig(ParseIceConfig(modified_config));
   }
 
+  memory_accountant_->SetSoftBudget(
+      modified_config.soft_memory_budget_bytes.value_or(0));
+
   configuration_ = modified_config;
   return SafeSetError(RTCErrorType::NONE, error);
 }
@@ -2710,8 +2725,12 @@ RTCError PeerConnection::SetBitrate(const BitrateParameters& bitrate) {
   mask.start_bitrate_bps = bitrate.current_bitrate_bps;
   mask.max_bitrate_bps = bitrate.max_bitrate_bps;
 
-  RTC_DCHECK(call_.get());
-  call_->SetBitrateConfigMask(mask);
+  Call* call = GetOrCreateCall();
+  if (!call) {
+    LOG_AND_RETURN_ERROR(RTCErrorType::INVALID_STATE,
+                         "SetBitrate called without a Call");
+  }
+  call->SetBitrateConfigMask(mask);
 
   return RTCError::OK();
 }
@@ -2719,19 +2738,22 @@ RTCError PeerConnection::SetBitrate(const BitrateParameters& bitrate) {
 void PeerConnection::SetBitrateAllocationStrategy(
     std::unique_ptr<rtc::BitrateAllocationStrategy>
         bitrate_allocation_strategy) {
+  Call* call = GetOrCreateCall();
+  if (!call) {
+    return;
+  }
   rtc::Thread* worker_thread = factory_->worker_thread();
   if (!worker_thread->IsCurrent()) {
     rtc::BitrateAllocationStrategy* strategy_raw =
         bitrate_allocation_strategy.release();
-    auto functor = [this, strategy_raw]() {
-      call_->SetBitrateAllocationStrategy(
+    auto functor = [call, strategy_raw]() {
+      call->SetBitrateAllocationStrategy(
           rtc::WrapUnique<rtc::BitrateAllocationStrategy>(strategy_raw));
     };
     worker_thread->Invoke<void>(RTC_FROM_HERE, functor);
     return;
   }
-  RTC_DCHECK(call_.get());
-  call_->SetBitrateAllocationStrategy(std::move(bitrate_allocation_strategy));
+  call->SetBitrateAllocationStrategy(std::move(bitrate_allocation_strategy));
 }
 
 void PeerConnection::SetAudioPlayout(bool playout) {
@@ -4178,6 +4200,8 @@ bool PeerConnection::InitializePortAllocator_n(
     return false;
   }
 
+  port_allocator_->SetNetworkIgnoreMask(
+      factory_->options().network_ignore_mask);
   port_allocator_->Initialize();
 
   // To handle both internal and externally created port allocator, we will
@@ -5113,7 +5137,7 @@ cricket::VoiceChannel* PeerConnection::CreateVoiceChannel(
   }
 
   cricket::VoiceChannel* voice_channel = channel_manager()->CreateVoiceChannel(
-      call_.get(), configuration_.media_config, rtp_dtls_transport,
+      GetOrCreateCall(), configuration_.media_config, rtp_dtls_transport,
       rtcp_dtls_transport, signaling_thread(), mid, SrtpRequired(),
       audio_options_);
   if (!voice_channel) {
@@ -5150,7 +5174,7 @@ cricket::VideoChannel* PeerConnection::CreateVideoChannel(
   }
 
   cricket::VideoChannel* video_channel = channel_manager()->CreateVideoChannel(
-      call_.get(), configuration_.media_config, rtp_dtls_transport,
+      GetOrCreateCall(), configuration_.media_config, rtp_dtls_transport,
       rtcp_dtls_transport, signaling_thread(), mid, SrtpRequired(),
       video_options_);
 
@@ -5691,8 +5715,21 @@ void PeerConnection::ReportNegotiatedCiphers(
 
 void PeerConnection::OnSentPacket_w(const rtc::SentPacket& sent_packet) {
   RTC_DCHECK(worker_thread()->IsCurrent());
-  RTC_DCHECK(call_);
-  call_->OnSentPacket(sent_packet);
+  // A session with only an RTP data channel never creates a Call.
+  if (call_)
+    call_->OnSentPacket(sent_packet);
+}
+
+Call* PeerConnection::GetOrCreateCall() {
+  if (IsClosed())
+    return nullptr;
+  return worker_thread()->Invoke<Call*>(RTC_FROM_HERE, [this] {
+    if (!call_) {
+      call_ = factory_->CreateCall_w(event_log_.get(),
+                                     memory_accountant_.get());
+    }
+    return call_.get();
+  });
 }
 
 const std::string PeerConnection::GetTransportName(
@@ -5794,4 +5831,8 @@ void PeerConnection::ClearStatsCache() {
   }
 }
 
+MemoryUsage PeerConnection::GetMemoryUsage() {
+  return memory_accountant_->GetUsage();
+}
+
 }  // namespace webrtc
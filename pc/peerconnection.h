@@ -55,7 +55,7 @@ class PeerConnection : public PeerConnectionInternal,
  public:
   explicit PeerConnection(PeerConnectionFactory* factory,
                           std::unique_ptr<RtcEventLog> event_log,
-                          std::unique_ptr<Call> call);
+                          rtc::scoped_refptr<MemoryAccountant> accountant);
 
   bool Initialize(
       const PeerConnectionInterface::RTCConfiguration& configuration,
@@ -121,6 +121,7 @@ class PeerConnection : public PeerConnectionInternal,
                 StatsOutputLevel level) override;
   void GetStats(RTCStatsCollectorCallback* callback) override;
   void ClearStatsCache() override;
+  MemoryUsage GetMemoryUsage() override;
 
   SignalingState signaling_state() override;
 
@@ -886,6 +887,12 @@ class PeerConnection : public PeerConnectionInternal,
 
   void OnSentPacket_w(const rtc::SentPacket& sent_packet);
 
+  // Returns |call_|, creating it on the worker thread the first time. Sessions
+  // that never negotiate media don't pay for the threads and modules of a
+  // Call. Returns null once closed, or if the factory has no media engine.
+  // |call_| itself is only accessed on the worker thread.
+  Call* GetOrCreateCall();
+
   const std::string GetTransportName(const std::string& content_name);
 
   void DestroyRtcpTransport_n(const std::string& transport_name);
@@ -950,6 +957,9 @@ class PeerConnection : public PeerConnectionInternal,
 
   bool remote_peer_supports_msid_ = false;
 
+  // Shared with |call_| and the streams it creates.
+  rtc::scoped_refptr<MemoryAccountant> memory_accountant_;
+  // Created by GetOrCreateCall(). Only accessed on the worker thread.
   std::unique_ptr<Call> call_;
   std::unique_ptr<StatsCollector> stats_;  // A pointer is passed to senders_
   rtc::scoped_refptr<RTCStatsCollector> stats_collector_;
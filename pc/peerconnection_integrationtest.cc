@@ -2540,6 +2540,31 @@ TEST_F(PeerConnectionIntegrationTest, AddRtpDataChannelInSubsequentOffer) {
                  kDefaultTimeout);
 }
 
+// A session with only an RTP data channel never creates a Call, so sent
+// packets must not be reported to one.
+TEST_F(PeerConnectionIntegrationTest, EndToEndCallWithOnlyRtpDataChannel) {
+  FakeConstraints setup_constraints;
+  setup_constraints.SetAllowRtpDataChannels();
+  ASSERT_TRUE(CreatePeerConnectionWrappersWithConstraints(&setup_constraints,
+                                                          &setup_constraints));
+  ConnectFakeSignaling();
+  caller()->CreateDataChannel();
+  caller()->CreateAndSetAndSignalOffer();
+  ASSERT_TRUE_WAIT(SignalingStateStable(), kDefaultTimeout);
+  ASSERT_NE(nullptr, caller()->data_channel());
+  ASSERT_NE(nullptr, callee()->data_channel());
+  EXPECT_TRUE_WAIT(caller()->data_observer()->IsOpen(), kDefaultTimeout);
+  EXPECT_TRUE_WAIT(callee()->data_observer()->IsOpen(), kDefaultTimeout);
+  // Ensure data can be sent in both directions.
+  std::string data = "hello world";
+  SendRtpDataWithRetries(caller()->data_channel(), data, 5);
+  EXPECT_EQ_WAIT(data, callee()->data_observer()->last_message(),
+                 kDefaultTimeout);
+  SendRtpDataWithRetries(callee()->data_channel(), data, 5);
+  EXPECT_EQ_WAIT(data, caller()->data_observer()->last_message(),
+                 kDefaultTimeout);
+}
+
 #ifdef HAVE_SCTP
 
 // This test sets up a call between two parties with audio, video and an SCTP
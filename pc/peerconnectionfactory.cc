@@ -245,22 +245,18 @@ PeerConnectionFactory::CreatePeerConnection(
         default_network_manager_.get(), default_socket_factory_.get(),
         configuration.turn_customizer));
   }
-  network_thread_->Invoke<void>(
-      RTC_FROM_HERE, rtc::Bind(&cricket::PortAllocator::SetNetworkIgnoreMask,
-                               allocator.get(), options_.network_ignore_mask));
-
   std::unique_ptr<RtcEventLog> event_log =
       worker_thread_->Invoke<std::unique_ptr<RtcEventLog>>(
           RTC_FROM_HERE,
           rtc::Bind(&PeerConnectionFactory::CreateRtcEventLog_w, this));
 
-  std::unique_ptr<Call> call = worker_thread_->Invoke<std::unique_ptr<Call>>(
-      RTC_FROM_HERE,
-      rtc::Bind(&PeerConnectionFactory::CreateCall_w, this, event_log.get()));
+  rtc::scoped_refptr<MemoryAccountant> memory_accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
 
+  // The Call is created by the PeerConnection when it first needs media.
   rtc::scoped_refptr<PeerConnection> pc(
       new rtc::RefCountedObject<PeerConnection>(this, std::move(event_log),
-                                                std::move(call)));
+                                                memory_accountant));
 
   if (!pc->Initialize(configuration, std::move(allocator),
                       std::move(cert_generator), observer)) {
@@ -338,7 +334,8 @@ std::unique_ptr<RtcEventLog> PeerConnectionFactory::CreateRtcEventLog_w() {
 }
 
 std::unique_ptr<Call> PeerConnectionFactory::CreateCall_w(
-    RtcEventLog* event_log) {
+    RtcEventLog* event_log,
+    MemoryAccountant* memory_accountant) {
   RTC_DCHECK_RUN_ON(worker_thread_);
 
   const int kMinBandwidthBps = 30000;
@@ -353,6 +350,7 @@ std::unique_ptr<Call> PeerConnectionFactory::CreateCall_w(
   call_config.bitrate_config.min_bitrate_bps = kMinBandwidthBps;
   call_config.bitrate_config.start_bitrate_bps = kStartBandwidthBps;
   call_config.bitrate_config.max_bitrate_bps = kMaxBandwidthBps;
+  call_config.memory_accountant = memory_accountant;
 
   return std::unique_ptr<Call>(call_factory_->CreateCall(call_config));
 }
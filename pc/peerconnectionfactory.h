@@ -100,6 +100,11 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   virtual rtc::Thread* network_thread();
   const Options& options() const { return options_; }
 
+  // Called by PeerConnection on the worker thread when it first needs a Call,
+  // which is when the first media channel is created. May return null.
+  std::unique_ptr<Call> CreateCall_w(RtcEventLog* event_log,
+                                     MemoryAccountant* memory_accountant);
+
  protected:
   PeerConnectionFactory(
       rtc::Thread* network_thread,
@@ -112,7 +117,6 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
 
  private:
   std::unique_ptr<RtcEventLog> CreateRtcEventLog_w();
-  std::unique_ptr<Call> CreateCall_w(RtcEventLog* event_log);
 
   bool wraps_current_thread_;
   rtc::Thread* network_thread_;
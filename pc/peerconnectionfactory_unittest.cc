@@ -20,7 +20,11 @@
 #include "p2p/base/fakeportallocator.h"
 #include "pc/peerconnectionfactory.h"
 #include "pc/test/fakeaudiocapturemodule.h"
+#include "pc/test/mockpeerconnectionobservers.h"
 #include "rtc_base/gunit.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
+#include "test/testsupport/perf_test.h"
 
 #ifdef WEBRTC_ANDROID
 #include "pc/test/androidtestinitializer.h"
@@ -62,6 +66,7 @@ static const char kStunIceServerWithIPv6AddressWithoutPort[] =
     "stun:[2401:fa00:4::]";
 static const char kTurnIceServerWithIPv6Address[] =
     "turn:test@[2401:fa00:4::]:1234";
+static const int kTimeoutMs = 10000;
 
 class NullPeerConnectionObserver : public PeerConnectionObserver {
  public:
@@ -368,3 +373,68 @@ TEST_F(PeerConnectionFactoryTest, LocalRendering) {
   EXPECT_EQ(3, local_renderer.num_rendered_frames());
   EXPECT_FALSE(local_renderer.black_frame());
 }
+
+// Times the steps of setting up and tearing down many sessions, the way a
+// signaling server does. Media channels and the Call are only created by
+// SetLocalDescription.
+TEST_F(PeerConnectionFactoryTest, DISABLED_CreatePeerConnectionBenchmark) {
+  const int kNumSessions = 200;
+  PeerConnectionInterface::RTCConfiguration config;
+  PeerConnectionInterface::RTCOfferAnswerOptions options;
+  options.offer_to_receive_audio = 1;
+  options.offer_to_receive_video = 1;
+
+  int64_t create_us = 0;
+  int64_t create_offer_us = 0;
+  int64_t set_local_description_us = 0;
+  int64_t close_us = 0;
+  for (int i = 0; i < kNumSessions; ++i) {
+    int64_t start_us = rtc::TimeMicros();
+    rtc::scoped_refptr<PeerConnectionInterface> pc(
+        factory_->CreatePeerConnection(
+            config,
+            rtc::MakeUnique<cricket::FakePortAllocator>(rtc::Thread::Current(),
+                                                        nullptr),
+            rtc::MakeUnique<FakeRTCCertificateGenerator>(), &observer_));
+    ASSERT_TRUE(pc);
+    create_us += rtc::TimeMicros() - start_us;
+
+    start_us = rtc::TimeMicros();
+    rtc::scoped_refptr<webrtc::MockCreateSessionDescriptionObserver>
+        offer_observer(new rtc::RefCountedObject<
+                       webrtc::MockCreateSessionDescriptionObserver>());
+    pc->CreateOffer(offer_observer, options);
+    EXPECT_TRUE_WAIT(offer_observer->called(), kTimeoutMs);
+    ASSERT_TRUE(offer_observer->result());
+    create_offer_us += rtc::TimeMicros() - start_us;
+
+    start_us = rtc::TimeMicros();
+    rtc::scoped_refptr<webrtc::MockSetSessionDescriptionObserver>
+        set_observer(new rtc::RefCountedObject<
+                     webrtc::MockSetSessionDescriptionObserver>());
+    pc->SetLocalDescription(set_observer,
+                            offer_observer->MoveDescription().release());
+    EXPECT_TRUE_WAIT(set_observer->called(), kTimeoutMs);
+    ASSERT_TRUE(set_observer->result());
+    set_local_description_us += rtc::TimeMicros() - start_us;
+
+    start_us = rtc::TimeMicros();
+    pc->Close();
+    pc = nullptr;
+    close_us += rtc::TimeMicros() - start_us;
+  }
+
+  webrtc::test::PrintResult("create_peer_connection", "", "",
+                            static_cast<double>(create_us) / kNumSessions,
+                            "us", false);
+  webrtc::test::PrintResult("create_offer", "", "",
+                            static_cast<double>(create_offer_us) / kNumSessions,
+                            "us", false);
+  webrtc::test::PrintResult(
+      "set_local_description", "", "",
+      static_cast<double>(set_local_description_us) / kNumSessions, "us",
+      false);
+  webrtc::test::PrintResult("close_peer_connection", "", "",
+                            static_cast<double>(close_us) / kNumSessions, "us",
+                            false);
+}
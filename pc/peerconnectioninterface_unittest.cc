@@ -2313,6 +2313,19 @@ TEST_F(PeerConnectionInterfaceTest, SetConfigurationChangesIceCheckInterval) {
   EXPECT_EQ(new_config.ice_check_min_interval, 100);
 }
 
+TEST_F(PeerConnectionInterfaceTest, SetConfigurationChangesSoftMemoryBudget) {
+  PeerConnectionInterface::RTCConfiguration config;
+  CreatePeerConnection(config, nullptr);
+  EXPECT_EQ(0, pc_->GetMemoryUsage().soft_budget_bytes);
+
+  config.soft_memory_budget_bytes = 1000000;
+  EXPECT_TRUE(pc_->SetConfiguration(config));
+  EXPECT_EQ(1000000, pc_->GetMemoryUsage().soft_budget_bytes);
+
+  config.soft_memory_budget_bytes = -1;
+  EXPECT_FALSE(pc_->SetConfiguration(config));
+}
+
 // Test that when SetConfiguration changes both the pool size and other
 // attributes, the pooled session is created with the updated attributes.
 TEST_F(PeerConnectionInterfaceTest,
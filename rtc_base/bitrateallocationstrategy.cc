@@ -20,6 +20,11 @@ namespace rtc {
 
 const int kTransmissionMaxBitrateMultiplier = 2;
 
+// Require a bitrate increase of max(10%, 20kbps) to resume paused tracks, same
+// as BitrateAllocator does.
+const double kDefaultToggleFactor = 0.1;
+const uint32_t kDefaultMinToggleBitrateBps = 20000;
+
 std::vector<uint32_t> BitrateAllocationStrategy::SetAllBitratesToMinimum(
     const ArrayView<const TrackConfig*> track_configs) {
   std::vector<uint32_t> track_allocations;
@@ -149,4 +154,139 @@ std::vector<uint32_t> AudioPriorityBitrateAllocationStrategy::AllocateBitrates(
   }
 }
 
+WeightedFairBitrateAllocationStrategy::WeightedFairBitrateAllocationStrategy()
+    : WeightedFairBitrateAllocationStrategy(kDefaultToggleFactor,
+                                            kDefaultMinToggleBitrateBps) {}
+
+WeightedFairBitrateAllocationStrategy::WeightedFairBitrateAllocationStrategy(
+    double toggle_factor,
+    uint32_t min_toggle_bitrate_bps)
+    : toggle_factor_(toggle_factor),
+      min_toggle_bitrate_bps_(min_toggle_bitrate_bps) {
+  RTC_DCHECK_GE(toggle_factor, 0.0);
+}
+
+WeightedFairBitrateAllocationStrategy::
+    ~WeightedFairBitrateAllocationStrategy() = default;
+
+std::vector<uint32_t> WeightedFairBitrateAllocationStrategy::AllocateBitrates(
+    uint32_t available_bitrate,
+    const ArrayView<const TrackConfig*> track_configs) {
+  const size_t num_tracks = track_configs.size();
+  std::vector<bool> active(num_tracks, false);
+  int64_t remaining_bitrate = available_bitrate;
+  int64_t sum_active_min_bitrates = 0;
+
+  // Tracks enforcing their min bitrate always get it, so remaining_bitrate
+  // might turn negative.
+  std::vector<size_t> pausable_tracks;
+  for (size_t i = 0; i < num_tracks; ++i) {
+    if (track_configs[i]->enforce_min_bitrate) {
+      active[i] = true;
+      remaining_bitrate -= track_configs[i]->min_bitrate_bps;
+      sum_active_min_bitrates += track_configs[i]->min_bitrate_bps;
+    } else {
+      pausable_tracks.push_back(i);
+    }
+  }
+
+  // Then resume or keep the other tracks, highest priority first, as long as
+  // their min bitrate fits. Tracks with the same priority keep their order.
+  std::stable_sort(pausable_tracks.begin(), pausable_tracks.end(),
+                   [&track_configs](size_t a, size_t b) {
+                     return track_configs[a]->bitrate_priority >
+                            track_configs[b]->bitrate_priority;
+                   });
+  for (size_t i : pausable_tracks) {
+    const int64_t required_bitrate =
+        MinBitrateWithHysteresis(*track_configs[i]);
+    if (remaining_bitrate < required_bitrate)
+      continue;
+    active[i] = true;
+    remaining_bitrate -= required_bitrate;
+    sum_active_min_bitrates += track_configs[i]->min_bitrate_bps;
+  }
+
+  paused_track_ids_.clear();
+  for (size_t i = 0; i < num_tracks; ++i) {
+    if (!active[i] && !track_configs[i]->track_id.empty())
+      paused_track_ids_.insert(track_configs[i]->track_id);
+  }
+
+  // The hysteresis only decides which tracks are active, what is left above
+  // the min bitrates is shared by all of them.
+  const uint32_t bitrate_above_min =
+      available_bitrate > sum_active_min_bitrates
+          ? static_cast<uint32_t>(available_bitrate - sum_active_min_bitrates)
+          : 0;
+  return WaterFill(track_configs, active, bitrate_above_min);
+}
+
+std::vector<uint32_t> WeightedFairBitrateAllocationStrategy::WaterFill(
+    const ArrayView<const TrackConfig*> track_configs,
+    const std::vector<bool>& active,
+    uint32_t bitrate) {
+  RTC_DCHECK_EQ(track_configs.size(), active.size());
+  std::vector<uint32_t> track_allocations(track_configs.size(), 0);
+  std::vector<size_t> active_tracks;
+  double bitrate_priority_sum = 0;
+  for (size_t i = 0; i < track_configs.size(); ++i) {
+    if (!active[i])
+      continue;
+    RTC_DCHECK_GT(track_configs[i]->bitrate_priority, 0.0);
+    track_allocations[i] = track_configs[i]->min_bitrate_bps;
+    active_tracks.push_back(i);
+    bitrate_priority_sum += track_configs[i]->bitrate_priority;
+  }
+
+  auto capacity = [&track_configs](size_t i) -> uint32_t {
+    const TrackConfig* config = track_configs[i];
+    return config->max_bitrate_bps > config->min_bitrate_bps
+               ? config->max_bitrate_bps - config->min_bitrate_bps
+               : 0;
+  };
+  // Sort by the water level at which each track is filled to its max, that
+  // is the capacity normalized by the priority.
+  std::sort(active_tracks.begin(), active_tracks.end(),
+            [&track_configs, &capacity](size_t a, size_t b) {
+              return capacity(a) / track_configs[a]->bitrate_priority <
+                     capacity(b) / track_configs[b]->bitrate_priority;
+            });
+
+  // Fill the tracks that reach their max below the final water level.
+  double remaining_bitrate = bitrate;
+  size_t k = 0;
+  for (; k < active_tracks.size(); ++k) {
+    const size_t i = active_tracks[k];
+    const double share = track_configs[i]->bitrate_priority /
+                         bitrate_priority_sum * remaining_bitrate;
+    if (share < capacity(i))
+      break;
+    track_allocations[i] += capacity(i);
+    remaining_bitrate -= capacity(i);
+    bitrate_priority_sum -= track_configs[i]->bitrate_priority;
+  }
+  // The rest share what is left in proportion to their priority.
+  for (; k < active_tracks.size(); ++k) {
+    const size_t i = active_tracks[k];
+    track_allocations[i] += static_cast<uint32_t>(
+        track_configs[i]->bitrate_priority / bitrate_priority_sum *
+        remaining_bitrate);
+  }
+  return track_allocations;
+}
+
+uint32_t WeightedFairBitrateAllocationStrategy::MinBitrateWithHysteresis(
+    const TrackConfig& track_config) const {
+  uint32_t min_bitrate = track_config.min_bitrate_bps;
+  if (track_config.track_id.empty() ||
+      paused_track_ids_.find(track_config.track_id) ==
+          paused_track_ids_.end()) {
+    return min_bitrate;
+  }
+  return min_bitrate +
+         std::max(static_cast<uint32_t>(toggle_factor_ * min_bitrate),
+                  min_toggle_bitrate_bps_);
+}
+
 }  // namespace rtc
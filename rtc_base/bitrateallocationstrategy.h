@@ -13,6 +13,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include "api/array_view.h"
@@ -35,13 +36,24 @@ class BitrateAllocationStrategy {
                 uint32_t max_bitrate_bps,
                 bool enforce_min_bitrate,
                 std::string track_id)
+        : TrackConfig(min_bitrate_bps,
+                      max_bitrate_bps,
+                      enforce_min_bitrate,
+                      track_id,
+                      1.0) {}
+    TrackConfig(uint32_t min_bitrate_bps,
+                uint32_t max_bitrate_bps,
+                bool enforce_min_bitrate,
+                std::string track_id,
+                double bitrate_priority)
         : min_bitrate_bps(min_bitrate_bps),
           max_bitrate_bps(max_bitrate_bps),
           enforce_min_bitrate(enforce_min_bitrate),
-          track_id(track_id) {}
+          track_id(track_id),
+          bitrate_priority(bitrate_priority) {}
     TrackConfig(const TrackConfig& track_config) = default;
     virtual ~TrackConfig() = default;
-    TrackConfig() {}
+    TrackConfig() : bitrate_priority(1.0) {}
 
     // Minimum bitrate supported by track.
     uint32_t min_bitrate_bps;
@@ -54,6 +66,12 @@ class BitrateAllocationStrategy {
 
     // MediaStreamTrack ID as defined by application. May be empty.
     std::string track_id;
+
+    // The amount of bitrate allocated to this track relative to all other
+    // tracks. If a track has twice the bitrate_priority of other tracks, it
+    // should be allocated twice the bitrate above its min. Strategies are free
+    // to ignore it.
+    double bitrate_priority;
   };
 
   static std::vector<uint32_t> SetAllBitratesToMinimum(
@@ -96,6 +114,49 @@ class AudioPriorityBitrateAllocationStrategy
   std::string audio_track_id_;
   uint32_t sufficient_audio_bitrate_;
 };
+
+// Weighted max-min fair allocation strategy. Every track first gets its
+// min_bitrate_bps, and the remaining bitrate is water-filled in proportion to
+// bitrate_priority: no track can get more by taking from a track that has a
+// lower allocation relative to its priority, except when that track is already
+// at its max_bitrate_bps.
+//
+// If the available bitrate can't cover all minimums, tracks with
+// enforce_min_bitrate still get their min and the others are paused, lowest
+// bitrate_priority first. To avoid toggling, a paused track must fit
+// max(|toggle_factor| * min_bitrate_bps, |min_toggle_bitrate_bps|) on top of
+// its min before it is resumed. The paused state is tracked per track_id, so
+// tracks with an empty track_id don't get the hysteresis.
+//
+// The allocation is O(n log n) in the number of tracks.
+class WeightedFairBitrateAllocationStrategy
+    : public BitrateAllocationStrategy {
+ public:
+  WeightedFairBitrateAllocationStrategy();
+  WeightedFairBitrateAllocationStrategy(double toggle_factor,
+                                        uint32_t min_toggle_bitrate_bps);
+  ~WeightedFairBitrateAllocationStrategy() override;
+
+  std::vector<uint32_t> AllocateBitrates(
+      uint32_t available_bitrate,
+      const ArrayView<const TrackConfig*> track_configs) override;
+
+  // Splits |bitrate| above the min bitrates of the tracks with
+  // |active[i]| set, in proportion to their bitrate_priority and capped at
+  // max_bitrate_bps. Inactive tracks are allocated 0. Exposed for testing.
+  static std::vector<uint32_t> WaterFill(
+      const ArrayView<const TrackConfig*> track_configs,
+      const std::vector<bool>& active,
+      uint32_t bitrate);
+
+ private:
+  uint32_t MinBitrateWithHysteresis(const TrackConfig& track_config) const;
+
+  const double toggle_factor_;
+  const uint32_t min_toggle_bitrate_bps_;
+  // Ids of the tracks that were paused by the last allocation.
+  std::set<std::string> paused_track_ids_;
+};
 }  // namespace rtc
 
 #endif  // RTC_BASE_BITRATEALLOCATIONSTRATEGY_H_
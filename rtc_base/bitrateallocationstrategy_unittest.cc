@@ -10,6 +10,7 @@
 
 #include "rtc_base/bitrateallocationstrategy.h"
 #include "rtc_base/gunit.h"
+#include "rtc_base/random.h"
 
 namespace rtc {
 
@@ -241,4 +242,197 @@ TEST(AudioPriorityBitrateAllocationStrategyTest, VideoAllocateBitrate) {
   EXPECT_EQ(max_other_bitrate, allocations[2]);
 }
 
+namespace {
+using TrackConfig = BitrateAllocationStrategy::TrackConfig;
+
+uint32_t Sum(const std::vector<uint32_t>& allocations) {
+  uint32_t sum = 0;
+  for (uint32_t allocation : allocations)
+    sum += allocation;
+  return sum;
+}
+
+// Checks the weighted max-min fairness of |allocations|: every active track
+// that isn't at its max must be at the highest water level, where the level of
+// a track is its allocation above min divided by its priority.
+void ExpectWeightedMaxMinFair(const std::vector<TrackConfig>& track_configs,
+                              const std::vector<uint32_t>& allocations) {
+  double max_level = 0;
+  for (size_t i = 0; i < track_configs.size(); ++i) {
+    if (allocations[i] == 0)
+      continue;
+    max_level = std::max(max_level, (allocations[i] -
+                                     track_configs[i].min_bitrate_bps) /
+                                        track_configs[i].bitrate_priority);
+  }
+  for (size_t i = 0; i < track_configs.size(); ++i) {
+    if (allocations[i] == 0 ||
+        allocations[i] >= track_configs[i].max_bitrate_bps)
+      continue;
+    double level = (allocations[i] - track_configs[i].min_bitrate_bps) /
+                   track_configs[i].bitrate_priority;
+    // Allow for rounding to whole bps.
+    EXPECT_NEAR(max_level, level, 1.0 / track_configs[i].bitrate_priority + 1)
+        << "track " << i;
+  }
+}
+}  // namespace
+
+TEST(WeightedFairBitrateAllocationStrategyTest, EqualPrioritiesShareEvenly) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(30000, 1000000, false, "a", 1.0),
+      TrackConfig(30000, 1000000, false, "b", 1.0),
+      TrackConfig(30000, 1000000, false, "c", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+  std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+      390000, track_config_ptrs);
+  EXPECT_EQ(130000u, allocations[0]);
+  EXPECT_EQ(130000u, allocations[1]);
+  EXPECT_EQ(130000u, allocations[2]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, ShareAboveMinFollowsPriority) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(50000, 2000000, false, "screenshare", 4.0),
+      TrackConfig(20000, 2000000, false, "thumbnail", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+  std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+      570000, track_config_ptrs);
+  EXPECT_EQ(50000u + 400000u, allocations[0]);
+  EXPECT_EQ(20000u + 100000u, allocations[1]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, CappedTrackLeavesRestToOthers) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(6000, 64000, true, "audio", 8.0),
+      TrackConfig(30000, 2000000, false, "video1", 1.0),
+      TrackConfig(30000, 2000000, false, "video2", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+  std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+      1064000, track_config_ptrs);
+  EXPECT_EQ(64000u, allocations[0]);
+  EXPECT_EQ(500000u, allocations[1]);
+  EXPECT_EQ(500000u, allocations[2]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, AllTracksAtMax) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(6000, 64000, true, "audio", 1.0),
+      TrackConfig(30000, 300000, false, "video", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+  std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+      1000000, track_config_ptrs);
+  EXPECT_EQ(64000u, allocations[0]);
+  EXPECT_EQ(300000u, allocations[1]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, PausesLowestPriorityFirst) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(100000, 2000000, false, "thumbnail", 1.0),
+      TrackConfig(100000, 2000000, false, "presenter", 4.0),
+      TrackConfig(16000, 64000, true, "audio", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+  std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+      150000, track_config_ptrs);
+  EXPECT_EQ(0u, allocations[0]);
+  EXPECT_GE(allocations[1], 100000u);
+  EXPECT_GE(allocations[2], 16000u);
+  EXPECT_EQ(150000u, Sum(allocations));
+
+  // Enforced mins are allocated even if there is too little bitrate.
+  allocations = strategy.AllocateBitrates(
+      10000, track_config_ptrs);
+  EXPECT_EQ(0u, allocations[0]);
+  EXPECT_EQ(0u, allocations[1]);
+  EXPECT_EQ(16000u, allocations[2]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, HysteresisAvoidsToggling) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(100000, 1000000, false, "video", 1.0)};
+  WeightedFairBitrateAllocationStrategy strategy(0.1, 20000);
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  EXPECT_EQ(100000u, strategy.AllocateBitrates(100000, track_config_ptrs)[0]);
+  EXPECT_EQ(0u, strategy.AllocateBitrates(99000, track_config_ptrs)[0]);
+  // Paused, needs max(10%, 20 kbps) on top of min to resume.
+  EXPECT_EQ(0u, strategy.AllocateBitrates(101000, track_config_ptrs)[0]);
+  EXPECT_EQ(0u, strategy.AllocateBitrates(119999, track_config_ptrs)[0]);
+  EXPECT_EQ(120000u, strategy.AllocateBitrates(120000, track_config_ptrs)[0]);
+  // Once resumed, the min is enough again.
+  EXPECT_EQ(100000u, strategy.AllocateBitrates(100000, track_config_ptrs)[0]);
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, FairForRandomConfigs) {
+  webrtc::Random random(0x5eed);
+  for (int run = 0; run < 100; ++run) {
+    std::vector<TrackConfig> track_configs;
+    const int num_tracks = random.Rand(1, 20);
+    uint32_t sum_min_bitrates = 0;
+    for (int i = 0; i < num_tracks; ++i) {
+      uint32_t min_bitrate = random.Rand(0, 100000);
+      uint32_t max_bitrate = min_bitrate + random.Rand(0, 3000000);
+      track_configs.emplace_back(min_bitrate, max_bitrate, false,
+                                 std::to_string(i), random.Rand(1, 8) / 2.0);
+      sum_min_bitrates += min_bitrate;
+    }
+    // Enough for all min bitrates, so no track is paused.
+    uint32_t available_bitrate = sum_min_bitrates + random.Rand(0, 10000000);
+    auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+    WeightedFairBitrateAllocationStrategy strategy;
+    std::vector<uint32_t> allocations = strategy.AllocateBitrates(
+        available_bitrate, track_config_ptrs);
+
+    uint32_t sum_max_bitrates = 0;
+    for (size_t i = 0; i < track_configs.size(); ++i) {
+      EXPECT_GE(allocations[i], track_configs[i].min_bitrate_bps);
+      EXPECT_LE(allocations[i], track_configs[i].max_bitrate_bps);
+      sum_max_bitrates += track_configs[i].max_bitrate_bps;
+    }
+    const uint32_t expected_sum = std::min(available_bitrate, sum_max_bitrates);
+    EXPECT_LE(Sum(allocations), expected_sum);
+    EXPECT_GE(Sum(allocations) + num_tracks, expected_sum);
+    ExpectWeightedMaxMinFair(track_configs, allocations);
+  }
+}
+
+TEST(WeightedFairBitrateAllocationStrategyTest, ConvergesAsEstimateChanges) {
+  std::vector<TrackConfig> track_configs = {
+      TrackConfig(16000, 64000, true, "audio", 2.0),
+      TrackConfig(150000, 2500000, false, "presenter", 4.0),
+      TrackConfig(50000, 300000, false, "thumbnail1", 1.0),
+      TrackConfig(50000, 300000, false, "thumbnail2", 1.0)};
+  auto track_config_ptrs = MakeTrackConfigPtrsVector(track_configs);
+  WeightedFairBitrateAllocationStrategy strategy;
+
+  // While the estimate ramps up, no allocation should decrease unless a paused
+  // track was resumed, and all of the estimate should be used once every track
+  // is active.
+  std::vector<uint32_t> previous(track_configs.size(), 0);
+  for (uint32_t estimate = 0; estimate <= 4000000; estimate += 10000) {
+    std::vector<uint32_t> allocations =
+        strategy.AllocateBitrates(estimate, track_config_ptrs);
+    bool resumed = false;
+    for (size_t i = 0; i < allocations.size(); ++i)
+      resumed |= previous[i] == 0 && allocations[i] > 0;
+    for (size_t i = 0; i < allocations.size() && !resumed; ++i)
+      EXPECT_GE(allocations[i], previous[i]) << "estimate " << estimate;
+    if (allocations[1] > 0 && allocations[2] > 0 && allocations[3] > 0)
+      EXPECT_GE(Sum(allocations) + allocations.size(),
+                std::min<uint32_t>(estimate, 3164000));
+    ExpectWeightedMaxMinFair(track_configs, allocations);
+    previous = allocations;
+  }
+
+  // A stable estimate gives a stable allocation.
+  std::vector<uint32_t> first =
+      strategy.AllocateBitrates(900000, track_config_ptrs);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(first, strategy.AllocateBitrates(900000, track_config_ptrs));
+}
+
 }  // namespace rtc
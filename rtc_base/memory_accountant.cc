@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/memory_accountant.h"
+
+#include <sstream>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+const char* MemoryTagName(MemoryTag tag) {
+  switch (tag) {
+    case MemoryTag::kRtpPacketHistory:
+      return "rtp_packet_history";
+    case MemoryTag::kVideoPacketBuffer:
+      return "video_packet_buffer";
+    case MemoryTag::kAudioPacketBuffer:
+      return "audio_packet_buffer";
+  }
+  RTC_NOTREACHED();
+  return "";
+}
+
+std::string MemoryUsage::ToString() const {
+  std::stringstream ss;
+  ss << "{soft_budget_bytes: " << soft_budget_bytes;
+  ss << ", total_bytes: " << total_bytes;
+  for (size_t i = 0; i < kNumMemoryTags; ++i)
+    ss << ", " << MemoryTagName(static_cast<MemoryTag>(i)) << ": " << bytes[i];
+  ss << '}';
+  return ss.str();
+}
+
+MemoryAccountant::MemoryAccountant()
+    : soft_budget_bytes_(0), total_bytes_(0) {
+  for (std::atomic<int64_t>& bytes : bytes_)
+    bytes.store(0, std::memory_order_relaxed);
+}
+
+MemoryAccountant::~MemoryAccountant() {
+  // Everything accounted must have been given back, since every
+  // MemoryAccount holds a reference.
+  RTC_DCHECK_EQ(0, total_bytes_.load());
+}
+
+void MemoryAccountant::SetSoftBudget(int64_t budget_bytes) {
+  RTC_DCHECK_GE(budget_bytes, 0);
+  soft_budget_bytes_.store(budget_bytes, std::memory_order_relaxed);
+}
+
+bool MemoryAccountant::OverBudget() const {
+  const int64_t budget_bytes =
+      soft_budget_bytes_.load(std::memory_order_relaxed);
+  return budget_bytes > 0 &&
+         total_bytes_.load(std::memory_order_relaxed) > budget_bytes;
+}
+
+MemoryUsage MemoryAccountant::GetUsage() const {
+  MemoryUsage usage;
+  usage.soft_budget_bytes = soft_budget_bytes_.load(std::memory_order_relaxed);
+  // Not a snapshot; the sum of the tags may differ slightly from the total
+  // while other threads account bytes.
+  usage.total_bytes = total_bytes_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kNumMemoryTags; ++i)
+    usage.bytes[i] = bytes_[i].load(std::memory_order_relaxed);
+  return usage;
+}
+
+void MemoryAccountant::Add(MemoryTag tag, int64_t bytes) {
+  const size_t index = static_cast<size_t>(tag);
+  RTC_DCHECK_LT(index, kNumMemoryTags);
+  bytes_[index].fetch_add(bytes, std::memory_order_relaxed);
+  total_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+MemoryAccount::MemoryAccount(MemoryTag tag) : tag_(tag), bytes_(0) {}
+
+MemoryAccount::~MemoryAccount() {
+  Clear();
+}
+
+void MemoryAccount::SetAccountant(MemoryAccountant* accountant) {
+  if (accountant_ == accountant)
+    return;
+  if (accountant_)
+    accountant_->Add(tag_, -static_cast<int64_t>(bytes_));
+  accountant_ = accountant;
+  if (accountant_)
+    accountant_->Add(tag_, static_cast<int64_t>(bytes_));
+}
+
+void MemoryAccount::Add(size_t bytes) {
+  bytes_ += bytes;
+  if (accountant_)
+    accountant_->Add(tag_, static_cast<int64_t>(bytes));
+}
+
+void MemoryAccount::Subtract(size_t bytes) {
+  RTC_DCHECK_LE(bytes, bytes_);
+  bytes_ -= bytes;
+  if (accountant_)
+    accountant_->Add(tag_, -static_cast<int64_t>(bytes));
+}
+
+void MemoryAccount::Clear() {
+  Subtract(bytes_);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_MEMORY_ACCOUNTANT_H_
+#define RTC_BASE_MEMORY_ACCOUNTANT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "rtc_base/constructormagic.h"
+#include "rtc_base/refcount.h"
+#include "rtc_base/scoped_ref_ptr.h"
+
+namespace webrtc {
+
+// The subsystems memory is accounted for.
+enum class MemoryTag {
+  // Sent RTP packets kept for retransmission, see RtpPacketHistory.
+  kRtpPacketHistory,
+  // Received video packets not yet assembled into frames.
+  kVideoPacketBuffer,
+  // Received audio packets not yet decoded by NetEq.
+  kAudioPacketBuffer,
+};
+constexpr size_t kNumMemoryTags = 3;
+
+const char* MemoryTagName(MemoryTag tag);
+
+struct MemoryUsage {
+  std::string ToString() const;
+
+  // 0 if there is no budget.
+  int64_t soft_budget_bytes = 0;
+  int64_t total_bytes = 0;
+  // Indexed by MemoryTag.
+  int64_t bytes[kNumMemoryTags] = {};
+};
+
+// Counts the bytes one session, such as a PeerConnection, uses per MemoryTag,
+// and holds a soft budget for their sum. Subsystems that can make do with less
+// memory check OverBudget() before they grow, and don't grow or shrink instead
+// while it's true. Nothing fails when the budget is exceeded.
+// The counters are updated through MemoryAccount, on any thread.
+class MemoryAccountant : public rtc::RefCountInterface {
+ public:
+  MemoryAccountant();
+
+  // A budget of 0 removes the budget.
+  void SetSoftBudget(int64_t budget_bytes);
+  bool OverBudget() const;
+
+  MemoryUsage GetUsage() const;
+
+ protected:
+  ~MemoryAccountant() override;
+
+ private:
+  friend class MemoryAccount;
+
+  void Add(MemoryTag tag, int64_t bytes);
+
+  std::atomic<int64_t> soft_budget_bytes_;
+  std::atomic<int64_t> total_bytes_;
+  std::atomic<int64_t> bytes_[kNumMemoryTags];
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MemoryAccountant);
+};
+
+// The bytes one object accounts with a MemoryAccountant under one tag. Gives
+// them back when destroyed or moved to another accountant. Without an
+// accountant it only keeps count. Not thread safe; the owner must serialize
+// calls, typically under its own lock.
+class MemoryAccount {
+ public:
+  explicit MemoryAccount(MemoryTag tag);
+  ~MemoryAccount();
+
+  // Moves the accounted bytes from the current accountant, if any, to
+  // |accountant|, which may be null.
+  void SetAccountant(MemoryAccountant* accountant);
+
+  void Add(size_t bytes);
+  void Subtract(size_t bytes);
+  // Subtracts everything accounted so far.
+  void Clear();
+
+  size_t bytes() const { return bytes_; }
+  // False without an accountant.
+  bool OverBudget() const {
+    return accountant_ && accountant_->OverBudget();
+  }
+
+ private:
+  const MemoryTag tag_;
+  rtc::scoped_refptr<MemoryAccountant> accountant_;
+  size_t bytes_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MemoryAccount);
+};
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_MEMORY_ACCOUNTANT_H_
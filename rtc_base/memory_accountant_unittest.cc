@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/memory_accountant.h"
+
+#include <memory>
+
+#include "rtc_base/refcountedobject.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+size_t Index(MemoryTag tag) {
+  return static_cast<size_t>(tag);
+}
+
+}  // namespace
+
+TEST(MemoryAccountantTest, CountsBytesPerTag) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  MemoryAccount history(MemoryTag::kRtpPacketHistory);
+  MemoryAccount video(MemoryTag::kVideoPacketBuffer);
+  MemoryAccount more_video(MemoryTag::kVideoPacketBuffer);
+  history.SetAccountant(accountant);
+  video.SetAccountant(accountant);
+  more_video.SetAccountant(accountant);
+
+  history.Add(1000);
+  video.Add(300);
+  more_video.Add(200);
+  video.Subtract(100);
+
+  MemoryUsage usage = accountant->GetUsage();
+  EXPECT_EQ(1400, usage.total_bytes);
+  EXPECT_EQ(1000, usage.bytes[Index(MemoryTag::kRtpPacketHistory)]);
+  EXPECT_EQ(400, usage.bytes[Index(MemoryTag::kVideoPacketBuffer)]);
+  EXPECT_EQ(0, usage.bytes[Index(MemoryTag::kAudioPacketBuffer)]);
+  EXPECT_EQ(200u, video.bytes());
+
+  history.Clear();
+  EXPECT_EQ(400, accountant->GetUsage().total_bytes);
+}
+
+TEST(MemoryAccountantTest, AccountGivesBytesBackWhenDestroyed) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  {
+    MemoryAccount account(MemoryTag::kAudioPacketBuffer);
+    account.SetAccountant(accountant);
+    account.Add(500);
+    EXPECT_EQ(500, accountant->GetUsage().total_bytes);
+  }
+  EXPECT_EQ(0, accountant->GetUsage().total_bytes);
+}
+
+TEST(MemoryAccountantTest, AccountKeepsAccountantAlive) {
+  std::unique_ptr<MemoryAccount> account(
+      new MemoryAccount(MemoryTag::kAudioPacketBuffer));
+  {
+    rtc::scoped_refptr<MemoryAccountant> accountant(
+        new rtc::RefCountedObject<MemoryAccountant>());
+    account->SetAccountant(accountant);
+  }
+  account->Add(500);
+  account.reset();
+}
+
+TEST(MemoryAccountantTest, MovesBytesToNewAccountant) {
+  rtc::scoped_refptr<MemoryAccountant> first(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  rtc::scoped_refptr<MemoryAccountant> second(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  MemoryAccount account(MemoryTag::kRtpPacketHistory);
+  account.Add(100);
+  account.SetAccountant(first);
+  EXPECT_EQ(100, first->GetUsage().total_bytes);
+  account.SetAccountant(second);
+  EXPECT_EQ(0, first->GetUsage().total_bytes);
+  EXPECT_EQ(100, second->GetUsage().total_bytes);
+  account.SetAccountant(nullptr);
+  EXPECT_EQ(0, second->GetUsage().total_bytes);
+  EXPECT_EQ(100u, account.bytes());
+}
+
+TEST(MemoryAccountantTest, OverBudgetWhenTotalExceedsSoftBudget) {
+  rtc::scoped_refptr<MemoryAccountant> accountant(
+      new rtc::RefCountedObject<MemoryAccountant>());
+  MemoryAccount history(MemoryTag::kRtpPacketHistory);
+  MemoryAccount audio(MemoryTag::kAudioPacketBuffer);
+  EXPECT_FALSE(history.OverBudget());
+  history.SetAccountant(accountant);
+  audio.SetAccountant(accountant);
+
+  history.Add(1000);
+  EXPECT_FALSE(accountant->OverBudget());
+
+  accountant->SetSoftBudget(1000);
+  EXPECT_FALSE(history.OverBudget());
+  audio.Add(1);
+  EXPECT_TRUE(history.OverBudget());
+  EXPECT_TRUE(audio.OverBudget());
+  EXPECT_EQ(1000, accountant->GetUsage().soft_budget_bytes);
+
+  accountant->SetSoftBudget(0);
+  EXPECT_FALSE(accountant->OverBudget());
+}
+
+}  // namespace webrtc
@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_NUMERICS_FENWICK_PERCENTILE_FILTER_H_
+#define RTC_BASE_NUMERICS_FENWICK_PERCENTILE_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+// Same interface and semantics as PercentileFilter, for non-negative integer
+// observations such as durations in ms; negative observations count as 0.
+// Values below |num_buckets| are counted in a Fenwick tree (binary indexed
+// tree) over a fixed array, which makes Insert, Erase and GetPercentileValue
+// O(log num_buckets) without touching the heap. Values from |num_buckets| and
+// up are kept sorted in a separate array, which is meant for rare outliers.
+template <typename T>
+class FenwickPercentileFilter {
+ public:
+  // Construct filter. |percentile| should be between 0 and 1.
+  FenwickPercentileFilter(float percentile, size_t num_buckets);
+
+  // Insert one observation.
+  void Insert(const T& value);
+
+  // Remove one observation or return false if |value| doesn't exist in the
+  // container.
+  bool Erase(const T& value);
+
+  // Get the percentile value.
+  T GetPercentileValue() const;
+
+  // Removes all the stored observations. Keeps the allocated memory.
+  void Reset();
+
+  size_t size() const { return size_; }
+
+ private:
+  // Maps negative observations to the first bucket, rather than to buckets
+  // that wrap around.
+  static T ClampValue(const T& value) { return std::max(value, T(0)); }
+  // Adds |delta| to the count of |bucket|.
+  void UpdateCount(size_t bucket, int32_t delta);
+  // Returns the number of observations in |bucket|.
+  uint32_t Count(size_t bucket) const;
+  // Returns the bucket of the observation at |index| in sorted order, which
+  // must be below the number of observations in the tree.
+  size_t FindBucket(size_t index) const;
+
+  const float percentile_;
+  const size_t num_buckets_;
+  // Largest power of two not above |num_buckets_|, where FindBucket starts.
+  size_t top_step_;
+  // 1-based; |tree_[i]| is the count of the buckets (i - (i & -i), i].
+  std::vector<uint32_t> tree_;
+  // Number of observations in |tree_|.
+  size_t tree_size_;
+  // Sorted observations from |num_buckets_| and up.
+  std::vector<T> large_values_;
+  size_t size_;
+};
+
+template <typename T>
+FenwickPercentileFilter<T>::FenwickPercentileFilter(float percentile,
+                                                    size_t num_buckets)
+    : percentile_(percentile),
+      num_buckets_(num_buckets),
+      top_step_(1),
+      tree_(num_buckets + 1, 0),
+      tree_size_(0),
+      size_(0) {
+  RTC_CHECK_GE(percentile, 0.0f);
+  RTC_CHECK_LE(percentile, 1.0f);
+  RTC_CHECK_GT(num_buckets, 0);
+  while (top_step_ * 2 <= num_buckets_)
+    top_step_ *= 2;
+}
+
+template <typename T>
+void FenwickPercentileFilter<T>::Insert(const T& observation) {
+  const T value = ClampValue(observation);
+  if (value < static_cast<T>(num_buckets_)) {
+    UpdateCount(static_cast<size_t>(value), 1);
+    ++tree_size_;
+  } else {
+    large_values_.insert(
+        std::upper_bound(large_values_.begin(), large_values_.end(), value),
+        value);
+  }
+  ++size_;
+}
+
+template <typename T>
+bool FenwickPercentileFilter<T>::Erase(const T& observation) {
+  const T value = ClampValue(observation);
+  if (value < static_cast<T>(num_buckets_)) {
+    if (Count(static_cast<size_t>(value)) == 0)
+      return false;
+    UpdateCount(static_cast<size_t>(value), -1);
+    --tree_size_;
+  } else {
+    auto it =
+        std::lower_bound(large_values_.begin(), large_values_.end(), value);
+    if (it == large_values_.end() || *it != value)
+      return false;
+    large_values_.erase(it);
+  }
+  --size_;
+  return true;
+}
+
+template <typename T>
+T FenwickPercentileFilter<T>::GetPercentileValue() const {
+  if (size_ == 0)
+    return 0;
+  // Same rounding as PercentileFilter.
+  const size_t index = static_cast<size_t>(percentile_ * (size_ - 1));
+  if (index < tree_size_)
+    return static_cast<T>(FindBucket(index));
+  return large_values_[index - tree_size_];
+}
+
+template <typename T>
+void FenwickPercentileFilter<T>::Reset() {
+  std::fill(tree_.begin(), tree_.end(), 0);
+  tree_size_ = 0;
+  large_values_.clear();
+  size_ = 0;
+}
+
+template <typename T>
+void FenwickPercentileFilter<T>::UpdateCount(size_t bucket, int32_t delta) {
+  for (size_t i = bucket + 1; i <= num_buckets_; i += i & (~i + 1))
+    tree_[i] += delta;
+}
+
+template <typename T>
+uint32_t FenwickPercentileFilter<T>::Count(size_t bucket) const {
+  // The node of the bucket covers (parent, bucket + 1]. Subtract the nodes
+  // covering the buckets before it in that range.
+  size_t i = bucket + 1;
+  uint32_t count = tree_[i];
+  const size_t parent = i - (i & (~i + 1));
+  for (--i; i != parent; i -= i & (~i + 1))
+    count -= tree_[i];
+  return count;
+}
+
+template <typename T>
+size_t FenwickPercentileFilter<T>::FindBucket(size_t index) const {
+  // Descend from the largest node, skipping nodes whose buckets hold at most
+  // |index| observations.
+  size_t position = 0;
+  size_t remaining = index;
+  for (size_t step = top_step_; step > 0; step /= 2) {
+    const size_t next = position + step;
+    if (next <= num_buckets_ && tree_[next] <= remaining) {
+      position = next;
+      remaining -= tree_[next];
+    }
+  }
+  RTC_DCHECK_LT(position, num_buckets_);
+  return position;
+}
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_NUMERICS_FENWICK_PERCENTILE_FILTER_H_
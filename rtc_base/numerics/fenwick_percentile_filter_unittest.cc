@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <limits>
+#include <vector>
+
+#include "rtc_base/numerics/fenwick_percentile_filter.h"
+#include "rtc_base/numerics/percentile_filter.h"
+#include "rtc_base/random.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(FenwickPercentileFilterTest, EmptyFilter) {
+  FenwickPercentileFilter<int64_t> filter(0.5f, 10);
+  EXPECT_EQ(0, filter.GetPercentileValue());
+  filter.Insert(3);
+  EXPECT_TRUE(filter.Erase(3));
+  EXPECT_EQ(0, filter.GetPercentileValue());
+  EXPECT_FALSE(filter.Erase(3));
+  EXPECT_FALSE(filter.Erase(30));
+  EXPECT_FALSE(filter.Erase(-1));
+}
+
+TEST(FenwickPercentileFilterTest, MedianFilterWithLargeValues) {
+  FenwickPercentileFilter<int64_t> filter(0.5f, 10);
+  filter.Insert(0);
+  filter.Insert(100);
+  filter.Insert(9);
+  EXPECT_EQ(9, filter.GetPercentileValue());
+  filter.Insert(50);
+  filter.Erase(0);
+  EXPECT_EQ(50, filter.GetPercentileValue());
+  EXPECT_FALSE(filter.Erase(51));
+  EXPECT_EQ(3u, filter.size());
+}
+
+TEST(FenwickPercentileFilterTest, DuplicateElements) {
+  FenwickPercentileFilter<int64_t> filter(0.5f, 4);
+  filter.Insert(3);
+  filter.Insert(3);
+  filter.Erase(3);
+  EXPECT_EQ(3, filter.GetPercentileValue());
+  EXPECT_EQ(1u, filter.size());
+  filter.Reset();
+  EXPECT_EQ(0u, filter.size());
+  EXPECT_FALSE(filter.Erase(3));
+}
+
+TEST(FenwickPercentileFilterTest, CountsNegativeValuesAsZero) {
+  FenwickPercentileFilter<int64_t> filter(1.0f, 10);
+  filter.Insert(-1);
+  filter.Insert(std::numeric_limits<int64_t>::min());
+  EXPECT_EQ(2u, filter.size());
+  EXPECT_EQ(0, filter.GetPercentileValue());
+  filter.Insert(5);
+  EXPECT_EQ(5, filter.GetPercentileValue());
+  EXPECT_TRUE(filter.Erase(-1));
+  EXPECT_TRUE(filter.Erase(-1));
+  EXPECT_FALSE(filter.Erase(-1));
+  EXPECT_EQ(1u, filter.size());
+  EXPECT_TRUE(filter.Erase(5));
+  EXPECT_EQ(0, filter.GetPercentileValue());
+}
+
+TEST(FenwickPercentileFilterTest, MatchesPercentileFilter) {
+  const float kPercentiles[] = {0.0f, 0.1f, 0.5f, 0.9f, 0.95f, 1.0f};
+  // Not a power of two, so that the top node doesn't cover all buckets.
+  const size_t kNumBuckets = 37;
+  for (float percentile : kPercentiles) {
+    Random random(0x1234);
+    PercentileFilter<int64_t> reference(percentile);
+    FenwickPercentileFilter<int64_t> filter(percentile, kNumBuckets);
+    std::vector<int64_t> inserted;
+    for (int i = 0; i < 2000; ++i) {
+      if (inserted.size() < 100 && random.Rand(0, 2) != 0) {
+        // Some values don't fit in the buckets.
+        int64_t value = random.Rand(0, 45);
+        reference.Insert(value);
+        filter.Insert(value);
+        inserted.push_back(value);
+      } else if (!inserted.empty()) {
+        size_t index =
+            random.Rand(0u, static_cast<uint32_t>(inserted.size() - 1));
+        EXPECT_TRUE(reference.Erase(inserted[index]));
+        EXPECT_TRUE(filter.Erase(inserted[index]));
+        inserted.erase(inserted.begin() + index);
+      }
+      ASSERT_EQ(reference.GetPercentileValue(), filter.GetPercentileValue());
+    }
+  }
+}
+
+}  // namespace webrtc
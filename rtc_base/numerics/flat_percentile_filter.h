@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_NUMERICS_FLAT_PERCENTILE_FILTER_H_
+#define RTC_BASE_NUMERICS_FLAT_PERCENTILE_FILTER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+// Same interface and semantics as PercentileFilter, but the observations are
+// kept in a sorted contiguous array instead of a node based std::multiset.
+// Insert and Erase do a binary search followed by a memmove, which for the
+// small to medium sized sets used by the estimators (up to a few hundred
+// elements) is considerably faster than the tree operations and does not touch
+// the heap once |capacity| elements have been reserved.
+template <typename T>
+class FlatPercentileFilter {
+ public:
+  // Construct filter. |percentile| should be between 0 and 1. |capacity| is
+  // the number of observations to reserve space for up front; inserting more
+  // than that is allowed but will reallocate.
+  FlatPercentileFilter(float percentile, size_t capacity);
+
+  // Insert one observation. The complexity of this operation is logarithmic in
+  // the size of the container for the search and linear for the move.
+  void Insert(const T& value);
+
+  // Remove one observation or return false if |value| doesn't exist in the
+  // container.
+  bool Erase(const T& value);
+
+  // Get the percentile value. The complexity of this operation is constant.
+  T GetPercentileValue() const;
+
+  // Removes all the stored observations. Keeps the reserved memory.
+  void Reset();
+
+  size_t size() const { return values_.size(); }
+
+ private:
+  const float percentile_;
+  std::vector<T> values_;
+};
+
+template <typename T>
+FlatPercentileFilter<T>::FlatPercentileFilter(float percentile,
+                                              size_t capacity)
+    : percentile_(percentile) {
+  RTC_CHECK_GE(percentile, 0.0f);
+  RTC_CHECK_LE(percentile, 1.0f);
+  values_.reserve(capacity);
+}
+
+template <typename T>
+void FlatPercentileFilter<T>::Insert(const T& value) {
+  // Insert element at the upper bound, like std::multiset does.
+  values_.insert(std::upper_bound(values_.begin(), values_.end(), value),
+                 value);
+}
+
+template <typename T>
+bool FlatPercentileFilter<T>::Erase(const T& value) {
+  auto it = std::lower_bound(values_.begin(), values_.end(), value);
+  // Ignore erase operation if the element is not present in the current set.
+  if (it == values_.end() || *it != value)
+    return false;
+  values_.erase(it);
+  return true;
+}
+
+template <typename T>
+T FlatPercentileFilter<T>::GetPercentileValue() const {
+  if (values_.empty())
+    return 0;
+  const size_t index = static_cast<size_t>(percentile_ * (values_.size() - 1));
+  return values_[index];
+}
+
+template <typename T>
+void FlatPercentileFilter<T>::Reset() {
+  values_.clear();
+}
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_NUMERICS_FLAT_PERCENTILE_FILTER_H_
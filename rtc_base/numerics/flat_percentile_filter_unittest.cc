@@ -0,0 +1,75 @@
+/*
+ *  Copyright 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <climits>
+#include <vector>
+
+#include "rtc_base/numerics/flat_percentile_filter.h"
+#include "rtc_base/numerics/percentile_filter.h"
+#include "rtc_base/random.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(FlatPercentileFilterTest, EmptyFilter) {
+  FlatPercentileFilter<int64_t> filter(0.5f, 10);
+  EXPECT_EQ(0, filter.GetPercentileValue());
+  filter.Insert(3);
+  EXPECT_TRUE(filter.Erase(3));
+  EXPECT_EQ(0, filter.GetPercentileValue());
+  EXPECT_FALSE(filter.Erase(3));
+}
+
+TEST(FlatPercentileFilterTest, MedianFilterInt) {
+  FlatPercentileFilter<int> filter(0.5f, 4);
+  filter.Insert(INT_MIN);
+  filter.Insert(1);
+  filter.Insert(2);
+  EXPECT_EQ(1, filter.GetPercentileValue());
+  filter.Insert(INT_MAX);
+  filter.Erase(INT_MIN);
+  EXPECT_EQ(2, filter.GetPercentileValue());
+}
+
+TEST(FlatPercentileFilterTest, DuplicateElements) {
+  FlatPercentileFilter<int64_t> filter(0.5f, 4);
+  filter.Insert(3);
+  filter.Insert(3);
+  filter.Erase(3);
+  EXPECT_EQ(3, filter.GetPercentileValue());
+  EXPECT_EQ(1u, filter.size());
+}
+
+TEST(FlatPercentileFilterTest, MatchesPercentileFilter) {
+  const float kPercentiles[] = {0.0f, 0.1f, 0.5f, 0.9f, 1.0f};
+  for (float percentile : kPercentiles) {
+    Random random(0x1234);
+    PercentileFilter<double> reference(percentile);
+    FlatPercentileFilter<double> filter(percentile, 100);
+    std::vector<double> inserted;
+    for (int i = 0; i < 1000; ++i) {
+      if (inserted.size() < 100 && random.Rand(0, 2) != 0) {
+        double value = random.Rand(0, 50) / 4.0;
+        reference.Insert(value);
+        filter.Insert(value);
+        inserted.push_back(value);
+      } else if (!inserted.empty()) {
+        size_t index =
+            random.Rand(0u, static_cast<uint32_t>(inserted.size() - 1));
+        EXPECT_TRUE(reference.Erase(inserted[index]));
+        EXPECT_TRUE(filter.Erase(inserted[index]));
+        inserted.erase(inserted.begin() + index);
+      }
+      ASSERT_EQ(reference.GetPercentileValue(), filter.GetPercentileValue());
+    }
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/rcu_snapshot.h"
+
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <sched.h>
+#include <time.h>
+#endif
+
+namespace rtc {
+
+namespace {
+
+// Number of times a writer yields before it starts sleeping, while waiting for
+// readers. Read sections are short, but spinning would take the processor from
+// the readers we wait for when there are few cores.
+const int kMaxYields = 16;
+
+void WaitForOtherThreads(int attempt) {
+#if defined(WEBRTC_WIN)
+  ::Sleep(attempt < kMaxYields ? 0 : 1);
+#else
+  if (attempt < kMaxYields) {
+    sched_yield();
+  } else {
+    const struct timespec one_ms = {0, 1000 * 1000};
+    nanosleep(&one_ms, nullptr);
+  }
+#endif
+}
+
+}  // namespace
+
+ReadEpochs::ReadEpochs() : epoch_(0) {
+  readers_[0].store(0);
+  readers_[1].store(0);
+}
+
+ReadEpochs::~ReadEpochs() {
+  RTC_DCHECK_EQ(0, readers_[0].load());
+  RTC_DCHECK_EQ(0, readers_[1].load());
+}
+
+int ReadEpochs::Enter() const {
+  while (true) {
+    const int epoch = epoch_.load() & 1;
+    readers_[epoch].fetch_add(1);
+    // If a writer flipped the epoch in between, it may already have seen this
+    // epoch drained; retry in the new one. Otherwise, the writer is bound to
+    // wait for us.
+    if ((epoch_.load() & 1) == epoch)
+      return epoch;
+    readers_[epoch].fetch_sub(1);
+  }
+}
+
+void ReadEpochs::Leave(int epoch) const {
+  RTC_DCHECK_GT(readers_[epoch].load(std::memory_order_relaxed), 0);
+  readers_[epoch].fetch_sub(1, std::memory_order_release);
+}
+
+void ReadEpochs::Synchronize() {
+  // Readers that enter from now on count in the other epoch, and see
+  // everything published before the flip.
+  const int epoch = epoch_.fetch_add(1) & 1;
+  for (int attempt = 0; readers_[epoch].load() != 0; ++attempt)
+    WaitForOtherThreads(attempt);
+}
+
+}  // namespace rtc
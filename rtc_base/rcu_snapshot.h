@@ -0,0 +1,96 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_RCU_SNAPSHOT_H_
+#define RTC_BASE_RCU_SNAPSHOT_H_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/constructormagic.h"
+
+namespace rtc {
+
+// Tracks readers in two epochs, so that a writer can wait for the readers that
+// started before a given point to leave, while new readers keep entering. The
+// read side is two atomic increments and never waits. See RcuSnapshot.
+class ReadEpochs {
+ public:
+  ReadEpochs();
+  ~ReadEpochs();
+
+  // Returns the epoch to pass to Leave().
+  int Enter() const;
+  void Leave(int epoch) const;
+
+  // Returns once every reader that entered before the call has left. Callers
+  // must serialize calls, and must not be inside a read section themselves.
+  void Synchronize();
+
+ private:
+  std::atomic<int> epoch_;
+  mutable std::atomic<int> readers_[2];
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ReadEpochs);
+};
+
+// Read-copy-update for a value that is read on hot paths and replaced rarely,
+// such as routing tables. Readers pin the current snapshot with a ReadScope,
+// without locking. A writer builds a new snapshot and publishes it; Publish()
+// returns after the readers that could still see the old snapshot are done,
+// and deletes it. Writers must be serialized by the caller.
+template <typename T>
+class RcuSnapshot {
+ public:
+  class ReadScope {
+   public:
+    explicit ReadScope(const RcuSnapshot<T>* rcu)
+        : rcu_(rcu),
+          epoch_(rcu->epochs_.Enter()),
+          snapshot_(rcu->snapshot_.load(std::memory_order_seq_cst)) {}
+    ~ReadScope() { rcu_->epochs_.Leave(epoch_); }
+
+    const T& operator*() const { return *snapshot_; }
+    const T* operator->() const { return snapshot_; }
+
+   private:
+    const RcuSnapshot<T>* const rcu_;
+    const int epoch_;
+    const T* const snapshot_;
+
+    RTC_DISALLOW_COPY_AND_ASSIGN(ReadScope);
+  };
+
+  RcuSnapshot() : snapshot_(new T()) {}
+  ~RcuSnapshot() { delete snapshot_.load(); }
+
+  // The current snapshot, for the writer. Valid until the next Publish().
+  const T& Get() const { return *snapshot_.load(std::memory_order_relaxed); }
+
+  void Publish(std::unique_ptr<const T> snapshot) {
+    RTC_DCHECK(snapshot);
+    const T* old_snapshot =
+        snapshot_.exchange(snapshot.release(), std::memory_order_seq_cst);
+    epochs_.Synchronize();
+    delete old_snapshot;
+  }
+
+ private:
+  ReadEpochs epochs_;
+  std::atomic<const T*> snapshot_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RcuSnapshot);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_RCU_SNAPSHOT_H_
@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/rcu_snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/ptr_util.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace rtc {
+
+namespace {
+
+struct Pair {
+  Pair() : Pair(0) {}
+  explicit Pair(int value) : first(value), second(value) {}
+  ~Pair() {
+    // Make use after delete visible to the readers below.
+    first = -1;
+    second = -2;
+  }
+
+  int first;
+  int second;
+};
+
+struct PublishTask {
+  RcuSnapshot<Pair>* rcu;
+  std::atomic<bool> published{false};
+};
+
+void Publish(void* obj) {
+  PublishTask* task = static_cast<PublishTask*>(obj);
+  task->rcu->Publish(MakeUnique<Pair>(2));
+  task->published = true;
+}
+
+struct StressTask {
+  RcuSnapshot<Pair>* rcu;
+  std::atomic<bool> stop{false};
+  std::atomic<int> mismatches{0};
+};
+
+void ReadUntilStopped(void* obj) {
+  StressTask* task = static_cast<StressTask*>(obj);
+  while (!task->stop) {
+    RcuSnapshot<Pair>::ReadScope snapshot(task->rcu);
+    if (snapshot->first != snapshot->second || snapshot->first < 0)
+      ++task->mismatches;
+  }
+}
+
+}  // namespace
+
+TEST(RcuSnapshotTest, ReadersSeePublishedSnapshot) {
+  RcuSnapshot<Pair> rcu;
+  {
+    RcuSnapshot<Pair>::ReadScope snapshot(&rcu);
+    EXPECT_EQ(0, snapshot->first);
+  }
+  rcu.Publish(MakeUnique<Pair>(1));
+  EXPECT_EQ(1, rcu.Get().first);
+  RcuSnapshot<Pair>::ReadScope snapshot(&rcu);
+  EXPECT_EQ(1, (*snapshot).second);
+}
+
+TEST(RcuSnapshotTest, PublishWaitsForReaders) {
+  RcuSnapshot<Pair> rcu;
+  PublishTask task;
+  task.rcu = &rcu;
+  PlatformThread thread(&Publish, &task, "Publish");
+  {
+    RcuSnapshot<Pair>::ReadScope snapshot(&rcu);
+    thread.Start();
+    webrtc::SleepMs(50);
+    EXPECT_FALSE(task.published);
+    // The snapshot read before the new one was published stays valid.
+    EXPECT_EQ(0, snapshot->first);
+
+    // Readers that start now see the new snapshot, without waiting.
+    RcuSnapshot<Pair>::ReadScope new_snapshot(&rcu);
+    EXPECT_EQ(2, new_snapshot->first);
+  }
+  thread.Stop();
+  EXPECT_TRUE(task.published);
+}
+
+TEST(RcuSnapshotTest, ReadersNeverSeeDeletedSnapshots) {
+  const int kNumReaders = 4;
+  RcuSnapshot<Pair> rcu;
+  StressTask task;
+  task.rcu = &rcu;
+  std::vector<std::unique_ptr<PlatformThread>> readers;
+  for (int i = 0; i < kNumReaders; ++i) {
+    readers.emplace_back(
+        new PlatformThread(&ReadUntilStopped, &task, "Reader"));
+    readers.back()->Start();
+  }
+  for (int i = 1; i <= 1000; ++i)
+    rcu.Publish(MakeUnique<Pair>(i));
+  task.stop = true;
+  for (auto& reader : readers)
+    reader->Stop();
+  EXPECT_EQ(0, task.mismatches);
+}
+
+namespace {
+
+using RoutingTable = std::map<uint32_t, int>;
+
+const int kNumRoutes = 1000;
+const int kNumLookups = 1000000;
+
+std::unique_ptr<RoutingTable> CreateRoutingTable(int generation) {
+  std::unique_ptr<RoutingTable> table(new RoutingTable());
+  for (int i = 0; i < kNumRoutes; ++i)
+    (*table)[i] = generation;
+  return table;
+}
+
+struct ContentionTask {
+  // Either |table| under |lock|, or |rcu|.
+  CriticalSection lock;
+  std::unique_ptr<RoutingTable> table;
+  RcuSnapshot<RoutingTable> rcu;
+  bool use_rcu = false;
+
+  std::atomic<bool> stop{false};
+  int64_t lookup_us = 0;
+  int64_t max_lookup_us = 0;
+};
+
+void LookUp(void* obj) {
+  ContentionTask* task = static_cast<ContentionTask*>(obj);
+  const int64_t start_us = TimeMicros();
+  int64_t sum = 0;
+  for (int i = 0; i < kNumLookups; ++i) {
+    const int64_t lookup_start_us = TimeMicros();
+    const uint32_t key = i % kNumRoutes;
+    if (task->use_rcu) {
+      RcuSnapshot<RoutingTable>::ReadScope table(&task->rcu);
+      sum += table->find(key)->second;
+    } else {
+      CritScope cs(&task->lock);
+      sum += task->table->find(key)->second;
+    }
+    task->max_lookup_us =
+        std::max(task->max_lookup_us, TimeMicros() - lookup_start_us);
+  }
+  task->lookup_us = TimeMicros() - start_us;
+  EXPECT_GE(sum, 0);
+}
+
+void Reconfigure(void* obj) {
+  ContentionTask* task = static_cast<ContentionTask*>(obj);
+  for (int generation = 1; !task->stop; ++generation) {
+    std::unique_ptr<RoutingTable> table = CreateRoutingTable(generation);
+    if (task->use_rcu) {
+      task->rcu.Publish(std::move(table));
+    } else {
+      // The old table is deleted while holding the lock, like Call changing
+      // its maps while holding the write lock.
+      CritScope cs(&task->lock);
+      task->table = std::move(table);
+    }
+    webrtc::SleepMs(1);
+  }
+}
+
+void RunContentionBenchmark(bool use_rcu) {
+  ContentionTask task;
+  task.use_rcu = use_rcu;
+  task.table = CreateRoutingTable(0);
+  task.rcu.Publish(CreateRoutingTable(0));
+
+  PlatformThread reader(&LookUp, &task, "LookUp");
+  PlatformThread writer(&Reconfigure, &task, "Reconfigure");
+  writer.Start();
+  reader.Start();
+  reader.Stop();
+  task.stop = true;
+  writer.Stop();
+
+  const char* trace = use_rcu ? "rcu_snapshot" : "critical_section";
+  webrtc::test::PrintResult("lookup_time", "", trace,
+                            task.lookup_us * 1000.0 / kNumLookups, "ns",
+                            false);
+  webrtc::test::PrintResult("max_lookup_time", "", trace,
+                            static_cast<double>(task.max_lookup_us), "us",
+                            false);
+}
+
+}  // namespace
+
+// Looks up routes on one thread while another thread keeps replacing the
+// routing table, as when streams are created and destroyed while packets flow.
+TEST(RcuSnapshotTest, DISABLED_LookupWhileReconfiguringBenchmark) {
+  RunContentionBenchmark(false);
+  RunContentionBenchmark(true);
+}
+
+}  // namespace rtc
@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_tools/frame_analyzer/frame_metrics.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// Same cap as CalculateMetrics(), libyuv's own cap of 128 dB for identical
+// frames skews averages too much.
+const double kMaxPsnr = 48.0;
+
+// SSIM constants (0.01 * 255)^2 and (0.03 * 255)^2 scaled by 64^2, for sums
+// over the 64 pixels of a window instead of means.
+const int64_t kSsimC1 = 26634;
+const int64_t kSsimC2 = 239708;
+const int64_t kWindowPixels = 64;
+
+const int kMaxMsSsimScales = 5;
+const double kMsSsimWeights[kMaxMsSsimScales] = {0.0448, 0.2856, 0.3001,
+                                                 0.2363, 0.1333};
+
+uint64_t SumSquaredError(const uint8_t* ref,
+                         const uint8_t* test,
+                         int width,
+                         int height) {
+  uint64_t sse = 0;
+  for (int y = 0; y < height; ++y) {
+    // A row of up to 66051 pixels fits in 32 bits, which vectorizes better.
+    uint32_t row_sse = 0;
+    for (int x = 0; x < width; ++x) {
+      const int diff = ref[x] - test[x];
+      row_sse += diff * diff;
+    }
+    sse += row_sse;
+    ref += width;
+    test += width;
+  }
+  return sse;
+}
+
+double SseToPsnr(uint64_t sse, uint64_t samples) {
+  if (sse == 0)
+    return kMaxPsnr;
+  const double psnr = 10.0 * log10(255.0 * 255.0 * samples / sse);
+  return std::min(psnr, kMaxPsnr);
+}
+
+// Averages 2x2 pixels into one.
+void Downscale(const uint8_t* src,
+               int src_stride,
+               int width,
+               int height,
+               uint8_t* dst) {
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row0 = src + 2 * y * src_stride;
+    const uint8_t* row1 = row0 + src_stride;
+    for (int x = 0; x < width; ++x) {
+      dst[x] = (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] +
+                row1[2 * x + 1] + 2) >> 2;
+    }
+    dst += width;
+  }
+}
+
+}  // namespace
+
+FrameMetricsCalculator::FrameMetricsCalculator() {}
+FrameMetricsCalculator::~FrameMetricsCalculator() {}
+
+bool FrameMetricsCalculator::Calculate(const uint8_t* ref_frame,
+                                       const uint8_t* test_frame,
+                                       int width,
+                                       int height,
+                                       FrameMetrics* metrics) {
+  if (width <= 0 || height <= 0)
+    return false;
+  const int half_width = (width + 1) >> 1;
+  const int half_height = (height + 1) >> 1;
+  const int y_size = width * height;
+  const int uv_size = half_width * half_height;
+  const uint8_t* ref_u = ref_frame + y_size;
+  const uint8_t* ref_v = ref_u + uv_size;
+  const uint8_t* test_u = test_frame + y_size;
+  const uint8_t* test_v = test_u + uv_size;
+
+  const uint64_t sse_y = SumSquaredError(ref_frame, test_frame, width, height);
+  const uint64_t sse_u = SumSquaredError(ref_u, test_u, half_width,
+                                         half_height);
+  const uint64_t sse_v = SumSquaredError(ref_v, test_v, half_width,
+                                         half_height);
+  metrics->psnr_y = SseToPsnr(sse_y, y_size);
+  metrics->psnr_u = SseToPsnr(sse_u, uv_size);
+  metrics->psnr_v = SseToPsnr(sse_v, uv_size);
+  metrics->psnr = SseToPsnr(sse_y + sse_u + sse_v, y_size + 2 * uv_size);
+
+  metrics->ssim_y =
+      CalculateSsim(ref_frame, width, test_frame, width, width, height).ssim;
+  metrics->ssim_u =
+      CalculateSsim(ref_u, half_width, test_u, half_width, half_width,
+                    half_height).ssim;
+  metrics->ssim_v =
+      CalculateSsim(ref_v, half_width, test_v, half_width, half_width,
+                    half_height).ssim;
+  metrics->ssim =
+      0.8 * metrics->ssim_y + 0.1 * (metrics->ssim_u + metrics->ssim_v);
+
+  metrics->ms_ssim_y = CalculateMsSsim(ref_frame, test_frame, width, height);
+  return true;
+}
+
+FrameMetricsCalculator::SsimResult FrameMetricsCalculator::CalculateSsim(
+    const uint8_t* ref,
+    int ref_stride,
+    const uint8_t* test,
+    int test_stride,
+    int width,
+    int height) {
+  // Windows start every 4 pixels, as long as they start more than 8 pixels
+  // from the right and bottom edges. Planes too small for a single window
+  // count as identical.
+  const int window_rows = height > 8 ? (height - 8 + 3) / 4 : 0;
+  const int window_cols = width > 8 ? (width - 8 + 3) / 4 : 0;
+  if (window_rows == 0 || window_cols == 0)
+    return {1.0, 1.0};
+  const int block_cols = window_cols + 1;
+  const int columns = 4 * block_cols;
+  for (int i = 0; i < 5; ++i) {
+    column_sums_[i].resize(columns);
+    block_sums_[0][i].resize(block_cols);
+    block_sums_[1][i].resize(block_cols);
+  }
+  uint32_t* const sum_a = column_sums_[0].data();
+  uint32_t* const sum_b = column_sums_[1].data();
+  uint32_t* const sum_aa = column_sums_[2].data();
+  uint32_t* const sum_bb = column_sums_[3].data();
+  uint32_t* const sum_ab = column_sums_[4].data();
+
+  double ssim_total = 0.0;
+  double contrast_structure_total = 0.0;
+  for (int block_row = 0; block_row <= window_rows; ++block_row) {
+    std::fill(sum_a, sum_a + columns, 0);
+    std::fill(sum_b, sum_b + columns, 0);
+    std::fill(sum_aa, sum_aa + columns, 0);
+    std::fill(sum_bb, sum_bb + columns, 0);
+    std::fill(sum_ab, sum_ab + columns, 0);
+    for (int y = 4 * block_row; y < 4 * block_row + 4; ++y) {
+      const uint8_t* a = ref + y * ref_stride;
+      const uint8_t* b = test + y * test_stride;
+      for (int x = 0; x < columns; ++x) {
+        const uint32_t pixel_a = a[x];
+        const uint32_t pixel_b = b[x];
+        sum_a[x] += pixel_a;
+        sum_b[x] += pixel_b;
+        sum_aa[x] += pixel_a * pixel_a;
+        sum_bb[x] += pixel_b * pixel_b;
+        sum_ab[x] += pixel_a * pixel_b;
+      }
+    }
+    std::vector<uint32_t>* blocks = block_sums_[block_row & 1];
+    for (int i = 0; i < 5; ++i) {
+      const uint32_t* column = column_sums_[i].data();
+      uint32_t* block = blocks[i].data();
+      for (int x = 0; x < block_cols; ++x) {
+        block[x] = column[4 * x] + column[4 * x + 1] + column[4 * x + 2] +
+                   column[4 * x + 3];
+      }
+    }
+    if (block_row == 0)
+      continue;
+
+    // Windows of the 2x2 blocks in this and the previous block row.
+    const std::vector<uint32_t>* previous = block_sums_[(block_row - 1) & 1];
+    int64_t window[5];
+    for (int x = 0; x < window_cols; ++x) {
+      for (int i = 0; i < 5; ++i) {
+        window[i] = static_cast<int64_t>(previous[i][x]) +
+                    previous[i][x + 1] + blocks[i][x] + blocks[i][x + 1];
+      }
+      const int64_t a_x_b = window[0] * window[1];
+      const int64_t a_sq = window[0] * window[0];
+      const int64_t b_sq = window[1] * window[1];
+      const int64_t luminance_n = 2 * a_x_b + kSsimC1;
+      const int64_t luminance_d = a_sq + b_sq + kSsimC1;
+      const int64_t contrast_structure_n =
+          2 * kWindowPixels * window[4] - 2 * a_x_b + kSsimC2;
+      const int64_t contrast_structure_d = kWindowPixels * window[2] - a_sq +
+                                           kWindowPixels * window[3] - b_sq +
+                                           kSsimC2;
+      ssim_total += (luminance_n * contrast_structure_n) * 1.0 /
+                    (luminance_d * contrast_structure_d);
+      contrast_structure_total +=
+          contrast_structure_n * 1.0 / contrast_structure_d;
+    }
+  }
+  const int windows = window_rows * window_cols;
+  return {ssim_total / windows, contrast_structure_total / windows};
+}
+
+double FrameMetricsCalculator::CalculateMsSsim(const uint8_t* ref,
+                                               const uint8_t* test,
+                                               int width,
+                                               int height) {
+  // Use as many scales as there are, up to 5, where the plane still fits a
+  // window, and renormalize the weights if there are fewer.
+  int scales = 1;
+  while (scales < kMaxMsSsimScales && (width >> scales) > 8 &&
+         (height >> scales) > 8) {
+    ++scales;
+  }
+  double weight_sum = 0.0;
+  for (int i = 0; i < scales; ++i)
+    weight_sum += kMsSsimWeights[i];
+
+  double ms_ssim = 1.0;
+  const uint8_t* scaled_ref = ref;
+  const uint8_t* scaled_test = test;
+  for (int scale = 0; scale < scales; ++scale) {
+    const int scaled_width = width >> scale;
+    const int scaled_height = height >> scale;
+    if (scale > 0) {
+      const int src_stride = width >> (scale - 1);
+      std::vector<uint8_t>& ref_buffer = scaled_ref_[scale & 1];
+      std::vector<uint8_t>& test_buffer = scaled_test_[scale & 1];
+      ref_buffer.resize(scaled_width * scaled_height);
+      test_buffer.resize(scaled_width * scaled_height);
+      Downscale(scaled_ref, src_stride, scaled_width, scaled_height,
+                ref_buffer.data());
+      Downscale(scaled_test, src_stride, scaled_width, scaled_height,
+                test_buffer.data());
+      scaled_ref = ref_buffer.data();
+      scaled_test = test_buffer.data();
+    }
+    const SsimResult result =
+        CalculateSsim(scaled_ref, scaled_width, scaled_test, scaled_width,
+                      scaled_width, scaled_height);
+    // Only the coarsest scale includes the luminance term. Negative
+    // correlation is clamped, as fractional powers of it aren't defined.
+    const double value =
+        scale == scales - 1 ? result.ssim : result.contrast_structure;
+    ms_ssim *= pow(std::max(value, 0.0), kMsSsimWeights[scale] / weight_sum);
+  }
+  return ms_ssim;
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_TOOLS_FRAME_ANALYZER_FRAME_METRICS_H_
+#define RTC_TOOLS_FRAME_ANALYZER_FRAME_METRICS_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace webrtc {
+namespace test {
+
+struct FrameMetrics {
+  // PSNR over all planes and per plane, capped at 48 like CalculateMetrics().
+  double psnr = 0.0;
+  double psnr_y = 0.0;
+  double psnr_u = 0.0;
+  double psnr_v = 0.0;
+  // SSIM weighted 0.8 for Y and 0.1 for U and V, which is what
+  // CalculateMetrics() returns, and the SSIM of each plane.
+  double ssim = 0.0;
+  double ssim_y = 0.0;
+  double ssim_u = 0.0;
+  double ssim_v = 0.0;
+  // Multi-scale SSIM of the Y plane, see
+  // Wang, Simoncelli, Bovik: "Multi-scale structural similarity for image
+  // quality assessment", 2003.
+  double ms_ssim_y = 0.0;
+};
+
+// Computes the PSNR, SSIM and MS-SSIM of two I420 frames. Holds the scratch
+// buffers needed for that, so that computing the metrics of a video doesn't
+// allocate for every frame. Use one instance per thread.
+//
+// SSIM is computed over 8x8 windows on a 4 pixel grid, like libyuv does, and
+// gives the same values. The window sums are built from sums over 4x4 blocks,
+// so that every pixel is only read once, in loops the compiler vectorizes.
+class FrameMetricsCalculator {
+ public:
+  FrameMetricsCalculator();
+  ~FrameMetricsCalculator();
+
+  // Returns false if |width| or |height| isn't positive.
+  bool Calculate(const uint8_t* ref_frame,
+                 const uint8_t* test_frame,
+                 int width,
+                 int height,
+                 FrameMetrics* metrics);
+
+ private:
+  struct SsimResult {
+    double ssim;
+    // Mean of the contrast and structure terms, without the luminance term.
+    double contrast_structure;
+  };
+
+  SsimResult CalculateSsim(const uint8_t* ref,
+                           int ref_stride,
+                           const uint8_t* test,
+                           int test_stride,
+                           int width,
+                           int height);
+  double CalculateMsSsim(const uint8_t* ref,
+                         const uint8_t* test,
+                         int width,
+                         int height);
+
+  // Sums over 4 rows for each column, and over 4x4 blocks for two rows of
+  // blocks: a, b, a * a, b * b and a * b.
+  std::vector<uint32_t> column_sums_[5];
+  std::vector<uint32_t> block_sums_[2][5];
+  // Downscaled planes for MS-SSIM.
+  std::vector<uint8_t> scaled_ref_[2];
+  std::vector<uint8_t> scaled_test_[2];
+};
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // RTC_TOOLS_FRAME_ANALYZER_FRAME_METRICS_H_
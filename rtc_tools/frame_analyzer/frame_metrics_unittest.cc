@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_tools/frame_analyzer/frame_metrics.h"
+
+#include <vector>
+
+#include "rtc_base/random.h"
+#include "rtc_tools/frame_analyzer/video_quality_analysis.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// A smooth gradient, so that there is structure for SSIM to compare.
+std::vector<uint8_t> CreateFrame(int width, int height) {
+  std::vector<uint8_t> frame(GetI420FrameSize(width, height));
+  for (size_t i = 0; i < frame.size(); ++i)
+    frame[i] = static_cast<uint8_t>((i % width) * 2 + (i / width) % 64);
+  return frame;
+}
+
+std::vector<uint8_t> AddNoise(const std::vector<uint8_t>& frame,
+                              int amplitude,
+                              Random* random) {
+  std::vector<uint8_t> noisy(frame);
+  for (uint8_t& pixel : noisy) {
+    const int value = pixel + random->Rand(-amplitude, amplitude);
+    pixel = static_cast<uint8_t>(std::min(255, std::max(0, value)));
+  }
+  return noisy;
+}
+
+}  // namespace
+
+TEST(FrameMetricsTest, IdenticalFrames) {
+  const std::vector<uint8_t> frame = CreateFrame(64, 48);
+  FrameMetricsCalculator calculator;
+  FrameMetrics metrics;
+  ASSERT_TRUE(
+      calculator.Calculate(frame.data(), frame.data(), 64, 48, &metrics));
+  EXPECT_EQ(48.0, metrics.psnr);
+  EXPECT_EQ(48.0, metrics.psnr_y);
+  EXPECT_EQ(48.0, metrics.psnr_u);
+  EXPECT_EQ(48.0, metrics.psnr_v);
+  EXPECT_DOUBLE_EQ(1.0, metrics.ssim);
+  EXPECT_DOUBLE_EQ(1.0, metrics.ssim_y);
+  EXPECT_DOUBLE_EQ(1.0, metrics.ms_ssim_y);
+}
+
+TEST(FrameMetricsTest, RejectsInvalidSize) {
+  const uint8_t frame[6] = {};
+  FrameMetricsCalculator calculator;
+  FrameMetrics metrics;
+  EXPECT_FALSE(calculator.Calculate(frame, frame, 0, 4, &metrics));
+  EXPECT_FALSE(calculator.Calculate(frame, frame, 4, -1, &metrics));
+}
+
+TEST(FrameMetricsTest, MatchesCalculateMetrics) {
+  Random random(0x55);
+  FrameMetricsCalculator calculator;
+  // Odd sizes too, where not all pixels are covered by SSIM windows.
+  const int kSizes[][2] = {{352, 288}, {101, 67}, {26, 18}, {640, 360}};
+  for (const auto& size : kSizes) {
+    const int width = size[0];
+    const int height = size[1];
+    const std::vector<uint8_t> ref = CreateFrame(width, height);
+    const std::vector<uint8_t> test = AddNoise(ref, 20, &random);
+    FrameMetrics metrics;
+    ASSERT_TRUE(calculator.Calculate(ref.data(), test.data(), width, height,
+                                     &metrics));
+    EXPECT_NEAR(
+        CalculateMetrics(kPSNR, ref.data(), test.data(), width, height),
+        metrics.psnr, 1e-9);
+    EXPECT_NEAR(
+        CalculateMetrics(kSSIM, ref.data(), test.data(), width, height),
+        metrics.ssim, 1e-9);
+  }
+}
+
+TEST(FrameMetricsTest, MetricsDecreaseWithNoise) {
+  const int kWidth = 320;
+  const int kHeight = 240;
+  Random random(0x66);
+  const std::vector<uint8_t> ref = CreateFrame(kWidth, kHeight);
+  FrameMetricsCalculator calculator;
+  FrameMetrics previous;
+  ASSERT_TRUE(calculator.Calculate(ref.data(), ref.data(), kWidth, kHeight,
+                                   &previous));
+  for (int amplitude : {2, 8, 32}) {
+    const std::vector<uint8_t> test = AddNoise(ref, amplitude, &random);
+    FrameMetrics metrics;
+    ASSERT_TRUE(calculator.Calculate(ref.data(), test.data(), kWidth, kHeight,
+                                     &metrics));
+    EXPECT_LT(metrics.psnr_y, previous.psnr_y);
+    EXPECT_LT(metrics.psnr_u, previous.psnr_u);
+    EXPECT_LT(metrics.psnr_v, previous.psnr_v);
+    EXPECT_LT(metrics.ssim_y, previous.ssim_y);
+    EXPECT_LT(metrics.ms_ssim_y, previous.ms_ssim_y);
+    EXPECT_GT(metrics.ms_ssim_y, 0.0);
+    previous = metrics;
+  }
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -0,0 +1,227 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_tools/frame_analyzer/video_comparison.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/format_macros.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
+#include "rtc_tools/frame_analyzer/video_quality_analysis.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+const char kY4mFileSignature[] = "YUV4MPEG2";
+const char kY4mFrameSignature[] = "FRAME";
+
+// State shared by the threads of CompareVideoFiles().
+struct ComparisonState {
+  rtc::CriticalSection crit;
+  I420FileReader reference RTC_GUARDED_BY(crit);
+  I420FileReader test RTC_GUARDED_BY(crit);
+  int next_frame RTC_GUARDED_BY(crit) = 0;
+  bool done RTC_GUARDED_BY(crit) = false;
+};
+
+class ComparisonWorker {
+ public:
+  ComparisonWorker(ComparisonState* state, int width, int height)
+      : state_(state),
+        width_(width),
+        height_(height),
+        reference_frame_(new uint8_t[GetI420FrameSize(width, height)]),
+        test_frame_(new uint8_t[GetI420FrameSize(width, height)]) {}
+
+  static void Run(void* obj) { static_cast<ComparisonWorker*>(obj)->Run(); }
+
+  void Run() {
+    while (true) {
+      int frame;
+      {
+        rtc::CritScope lock(&state_->crit);
+        if (state_->done)
+          return;
+        if (!state_->reference.ReadFrame(reference_frame_.get()) ||
+            !state_->test.ReadFrame(test_frame_.get())) {
+          state_->done = true;
+          return;
+        }
+        frame = state_->next_frame++;
+      }
+      FrameMetrics metrics;
+      calculator_.Calculate(reference_frame_.get(), test_frame_.get(), width_,
+                            height_, &metrics);
+      results_.emplace_back(frame, metrics);
+    }
+  }
+
+  const std::vector<std::pair<int, FrameMetrics>>& results() const {
+    return results_;
+  }
+
+ private:
+  ComparisonState* const state_;
+  const int width_;
+  const int height_;
+  std::unique_ptr<uint8_t[]> reference_frame_;
+  std::unique_ptr<uint8_t[]> test_frame_;
+  FrameMetricsCalculator calculator_;
+  std::vector<std::pair<int, FrameMetrics>> results_;
+};
+
+}  // namespace
+
+I420FileReader::I420FileReader()
+    : file_(nullptr), y4m_(false), frame_size_(0) {}
+
+I420FileReader::~I420FileReader() {
+  Close();
+}
+
+bool I420FileReader::Open(const std::string& file_name,
+                          int width,
+                          int height) {
+  Close();
+  file_ = fopen(file_name.c_str(), "rb");
+  if (!file_) {
+    fprintf(stderr, "Couldn't open input file for reading: %s\n",
+            file_name.c_str());
+    return false;
+  }
+  frame_size_ = GetI420FrameSize(width, height);
+
+  // The Y4M file header is a line like
+  // "YUV4MPEG2 C420 W640 H360 Ip F30:1 A1:1".
+  char signature[sizeof(kY4mFileSignature) - 1];
+  y4m_ = fread(signature, 1, sizeof(signature), file_) == sizeof(signature) &&
+         memcmp(signature, kY4mFileSignature, sizeof(signature)) == 0;
+  if (y4m_) {
+    if (!SkipLine()) {
+      Close();
+      return false;
+    }
+  } else {
+    rewind(file_);
+  }
+  return true;
+}
+
+void I420FileReader::Close() {
+  if (file_)
+    fclose(file_);
+  file_ = nullptr;
+}
+
+bool I420FileReader::ReadFrame(uint8_t* frame) {
+  if (!file_)
+    return false;
+  if (y4m_) {
+    // Every frame starts with a "FRAME" line, which may have parameters.
+    char signature[sizeof(kY4mFrameSignature) - 1];
+    if (fread(signature, 1, sizeof(signature), file_) != sizeof(signature) ||
+        memcmp(signature, kY4mFrameSignature, sizeof(signature)) != 0 ||
+        !SkipLine()) {
+      return false;
+    }
+  }
+  return fread(frame, 1, frame_size_, file_) == frame_size_;
+}
+
+bool I420FileReader::SkipLine() {
+  int c;
+  do {
+    c = getc(file_);
+  } while (c != '\n' && c != EOF);
+  return c == '\n';
+}
+
+bool CompareVideoFiles(const std::string& reference_file_name,
+                       const std::string& test_file_name,
+                       int width,
+                       int height,
+                       int num_threads,
+                       std::vector<FrameMetrics>* metrics) {
+  metrics->clear();
+  if (width <= 0 || height <= 0)
+    return false;
+  ComparisonState state;
+  {
+    rtc::CritScope lock(&state.crit);
+    if (!state.reference.Open(reference_file_name, width, height) ||
+        !state.test.Open(test_file_name, width, height)) {
+      return false;
+    }
+  }
+
+  std::vector<std::unique_ptr<ComparisonWorker>> workers;
+  for (int i = 0; i < std::max(num_threads, 1); ++i)
+    workers.emplace_back(new ComparisonWorker(&state, width, height));
+  if (workers.size() == 1) {
+    workers[0]->Run();
+  } else {
+    std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+    for (const auto& worker : workers) {
+      threads.emplace_back(new rtc::PlatformThread(
+          &ComparisonWorker::Run, worker.get(), "VideoComparison"));
+      threads.back()->Start();
+    }
+    for (const auto& thread : threads)
+      thread->Stop();
+  }
+
+  // Each frame was compared by exactly one worker.
+  for (const auto& worker : workers) {
+    for (const auto& result : worker->results()) {
+      if (metrics->size() <= static_cast<size_t>(result.first))
+        metrics->resize(result.first + 1);
+      (*metrics)[result.first] = result.second;
+    }
+  }
+  return true;
+}
+
+void PrintFrameMetricsCsv(FILE* output,
+                          const std::vector<FrameMetrics>& metrics) {
+  fprintf(output,
+          "frame,psnr,psnr_y,psnr_u,psnr_v,ssim,ssim_y,ssim_u,ssim_v,"
+          "ms_ssim_y\n");
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const FrameMetrics& m = metrics[i];
+    fprintf(output, "%" PRIuS ",%f,%f,%f,%f,%f,%f,%f,%f,%f\n", i, m.psnr,
+            m.psnr_y, m.psnr_u, m.psnr_v, m.ssim, m.ssim_y, m.ssim_u, m.ssim_v,
+            m.ms_ssim_y);
+  }
+}
+
+void PrintFrameMetricsJson(FILE* output,
+                           const std::vector<FrameMetrics>& metrics) {
+  fprintf(output, "[");
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const FrameMetrics& m = metrics[i];
+    fprintf(output,
+            "%s\n  {\"frame\": %" PRIuS ", \"psnr\": %f, \"psnr_y\": %f, "
+            "\"psnr_u\": %f, \"psnr_v\": %f, \"ssim\": %f, \"ssim_y\": %f, "
+            "\"ssim_u\": %f, \"ssim_v\": %f, \"ms_ssim_y\": %f}",
+            i > 0 ? "," : "", i, m.psnr, m.psnr_y, m.psnr_u, m.psnr_v, m.ssim,
+            m.ssim_y, m.ssim_u, m.ssim_v, m.ms_ssim_y);
+  }
+  fprintf(output, "\n]\n");
+}
+
+}  // namespace test
+}  // namespace webrtc
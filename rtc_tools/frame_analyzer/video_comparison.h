@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_TOOLS_FRAME_ANALYZER_VIDEO_COMPARISON_H_
+#define RTC_TOOLS_FRAME_ANALYZER_VIDEO_COMPARISON_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "rtc_base/constructormagic.h"
+#include "rtc_tools/frame_analyzer/frame_metrics.h"
+
+namespace webrtc {
+namespace test {
+
+// Reads the I420 frames of a raw YUV or a Y4M file one after the other from
+// one open file, instead of opening the file and seeking to the frame for
+// every frame like ExtractFrameFromYuvFile() does. Y4M files are recognized
+// by their header.
+class I420FileReader {
+ public:
+  I420FileReader();
+  ~I420FileReader();
+
+  bool Open(const std::string& file_name, int width, int height);
+  void Close();
+
+  // Reads the next frame into |frame|, which must have room for
+  // GetI420FrameSize() bytes. Returns false at the end of the file.
+  bool ReadFrame(uint8_t* frame);
+
+ private:
+  // Skips the rest of the current line.
+  bool SkipLine();
+
+  FILE* file_;
+  bool y4m_;
+  size_t frame_size_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(I420FileReader);
+};
+
+// Computes the FrameMetrics of each frame of |test_file_name| against the
+// frame at the same position in |reference_file_name|, until either file
+// runs out of frames. Frames are read by |num_threads| threads taking turns,
+// and each thread computes the metrics of the frames it read while the
+// others read theirs. Returns false if a file can't be opened.
+bool CompareVideoFiles(const std::string& reference_file_name,
+                       const std::string& test_file_name,
+                       int width,
+                       int height,
+                       int num_threads,
+                       std::vector<FrameMetrics>* metrics);
+
+// Writes |metrics| as CSV, with a header line, or as a JSON array of objects
+// with one object per frame.
+void PrintFrameMetricsCsv(FILE* output,
+                          const std::vector<FrameMetrics>& metrics);
+void PrintFrameMetricsJson(FILE* output,
+                           const std::vector<FrameMetrics>& metrics);
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // RTC_TOOLS_FRAME_ANALYZER_VIDEO_COMPARISON_H_
@@ -0,0 +1,192 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_tools/frame_analyzer/video_comparison.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "rtc_base/random.h"
+#include "rtc_base/timeutils.h"
+#include "rtc_tools/frame_analyzer/video_quality_analysis.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "test/gtest.h"
+#include "test/testsupport/fileutils.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+const int kWidth = 176;
+const int kHeight = 144;
+
+std::vector<uint8_t> CreateFrame(int width, int height, Random* random) {
+  std::vector<uint8_t> frame(GetI420FrameSize(width, height));
+  const int offset = random->Rand(0, 255);
+  for (size_t i = 0; i < frame.size(); ++i) {
+    frame[i] = static_cast<uint8_t>((i % width) + (i / width) % 32 + offset +
+                                    random->Rand(0, 7));
+  }
+  return frame;
+}
+
+class VideoComparisonTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    for (const std::string& file_name : file_names_)
+      remove(file_name.c_str());
+  }
+
+  // Writes |num_frames| random frames, as Y4M if |y4m| is true and as raw
+  // YUV otherwise.
+  std::string WriteFile(int width,
+                        int height,
+                        int num_frames,
+                        bool y4m,
+                        Random* random) {
+    file_names_.push_back(TempFilename(OutputPath(), "video_comparison"));
+    FILE* file = fopen(file_names_.back().c_str(), "wb");
+    EXPECT_TRUE(file);
+    if (y4m)
+      fprintf(file, "YUV4MPEG2 W%d H%d F30:1 C420\n", width, height);
+    for (int i = 0; i < num_frames; ++i) {
+      // Frame headers may have parameters.
+      if (y4m)
+        fprintf(file, i % 2 ? "FRAME\n" : "FRAME Ip\n");
+      const std::vector<uint8_t> frame = CreateFrame(width, height, random);
+      fwrite(frame.data(), 1, frame.size(), file);
+    }
+    fclose(file);
+    return file_names_.back();
+  }
+
+  std::vector<std::string> file_names_;
+};
+
+}  // namespace
+
+TEST_F(VideoComparisonTest, I420FileReaderReadsYuvAndY4m) {
+  Random random(0x10);
+  const std::string yuv_file = WriteFile(kWidth, kHeight, 3, false, &random);
+  const std::string y4m_file = WriteFile(kWidth, kHeight, 3, true, &random);
+  for (const std::string& file_name : {yuv_file, y4m_file}) {
+    std::vector<uint8_t> frame(GetI420FrameSize(kWidth, kHeight));
+    std::vector<uint8_t> expected_frame(frame.size());
+    I420FileReader reader;
+    ASSERT_TRUE(reader.Open(file_name, kWidth, kHeight));
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(reader.ReadFrame(frame.data()));
+      if (file_name == yuv_file) {
+        ASSERT_TRUE(ExtractFrameFromYuvFile(file_name.c_str(), kWidth,
+                                            kHeight, i,
+                                            expected_frame.data()));
+        EXPECT_EQ(expected_frame, frame);
+      }
+    }
+    EXPECT_FALSE(reader.ReadFrame(frame.data()));
+  }
+}
+
+TEST_F(VideoComparisonTest, ComparesUntilShortestFileEnds) {
+  Random random(0x20);
+  const std::string reference = WriteFile(kWidth, kHeight, 10, true, &random);
+  const std::string test = WriteFile(kWidth, kHeight, 7, false, &random);
+
+  // Compute the expected metrics one frame at a time.
+  std::vector<FrameMetrics> expected;
+  I420FileReader reference_reader;
+  I420FileReader test_reader;
+  ASSERT_TRUE(reference_reader.Open(reference, kWidth, kHeight));
+  ASSERT_TRUE(test_reader.Open(test, kWidth, kHeight));
+  std::vector<uint8_t> reference_frame(GetI420FrameSize(kWidth, kHeight));
+  std::vector<uint8_t> test_frame(reference_frame.size());
+  FrameMetricsCalculator calculator;
+  while (reference_reader.ReadFrame(reference_frame.data()) &&
+         test_reader.ReadFrame(test_frame.data())) {
+    expected.emplace_back();
+    calculator.Calculate(reference_frame.data(), test_frame.data(), kWidth,
+                         kHeight, &expected.back());
+  }
+  ASSERT_EQ(7u, expected.size());
+
+  for (int num_threads : {1, 3, 8}) {
+    std::vector<FrameMetrics> metrics;
+    ASSERT_TRUE(CompareVideoFiles(reference, test, kWidth, kHeight,
+                                  num_threads, &metrics));
+    ASSERT_EQ(expected.size(), metrics.size());
+    for (size_t i = 0; i < metrics.size(); ++i) {
+      EXPECT_EQ(expected[i].psnr, metrics[i].psnr);
+      EXPECT_EQ(expected[i].ssim, metrics[i].ssim);
+      EXPECT_EQ(expected[i].ms_ssim_y, metrics[i].ms_ssim_y);
+    }
+  }
+}
+
+TEST_F(VideoComparisonTest, FailsOnMissingFile) {
+  Random random(0x30);
+  const std::string test = WriteFile(kWidth, kHeight, 1, false, &random);
+  std::vector<FrameMetrics> metrics;
+  EXPECT_FALSE(CompareVideoFiles(OutputPath() + "does_not_exist.yuv", test,
+                                 kWidth, kHeight, 2, &metrics));
+  EXPECT_TRUE(metrics.empty());
+}
+
+TEST_F(VideoComparisonTest, DISABLED_ComparisonThroughput) {
+  const int kHdWidth = 1280;
+  const int kHdHeight = 720;
+  const int kNumFrames = 40;
+  Random random(0x40);
+  const std::string reference =
+      WriteFile(kHdWidth, kHdHeight, kNumFrames, true, &random);
+  const std::string test =
+      WriteFile(kHdWidth, kHdHeight, kNumFrames, false, &random);
+
+  // What psnr_ssim_analyzer did before: each frame extracted from the files
+  // and its PSNR and SSIM computed with libyuv.
+  std::vector<uint8_t> reference_frame(GetI420FrameSize(kHdWidth, kHdHeight));
+  std::vector<uint8_t> test_frame(reference_frame.size());
+  int64_t start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumFrames; ++i) {
+    ExtractFrameFromY4mFile(reference.c_str(), kHdWidth, kHdHeight, i,
+                            reference_frame.data());
+    ExtractFrameFromYuvFile(test.c_str(), kHdWidth, kHdHeight, i,
+                            test_frame.data());
+    CalculateMetrics(kPSNR, reference_frame.data(), test_frame.data(),
+                     kHdWidth, kHdHeight);
+    CalculateMetrics(kSSIM, reference_frame.data(), test_frame.data(),
+                     kHdWidth, kHdHeight);
+  }
+  int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+  PrintResult("video_comparison_720p", "", "extract_and_calculate_metrics",
+              kNumFrames * 1e9 / elapsed_ns, "fps", false);
+
+  std::vector<int> thread_counts = {1};
+  const int num_cores = CpuInfo::DetectNumberOfCores();
+  if (num_cores > 1)
+    thread_counts.push_back(num_cores);
+  for (int num_threads : thread_counts) {
+    std::vector<FrameMetrics> metrics;
+    start_ns = rtc::TimeNanos();
+    ASSERT_TRUE(CompareVideoFiles(reference, test, kHdWidth, kHdHeight,
+                                  num_threads, &metrics));
+    elapsed_ns = rtc::TimeNanos() - start_ns;
+    ASSERT_EQ(static_cast<size_t>(kNumFrames), metrics.size());
+    PrintResult("video_comparison_720p",
+                "_" + std::to_string(num_threads) + "_threads",
+                "compare_video_files", kNumFrames * 1e9 / elapsed_ns, "fps",
+                false);
+  }
+}
+
+}  // namespace test
+}  // namespace webrtc
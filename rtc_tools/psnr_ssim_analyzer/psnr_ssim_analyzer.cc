@@ -8,60 +8,43 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
-#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <map>
 #include <string>
 #include <vector>
 
-#include "rtc_tools/frame_analyzer/video_quality_analysis.h"
+#include "rtc_tools/frame_analyzer/video_comparison.h"
 #include "rtc_tools/simple_command_line_parser.h"
-
-#define MAX_NUM_FRAMES_PER_FILE INT_MAX
-
-void CompareFiles(const char* reference_file_name, const char* test_file_name,
-                  const char* results_file_name, int width, int height) {
-  // Check if the reference_file_name ends with "y4m".
-  bool y4m_mode = false;
-  if (std::string(reference_file_name).find("y4m") != std::string::npos) {
-    y4m_mode = true;
+#include "system_wrappers/include/cpu_info.h"
+
+bool CompareFiles(const char* reference_file_name, const char* test_file_name,
+                  const char* results_file_name, int width, int height,
+                  int num_threads, const std::string& format) {
+  std::vector<webrtc::test::FrameMetrics> metrics;
+  if (!webrtc::test::CompareVideoFiles(reference_file_name, test_file_name,
+                                       width, height, num_threads, &metrics)) {
+    return false;
   }
 
   FILE* results_file = fopen(results_file_name, "w");
-
-  int size = webrtc::test::GetI420FrameSize(width, height);
-
-  // Allocate buffers for test and reference frames.
-  uint8_t* test_frame = new uint8_t[size];
-  uint8_t* ref_frame = new uint8_t[size];
-
-  bool read_result = true;
-  for (int frame_counter = 0; frame_counter < MAX_NUM_FRAMES_PER_FILE;
-      ++frame_counter) {
-    read_result &= (y4m_mode) ? webrtc::test::ExtractFrameFromY4mFile(
-        reference_file_name, width, height, frame_counter, ref_frame):
-        webrtc::test::ExtractFrameFromYuvFile(reference_file_name, width,
-                                              height, frame_counter, ref_frame);
-    read_result &=  webrtc::test::ExtractFrameFromYuvFile(test_file_name, width,
-        height, frame_counter, test_frame);
-
-    if (!read_result)
-      break;
-
-    // Calculate the PSNR and SSIM.
-    double result_psnr = webrtc::test::CalculateMetrics(
-        webrtc::test::kPSNR, ref_frame, test_frame, width, height);
-    double result_ssim = webrtc::test::CalculateMetrics(
-        webrtc::test::kSSIM, ref_frame, test_frame, width, height);
-    fprintf(results_file, "Frame: %d, PSNR: %f, SSIM: %f\n", frame_counter,
-            result_psnr, result_ssim);
+  if (!results_file) {
+    fprintf(stderr, "Couldn't open results file for writing: %s\n",
+            results_file_name);
+    return false;
+  }
+  if (format == "csv") {
+    webrtc::test::PrintFrameMetricsCsv(results_file, metrics);
+  } else if (format == "json") {
+    webrtc::test::PrintFrameMetricsJson(results_file, metrics);
+  } else {
+    for (size_t i = 0; i < metrics.size(); ++i) {
+      fprintf(results_file, "Frame: %d, PSNR: %f, SSIM: %f\n",
+              static_cast<int>(i), metrics[i].psnr, metrics[i].ssim);
+    }
   }
-  delete[] test_frame;
-  delete[] ref_frame;
-
   fclose(results_file);
+  return true;
 }
 
 /*
@@ -78,7 +61,7 @@ void CompareFiles(const char* reference_file_name, const char* test_file_name,
  * Usage:
  * psnr_ssim_analyzer --reference_file=<name_of_file> --test_file=<name_of_file>
  * --results_file=<name_of_file> --width=<width_of_frames>
- * --height=<height_of_frames>
+ * --height=<height_of_frames> [--num_threads=<threads>] [--format=<format>]
  */
 int main(int argc, char* argv[]) {
   std::string program_name = argv[0];
@@ -96,7 +79,11 @@ int main(int argc, char* argv[]) {
       "  - test_file(string): The test YUV file to run the analysis for."
       " Default: test_file.yuv\n"
       "  - results_file(string): The full name of the file where the results "
-      "will be written. Default: results.txt\n";
+      "will be written. Default: results.txt\n"
+      "  - num_threads(int): The number of threads comparing frames. "
+      "Default: 0, meaning one per core\n"
+      "  - format(string): The format of the results file, text, csv or json."
+      " Default: text\n";
 
   webrtc::test::CommandLineParser parser;
 
@@ -110,6 +97,8 @@ int main(int argc, char* argv[]) {
   parser.SetFlag("reference_file", "ref.yuv");
   parser.SetFlag("test_file", "test.yuv");
   parser.SetFlag("results_file", "results.txt");
+  parser.SetFlag("num_threads", "0");
+  parser.SetFlag("format", "text");
   parser.SetFlag("help", "false");
 
   parser.ProcessFlags();
@@ -127,8 +116,21 @@ int main(int argc, char* argv[]) {
     return -1;
   }
 
-  CompareFiles(parser.GetFlag("reference_file").c_str(),
-               parser.GetFlag("test_file").c_str(),
-               parser.GetFlag("results_file").c_str(), width, height);
+  int num_threads = strtol((parser.GetFlag("num_threads")).c_str(), NULL, 10);
+  if (num_threads <= 0)
+    num_threads = webrtc::CpuInfo::DetectNumberOfCores();
+
+  const std::string format = parser.GetFlag("format");
+  if (format != "text" && format != "csv" && format != "json") {
+    fprintf(stderr, "Error: format must be text, csv or json!\n");
+    return -1;
+  }
+
+  if (!CompareFiles(parser.GetFlag("reference_file").c_str(),
+                    parser.GetFlag("test_file").c_str(),
+                    parser.GetFlag("results_file").c_str(), width, height,
+                    num_threads, format)) {
+    return -1;
+  }
   return 0;
 }
@@ -18,6 +18,11 @@ namespace field_trial {
 // This method can be called at most once before any other call into webrtc.
 // E.g. before the peer connection factory is constructed.
 // Note: trials_string must never be destroyed.
+// The string is parsed here, so that looking up a trial doesn't parse it
+// again. Calls must not be concurrent with each other, but may be concurrent
+// with field trial lookups on other threads, e.g. when test::ScopedFieldTrials
+// replaces the trials. The previous trials are freed once those lookups are
+// done.
 void InitFieldTrialsFromString(const char* trials_string);
 
 const char* GetFieldTrialString();
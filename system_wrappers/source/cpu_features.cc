@@ -13,6 +13,7 @@
 #include "system_wrappers/include/cpu_features_wrapper.h"
 
 #if defined(WEBRTC_ARCH_X86_FAMILY) && defined(_MSC_VER)
+#include <immintrin.h>
 #include <intrin.h>
 #endif
 
@@ -28,24 +29,39 @@ int GetCPUInfoNoASM(CPUFeature feature) {
 #ifndef _MSC_VER
 // Intrinsic for "cpuid".
 #if defined(__pic__) && defined(__i386__)
-static inline void __cpuid(int cpu_info[4], int info_type) {
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
   __asm__ volatile(
       "mov %%ebx, %%edi\n"
       "cpuid\n"
       "xchg %%edi, %%ebx\n"
       : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]),
         "=d"(cpu_info[3])
-      : "a"(info_type));
+      : "a"(info_type), "c"(sub_type));
 }
 #else
-static inline void __cpuid(int cpu_info[4], int info_type) {
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
   __asm__ volatile("cpuid\n"
                    : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]),
                      "=d"(cpu_info[3])
-                   : "a"(info_type));
+                   : "a"(info_type), "c"(sub_type));
 }
 #endif
+static inline void __cpuid(int cpu_info[4], int info_type) {
+  __cpuidex(cpu_info, info_type, 0);
+}
 #endif  // _MSC_VER
+
+// Returns the XCR0 register, which tells which register states the OS saves.
+static inline uint64_t GetXCR0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  // "xgetbv", which older assemblers don't know by name.
+  uint32_t eax, edx;
+  __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
 #endif  // WEBRTC_ARCH_X86_FAMILY
 
 #if defined(WEBRTC_ARCH_X86_FAMILY)
@@ -59,6 +75,18 @@ static int GetCPUInfo(CPUFeature feature) {
   if (feature == kSSE3) {
     return 0 != (cpu_info[2] & 0x00000001);
   }
+  if (feature == kAVX2) {
+    // The OS must save the YMM registers (OSXSAVE and XCR0 bits 1 and 2) and
+    // the CPU must support AVX before the AVX2 bit can be trusted.
+    if ((cpu_info[2] & 0x18000000) != 0x18000000 || (GetXCR0() & 6) != 6)
+      return 0;
+    int cpu_info7[4];
+    __cpuid(cpu_info7, 0);
+    if (cpu_info7[0] < 7)
+      return 0;
+    __cpuidex(cpu_info7, 7, 0);
+    return 0 != (cpu_info7[1] & 0x00000020);
+  }
   return 0;
 }
 #else
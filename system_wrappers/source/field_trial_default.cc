@@ -10,23 +10,38 @@
 #include "system_wrappers/include/field_trial_default.h"
 #include "system_wrappers/include/field_trial.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "rtc_base/rcu_snapshot.h"
 
 // Simple field trial implementation, which allows client to
 // specify desired flags in InitFieldTrialsFromString.
 namespace webrtc {
 namespace field_trial {
 
-static const char* trials_init_string = NULL;
+namespace {
+// Name/value pairs of the string given to InitFieldTrialsFromString.
+typedef std::unordered_map<std::string, std::string> FieldTrialMap;
 
-std::string FindFullName(const std::string& name) {
-  if (trials_init_string == NULL)
-    return std::string();
+struct FieldTrials {
+  const char* init_string = NULL;
+  // Parsed from |init_string|, so that lookups don't parse it again.
+  std::unique_ptr<const FieldTrialMap> map;
+};
 
-  std::string trials_string(trials_init_string);
-  if (trials_string.empty())
-    return std::string();
+// Lookups may run on other threads while the trials are reinitialized, so the
+// trials are replaced with read-copy-update. Never destroyed, since lookups
+// may run until the process exits.
+rtc::RcuSnapshot<FieldTrials>* CurrentTrials() {
+  static auto* const current_trials = new rtc::RcuSnapshot<FieldTrials>();
+  return current_trials;
+}
 
+FieldTrialMap* ParseFieldTrials(const std::string& trials_string) {
+  FieldTrialMap* trials = new FieldTrialMap();
   static const char kPersistentStringSeparator = '/';
   size_t next_item = 0;
   while (next_item < trials_string.length()) {
@@ -46,19 +61,37 @@ std::string FindFullName(const std::string& name) {
                             field_value_end - field_name_end - 1);
     next_item = field_value_end + 1;
 
-    if (name == field_name)
-      return field_value;
+    // The first value of a name is used.
+    trials->emplace(std::move(field_name), std::move(field_value));
   }
-  return std::string();
+  return trials;
+}
+}  // namespace
+
+std::string FindFullName(const std::string& name) {
+  rtc::RcuSnapshot<FieldTrials>::ReadScope trials(CurrentTrials());
+  if (!trials->map)
+    return std::string();
+
+  const auto it = trials->map->find(name);
+  if (it == trials->map->end())
+    return std::string();
+  return it->second;
 }
 
 // Optionally initialize field trial from a string.
 void InitFieldTrialsFromString(const char* trials_string) {
-  trials_init_string = trials_string;
+  std::unique_ptr<FieldTrials> new_trials(new FieldTrials());
+  new_trials->init_string = trials_string;
+  if (trials_string)
+    new_trials->map.reset(ParseFieldTrials(trials_string));
+  // Waits for the lookups in the previous trials, and deletes them.
+  CurrentTrials()->Publish(std::move(new_trials));
 }
 
 const char* GetFieldTrialString() {
-  return trials_init_string;
+  rtc::RcuSnapshot<FieldTrials>::ReadScope trials(CurrentTrials());
+  return trials->init_string;
 }
 
 }  // namespace field_trial
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "system_wrappers/include/field_trial_default.h"
+
+#include <string>
+
+#include "rtc_base/atomicops.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/field_trial.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace field_trial {
+
+namespace {
+struct Lookups {
+  volatile int done = 0;
+  int num_unexpected = 0;
+};
+
+void LookUpUntilDone(void* obj) {
+  Lookups* lookups = static_cast<Lookups*>(obj);
+  while (!rtc::AtomicOps::AcquireLoad(&lookups->done)) {
+    const std::string value = FindFullName("WebRTC-A");
+    if (value != "" && value != "Enabled" && value != "Disabled")
+      ++lookups->num_unexpected;
+  }
+}
+}  // namespace
+
+class FieldTrialDefaultTest : public ::testing::Test {
+ protected:
+  FieldTrialDefaultTest() : previous_trials_(GetFieldTrialString()) {}
+  ~FieldTrialDefaultTest() override {
+    InitFieldTrialsFromString(previous_trials_);
+  }
+
+ private:
+  const char* const previous_trials_;
+};
+
+TEST_F(FieldTrialDefaultTest, NotInitialized) {
+  InitFieldTrialsFromString(nullptr);
+  EXPECT_EQ(nullptr, GetFieldTrialString());
+  EXPECT_EQ("", FindFullName("WebRTC-Trial"));
+}
+
+TEST_F(FieldTrialDefaultTest, FindsTrials) {
+  const char kTrials[] = "WebRTC-A/Enabled/WebRTC-B/Disabled-100/";
+  InitFieldTrialsFromString(kTrials);
+  EXPECT_EQ(kTrials, GetFieldTrialString());
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-A"));
+  EXPECT_EQ("Disabled-100", FindFullName("WebRTC-B"));
+  EXPECT_EQ("", FindFullName("WebRTC-C"));
+  EXPECT_EQ("", FindFullName("Enabled"));
+}
+
+TEST_F(FieldTrialDefaultTest, UsesFirstValueOfTrial) {
+  InitFieldTrialsFromString("WebRTC-A/First/WebRTC-A/Second/");
+  EXPECT_EQ("First", FindFullName("WebRTC-A"));
+}
+
+TEST_F(FieldTrialDefaultTest, StopsAtInvalidTrial) {
+  InitFieldTrialsFromString("WebRTC-A/Enabled//Empty/WebRTC-B/Enabled/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-A"));
+  EXPECT_EQ("", FindFullName("WebRTC-B"));
+
+  InitFieldTrialsFromString("WebRTC-A/Enabled/WebRTC-B/Enabled");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-A"));
+  EXPECT_EQ("", FindFullName("WebRTC-B"));
+}
+
+TEST_F(FieldTrialDefaultTest, ReinitializingReplacesTrials) {
+  InitFieldTrialsFromString("WebRTC-A/Enabled/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-A"));
+  InitFieldTrialsFromString("WebRTC-B/Enabled/");
+  EXPECT_EQ("", FindFullName("WebRTC-A"));
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-B"));
+}
+
+TEST_F(FieldTrialDefaultTest, LooksUpWhileReinitializing) {
+  Lookups lookups;
+  rtc::PlatformThread thread(&LookUpUntilDone, &lookups, "Lookups");
+  thread.Start();
+  for (int i = 0; i < 1000; ++i) {
+    InitFieldTrialsFromString("WebRTC-A/Enabled/WebRTC-B/Enabled/");
+    InitFieldTrialsFromString(nullptr);
+    InitFieldTrialsFromString("WebRTC-A/Disabled/");
+  }
+  rtc::AtomicOps::ReleaseStore(&lookups.done, 1);
+  thread.Stop();
+  EXPECT_EQ(0, lookups.num_unexpected);
+  EXPECT_EQ("Disabled", FindFullName("WebRTC-A"));
+}
+
+// Like the lookups in the constructors of each stream, with a trial string
+// of typical length.
+TEST_F(FieldTrialDefaultTest, DISABLED_LookupCost) {
+  const int kNumTrials = 30;
+  const int kNumLookups = 100000;
+  std::string trials;
+  for (int i = 0; i < kNumTrials; ++i)
+    trials += "WebRTC-Trial" + std::to_string(i) + "/Enabled-" +
+              std::to_string(i) + "/";
+  InitFieldTrialsFromString(trials.c_str());
+
+  const std::string kLast = "WebRTC-Trial" + std::to_string(kNumTrials - 1);
+  const std::string kMissing = "WebRTC-Missing";
+  size_t total_size = 0;
+  const int64_t start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumLookups; ++i) {
+    total_size += FindFullName(kLast).size();
+    total_size += FindFullName(kMissing).size();
+  }
+  const int64_t elapsed_ns = rtc::TimeNanos() - start_ns;
+  EXPECT_EQ(kNumLookups * (std::string("Enabled-") +
+                           std::to_string(kNumTrials - 1)).size(),
+            total_size);
+  test::PrintResult("field_trial_lookup", "", "FindFullName",
+                    static_cast<double>(elapsed_ns) / (2 * kNumLookups), "ns",
+                    false);
+}
+
+}  // namespace field_trial
+}  // namespace webrtc
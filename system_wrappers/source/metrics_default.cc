@@ -9,9 +9,20 @@
 
 #include "system_wrappers/include/metrics_default.h"
 
+#include <string.h>
+
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
 #include <algorithm>
+#include <limits>
 
+#include "rtc_base/atomicops.h"
 #include "rtc_base/criticalsection.h"
+#include "rtc_base/platform_thread.h"
 #include "rtc_base/thread_annotations.h"
 #include "system_wrappers/include/metrics.h"
 
@@ -28,72 +39,247 @@ namespace {
 // linearly/exponentially spaced buckets) if samples are logged more frequently.
 const int kMaxSampleMapSize = 300;
 
+// Samples are counted in one of this many shards, picked by the adding
+// thread, and merged when read.
+const size_t kNumShards = 8;
+// Power of two, large enough to keep the probe sequences short with
+// kMaxSampleMapSize different samples.
+const size_t kShardSize = 512;
+const int kEmptySlot = std::numeric_limits<int>::min();
+
+size_t CurrentShardIndex() {
+  const rtc::PlatformThreadRef thread = rtc::CurrentThreadRef();
+  uint64_t id = 0;
+  memcpy(&id, &thread, std::min(sizeof(id), sizeof(thread)));
+  // Thread refs are often aligned addresses; multiplying moves their varying
+  // bits into the bits that are used.
+  return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> 32) % kNumShards;
+}
+
+size_t SlotIndex(int sample) {
+  return (static_cast<uint32_t>(sample) * 2654435761u) % kShardSize;
+}
+
+void YieldToOtherThreads() {
+#if defined(WEBRTC_WIN)
+  ::Sleep(0);
+#else
+  sched_yield();
+#endif
+}
+
+// Open addressing hash table from sample to number of events. Samples are
+// not removed while the shard is in use, so slots can be claimed and counted
+// with atomic operations only.
+struct SampleShard {
+  struct Slot {
+    volatile int sample;
+    volatile int count;
+  };
+
+  SampleShard() : size(0), writers(0) { Clear(); }
+
+  // Only when no thread adds to the shard.
+  void Clear() {
+    for (Slot& slot : slots) {
+      slot.sample = kEmptySlot;
+      slot.count = 0;
+    }
+    size = 0;
+  }
+
+  Slot slots[kShardSize];
+  // Number of claimed slots.
+  volatile int size;
+  // Number of threads that may be adding to the shard.
+  volatile int writers;
+};
+
 class RtcHistogram {
  public:
   RtcHistogram(const std::string& name, int min, int max, int bucket_count)
-      : min_(min), max_(max), info_(name, min, max, bucket_count) {
+      : min_(min),
+        max_(max),
+        info_(name, min, max, bucket_count),
+        shards_(),
+        spare_shards_() {
     RTC_DCHECK_GT(bucket_count, 0);
+    RTC_DCHECK_GT(min_ - 1, kEmptySlot);
   }
 
+  ~RtcHistogram() {
+    for (SampleShard* shard : shards_)
+      delete shard;
+    for (SampleShard* shard : spare_shards_)
+      delete shard;
+  }
+
+  // Lock-free. Threads add to different shards, so they rarely write to the
+  // same cache lines.
   void Add(int sample) {
     sample = std::min(sample, max_);
     sample = std::max(sample, min_ - 1);  // Underflow bucket.
 
-    rtc::CritScope cs(&crit_);
-    if (info_.samples.size() == kMaxSampleMapSize &&
-        info_.samples.find(sample) == info_.samples.end()) {
-      return;
-    }
-    ++info_.samples[sample];
+    SampleShard* shard = AcquireShard(CurrentShardIndex());
+    AddToShard(shard, sample);
+    rtc::AtomicOps::Decrement(&shard->writers);
   }
 
   // Returns a copy (or nullptr if there are no samples) and clears samples.
+  // Not safe to call concurrently with itself or Reset, but with Add.
   std::unique_ptr<SampleInfo> GetAndReset() {
-    rtc::CritScope cs(&crit_);
-    if (info_.samples.empty())
+    std::unique_ptr<SampleInfo> copy(
+        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count));
+    for (size_t i = 0; i < kNumShards; ++i) {
+      SampleShard* shard = RetireShard(i);
+      if (!shard)
+        continue;
+      for (const SampleShard::Slot& slot : shard->slots) {
+        const int sample = slot.sample;
+        const int count = slot.count;
+        if (sample != kEmptySlot && count > 0)
+          copy->samples[sample] += count;
+      }
+      shard->Clear();
+    }
+    if (copy->samples.empty())
       return nullptr;
-
-    SampleInfo* copy =
-        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count);
-
-    std::swap(info_.samples, copy->samples);
-
-    return std::unique_ptr<SampleInfo>(copy);
+    return copy;
   }
 
   const std::string& name() const { return info_.name; }
 
   // Functions only for testing.
-  void Reset() {
-    rtc::CritScope cs(&crit_);
-    info_.samples.clear();
-  }
+  void Reset() { GetAndReset(); }
 
   int NumEvents(int sample) const {
-    rtc::CritScope cs(&crit_);
-    const auto it = info_.samples.find(sample);
-    return (it == info_.samples.end()) ? 0 : it->second;
+    const auto samples = MergedSamples();
+    const auto it = samples.find(sample);
+    return (it == samples.end()) ? 0 : it->second;
   }
 
   int NumSamples() const {
     int num_samples = 0;
-    rtc::CritScope cs(&crit_);
-    for (const auto& sample : info_.samples) {
+    for (const auto& sample : MergedSamples()) {
       num_samples += sample.second;
     }
     return num_samples;
   }
 
   int MinSample() const {
-    rtc::CritScope cs(&crit_);
-    return (info_.samples.empty()) ? -1 : info_.samples.begin()->first;
+    const auto samples = MergedSamples();
+    return (samples.empty()) ? -1 : samples.begin()->first;
   }
 
  private:
-  rtc::CriticalSection crit_;
+  void AddToShard(SampleShard* shard, int sample) {
+    const size_t start = SlotIndex(sample);
+    for (size_t i = 0; i < kShardSize; ++i) {
+      SampleShard::Slot& slot = shard->slots[(start + i) % kShardSize];
+      int slot_sample = rtc::AtomicOps::AcquireLoad(&slot.sample);
+      if (slot_sample == kEmptySlot) {
+        // |sample| isn't in the shard, since it would have been found before
+        // the first empty slot.
+        if (rtc::AtomicOps::Increment(&shard->size) > kMaxSampleMapSize) {
+          rtc::AtomicOps::Decrement(&shard->size);
+          return;
+        }
+        slot_sample =
+            rtc::AtomicOps::CompareAndSwap(&slot.sample, kEmptySlot, sample);
+        if (slot_sample == kEmptySlot) {
+          slot_sample = sample;
+        } else {
+          // Another thread claimed the slot first.
+          rtc::AtomicOps::Decrement(&shard->size);
+        }
+      }
+      if (slot_sample == sample) {
+        rtc::AtomicOps::Increment(&slot.count);
+        return;
+      }
+    }
+  }
+
+  SampleShard* GetOrCreateShard(size_t index) {
+    SampleShard* shard = rtc::AtomicOps::AcquireLoadPtr(&shards_[index]);
+    if (shard)
+      return shard;
+    SampleShard* new_shard = new SampleShard();
+    shard = rtc::AtomicOps::CompareAndSwapPtr(
+        &shards_[index], static_cast<SampleShard*>(nullptr), new_shard);
+    if (shard) {
+      delete new_shard;
+      return shard;
+    }
+    return new_shard;
+  }
+
+  // Returns the shard at |index| with its |writers| incremented, which keeps
+  // it from being retired until the caller decrements them.
+  SampleShard* AcquireShard(size_t index) {
+    while (true) {
+      SampleShard* shard = GetOrCreateShard(index);
+      rtc::AtomicOps::Increment(&shard->writers);
+      if (rtc::AtomicOps::AcquireLoadPtr(&shards_[index]) == shard)
+        return shard;
+      // Retired in between; the retiring thread may be waiting for us.
+      rtc::AtomicOps::Decrement(&shard->writers);
+    }
+  }
+
+  // Replaces the shard at |index| with an empty one, and returns the old
+  // shard once no thread adds to it any more (or nullptr if there was none).
+  // The old shard becomes the next replacement, so shards are never freed
+  // while a thread may still hold a pointer to them.
+  SampleShard* RetireShard(size_t index) {
+    SampleShard* shard = rtc::AtomicOps::AcquireLoadPtr(&shards_[index]);
+    if (!shard)
+      return nullptr;
+    if (!spare_shards_[index])
+      spare_shards_[index] = new SampleShard();
+    // Only retiring replaces a shard that is set.
+    SampleShard* const replaced = rtc::AtomicOps::CompareAndSwapPtr(
+        &shards_[index], shard, spare_shards_[index]);
+    RTC_DCHECK_EQ(replaced, shard);
+    while (rtc::AtomicOps::AcquireLoad(&shard->writers) != 0)
+      YieldToOtherThreads();
+    spare_shards_[index] = shard;
+    return shard;
+  }
+
+  template <typename Function>
+  void ForEachSlot(Function function) const {
+    for (SampleShard* volatile& shard_pointer : shards_) {
+      SampleShard* shard = rtc::AtomicOps::AcquireLoadPtr(&shard_pointer);
+      if (!shard)
+        continue;
+      for (SampleShard::Slot& slot : shard->slots) {
+        const int sample = rtc::AtomicOps::AcquireLoad(&slot.sample);
+        if (sample != kEmptySlot)
+          function(&slot, sample);
+      }
+    }
+  }
+
+  std::map<int, int> MergedSamples() const {
+    std::map<int, int> samples;
+    ForEachSlot([&samples](SampleShard::Slot* slot, int sample) {
+      const int count = rtc::AtomicOps::AcquireLoad(&slot->count);
+      if (count > 0)
+        samples[sample] += count;
+    });
+    return samples;
+  }
+
   const int min_;
   const int max_;
-  SampleInfo info_ RTC_GUARDED_BY(crit_);
+  // Only name and limits; the samples are in |shards_|.
+  const SampleInfo info_;
+  // Created when first added to. Mutable, since reading them takes atomic
+  // loads.
+  mutable SampleShard* volatile shards_[kNumShards];
+  // Empty shards that replace |shards_| when they are retired.
+  SampleShard* spare_shards_[kNumShards];
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtcHistogram);
 };
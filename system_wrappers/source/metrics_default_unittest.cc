@@ -9,8 +9,15 @@
  */
 
 #include "system_wrappers/include/metrics_default.h"
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -47,6 +54,31 @@ int NumEvents(const std::string& name,
 
   return it_sample->second;
 }
+
+const char kConcurrentName[] = "Concurrent";
+const int kNumSampleValues = 100;
+const int kNumSamplesPerThread = 100000;
+
+void AddSamples(void* /* obj */) {
+  for (int i = 0; i < kNumSamplesPerThread; ++i)
+    RTC_HISTOGRAM_COUNTS_1000(kConcurrentName, i % kNumSampleValues);
+}
+
+// Returns the time it took for |num_threads| threads to add
+// kNumSamplesPerThread samples each at the same time.
+int64_t AddSamplesOnThreads(int num_threads) {
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(
+        new rtc::PlatformThread(&AddSamples, nullptr, "AddSamples"));
+  }
+  const int64_t start_ns = rtc::TimeNanos();
+  for (const auto& thread : threads)
+    thread->Start();
+  for (const auto& thread : threads)
+    thread->Stop();
+  return rtc::TimeNanos() - start_ns;
+}
 }  // namespace
 
 class MetricsDefaultTest : public ::testing::Test {
@@ -158,4 +190,63 @@ TEST_F(MetricsDefaultTest, TestMinMaxBucket) {
   EXPECT_EQ(1u, histograms.begin()->second->samples.size());
 }
 
+TEST_F(MetricsDefaultTest, LimitsNumberOfSampleValues) {
+  const std::string kName = "ManyValues";
+  for (int i = 0; i < 400; ++i)
+    RTC_HISTOGRAM_COUNTS_1000(kName, i + 1);
+  RTC_HISTOGRAM_COUNTS_1000(kName, 1);
+  RTC_HISTOGRAM_COUNTS_1000(kName, 400);
+  EXPECT_EQ(301, metrics::NumSamples(kName));
+  EXPECT_EQ(2, metrics::NumEvents(kName, 1));
+  EXPECT_EQ(0, metrics::NumEvents(kName, 400));
+}
+
+TEST_F(MetricsDefaultTest, GetAndResetFreesSampleValues) {
+  const std::string kManyValues = "ManyValues";
+  for (int i = 0; i < 300; ++i)
+    RTC_HISTOGRAM_COUNTS_1000(kManyValues, i + 1);
+  RTC_HISTOGRAM_COUNTS_1000(kManyValues, 301);
+  EXPECT_EQ(0, metrics::NumEvents(kManyValues, 301));
+
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  EXPECT_EQ(300, NumSamples(kManyValues, histograms));
+
+  // The limit applies from the reset on.
+  for (int i = 0; i < 300; ++i)
+    RTC_HISTOGRAM_COUNTS_1000(kManyValues, i + 301);
+  EXPECT_EQ(300, metrics::NumSamples(kManyValues));
+  EXPECT_EQ(1, metrics::NumEvents(kManyValues, 301));
+  EXPECT_EQ(1, metrics::NumEvents(kManyValues, 600));
+  EXPECT_EQ(0, metrics::NumEvents(kManyValues, 1));
+}
+
+TEST_F(MetricsDefaultTest, AddFromMultipleThreads) {
+  const int kNumThreads = 4;
+  AddSamplesOnThreads(kNumThreads);
+  EXPECT_EQ(kNumThreads * kNumSamplesPerThread,
+            metrics::NumSamples(kConcurrentName));
+  for (int i = 0; i < kNumSampleValues; ++i) {
+    EXPECT_EQ(kNumThreads * kNumSamplesPerThread / kNumSampleValues,
+              metrics::NumEvents(kConcurrentName, i));
+  }
+
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  EXPECT_EQ(kNumThreads * kNumSamplesPerThread,
+            NumSamples(kConcurrentName, histograms));
+  EXPECT_EQ(0, metrics::NumSamples(kConcurrentName));
+}
+
+TEST_F(MetricsDefaultTest, DISABLED_AddCost) {
+  for (int num_threads : {1, 4}) {
+    const int64_t elapsed_ns = AddSamplesOnThreads(num_threads);
+    test::PrintResult("histogram_add", "",
+                      std::to_string(num_threads) + "_threads",
+                      static_cast<double>(elapsed_ns) /
+                          (num_threads * kNumSamplesPerThread),
+                      "ns", false);
+  }
+}
+
 }  // namespace webrtc
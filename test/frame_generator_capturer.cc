@@ -17,7 +17,6 @@
 #include "rtc_base/logging.h"
 #include "rtc_base/platform_thread.h"
 #include "rtc_base/task_queue.h"
-#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/frame_generator.h"
 #include "call/video_send_stream.h"
@@ -53,7 +52,8 @@ class FrameGeneratorCapturer::InsertFrameTask : public rtc::QueuedTask {
         // Schedule the next frame capture event to happen at approximately the
         // correct absolute time point.
         int64_t delay_ms;
-        int64_t time_now_ms = rtc::TimeMillis();
+        int64_t time_now_ms =
+            frame_generator_capturer_->clock_->TimeInMilliseconds();
         if (intended_run_time_ms_ > 0) {
           delay_ms = time_now_ms - intended_run_time_ms_;
         } else {
@@ -17,5 +17,7 @@ void FuzzOneInput(const uint8_t* data, size_t size) {
   h264_bitstream_parser.ParseBitstream(data, size);
   int qp;
   h264_bitstream_parser.GetLastSliceQp(&qp);
+  h264_bitstream_parser.ParseFirstSlice(data, size);
+  h264_bitstream_parser.GetLastSliceQp(&qp);
 }
 }  // namespace webrtc
@@ -0,0 +1,312 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "test/rtp_load_replayer.h"
+
+#if defined(WEBRTC_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+
+#include <algorithm>
+
+#include "modules/rtp_rtcp/include/rtp_header_parser.h"
+#include "modules/rtp_rtcp/source/byte_io.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/rtp_file_reader.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+// The rtpdump file header is a "#!rtpplay1.0 address/port\n" line followed
+// by 16 bytes of start time and source address, and every packet has an 8
+// byte header with its length, its length on the wire and its time offset.
+const char kRtpDumpSignature[] = "#!rtpplay1.0";
+const size_t kRtpDumpMaxFirstLineLength = 40;
+const size_t kRtpDumpFileHeaderSize = 16;
+const size_t kRtpDumpPacketHeaderSize = 8;
+
+const size_t kMinRtpHeaderSize = 12;
+const size_t kRtcpHeaderSize = 4;
+
+uint32_t PacketSsrc(rtc::ArrayView<const uint8_t> packet) {
+  if (RtpHeaderParser::IsRtcp(packet.data(), packet.size())) {
+    if (packet.size() < kRtcpHeaderSize + 4)
+      return 0;
+    return ByteReader<uint32_t>::ReadBigEndian(&packet[kRtcpHeaderSize]);
+  }
+  if (packet.size() < kMinRtpHeaderSize)
+    return 0;
+  return ByteReader<uint32_t>::ReadBigEndian(&packet[8]);
+}
+
+void RewriteSsrc(int session, uint8_t* ssrc) {
+  ByteWriter<uint32_t>::WriteBigEndian(
+      ssrc, SessionSsrc(ByteReader<uint32_t>::ReadBigEndian(ssrc), session));
+}
+
+void AddStats(const RtpLoadReplayStats& stats, RtpLoadReplayStats* total) {
+  total->num_delivered_packets += stats.num_delivered_packets;
+  total->num_delivered_bytes += stats.num_delivered_bytes;
+  total->num_dropped_packets += stats.num_dropped_packets;
+  total->num_unknown_ssrc_packets += stats.num_unknown_ssrc_packets;
+  total->num_packet_errors += stats.num_packet_errors;
+  for (const auto& unknown_ssrc : stats.unknown_ssrcs)
+    total->unknown_ssrcs[unknown_ssrc.first] += unknown_ssrc.second;
+}
+
+// Replays the capture for some of the sessions.
+class ReplayWorker {
+ public:
+  ReplayWorker(const RtpCapture* capture,
+               PacketReceiver* receiver,
+               const RtpLoadReplayConfig& config,
+               int64_t start_time_us)
+      : capture_(capture),
+        receiver_(receiver),
+        config_(config),
+        start_time_us_(start_time_us) {}
+
+  static void Run(void* obj) { static_cast<ReplayWorker*>(obj)->Run(); }
+
+  void Run() {
+    for (const RtpCapture::Packet& packet : capture_->packets()) {
+      if (config_.speed > 0) {
+        const int64_t send_time_us =
+            start_time_us_ +
+            static_cast<int64_t>(packet.time_ms * 1000 / config_.speed);
+        const int64_t now_us = rtc::TimeMicros();
+        if (send_time_us > now_us) {
+          SleepMs(static_cast<int>((send_time_us - now_us + 999) / 1000));
+        } else if (config_.max_lag_ms >= 0 &&
+                   now_us - send_time_us >
+                       config_.max_lag_ms * rtc::kNumMicrosecsPerMillisec) {
+          stats_.num_dropped_packets += sessions_.size();
+          continue;
+        }
+      }
+      for (int session : sessions_)
+        Deliver(session, packet.data);
+    }
+  }
+
+  void AddSession(int session) { sessions_.push_back(session); }
+
+  const RtpLoadReplayStats& stats() const { return stats_; }
+
+ private:
+  void Deliver(int session, rtc::ArrayView<const uint8_t> data) {
+    rtc::CopyOnWriteBuffer packet(data.data(), data.size());
+    if (session != 0) {
+      RewriteSsrcs(session,
+                   rtc::ArrayView<uint8_t>(packet.data(), packet.size()));
+    }
+    switch (
+        receiver_->DeliverPacket(config_.media_type, packet, PacketTime())) {
+      case PacketReceiver::DELIVERY_OK:
+        break;
+      case PacketReceiver::DELIVERY_UNKNOWN_SSRC:
+        ++stats_.num_unknown_ssrc_packets;
+        ++stats_.unknown_ssrcs[PacketSsrc(packet)];
+        break;
+      case PacketReceiver::DELIVERY_PACKET_ERROR:
+        ++stats_.num_packet_errors;
+        break;
+    }
+    ++stats_.num_delivered_packets;
+    stats_.num_delivered_bytes += data.size();
+  }
+
+  const RtpCapture* const capture_;
+  PacketReceiver* const receiver_;
+  const RtpLoadReplayConfig config_;
+  const int64_t start_time_us_;
+  std::vector<int> sessions_;
+  RtpLoadReplayStats stats_;
+};
+
+}  // namespace
+
+RtpCapture::RtpCapture() : mapped_data_(nullptr), mapped_size_(0) {}
+
+RtpCapture::~RtpCapture() {
+#if defined(WEBRTC_POSIX)
+  if (mapped_data_)
+    munmap(const_cast<uint8_t*>(mapped_data_), mapped_size_);
+#endif
+}
+
+std::unique_ptr<RtpCapture> RtpCapture::Load(const std::string& filename) {
+  std::unique_ptr<RtpCapture> capture(new RtpCapture());
+  if (!capture->MapRtpDump(filename) &&
+      !capture->ReadWithFileReader(filename)) {
+    return nullptr;
+  }
+  if (!capture->packets_.empty()) {
+    const uint32_t first_time_ms = capture->packets_.front().time_ms;
+    for (Packet& packet : capture->packets_)
+      packet.time_ms -= std::min(packet.time_ms, first_time_ms);
+  }
+  return capture;
+}
+
+bool RtpCapture::MapRtpDump(const std::string& filename) {
+#if defined(WEBRTC_POSIX)
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  const uint8_t* const begin = static_cast<const uint8_t*>(data);
+  const uint8_t* const end = begin + size;
+  const uint8_t* line_end = static_cast<const uint8_t*>(
+      memchr(begin, '\n', std::min(size, kRtpDumpMaxFirstLineLength)));
+  if (size < sizeof(kRtpDumpSignature) - 1 ||
+      memcmp(begin, kRtpDumpSignature, sizeof(kRtpDumpSignature) - 1) != 0 ||
+      !line_end ||
+      static_cast<size_t>(end - line_end) <= kRtpDumpFileHeaderSize) {
+    munmap(data, size);
+    return false;
+  }
+  mapped_data_ = begin;
+  mapped_size_ = size;
+  madvise(data, size, MADV_SEQUENTIAL);
+
+  const uint8_t* pos = line_end + 1 + kRtpDumpFileHeaderSize;
+  while (static_cast<size_t>(end - pos) >= kRtpDumpPacketHeaderSize) {
+    // |length| includes the packet header.
+    const uint16_t length = ByteReader<uint16_t>::ReadBigEndian(pos);
+    const uint32_t time_ms = ByteReader<uint32_t>::ReadBigEndian(pos + 4);
+    if (length < kRtpDumpPacketHeaderSize ||
+        length > static_cast<size_t>(end - pos)) {
+      break;
+    }
+    packets_.push_back(
+        {rtc::ArrayView<const uint8_t>(pos + kRtpDumpPacketHeaderSize,
+                                       length - kRtpDumpPacketHeaderSize),
+         time_ms});
+    pos += length;
+  }
+  if (pos != end) {
+    RTC_LOG(LS_WARNING) << "Ignoring " << (end - pos)
+                        << " bytes at the end of " << filename;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool RtpCapture::ReadWithFileReader(const std::string& filename) {
+  std::unique_ptr<RtpFileReader> reader;
+  for (RtpFileReader::FileFormat format :
+       {RtpFileReader::kRtpDump, RtpFileReader::kPcap,
+        RtpFileReader::kLengthPacketInterleaved}) {
+    reader.reset(RtpFileReader::Create(format, filename));
+    if (reader)
+      break;
+  }
+  if (!reader)
+    return false;
+  RtpPacket packet;
+  while (reader->NextPacket(&packet)) {
+    packet_buffers_.emplace_back(packet.data, packet.data + packet.length);
+    packets_.push_back({packet_buffers_.back(), packet.time_ms});
+  }
+  // |packet_buffers_| may have reallocated, but the packet data didn't move.
+  return true;
+}
+
+double RtpLoadReplayStats::PacketsPerSecond() const {
+  if (duration_ms <= 0)
+    return 0.0;
+  return num_delivered_packets * 1000.0 / duration_ms;
+}
+
+double RtpLoadReplayStats::Mbps() const {
+  if (duration_ms <= 0)
+    return 0.0;
+  return num_delivered_bytes * 8.0 / 1000.0 / duration_ms;
+}
+
+uint32_t SessionSsrc(uint32_t ssrc, int session) {
+  RTC_DCHECK_GE(session, 0);
+  return ssrc + (static_cast<uint32_t>(session) << 16);
+}
+
+void RewriteSsrcs(int session, rtc::ArrayView<uint8_t> packet) {
+  if (RtpHeaderParser::IsRtcp(packet.data(), packet.size())) {
+    // The length of each packet in a compound packet is in 32-bit words
+    // minus one, and the sender SSRC follows the 4 byte header.
+    size_t offset = 0;
+    while (offset + kRtcpHeaderSize + 4 <= packet.size()) {
+      RewriteSsrc(session, &packet[offset + kRtcpHeaderSize]);
+      offset +=
+          (ByteReader<uint16_t>::ReadBigEndian(&packet[offset + 2]) + 1) * 4;
+    }
+  } else if (packet.size() >= kMinRtpHeaderSize) {
+    RewriteSsrc(session, &packet[8]);
+  }
+}
+
+RtpLoadReplayStats ReplayRtpCapture(const RtpCapture& capture,
+                                    PacketReceiver* receiver,
+                                    const RtpLoadReplayConfig& config) {
+  RTC_DCHECK_GT(config.num_sessions, 0);
+  const int num_workers =
+      std::max(1, std::min(config.num_threads, config.num_sessions));
+  const int64_t start_time_us = rtc::TimeMicros();
+  std::vector<std::unique_ptr<ReplayWorker>> workers;
+  for (int i = 0; i < num_workers; ++i) {
+    workers.emplace_back(
+        new ReplayWorker(&capture, receiver, config, start_time_us));
+  }
+  for (int session = 0; session < config.num_sessions; ++session)
+    workers[session % num_workers]->AddSession(session);
+
+  if (workers.size() == 1) {
+    workers[0]->Run();
+  } else {
+    std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+    for (const auto& worker : workers) {
+      threads.emplace_back(new rtc::PlatformThread(
+          &ReplayWorker::Run, worker.get(), "RtpLoadReplay"));
+      threads.back()->Start();
+    }
+    for (const auto& thread : threads)
+      thread->Stop();
+  }
+
+  RtpLoadReplayStats stats;
+  for (const auto& worker : workers)
+    AddStats(worker->stats(), &stats);
+  stats.duration_ms = (rtc::TimeMicros() - start_time_us) /
+                      rtc::kNumMicrosecsPerMillisec;
+  return stats;
+}
+
+}  // namespace test
+}  // namespace webrtc
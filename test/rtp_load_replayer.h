@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#ifndef TEST_RTP_LOAD_REPLAYER_H_
+#define TEST_RTP_LOAD_REPLAYER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/array_view.h"
+#include "call/call.h"
+#include "rtc_base/constructormagic.h"
+
+namespace webrtc {
+namespace test {
+
+// All RTP and RTCP packets of a capture file, held in memory so that they
+// can be replayed much faster than real time. Rtpdump files are memory
+// mapped and the packets point into the mapping; pcap and length/packet
+// interleaved files are read once through RtpFileReader.
+class RtpCapture {
+ public:
+  struct Packet {
+    rtc::ArrayView<const uint8_t> data;
+    // Relative to the first packet.
+    uint32_t time_ms;
+  };
+
+  // Returns nullptr if |filename| can't be read in any supported format.
+  static std::unique_ptr<RtpCapture> Load(const std::string& filename);
+
+  ~RtpCapture();
+
+  const std::vector<Packet>& packets() const { return packets_; }
+
+ private:
+  RtpCapture();
+
+  bool MapRtpDump(const std::string& filename);
+  bool ReadWithFileReader(const std::string& filename);
+
+  const uint8_t* mapped_data_;
+  size_t mapped_size_;
+  // Packet data of files that aren't mapped.
+  std::vector<std::vector<uint8_t>> packet_buffers_;
+  std::vector<Packet> packets_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(RtpCapture);
+};
+
+struct RtpLoadReplayConfig {
+  MediaType media_type = MediaType::VIDEO;
+  // Number of copies of the capture that are replayed at the same time. Each
+  // session but the first gets its own SSRCs, see SessionSsrc().
+  int num_sessions = 1;
+  // Sessions are spread over this many threads. Values above 1 need a
+  // receiver that can be called on several threads at once, which Call can't.
+  int num_threads = 1;
+  // Multiple of real time. 0 replays as fast as the receiver allows.
+  double speed = 1.0;
+  // Packets the replay is later than this for are dropped instead of
+  // delivered, like a full receive queue would. Negative values never drop.
+  // Not used if |speed| is 0.
+  int max_lag_ms = -1;
+};
+
+struct RtpLoadReplayStats {
+  int64_t num_delivered_packets = 0;
+  int64_t num_delivered_bytes = 0;
+  // Packets not delivered because the replay fell behind.
+  int64_t num_dropped_packets = 0;
+  // Delivered packets the receiver returned an error for.
+  int64_t num_unknown_ssrc_packets = 0;
+  int64_t num_packet_errors = 0;
+  std::map<uint32_t, int64_t> unknown_ssrcs;
+  int64_t duration_ms = 0;
+
+  double PacketsPerSecond() const;
+  double Mbps() const;
+};
+
+// SSRC used for |ssrc| in |session|. Session 0 keeps the captured SSRCs.
+uint32_t SessionSsrc(uint32_t ssrc, int session);
+
+// Rewrites the SSRC of an RTP packet, or the sender SSRC of each packet in a
+// compound RTCP packet, for |session|.
+void RewriteSsrcs(int session, rtc::ArrayView<uint8_t> packet);
+
+// Delivers every packet of |capture| to |receiver| once for each session,
+// paced according to the capture timestamps and |config.speed|, and blocks
+// until done. |receiver| is called on |config.num_threads| threads at once, or
+// only on the calling thread if that is 1.
+RtpLoadReplayStats ReplayRtpCapture(const RtpCapture& capture,
+                                    PacketReceiver* receiver,
+                                    const RtpLoadReplayConfig& config);
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // TEST_RTP_LOAD_REPLAYER_H_
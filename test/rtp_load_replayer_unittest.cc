@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2018 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "test/rtp_load_replayer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "modules/rtp_rtcp/source/byte_io.h"
+#include "rtc_base/criticalsection.h"
+#include "rtc_base/thread_annotations.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/gtest.h"
+#include "test/rtp_file_writer.h"
+#include "test/testsupport/fileutils.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+const uint32_t kSsrc = 0x12345678;
+const size_t kNumPackets = 10;
+
+// An RTP packet with |kSsrc|, numbered by |sequence_number|.
+RtpPacket CreateRtpPacket(uint16_t sequence_number, uint32_t time_ms) {
+  RtpPacket packet;
+  memset(packet.data, 0, sizeof(packet.data));
+  packet.data[0] = 0x80;
+  packet.data[1] = 96;
+  ByteWriter<uint16_t>::WriteBigEndian(&packet.data[2], sequence_number);
+  ByteWriter<uint32_t>::WriteBigEndian(&packet.data[8], kSsrc);
+  packet.length = 100 + sequence_number;
+  packet.original_length = packet.length;
+  packet.time_ms = time_ms;
+  return packet;
+}
+
+class RecordingPacketReceiver : public PacketReceiver {
+ public:
+  explicit RecordingPacketReceiver(int first_packet_delay_ms)
+      : first_packet_delay_ms_(first_packet_delay_ms) {}
+
+  DeliveryStatus DeliverPacket(MediaType media_type,
+                               rtc::CopyOnWriteBuffer packet,
+                               const PacketTime& packet_time) override {
+    const uint32_t ssrc = ByteReader<uint32_t>::ReadBigEndian(&packet[8]);
+    bool first_packet;
+    {
+      rtc::CritScope lock(&crit_);
+      first_packet = packets_per_ssrc_.empty();
+      ++packets_per_ssrc_[ssrc];
+    }
+    if (first_packet)
+      SleepMs(first_packet_delay_ms_);
+    return ssrc == SessionSsrc(kSsrc, 2) ? DELIVERY_UNKNOWN_SSRC
+                                         : DELIVERY_OK;
+  }
+
+  std::map<uint32_t, int> packets_per_ssrc() const {
+    rtc::CritScope lock(&crit_);
+    return packets_per_ssrc_;
+  }
+
+ private:
+  const int first_packet_delay_ms_;
+  rtc::CriticalSection crit_;
+  std::map<uint32_t, int> packets_per_ssrc_ RTC_GUARDED_BY(crit_);
+};
+
+}  // namespace
+
+class RtpLoadReplayerTest : public ::testing::Test {
+ protected:
+  RtpLoadReplayerTest()
+      : filename_(TempFilename(OutputPath(), "rtp_load_replayer_test")) {}
+
+  ~RtpLoadReplayerTest() override { remove(filename_.c_str()); }
+
+  // Writes |kNumPackets| packets, 1 ms apart and starting at 1000 ms.
+  void WriteRtpDump() {
+    std::unique_ptr<RtpFileWriter> writer(
+        RtpFileWriter::Create(RtpFileWriter::kRtpDump, filename_));
+    ASSERT_TRUE(writer);
+    for (size_t i = 0; i < kNumPackets; ++i) {
+      RtpPacket packet = CreateRtpPacket(i, 1000 + i);
+      ASSERT_TRUE(writer->WritePacket(&packet));
+    }
+  }
+
+  const std::string filename_;
+};
+
+TEST_F(RtpLoadReplayerTest, LoadsRtpDump) {
+  WriteRtpDump();
+  std::unique_ptr<RtpCapture> capture = RtpCapture::Load(filename_);
+  ASSERT_TRUE(capture);
+  ASSERT_EQ(kNumPackets, capture->packets().size());
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    const RtpCapture::Packet& packet = capture->packets()[i];
+    const RtpPacket expected_packet = CreateRtpPacket(i, 0);
+    EXPECT_EQ(i, packet.time_ms);
+    ASSERT_EQ(expected_packet.length, packet.data.size());
+    EXPECT_EQ(0, memcmp(expected_packet.data, packet.data.data(),
+                        expected_packet.length));
+  }
+}
+
+TEST_F(RtpLoadReplayerTest, FailsToLoadMissingFile) {
+  EXPECT_FALSE(RtpCapture::Load(filename_ + "_missing"));
+}
+
+TEST(RtpLoadReplayerSsrcTest, RewritesRtpSsrc) {
+  RtpPacket packet = CreateRtpPacket(0, 0);
+  RewriteSsrcs(0, rtc::ArrayView<uint8_t>(packet.data, packet.length));
+  EXPECT_EQ(kSsrc, ByteReader<uint32_t>::ReadBigEndian(&packet.data[8]));
+  RewriteSsrcs(3, rtc::ArrayView<uint8_t>(packet.data, packet.length));
+  EXPECT_EQ(SessionSsrc(kSsrc, 3),
+            ByteReader<uint32_t>::ReadBigEndian(&packet.data[8]));
+  EXPECT_NE(kSsrc, SessionSsrc(kSsrc, 3));
+  // Only the SSRC changes.
+  EXPECT_EQ(0x80, packet.data[0]);
+  EXPECT_EQ(96, packet.data[1]);
+}
+
+TEST(RtpLoadReplayerSsrcTest, RewritesSenderSsrcsOfCompoundRtcp) {
+  // An 8 byte receiver report without report blocks followed by a 12 byte
+  // SDES-like packet.
+  uint8_t packet[20] = {0x80, 201, 0, 1, 0, 0, 0, 1,
+                        0x81, 202, 0, 2, 0, 0, 0, 2};
+  RewriteSsrcs(1, packet);
+  EXPECT_EQ(SessionSsrc(1, 1), ByteReader<uint32_t>::ReadBigEndian(&packet[4]));
+  EXPECT_EQ(SessionSsrc(2, 1),
+            ByteReader<uint32_t>::ReadBigEndian(&packet[12]));
+  EXPECT_EQ(0u, ByteReader<uint32_t>::ReadBigEndian(&packet[16]));
+}
+
+TEST_F(RtpLoadReplayerTest, DeliversEveryPacketToEachSession) {
+  WriteRtpDump();
+  std::unique_ptr<RtpCapture> capture = RtpCapture::Load(filename_);
+  ASSERT_TRUE(capture);
+  RecordingPacketReceiver receiver(0);
+  RtpLoadReplayConfig config;
+  config.num_sessions = 3;
+  config.num_threads = 2;
+  config.speed = 0;
+  const RtpLoadReplayStats stats =
+      ReplayRtpCapture(*capture, &receiver, config);
+
+  std::map<uint32_t, int> expected_packets_per_ssrc;
+  for (int session = 0; session < config.num_sessions; ++session)
+    expected_packets_per_ssrc[SessionSsrc(kSsrc, session)] = kNumPackets;
+  EXPECT_EQ(expected_packets_per_ssrc, receiver.packets_per_ssrc());
+  EXPECT_EQ(static_cast<int64_t>(3 * kNumPackets),
+            stats.num_delivered_packets);
+  EXPECT_EQ(0, stats.num_dropped_packets);
+  EXPECT_EQ(static_cast<int64_t>(kNumPackets), stats.num_unknown_ssrc_packets);
+  EXPECT_EQ(1u, stats.unknown_ssrcs.size());
+  EXPECT_EQ(static_cast<int64_t>(kNumPackets),
+            stats.unknown_ssrcs.at(SessionSsrc(kSsrc, 2)));
+}
+
+TEST_F(RtpLoadReplayerTest, DropsPacketsWhenFallingBehind) {
+  WriteRtpDump();
+  std::unique_ptr<RtpCapture> capture = RtpCapture::Load(filename_);
+  ASSERT_TRUE(capture);
+  // The packets are 1 ms apart, so all but the first are more than 20 ms late
+  // after the receiver blocks for 50 ms.
+  RecordingPacketReceiver receiver(50);
+  RtpLoadReplayConfig config;
+  config.max_lag_ms = 20;
+  const RtpLoadReplayStats stats =
+      ReplayRtpCapture(*capture, &receiver, config);
+  EXPECT_EQ(1, stats.num_delivered_packets);
+  EXPECT_EQ(static_cast<int64_t>(kNumPackets - 1), stats.num_dropped_packets);
+}
+
+}  // namespace test
+}  // namespace webrtc
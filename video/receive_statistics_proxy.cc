@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/utility/frame_buffer_memory_budget.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/timeutils.h"
@@ -531,6 +532,11 @@ VideoReceiveStream::Stats ReceiveStatisticsProxy::GetStats() const {
   stats_.interframe_delay_max_ms =
       interframe_delay_max_moving_.Max(now_ms).value_or(-1);
   stats_.timing_frame_info = timing_frame_info_counter_.Max(now_ms);
+  const FrameBufferMemoryBudget::Stats frame_buffer_stats =
+      FrameBufferMemoryBudget::GetStats();
+  stats_.decoder_frame_buffer_bytes = frame_buffer_stats.allocated_bytes;
+  stats_.decoder_frame_buffer_failed_allocations =
+      frame_buffer_stats.num_failed_reservations;
   stats_.content_type = last_content_type_;
   return stats_;
 }
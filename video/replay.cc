@@ -8,29 +8,27 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 
-#include <map>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "api/video_codecs/video_decoder.h"
 #include "call/call.h"
 #include "common_video/libyuv/include/webrtc_libyuv.h"
 #include "logging/rtc_event_log/rtc_event_log.h"
-#include "modules/rtp_rtcp/include/rtp_header_parser.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/flags.h"
 #include "rtc_base/string_to_number.h"
-#include "rtc_base/timeutils.h"
 #include "system_wrappers/include/clock.h"
-#include "system_wrappers/include/sleep.h"
 #include "test/call_test.h"
 #include "test/encoder_settings.h"
 #include "test/fake_decoder.h"
 #include "test/gtest.h"
 #include "test/null_transport.h"
-#include "test/rtp_file_reader.h"
+#include "test/rtp_load_replayer.h"
 #include "test/run_loop.h"
 #include "test/run_test.h"
 #include "test/testsupport/frame_writer.h"
@@ -159,6 +157,31 @@ static std::string DecoderBitstreamFilename() {
 DEFINE_string(codec, "VP8", "Video codec");
 static std::string Codec() { return static_cast<std::string>(FLAG_codec); }
 
+// Flags for load generation.
+DEFINE_int(num_sessions,
+           1,
+           "Number of copies of the input replayed at the same time, each "
+           "into its own receive stream and with its own SSRCs");
+static int NumSessions() {
+  return static_cast<int>(FLAG_num_sessions);
+}
+
+DEFINE_float(speed,
+             1.0,
+             "Replay speed as a multiple of real time, 0 for as fast as "
+             "possible");
+static double Speed() {
+  return static_cast<double>(FLAG_speed);
+}
+
+DEFINE_int(max_lag_ms,
+           -1,
+           "Drop packets when the replay falls this far behind, -1 to never "
+           "drop");
+static int MaxLagMs() {
+  return static_cast<int>(FLAG_max_lag_ms);
+}
+
 DEFINE_bool(help, false, "Print this message.");
 }  // namespace flags
 
@@ -224,127 +247,96 @@ void RtpReplay() {
   webrtc::RtcEventLogNullImpl event_log;
   std::unique_ptr<Call> call(Call::Create(Call::Config(&event_log)));
 
-  test::NullTransport transport;
-  VideoReceiveStream::Config receive_config(&transport);
-  receive_config.rtp.remote_ssrc = flags::Ssrc();
-  receive_config.rtp.local_ssrc = kReceiverLocalSsrc;
-  receive_config.rtp.rtx_ssrc = flags::SsrcRtx();
-  receive_config.rtp
-      .rtx_associated_payload_types[flags::MediaPayloadTypeRtx()] =
-      flags::MediaPayloadType();
-  receive_config.rtp.rtx_associated_payload_types[flags::RedPayloadTypeRtx()] =
-      flags::RedPayloadType();
-  receive_config.rtp.ulpfec_payload_type = flags::UlpfecPayloadType();
-  receive_config.rtp.red_payload_type = flags::RedPayloadType();
-  receive_config.rtp.nack.rtp_history_ms = 1000;
-  if (flags::TransmissionOffsetId() != -1) {
-    receive_config.rtp.extensions.push_back(RtpExtension(
-        RtpExtension::kTimestampOffsetUri, flags::TransmissionOffsetId()));
+  std::unique_ptr<test::RtpCapture> capture =
+      test::RtpCapture::Load(flags::InputFile());
+  if (!capture) {
+    fprintf(stderr,
+            "Unable to open input file as rtpdump, .pcap or length/packet "
+            "interleaved. Note that .pcapng is not supported.\n");
+    return;
   }
-  if (flags::AbsSendTimeId() != -1) {
-    receive_config.rtp.extensions.push_back(
-        RtpExtension(RtpExtension::kAbsSendTimeUri, flags::AbsSendTimeId()));
-  }
-  receive_config.renderer = &file_passthrough;
 
+  test::NullTransport transport;
   VideoSendStream::Config::EncoderSettings encoder_settings;
   encoder_settings.payload_name = flags::Codec();
   encoder_settings.payload_type = flags::MediaPayloadType();
-  VideoReceiveStream::Decoder decoder;
   std::unique_ptr<DecoderBitstreamFileWriter> bitstream_writer;
   if (!flags::DecoderBitstreamFilename().empty()) {
     bitstream_writer.reset(new DecoderBitstreamFileWriter(
         flags::DecoderBitstreamFilename().c_str()));
-    receive_config.pre_decode_callback = bitstream_writer.get();
   }
-  decoder = test::CreateMatchingDecoder(encoder_settings);
-  if (!flags::DecoderBitstreamFilename().empty()) {
-    // Replace with a null decoder if we're writing the bitstream to a file
-    // instead.
-    delete decoder.decoder;
-    decoder.decoder = new test::FakeNullDecoder();
-  }
-  receive_config.decoders.push_back(decoder);
-
-  VideoReceiveStream* receive_stream =
-      call->CreateVideoReceiveStream(std::move(receive_config));
-
-  std::unique_ptr<test::RtpFileReader> rtp_reader(test::RtpFileReader::Create(
-      test::RtpFileReader::kRtpDump, flags::InputFile()));
-  if (!rtp_reader) {
-    rtp_reader.reset(test::RtpFileReader::Create(test::RtpFileReader::kPcap,
-                                                 flags::InputFile()));
-    if (!rtp_reader) {
-      fprintf(stderr,
-              "Couldn't open input file as either a rtpdump or .pcap. Note "
-              "that .pcapng is not supported.\nTrying to interpret the file as "
-              "length/packet interleaved.\n");
-      rtp_reader.reset(test::RtpFileReader::Create(
-          test::RtpFileReader::kLengthPacketInterleaved, flags::InputFile()));
-      if (!rtp_reader) {
-        fprintf(stderr,
-                "Unable to open input file with any supported format\n");
-        return;
-      }
+
+  // Session 0 is rendered and written to the output files, the others only
+  // add load.
+  std::vector<VideoReceiveStream*> receive_streams;
+  std::vector<std::unique_ptr<VideoDecoder>> decoders;
+  for (int session = 0; session < flags::NumSessions(); ++session) {
+    VideoReceiveStream::Config receive_config(&transport);
+    receive_config.rtp.remote_ssrc =
+        test::SessionSsrc(flags::Ssrc(), session);
+    receive_config.rtp.local_ssrc = kReceiverLocalSsrc + session;
+    receive_config.rtp.rtx_ssrc = test::SessionSsrc(flags::SsrcRtx(), session);
+    receive_config.rtp
+        .rtx_associated_payload_types[flags::MediaPayloadTypeRtx()] =
+        flags::MediaPayloadType();
+    receive_config.rtp
+        .rtx_associated_payload_types[flags::RedPayloadTypeRtx()] =
+        flags::RedPayloadType();
+    receive_config.rtp.ulpfec_payload_type = flags::UlpfecPayloadType();
+    receive_config.rtp.red_payload_type = flags::RedPayloadType();
+    receive_config.rtp.nack.rtp_history_ms = 1000;
+    if (flags::TransmissionOffsetId() != -1) {
+      receive_config.rtp.extensions.push_back(RtpExtension(
+          RtpExtension::kTimestampOffsetUri, flags::TransmissionOffsetId()));
     }
-  }
-  receive_stream->Start();
-
-  int64_t replay_start_ms = -1;
-  int num_packets = 0;
-  std::map<uint32_t, int> unknown_packets;
-  while (true) {
-    int64_t now_ms = rtc::TimeMillis();
-    if (replay_start_ms == -1)
-      replay_start_ms = now_ms;
-
-    test::RtpPacket packet;
-    if (!rtp_reader->NextPacket(&packet))
-      break;
-
-    int64_t deliver_in_ms = replay_start_ms + packet.time_ms - now_ms;
-    if (deliver_in_ms > 0)
-      SleepMs(deliver_in_ms);
-
-    ++num_packets;
-    switch (call->Receiver()->DeliverPacket(
-        webrtc::MediaType::VIDEO,
-        rtc::CopyOnWriteBuffer(packet.data, packet.length), PacketTime())) {
-      case PacketReceiver::DELIVERY_OK:
-        break;
-      case PacketReceiver::DELIVERY_UNKNOWN_SSRC: {
-        RTPHeader header;
-        std::unique_ptr<RtpHeaderParser> parser(RtpHeaderParser::Create());
-        parser->Parse(packet.data, packet.length, &header);
-        if (unknown_packets[header.ssrc] == 0)
-          fprintf(stderr, "Unknown SSRC: %u!\n", header.ssrc);
-        ++unknown_packets[header.ssrc];
-        break;
-      }
-      case PacketReceiver::DELIVERY_PACKET_ERROR: {
-        fprintf(stderr, "Packet error, corrupt packets or incorrect setup?\n");
-        RTPHeader header;
-        std::unique_ptr<RtpHeaderParser> parser(RtpHeaderParser::Create());
-        parser->Parse(packet.data, packet.length, &header);
-        fprintf(stderr, "Packet len=%zu pt=%u seq=%u ts=%u ssrc=0x%8x\n",
-                packet.length, header.payloadType, header.sequenceNumber,
-                header.timestamp, header.ssrc);
-        break;
-      }
+    if (flags::AbsSendTimeId() != -1) {
+      receive_config.rtp.extensions.push_back(
+          RtpExtension(RtpExtension::kAbsSendTimeUri, flags::AbsSendTimeId()));
+    }
+    if (session == 0) {
+      receive_config.renderer = &file_passthrough;
+      receive_config.pre_decode_callback = bitstream_writer.get();
     }
-  }
-  fprintf(stderr, "num_packets: %d\n", num_packets);
 
-  for (std::map<uint32_t, int>::const_iterator it = unknown_packets.begin();
-       it != unknown_packets.end();
-       ++it) {
-    fprintf(
-        stderr, "Packets for unknown ssrc '%u': %d\n", it->first, it->second);
-  }
+    VideoReceiveStream::Decoder decoder =
+        test::CreateMatchingDecoder(encoder_settings);
+    if (bitstream_writer) {
+      // Replace with a null decoder if we're writing the bitstream to a file
+      // instead.
+      delete decoder.decoder;
+      decoder.decoder = new test::FakeNullDecoder();
+    }
+    decoders.emplace_back(decoder.decoder);
+    receive_config.decoders.push_back(decoder);
 
-  call->DestroyVideoReceiveStream(receive_stream);
+    receive_streams.push_back(
+        call->CreateVideoReceiveStream(std::move(receive_config)));
+  }
+  for (VideoReceiveStream* receive_stream : receive_streams)
+    receive_stream->Start();
+
+  test::RtpLoadReplayConfig replay_config;
+  replay_config.num_sessions = flags::NumSessions();
+  replay_config.speed = flags::Speed();
+  replay_config.max_lag_ms = flags::MaxLagMs();
+  // All sessions are delivered on this thread, since Call must not be called
+  // on several threads at once.
+  const test::RtpLoadReplayStats stats =
+      test::ReplayRtpCapture(*capture, call->Receiver(), replay_config);
+
+  fprintf(stderr, "num_packets: %" PRId64 "\n", stats.num_delivered_packets);
+  fprintf(stderr, "num_dropped_packets: %" PRId64 "\n",
+          stats.num_dropped_packets);
+  fprintf(stderr, "num_packet_errors: %" PRId64 "\n", stats.num_packet_errors);
+  fprintf(stderr, "duration: %" PRId64 " ms, %.0f packets/s, %.1f Mbps\n",
+          stats.duration_ms, stats.PacketsPerSecond(), stats.Mbps());
+  for (const auto& unknown_ssrc : stats.unknown_ssrcs) {
+    fprintf(stderr, "Packets for unknown ssrc '%u': %" PRId64 "\n",
+            unknown_ssrc.first, unknown_ssrc.second);
+  }
 
-  delete decoder.decoder;
+  for (VideoReceiveStream* receive_stream : receive_streams)
+    call->DestroyVideoReceiveStream(receive_stream);
 }
 }  // namespace webrtc
 
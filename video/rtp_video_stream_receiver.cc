@@ -91,7 +91,8 @@ RtpVideoStreamReceiver::RtpVideoStreamReceiver(
     NackSender* nack_sender,
     KeyFrameRequestSender* keyframe_request_sender,
     video_coding::OnCompleteFrameCallback* complete_frame_callback,
-    VCMTiming* timing)
+    VCMTiming* timing,
+    MemoryAccountant* memory_accountant)
     : clock_(Clock::GetRealTimeClock()),
       config_(*config),
       packet_router_(packet_router),
@@ -176,6 +177,7 @@ RtpVideoStreamReceiver::RtpVideoStreamReceiver(
 
   packet_buffer_ = video_coding::PacketBuffer::Create(
       clock_, kPacketBufferStartSize, kPacketBufferMaxSixe, this);
+  packet_buffer_->SetMemoryAccountant(memory_accountant);
   reference_finder_.reset(new video_coding::RtpFrameReferenceFinder(this));
 }
 
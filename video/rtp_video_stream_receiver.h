@@ -38,6 +38,7 @@
 
 namespace webrtc {
 
+class MemoryAccountant;
 class NackModule;
 class PacketRouter;
 class ProcessThread;
@@ -75,7 +76,8 @@ class RtpVideoStreamReceiver : public RtpData,
       NackSender* nack_sender,
       KeyFrameRequestSender* keyframe_request_sender,
       video_coding::OnCompleteFrameCallback* complete_frame_callback,
-      VCMTiming* timing);
+      VCMTiming* timing,
+      MemoryAccountant* memory_accountant);
   ~RtpVideoStreamReceiver();
 
   bool AddReceiveCodec(const VideoCodec& video_codec,
@@ -15,6 +15,7 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "logging/rtc_event_log/output/rtc_event_log_output_file.h"
@@ -141,6 +142,10 @@ class VideoAnalyzer : public PacketReceiver,
         last_sending_time_(0),
         cpu_time_(0),
         wallclock_time_(0),
+        measuring_cpu_(false),
+        encode_cpu_time_(0),
+        decode_cpu_time_(0),
+        analyzer_cpu_time_(0),
         avg_psnr_threshold_(avg_psnr_threshold),
         avg_ssim_threshold_(avg_ssim_threshold),
         is_quick_test_enabled_(is_quick_test_enabled),
@@ -420,22 +425,43 @@ class VideoAnalyzer : public PacketReceiver,
     rtc::CritScope lock(&cpu_measurement_lock_);
     cpu_time_ -= rtc::GetProcessCpuTimeNanos();
     wallclock_time_ -= rtc::SystemTimeNanos();
+    measuring_cpu_ = true;
   }
 
   void StopMeasuringCpuProcessTime() {
     rtc::CritScope lock(&cpu_measurement_lock_);
     cpu_time_ += rtc::GetProcessCpuTimeNanos();
     wallclock_time_ += rtc::SystemTimeNanos();
+    measuring_cpu_ = false;
   }
 
   void StartExcludingCpuThreadTime() {
     rtc::CritScope lock(&cpu_measurement_lock_);
-    cpu_time_ += rtc::GetThreadCpuTimeNanos();
+    const int64_t thread_cpu_time = rtc::GetThreadCpuTimeNanos();
+    cpu_time_ += thread_cpu_time;
+    analyzer_cpu_time_ -= thread_cpu_time;
   }
 
   void StopExcludingCpuThreadTime() {
     rtc::CritScope lock(&cpu_measurement_lock_);
-    cpu_time_ -= rtc::GetThreadCpuTimeNanos();
+    const int64_t thread_cpu_time = rtc::GetThreadCpuTimeNanos();
+    cpu_time_ -= thread_cpu_time;
+    analyzer_cpu_time_ += thread_cpu_time;
+  }
+
+  // CPU time spent by the encoder and the decoder of the analyzed stream,
+  // measured on the threads calling them. Only counted while the process CPU
+  // time is measured, so that the stages add up to cpu_usage.
+  void AddEncodeCpuTime(int64_t cpu_time_ns) {
+    rtc::CritScope lock(&cpu_measurement_lock_);
+    if (measuring_cpu_)
+      encode_cpu_time_ += cpu_time_ns;
+  }
+
+  void AddDecodeCpuTime(int64_t cpu_time_ns) {
+    rtc::CritScope lock(&cpu_measurement_lock_);
+    if (measuring_cpu_)
+      decode_cpu_time_ += cpu_time_ns;
   }
 
   double GetCpuUsagePercent() {
@@ -443,6 +469,25 @@ class VideoAnalyzer : public PacketReceiver,
     return static_cast<double>(cpu_time_) / wallclock_time_ * 100.0;
   }
 
+  // Prints the CPU usage of the encoder, the decoder, the frame comparisons
+  // of the analyzer, and of everything else, which is capture, packetization,
+  // pacing, the simulated network and thumbnails. All but the analyzer add up
+  // to cpu_usage.
+  void PrintStageCpuUsage() {
+    rtc::CritScope lock(&cpu_measurement_lock_);
+    const double to_percent = 100.0 / wallclock_time_;
+    test::PrintResult("cpu_usage_encode", "", test_label_.c_str(),
+                      encode_cpu_time_ * to_percent, "%", false);
+    test::PrintResult("cpu_usage_decode", "", test_label_.c_str(),
+                      decode_cpu_time_ * to_percent, "%", false);
+    test::PrintResult(
+        "cpu_usage_other", "", test_label_.c_str(),
+        (cpu_time_ - encode_cpu_time_ - decode_cpu_time_) * to_percent, "%",
+        false);
+    test::PrintResult("cpu_usage_analyzer", "", test_label_.c_str(),
+                      analyzer_cpu_time_ * to_percent, "%", false);
+  }
+
   test::LayerFilteringTransport* const transport_;
   PacketReceiver* receiver_;
 
@@ -765,6 +810,7 @@ class VideoAnalyzer : public PacketReceiver,
                   dropped_frames_, "frames", false);
     test::PrintResult("cpu_usage", "", test_label_.c_str(),
                       GetCpuUsagePercent(), "%", false);
+    PrintStageCpuUsage();
 
 #if defined(WEBRTC_WIN)
       // On Linux and Mac in Resident Set some unused pages may be counted.
@@ -1019,6 +1065,10 @@ class VideoAnalyzer : public PacketReceiver,
 
   int64_t cpu_time_ RTC_GUARDED_BY(cpu_measurement_lock_);
   int64_t wallclock_time_ RTC_GUARDED_BY(cpu_measurement_lock_);
+  bool measuring_cpu_ RTC_GUARDED_BY(cpu_measurement_lock_);
+  int64_t encode_cpu_time_ RTC_GUARDED_BY(cpu_measurement_lock_);
+  int64_t decode_cpu_time_ RTC_GUARDED_BY(cpu_measurement_lock_);
+  int64_t analyzer_cpu_time_ RTC_GUARDED_BY(cpu_measurement_lock_);
   rtc::CriticalSection cpu_measurement_lock_;
 
   rtc::CriticalSection crit_;
@@ -1046,6 +1096,108 @@ class VideoAnalyzer : public PacketReceiver,
   const int64_t start_ms_;
 };
 
+namespace {
+
+// Forwards every call to |encoder|, so that wrapping doesn't change its
+// behavior, and reports the CPU time spent in Encode() to |analyzer|.
+class CpuTimeMeasuringEncoder : public VideoEncoder {
+ public:
+  CpuTimeMeasuringEncoder(std::unique_ptr<VideoEncoder> encoder,
+                          VideoAnalyzer* analyzer)
+      : encoder_(std::move(encoder)), analyzer_(analyzer) {}
+
+  int32_t InitEncode(const VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    return encoder_->InitEncode(codec_settings, number_of_cores,
+                                max_payload_size);
+  }
+  int32_t RegisterEncodeCompleteCallback(
+      EncodedImageCallback* callback) override {
+    return encoder_->RegisterEncodeCompleteCallback(callback);
+  }
+  int32_t Release() override { return encoder_->Release(); }
+  int32_t Encode(const VideoFrame& frame,
+                 const CodecSpecificInfo* codec_specific_info,
+                 const std::vector<FrameType>* frame_types) override {
+    const int64_t start_cpu_time = rtc::GetThreadCpuTimeNanos();
+    const int32_t result =
+        encoder_->Encode(frame, codec_specific_info, frame_types);
+    analyzer_->AddEncodeCpuTime(rtc::GetThreadCpuTimeNanos() -
+                                start_cpu_time);
+    return result;
+  }
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override {
+    return encoder_->SetChannelParameters(packet_loss, rtt);
+  }
+  int32_t SetRates(uint32_t bitrate, uint32_t framerate) override {
+    return encoder_->SetRates(bitrate, framerate);
+  }
+  int32_t SetRateAllocation(const BitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    return encoder_->SetRateAllocation(allocation, framerate);
+  }
+  ScalingSettings GetScalingSettings() const override {
+    return encoder_->GetScalingSettings();
+  }
+  int32_t SetPeriodicKeyFrames(bool enable) override {
+    return encoder_->SetPeriodicKeyFrames(enable);
+  }
+  bool SupportsNativeHandle() const override {
+    return encoder_->SupportsNativeHandle();
+  }
+  const char* ImplementationName() const override {
+    return encoder_->ImplementationName();
+  }
+
+ private:
+  const std::unique_ptr<VideoEncoder> encoder_;
+  VideoAnalyzer* const analyzer_;
+};
+
+// Forwards every call to |decoder| and reports the CPU time spent in Decode()
+// to |analyzer|. Doesn't take ownership of |decoder|.
+class CpuTimeMeasuringDecoder : public VideoDecoder {
+ public:
+  CpuTimeMeasuringDecoder(VideoDecoder* decoder, VideoAnalyzer* analyzer)
+      : decoder_(decoder), analyzer_(analyzer) {}
+
+  int32_t InitDecode(const VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    return decoder_->InitDecode(codec_settings, number_of_cores);
+  }
+  int32_t Decode(const EncodedImage& input_image,
+                 bool missing_frames,
+                 const RTPFragmentationHeader* fragmentation,
+                 const CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    const int64_t start_cpu_time = rtc::GetThreadCpuTimeNanos();
+    const int32_t result =
+        decoder_->Decode(input_image, missing_frames, fragmentation,
+                         codec_specific_info, render_time_ms);
+    analyzer_->AddDecodeCpuTime(rtc::GetThreadCpuTimeNanos() -
+                                start_cpu_time);
+    return result;
+  }
+  int32_t RegisterDecodeCompleteCallback(
+      DecodedImageCallback* callback) override {
+    return decoder_->RegisterDecodeCompleteCallback(callback);
+  }
+  int32_t Release() override { return decoder_->Release(); }
+  bool PrefersLateDecoding() const override {
+    return decoder_->PrefersLateDecoding();
+  }
+  const char* ImplementationName() const override {
+    return decoder_->ImplementationName();
+  }
+
+ private:
+  VideoDecoder* const decoder_;
+  VideoAnalyzer* const analyzer_;
+};
+
+}  // namespace
+
 VideoQualityTest::VideoQualityTest()
     : clock_(Clock::GetRealTimeClock()), receive_logs_(0), send_logs_(0) {
   payload_type_map_ = test::CallTest::payload_type_map_;
@@ -1780,9 +1932,9 @@ void VideoQualityTest::CreateCapturers() {
 std::unique_ptr<test::LayerFilteringTransport>
 VideoQualityTest::CreateSendTransport() {
   return rtc::MakeUnique<test::LayerFilteringTransport>(
-      &task_queue_, params_.pipe, sender_call_.get(), kPayloadTypeVP8,
+      &task_queue_, CreateNetworkPipe(), sender_call_.get(), kPayloadTypeVP8,
       kPayloadTypeVP9, params_.video[0].selected_tl, params_.ss[0].selected_sl,
-      payload_type_map_, kVideoSendSsrcs[0],
+      kVideoSendSsrcs[0],
       static_cast<uint32_t>(kVideoSendSsrcs[0] + params_.ss[0].streams.size() -
                             1));
 }
@@ -1790,7 +1942,15 @@ VideoQualityTest::CreateSendTransport() {
 std::unique_ptr<test::DirectTransport>
 VideoQualityTest::CreateReceiveTransport() {
   return rtc::MakeUnique<test::DirectTransport>(
-      &task_queue_, params_.pipe, receiver_call_.get(), payload_type_map_);
+      &task_queue_, CreateNetworkPipe(), receiver_call_.get());
+}
+
+// The simulated network runs on |clock_|, like the capturers. This is the
+// real-time clock, see the class comment.
+std::unique_ptr<FakeNetworkPipe> VideoQualityTest::CreateNetworkPipe() {
+  return rtc::MakeUnique<FakeNetworkPipe>(
+      clock_, params_.pipe,
+      rtc::MakeUnique<DemuxerImpl>(payload_type_map_));
 }
 
 void VideoQualityTest::CreateVideoStreams() {
@@ -1918,6 +2078,17 @@ void VideoQualityTest::RunWithAnalyzer(const Params& params) {
     SetupThumbnails(analyzer.get(), recv_transport.get());
     video_receive_configs_[params_.ss[0].selected_stream].renderer =
         analyzer.get();
+    // Measure the CPU time of the encoder and the decoder of the analyzed
+    // stream, to report it separately from the rest of the pipeline.
+    video_encoders_[0].reset(new CpuTimeMeasuringEncoder(
+        std::move(video_encoders_[0]), analyzer.get()));
+    video_send_configs_[0].encoder_settings.encoder = video_encoders_[0].get();
+    for (VideoReceiveStream::Decoder& decoder :
+         video_receive_configs_[params_.ss[0].selected_stream].decoders) {
+      allocated_decoders_.emplace_back(
+          new CpuTimeMeasuringDecoder(decoder.decoder, analyzer.get()));
+      decoder.decoder = allocated_decoders_.back().get();
+    }
     video_send_configs_[0].pre_encode_callback = analyzer->pre_encode_proxy();
     RTC_DCHECK(!video_send_configs_[0].post_encode_callback);
     video_send_configs_[0].post_encode_callback =
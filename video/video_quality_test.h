@@ -22,6 +22,12 @@
 
 namespace webrtc {
 
+// Runs a call with the given parameters and, with RunWithAnalyzer(), measures
+// the quality and per-stage CPU usage of the received video. The test runs in
+// real time: Call, the RTP/RTCP modules, the pacer and the task queues read
+// the real-time clock, so a scenario takes at least its duration. To run
+// several scenarios in parallel, run them as separate processes, e.g. with
+// gtest sharding (GTEST_TOTAL_SHARDS and GTEST_SHARD_INDEX).
 class VideoQualityTest : public test::CallTest {
  public:
   // Parameters are grouped into smaller structs to make it easier to set
@@ -146,6 +152,7 @@ class VideoQualityTest : public test::CallTest {
 
   virtual std::unique_ptr<test::LayerFilteringTransport> CreateSendTransport();
   virtual std::unique_ptr<test::DirectTransport> CreateReceiveTransport();
+  std::unique_ptr<FakeNetworkPipe> CreateNetworkPipe();
 
   std::vector<std::unique_ptr<test::VideoCapturer>> video_capturers_;
   std::vector<std::unique_ptr<test::VideoCapturer>> thumbnail_capturers_;
@@ -88,7 +88,8 @@ VideoReceiveStream::VideoReceiveStream(
     PacketRouter* packet_router,
     VideoReceiveStream::Config config,
     ProcessThread* process_thread,
-    CallStats* call_stats)
+    CallStats* call_stats,
+    MemoryAccountant* memory_accountant)
     : transport_adapter_(config.rtcp_send_transport),
       config_(std::move(config)),
       num_cpu_cores_(num_cpu_cores),
@@ -113,7 +114,8 @@ VideoReceiveStream::VideoReceiveStream(
                                  this,  // NackSender
                                  this,  // KeyFrameRequestSender
                                  this,  // OnCompleteFrameCallback
-                                 timing_.get()),
+                                 timing_.get(),
+                                 memory_accountant),
       rtp_stream_sync_(this) {
   RTC_LOG(LS_INFO) << "VideoReceiveStream: " << config_.ToString();
 
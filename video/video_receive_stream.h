@@ -33,6 +33,7 @@ namespace webrtc {
 
 class CallStats;
 class IvfFileWriter;
+class MemoryAccountant;
 class ProcessThread;
 class RTPFragmentationHeader;
 class RtpStreamReceiverInterface;
@@ -57,7 +58,8 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
                      PacketRouter* packet_router,
                      VideoReceiveStream::Config config,
                      ProcessThread* process_thread,
-                     CallStats* call_stats);
+                     CallStats* call_stats,
+                     MemoryAccountant* memory_accountant);
   ~VideoReceiveStream() override;
 
   const Config& config() const { return config_; }
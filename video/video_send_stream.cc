@@ -60,6 +60,7 @@ std::vector<RtpRtcp*> CreateRtpRtcpModules(
     SendStatisticsProxy* stats_proxy,
     SendDelayStats* send_delay_stats,
     RtcEventLog* event_log,
+    MemoryAccountant* memory_accountant,
     RateLimiter* retransmission_rate_limiter,
     OverheadObserver* overhead_observer,
     size_t num_modules,
@@ -84,6 +85,7 @@ std::vector<RtpRtcp*> CreateRtpRtcpModules(
   configuration.send_side_delay_observer = stats_proxy;
   configuration.send_packet_observer = send_delay_stats;
   configuration.event_log = event_log;
+  configuration.memory_accountant = memory_accountant;
   configuration.retransmission_rate_limiter = retransmission_rate_limiter;
   configuration.overhead_observer = overhead_observer;
   configuration.keepalive_config = keepalive_config;
@@ -260,6 +262,7 @@ class VideoSendStreamImpl : public webrtc::BitrateAllocatorObserver,
       SendDelayStats* send_delay_stats,
       VideoStreamEncoder* video_stream_encoder,
       RtcEventLog* event_log,
+      MemoryAccountant* memory_accountant,
       const VideoSendStream::Config* config,
       int initial_encoder_max_bitrate,
       double initial_encoder_bitrate_priority,
@@ -408,6 +411,7 @@ class VideoSendStream::ConstructionTask : public rtc::QueuedTask {
       BitrateAllocator* bitrate_allocator,
       SendDelayStats* send_delay_stats,
       RtcEventLog* event_log,
+      MemoryAccountant* memory_accountant,
       const VideoSendStream::Config* config,
       int initial_encoder_max_bitrate,
       double initial_encoder_bitrate_priority,
@@ -424,6 +428,7 @@ class VideoSendStream::ConstructionTask : public rtc::QueuedTask {
         bitrate_allocator_(bitrate_allocator),
         send_delay_stats_(send_delay_stats),
         event_log_(event_log),
+        memory_accountant_(memory_accountant),
         config_(config),
         initial_encoder_max_bitrate_(initial_encoder_max_bitrate),
         initial_encoder_bitrate_priority_(initial_encoder_bitrate_priority),
@@ -439,7 +444,7 @@ class VideoSendStream::ConstructionTask : public rtc::QueuedTask {
     send_stream_->reset(new VideoSendStreamImpl(
         stats_proxy_, rtc::TaskQueue::Current(), call_stats_, transport_,
         bitrate_allocator_, send_delay_stats_, video_stream_encoder_,
-        event_log_, config_, initial_encoder_max_bitrate_,
+        event_log_, memory_accountant_, config_, initial_encoder_max_bitrate_,
         initial_encoder_bitrate_priority_, std::move(suspended_ssrcs_),
         std::move(suspended_payload_states_), content_type_,
         std::move(fec_controller_)));
@@ -455,6 +460,7 @@ class VideoSendStream::ConstructionTask : public rtc::QueuedTask {
   BitrateAllocator* const bitrate_allocator_;
   SendDelayStats* const send_delay_stats_;
   RtcEventLog* const event_log_;
+  MemoryAccountant* const memory_accountant_;
   const VideoSendStream::Config* config_;
   int initial_encoder_max_bitrate_;
   double initial_encoder_bitrate_priority_;
@@ -577,6 +583,7 @@ VideoSendStream::VideoSendStream(
     BitrateAllocator* bitrate_allocator,
     SendDelayStats* send_delay_stats,
     RtcEventLog* event_log,
+    MemoryAccountant* memory_accountant,
     VideoSendStream::Config config,
     VideoEncoderConfig encoder_config,
     const std::map<uint32_t, RtpState>& suspended_ssrcs,
@@ -597,8 +604,8 @@ VideoSendStream::VideoSendStream(
   worker_queue_->PostTask(std::unique_ptr<rtc::QueuedTask>(new ConstructionTask(
       &send_stream_, &thread_sync_event_, &stats_proxy_,
       video_stream_encoder_.get(), module_process_thread, call_stats, transport,
-      bitrate_allocator, send_delay_stats, event_log, &config_,
-      encoder_config.max_bitrate_bps, encoder_config.bitrate_priority,
+      bitrate_allocator, send_delay_stats, event_log, memory_accountant,
+      &config_, encoder_config.max_bitrate_bps, encoder_config.bitrate_priority,
       suspended_ssrcs, suspended_payload_states, encoder_config.content_type,
       std::move(fec_controller))));
 
@@ -720,6 +727,7 @@ VideoSendStreamImpl::VideoSendStreamImpl(
     SendDelayStats* send_delay_stats,
     VideoStreamEncoder* video_stream_encoder,
     RtcEventLog* event_log,
+    MemoryAccountant* memory_accountant,
     const VideoSendStream::Config* config,
     int initial_encoder_max_bitrate,
     double initial_encoder_bitrate_priority,
@@ -760,6 +768,7 @@ VideoSendStreamImpl::VideoSendStreamImpl(
           stats_proxy_,
           send_delay_stats,
           event_log,
+          memory_accountant,
           transport->send_side_cc()->GetRetransmissionRateLimiter(),
           this,
           config_->rtp.ssrcs.size(),
@@ -36,6 +36,7 @@ class VideoSendStreamPeer;
 class CallStats;
 class SendSideCongestionController;
 class IvfFileWriter;
+class MemoryAccountant;
 class ProcessThread;
 class RtpRtcp;
 class RtpTransportControllerSendInterface;
@@ -60,6 +61,7 @@ class VideoSendStream : public webrtc::VideoSendStream {
       BitrateAllocator* bitrate_allocator,
       SendDelayStats* send_delay_stats,
       RtcEventLog* event_log,
+      MemoryAccountant* memory_accountant,
       VideoSendStream::Config config,
       VideoEncoderConfig encoder_config,
       const std::map<uint32_t, RtpState>& suspended_ssrcs,